@@ -9,31 +9,158 @@
 #include "settings.h"
 
 #include <QtCore/QCoreApplication>
+#include <QtCore/QPromise>
+#include <QtCore/QThread>
 
 using namespace Quotient;
 
 struct Q_DECL_HIDDEN AccountRegistry::Private {
+    explicit Private(AccountRegistry* q) : q(q) {}
+
+    AccountRegistry* q;
     QStringList m_accountsLoading;
+    ThreadingMode threadingMode = ThreadingMode::SharedThread;
+    //! Worker threads with the objects used to invoke functions on them
+    QHash<QThread*, QObject*> workers;
+    //! User ids of connections living on worker threads, to avoid calling into those threads
+    QHash<const Connection*, QString> workerUserIds;
+
+    QString userIdOf(const Connection* connection) const
+    {
+        const auto it = workerUserIds.constFind(connection);
+        return it != workerUserIds.cend() ? *it : connection->userId();
+    }
+
+    void finishLoading(const QString& accountId)
+    {
+        m_accountsLoading.removeAll(accountId);
+        emit q->accountsLoadingChanged();
+    }
+
+    //! Log \p connection in with the stored credentials, on the thread it lives on
+    void setupLogin(Connection* connection, const QString& accountId, const QString& deviceId,
+                    const QString& accessToken);
+
+    //! Add \p connection with \p userId read beforehand, on the thread the connection lives on
+    void addConnection(Connection* connection, const QString& userId);
+
+    //! Stop \p thread once it has processed the events already posted to it
+    void stopWorker(QThread* thread)
+    {
+        if (auto* context = workers.take(thread))
+            QMetaObject::invokeMethod(context, [thread] { thread->quit(); });
+    }
 };
 
+void AccountRegistry::Private::setupLogin(Connection* connection, const QString& accountId,
+                                          const QString& deviceId, const QString& accessToken)
+{
+    // The connection may live on another thread; signals get queued to the registry, and
+    // the registry's calls into the connection go through invokeMethod()
+    connect(connection, &Connection::connected, q, [this, connection, accountId] {
+        QMetaObject::invokeMethod(connection, [connection] {
+            connection->loadState();
+            connection->setLazyLoading(true);
+            connection->syncLoop();
+        });
+        finishLoading(accountId);
+    });
+    connect(connection, &Connection::loginError, q,
+            [this, connection, accountId](const QString& error, const QString& details) {
+                emit q->loginError(connection, error, details);
+                finishLoading(accountId);
+            });
+    connect(connection, &Connection::resolveError, q,
+            [this, connection, accountId](const QString& error) {
+                emit q->resolveError(connection, error);
+                finishLoading(accountId);
+            });
+    QMetaObject::invokeMethod(connection, [this, connection, accountId, deviceId, accessToken] {
+        connection->assumeIdentity(accountId, deviceId, accessToken);
+        QMetaObject::invokeMethod(q, [this, connection, userId = connection->userId()] {
+            addConnection(connection, userId);
+        });
+    });
+}
+
 AccountRegistry::AccountRegistry(QObject* parent)
-    : QAbstractListModel(parent), d(makeImpl<Private>())
+    : QAbstractListModel(parent), d(makeImpl<Private>(this))
 {}
 
-void AccountRegistry::add(Connection* a)
+AccountRegistry::~AccountRegistry()
 {
-    Q_ASSERT(a != nullptr);
-    if (get(a->userId()) != nullptr) {
+    const auto threads = d->workers.keys();
+    for (auto* thread : threads) {
+        d->stopWorker(thread);
+        thread->wait(); // Connections on the thread are deleted as it finishes
+    }
+}
+
+AccountRegistry::ThreadingMode AccountRegistry::threadingMode() const
+{
+    return d->threadingMode;
+}
+
+void AccountRegistry::setThreadingMode(ThreadingMode newMode) { d->threadingMode = newMode; }
+
+QFuture<Connection*> AccountRegistry::createConnection(const QUrl& homeserver)
+{
+    if (d->threadingMode == ThreadingMode::SharedThread)
+        return QtFuture::makeReadyFuture(new Connection(homeserver));
+
+    auto* thread = new QThread(this);
+    thread->setObjectName("Quotient connection to "_L1 + homeserver.host());
+    auto* context = new QObject;
+    context->moveToThread(thread);
+    connect(thread, &QThread::finished, context, &QObject::deleteLater);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    d->workers.insert(thread, context);
+    thread->start();
+
+    // Connection and its parts (notably, timers) must be created on the thread they live on
+    auto promise = std::make_shared<QPromise<Connection*>>();
+    promise->start();
+    QMetaObject::invokeMethod(context, [this, thread, homeserver, promise] {
+        auto* connection = new Connection(homeserver);
+        connect(thread, &QThread::finished, connection, &QObject::deleteLater);
+        // The thread is no more needed once the connection is gone, e.g. after logout
+        connect(connection, &QObject::destroyed, this, [this, thread] { d->stopWorker(thread); });
+        promise->addResult(connection);
+        promise->finish();
+    });
+    qCDebug(MAIN) << "Creating a connection to" << homeserver << "on a worker thread";
+    return promise->future();
+}
+
+void AccountRegistry::Private::addConnection(Connection* connection, const QString& userId)
+{
+    if (q->get(userId) != nullptr) {
         qWarning(MAIN) << "Attempt to add another connection for the same user "
                           "id; skipping";
         return;
     }
-    beginInsertRows(QModelIndex(), size(), size());
-    push_back(a);
-    connect(a, &Connection::loggedOut, this, [this, a] { drop(a); });
-    qDebug(MAIN) << "Added" << a->objectName() << "to the account registry";
-    endInsertRows();
-    emit accountCountChanged();
+    q->beginInsertRows(QModelIndex(), q->size(), q->size());
+    if (connection->thread() != q->thread())
+        workerUserIds.insert(connection, userId);
+    q->push_back(connection);
+    connect(connection, &Connection::loggedOut, q, [this, connection] { q->drop(connection); });
+    qDebug(MAIN) << "Added" << connection->objectName() << "to the account registry";
+    q->endInsertRows();
+    emit q->accountCountChanged();
+}
+
+void AccountRegistry::add(Connection* a)
+{
+    Q_ASSERT(a != nullptr);
+    if (a->thread() == thread()) {
+        d->addConnection(a, a->userId());
+        return;
+    }
+    // Don't read the connection's state across threads; ask its own thread for the user id
+    QString userId;
+    QMetaObject::invokeMethod(a, [a, &userId] { userId = a->userId(); },
+                              Qt::BlockingQueuedConnection);
+    d->addConnection(a, userId);
 }
 
 void AccountRegistry::drop(Connection* a)
@@ -41,6 +168,7 @@ void AccountRegistry::drop(Connection* a)
     if (const auto idx = indexOf(a); idx != -1) {
         beginRemoveRows(QModelIndex(), idx, idx);
         remove(idx);
+        d->workerUserIds.remove(a);
         qDebug(MAIN) << "Removed" << a->objectName()
                      << "from the account registry";
         endRemoveRows();
@@ -63,7 +191,7 @@ QVariant AccountRegistry::data(const QModelIndex& index, int role) const
         case AccountRole:
             return QVariant::fromValue(at(index.row()));
         case UserIdRole:
-            return QVariant::fromValue(at(index.row())->userId());
+            return QVariant::fromValue(d->userIdOf(at(index.row())));
         default:
             return {};
     }
@@ -83,7 +211,7 @@ QHash<int, QByteArray> AccountRegistry::roleNames() const
 Connection* AccountRegistry::get(const QString& userId) const
 {
     for (const auto& connection : accounts()) {
-        if (connection->userId() == userId)
+        if (d->userIdOf(connection) == userId)
             return connection;
     }
     return nullptr;
@@ -116,37 +244,13 @@ void AccountRegistry::invokeLogin()
                     }
 
                     AccountSettings account { accountId };
-                    auto connection = new Connection(account.homeserver());
-                    connect(connection, &Connection::connected, this,
-                            [connection, this, accountId] {
-                                connection->loadState();
-                                connection->setLazyLoading(true);
-
-                                connection->syncLoop();
-
-                                d->m_accountsLoading.removeAll(accountId);
-                                emit accountsLoadingChanged();
-                            });
-                    connect(connection, &Connection::loginError, this,
-                            [this, connection, accountId](const QString& error,
-                                               const QString& details) {
-                                emit loginError(connection, error, details);
-
-                                d->m_accountsLoading.removeAll(accountId);
-                                emit accountsLoadingChanged();
-                            });
-                    connect(connection, &Connection::resolveError, this,
-                            [this, connection, accountId](const QString& error) {
-                                emit resolveError(connection, error);
-
-                                d->m_accountsLoading.removeAll(accountId);
-                                emit accountsLoadingChanged();
-                            });
-                    connection->assumeIdentity(
-                        account.userId(),
-                        account.deviceId(),
-                        QString::fromUtf8(accessTokenLoadingJob->binaryData()));
-                    add(connection);
+                    createConnection(account.homeserver())
+                        .then(this, [this, accountId, deviceId = account.deviceId(),
+                                     accessToken = QString::fromUtf8(
+                                         accessTokenLoadingJob->binaryData())](
+                                        Connection* connection) {
+                            d->setupLogin(connection, accountId, deviceId, accessToken);
+                        });
                 });
         accessTokenLoadingJob->start();
     }
@@ -7,12 +7,25 @@
 #include "util.h"
 
 #include <QtCore/QAbstractListModel>
+#include <QtCore/QFuture>
 
 #include <qt6keychain/keychain.h>
 
 namespace Quotient {
 class Connection;
 
+//! \brief The list of accounts (connections) of the application
+//!
+//! By default, all connections live on the thread of the registry (usually the GUI thread), so
+//! processing sync responses for all accounts shares that thread with the UI. With many accounts
+//! catching up at once this makes the UI unresponsive; in ThreadPerAccount mode, each connection
+//! created by the registry (see createConnection()) gets a dedicated worker thread instead, along
+//! with everything it creates: rooms, users, the database and the network access manager.
+//!
+//! Connections on worker threads can be used from the UI by connecting to their signals as usual
+//! (Qt queues them to the receiver's thread) and calling their functions via
+//! QMetaObject::invokeMethod(). The registry itself remains a model on its own thread; it doesn't
+//! call into connections on other threads when serving its data.
 class QUOTIENT_API AccountRegistry : public QAbstractListModel,
                                      private QVector<Connection*> {
     Q_OBJECT
@@ -21,6 +34,7 @@ class QUOTIENT_API AccountRegistry : public QAbstractListModel,
     /// List of accounts that are currently in some stage of being loaded (Reading token from keychain, trying to contact server, etc).
     /// Can be used to inform the user or to show a login screen if size() == 0 and no accounts are loaded
     Q_PROPERTY(QStringList accountsLoading READ accountsLoading NOTIFY accountsLoadingChanged)
+    Q_PROPERTY(ThreadingMode threadingMode READ threadingMode WRITE setThreadingMode)
 public:
     using vector_t = QVector<Connection*>;
     using const_iterator = vector_t::const_iterator;
@@ -32,7 +46,29 @@ public:
         UserIdRole = Qt::DisplayRole
     };
 
+    enum class ThreadingMode : uint8_t {
+        //! Connections live on the thread of the registry
+        SharedThread,
+        //! Each connection lives on its own worker thread
+        ThreadPerAccount
+    };
+    Q_ENUM(ThreadingMode)
+
     explicit AccountRegistry(QObject* parent = nullptr);
+    //! Stops worker threads, deleting the connections that live on them
+    ~AccountRegistry() override;
+
+    ThreadingMode threadingMode() const;
+    //! Set the threading mode for connections created by the registry from now on
+    void setThreadingMode(ThreadingMode newMode);
+
+    //! \brief Create a connection to \p homeserver according to the threading mode
+    //!
+    //! In ThreadPerAccount mode, the connection is created on a new worker thread that stops
+    //! once the connection is deleted (e.g. after logging out). The registry owns such
+    //! connections and deletes them when it's destroyed itself. The connection is not added to
+    //! the registry; call add() once it has a user id.
+    QFuture<Connection*> createConnection(const QUrl& homeserver);
 
     // Expose most of vector_t's const-API but only provide add() and drop()
     // for changing it. In theory other changing operations could be supported
@@ -17,6 +17,7 @@
 #include "user.h"
 
 #include "csapi/account-data.h"
+#include "csapi/filter.h"
 #include "csapi/joining.h"
 #include "csapi/leaving.h"
 #include "csapi/logout.h"
@@ -38,6 +39,7 @@
 #include "moc_connection.cpp" // NOLINT(bugprone-suspicious-include)
 
 #include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
 #include <QtCore/QDir>
 #include <QtCore/QElapsedTimer>
 #include <QtCore/QFile>
@@ -71,6 +73,9 @@ Connection::Connection(const QUrl& server, QObject* parent)
 {
     d->q = this; // All d initialization should occur before this line
     setObjectName(server.toString());
+    d->roomUpdateTimer.setSingleShot(true);
+    connect(&d->roomUpdateTimer, &QTimer::timeout, this,
+            [this] { d->applyRoomUpdates(d->roomUpdateBudget); });
 }
 
 Connection::Connection(QObject* parent) : Connection({}, parent) {}
@@ -191,14 +196,15 @@ void Connection::assumeIdentity(const QString& mxId, const QString& deviceId,
 
 JobHandle<GetVersionsJob> Connection::loadVersions()
 {
-    return callApi<GetVersionsJob>(BackgroundRequest).then([this](GetVersionsJob::Response r) {
-        d->data->setSupportedSpecVersions(std::move(r.versions));
-    });
+    return callApiCoalesced<GetVersionsJob>(BackgroundRequest)
+        .then([this](GetVersionsJob::Response r) {
+            d->data->setSupportedSpecVersions(std::move(r.versions));
+        });
 }
 
 JobHandle<GetCapabilitiesJob> Connection::loadCapabilities()
 {
-    return callApi<GetCapabilitiesJob>(BackgroundRequest)
+    return callApiCoalesced<GetCapabilitiesJob>(BackgroundRequest)
         .then(
             [this](GetCapabilitiesJob::Capabilities response) {
                 d->capabilities = std::move(response);
@@ -250,6 +256,20 @@ void Connection::Private::saveAccessTokenToKeychain() const
 
 }
 
+void Connection::Private::purgeEventStore()
+{
+    eventStore.reset(); // Waits until pending writes are done and the store is closed
+    if (const auto& userId = q->userId(); !userId.isEmpty())
+        EventStore::purge(userId);
+}
+
+void Connection::Private::purgeSearchIndex()
+{
+    searchIndex.reset(); // Waits until the index is closed
+    if (const auto& userId = q->userId(); !userId.isEmpty())
+        SearchIndex::purge(userId);
+}
+
 void Connection::Private::dropAccessToken()
 {
     // TODO: emit a signal on important (i.e. access denied) keychain errors
@@ -398,6 +418,8 @@ QFuture<void> Connection::logout()
                 disconnect(d->syncLoopConnection);
             SettingsGroup("Accounts"_L1).remove(userId());
             d->dropAccessToken();
+            d->purgeEventStore();
+            d->purgeSearchIndex();
             emit loggedOut();
             deleteLater();
         } else { // logout() somehow didn't proceed - restore the session state
@@ -424,14 +446,13 @@ void Connection::sync(int timeout)
     }
 
     d->syncTimeout = timeout;
-    Filter filter;
-    filter.room.timeline.limit.emplace(100);
-    filter.room.state.lazyLoadMembers.emplace(d->lazyLoading);
+    const auto filter = d->syncFilter();
     auto job = d->syncJob =
         callApi<SyncJob>(BackgroundRequest, d->data->lastEvent(), filter,
                          timeout);
     connect(job, &SyncJob::success, this, [this, job] {
         onSyncSuccess(job->takeData());
+        d->lastSyncTimeMs = QDateTime::currentMSecsSinceEpoch();
         d->syncJob = nullptr;
         emit syncDone();
     });
@@ -440,7 +461,18 @@ void Connection::sync(int timeout)
                 emit networkError(job->errorString(), job->rawDataSample(),
                                   retriesTaken, nextInMilliseconds);
             });
-    connect(job, &SyncJob::failure, this, [this, job] {
+    connect(job, &SyncJob::failure, this, [this, job, filter, timeout] {
+        if (!filter.startsWith(u'{')
+            && (job->error() == BaseJob::NotFound || job->error() == BaseJob::IncorrectRequest)) {
+            // The server has likely dropped the filter; sync with a filter defined anew
+            qCWarning(SYNCJOB) << "The server didn't accept sync filter" << filter
+                               << "- defining it again";
+            d->forgetSyncFilter(filter);
+            d->syncJob = nullptr;
+            QMetaObject::invokeMethod(this, [this, timeout] { sync(timeout); },
+                                      Qt::QueuedConnection);
+            return;
+        }
         // SyncJob persists with retries on transient errors; if it fails,
         // there's likely something serious enough to stop the loop.
         stopSync();
@@ -453,6 +485,61 @@ void Connection::sync(int timeout)
     });
 }
 
+int Connection::Private::nextSyncTimelineLimit() const
+{
+    if (data->lastEvent().isEmpty())
+        return syncTimelineLimits.initialSync;
+    // Before the first sync in the session, the local state is as old as the cache
+    if (lastSyncTimeMs == 0)
+        return syncTimelineLimits.catchUp;
+    const std::chrono::milliseconds sinceLastSync{ QDateTime::currentMSecsSinceEpoch()
+                                                   - lastSyncTimeMs };
+    return sinceLastSync >= syncTimelineLimits.catchUpAfter ? syncTimelineLimits.catchUp
+                                                            : syncTimelineLimits.steadyState;
+}
+
+QString Connection::Private::syncFilter()
+{
+    Filter filter;
+    filter.room.timeline.limit.emplace(nextSyncTimelineLimit());
+    filter.room.state.lazyLoadMembers.emplace(lazyLoading);
+    auto filterJson = QJsonDocument(toJson(filter)).toJson(QJsonDocument::Compact);
+
+    if (const auto it = syncFilterIds.constFind(filterJson); it != syncFilterIds.cend())
+        return *it;
+    if (auto filterId = AccountSettings(data->userId()).filterId(filterJson);
+        !filterId.isEmpty()) {
+        syncFilterIds.insert(filterJson, filterId);
+        return filterId;
+    }
+    if (!syncFiltersBeingDefined.contains(filterJson)) {
+        syncFiltersBeingDefined.insert(filterJson);
+        q->callApi<DefineFilterJob>(BackgroundRequest, data->userId(), filter)
+            .then(
+                q,
+                [this, filterJson](const QString& filterId) {
+                    syncFiltersBeingDefined.remove(filterJson);
+                    qCDebug(SYNCJOB) << "Sync filter" << filterJson << "is defined as"
+                                     << filterId;
+                    syncFilterIds.insert(filterJson, filterId);
+                    AccountSettings(data->userId()).setFilterId(filterJson, filterId);
+                },
+                [this, filterJson] { syncFiltersBeingDefined.remove(filterJson); });
+    }
+    // Don't wait for the filter to be defined, pass it inline this time
+    return QString::fromUtf8(filterJson);
+}
+
+void Connection::Private::forgetSyncFilter(const QString& filterId)
+{
+    for (auto it = syncFilterIds.begin(); it != syncFilterIds.end();)
+        if (*it == filterId) {
+            AccountSettings(data->userId()).setFilterId(it.key(), {});
+            it = syncFilterIds.erase(it);
+        } else
+            ++it;
+}
+
 void Connection::syncLoop(int timeout)
 {
     if (d->syncLoopConnection && d->syncTimeout == timeout) {
@@ -499,7 +586,8 @@ void Connection::onSyncSuccess(SyncData&& data, bool fromCache)
         d->encryptionData->onSyncSuccess(data);
     }
     d->consumeToDeviceEvents(data.takeToDeviceEvents());
-    d->data->setLastEvent(data.nextBatch());
+    if (!data.nextBatch().isEmpty()) // Sliding sync keeps its position elsewhere
+        d->data->setLastEvent(data.nextBatch());
     d->consumeRoomData(data.takeRoomData(), fromCache);
     d->consumeAccountData(data.takeAccountData());
     d->consumePresenceData(data.takePresenceData());
@@ -530,15 +618,64 @@ void Connection::Private::consumeRoomData(SyncDataList&& roomDataList,
         }
         if (auto* r = q->provideRoom(roomData.roomId, roomData.joinState)) {
             pendingStateRoomIds.removeOne(roomData.roomId);
-            // Update rooms one by one, giving time to update the UI.
-            QMetaObject::invokeMethod(
-                r,
-                [r, rd = std::move(roomData), fromCache] () mutable {
-                    r->updateData(std::move(rd), fromCache);
-                },
-                Qt::QueuedConnection);
+            pendingRoomUpdates.push_back({ r, std::move(roomData), fromCache });
+            ++roomUpdatesTotal;
+        }
+    }
+    // Update rooms in time slices, giving time to update the UI; syncApplied() is emitted
+    // even if the sync response had nothing for rooms
+    if (!roomUpdateTimer.isActive())
+        roomUpdateTimer.start();
+}
+
+void Connection::Private::applyRoomUpdates(std::chrono::milliseconds budget)
+{
+    // Room signal handlers may call back; bail out instead of applying updates out of order
+    if (applyingRoomUpdates)
+        return;
+    roomUpdateTimer.stop();
+
+    QElapsedTimer et;
+    et.start();
+    applyingRoomUpdates = true;
+    // Rooms in front of the user go first, keeping the order of updates to each room
+    std::stable_partition(pendingRoomUpdates.begin(), pendingRoomUpdates.end(),
+                          [](const PendingRoomUpdate& u) { return u.room && u.room->displayed(); });
+    while (!pendingRoomUpdates.empty()) {
+        auto& update = pendingRoomUpdates.front();
+        if (!update.room // The room has been deleted in the meantime
+            || !update.room->applySyncChunk(update.data, MaxEventsPerRoomUpdateChunk,
+                                            update.fromCache)) {
+            auto lastChunk = std::move(update);
+            pendingRoomUpdates.pop_front();
+            if (lastChunk.room)
+                lastChunk.room->updateData(std::move(lastChunk.data), lastChunk.fromCache);
+            ++roomUpdatesApplied;
         }
+        if (budget > std::chrono::milliseconds::zero() && et.elapsed() >= budget.count())
+            break;
     }
+    applyingRoomUpdates = false;
+
+    const auto sliceMs = et.elapsed();
+    ++roomUpdateSlices;
+    longestRoomUpdateSliceMs = std::max(longestRoomUpdateSliceMs, sliceMs);
+    roomUpdatesTimeMs += sliceMs;
+    emit q->roomUpdatesProgress(roomUpdatesApplied, roomUpdatesTotal);
+    if (!pendingRoomUpdates.empty()) {
+        roomUpdateTimer.start();
+        return;
+    }
+    if (roomUpdatesTotal > 0)
+        qCDebug(PROFILER) << roomUpdatesTotal << "room update(s) for" << q->objectName()
+                          << "applied in" << roomUpdatesTimeMs << "ms over" << roomUpdateSlices
+                          << "slice(s), the longest one taking" << longestRoomUpdateSliceMs
+                          << "ms";
+    roomUpdatesApplied = roomUpdatesTotal = roomUpdateSlices = 0;
+    longestRoomUpdateSliceMs = roomUpdatesTimeMs = 0;
+    if (std::exchange(saveStateDeferred, false))
+        q->saveState();
+    emit q->syncApplied();
 }
 
 void Connection::Private::consumeAccountData(Events&& accountDataEvents)
@@ -556,9 +693,8 @@ void Connection::Private::consumeAccountData(Events&& accountDataEvents)
                             usersToDCs.contains(it.key()->id(), it.value())
                             || dcLocalAdditions.contains(it.key(), it.value()));
                     });
-                remove_if(directChatMemberIds, [&remoteRemovals, this](auto it) {
-                    return remoteRemovals.contains(q->user(it.value()), it.key());
-                });
+                for (auto it = remoteRemovals.cbegin(); it != remoteRemovals.cend(); ++it)
+                    directChatMemberIds.remove(it.value(), it.key()->id());
                 // Remove from dcLocalRemovals what the server already has.
                 remove_if(dcLocalRemovals, [&remoteRemovals](auto it) {
                     return remoteRemovals.contains(it.key(), it.value());
@@ -592,8 +728,7 @@ void Connection::Private::consumeAccountData(Events&& accountDataEvents)
                     return remoteAdditions.contains(it.key(), it.value());
                 });
                 if (!remoteAdditions.isEmpty() || !remoteRemovals.isEmpty())
-                    emit q->directChatsListChanged(remoteAdditions,
-                                                   remoteRemovals);
+                    notifyDirectChatsChanged(remoteAdditions, remoteRemovals);
             },
             // catch-all, passing eventPtr for a possible take-over
             [this, &eventPtr](const Event& accountEvent) {
@@ -854,7 +989,7 @@ QFuture<Room*> Connection::getDirectChat(const QString& otherUserId)
             d->directChats.remove(it.key(), it.value());
             d->directChatMemberIds.remove(it.value(), it.key()->id());
         }
-        emit directChatsListChanged({}, removals);
+        d->notifyDirectChatsChanged({}, removals);
     }
 
     return createDirectChat(otherUserId).then([this](const QString& roomId) {
@@ -1054,29 +1189,100 @@ User* Connection::user(const QString& uId)
 {
     if (uId.isEmpty())
         return nullptr;
-    if (const auto v = d->userMap.value(uId, nullptr))
-        return v;
+    if (const auto it = d->userMap.find(d->idPool.find(uId)); it != d->userMap.end()) {
+        it->lastLookup = ++d->userLookups;
+        return it->user;
+    }
     // Before creating a user object, check that the user id is well-formed
     // (it's faster to just do a lookup above before validation)
     if (!uId.startsWith(u'@') || serverPart(uId).isEmpty()) {
         qCCritical(MAIN) << "Malformed userId:" << uId;
         return nullptr;
     }
+    // Make room before adding, so that the new user is not evicted right away
+    if (d->userCacheCapacity > 0 && d->userMap.size() >= d->nextUserEviction)
+        d->evictUsers();
     auto* user = userFactory()(this, uId);
-    d->userMap.insert(uId, user);
+    d->userMap.insert(d->idPool.intern(uId), { user, ++d->userLookups });
     emit newUser(user);
     return user;
 }
 
 const User* Connection::user() const
 {
-    return d->userMap.value(userId(), nullptr);
+    return d->userMap.value(d->idPool.find(userId())).user;
+}
+
+void Connection::holdUser(const User* user)
+{
+    Q_ASSERT(user != nullptr);
+    if (const auto it = d->userMap.find(d->idPool.find(user->id())); it != d->userMap.end())
+        ++it->holds;
+}
+
+void Connection::releaseUser(const User* user)
+{
+    Q_ASSERT(user != nullptr);
+    if (const auto it = d->userMap.find(d->idPool.find(user->id()));
+        it != d->userMap.end() && QUO_CHECK(it->holds > 0))
+        --it->holds;
+}
+
+qsizetype Connection::userCacheCapacity() const { return d->userCacheCapacity; }
+
+void Connection::setUserCacheCapacity(qsizetype capacity)
+{
+    d->userCacheCapacity = std::max(capacity, qsizetype(0));
+    d->nextUserEviction = d->userCacheCapacity;
+    if (d->userCacheCapacity > 0 && d->userMap.size() > d->userCacheCapacity)
+        d->evictUsers();
+}
+
+void Connection::Private::evictUsers()
+{
+    QElapsedTimer et;
+    et.start();
+    std::vector<std::pair<quint64, InternedId>> candidates;
+    for (auto it = userMap.cbegin(); it != userMap.cend(); ++it)
+        if (it->holds == 0)
+            candidates.emplace_back(it->lastLookup, it.key());
+    std::ranges::sort(candidates, {}, &std::pair<quint64, InternedId>::first);
+
+    // Evict down to 3/4 of the capacity to make evictions rare
+    const auto targetSize = userCacheCapacity * 3 / 4;
+    const auto localUserId = data->userId();
+    const auto sizeBefore = userMap.size();
+    // Collect members of joined rooms once rather than asking every room for every candidate
+    QSet<QString> joinedMembers;
+    if (sizeBefore > targetSize)
+        for (const auto* r : std::as_const(roomMap))
+            if (r->joinState() == JoinState::Join)
+                for (const auto& memberId : r->joinedMemberIds())
+                    joinedMembers.insert(memberId);
+    for (const auto& [lastLookup, id] : candidates) {
+        if (userMap.size() <= targetSize)
+            break;
+        const auto& uId = id.toString();
+        const auto* u = userMap.value(id).user;
+        if (uId == localUserId || directChats.contains(u) || dcLocalAdditions.contains(u)
+            || dcLocalRemovals.contains(u) || joinedMembers.contains(uId))
+            continue;
+        auto* user = userMap.take(id).user;
+        emit q->aboutToDeleteUser(user);
+        user->deleteLater();
+    }
+    // If most users have to stay, don't come back until there's a good share of new ones
+    nextUserEviction = std::max(userCacheCapacity, userMap.size() + userCacheCapacity / 4);
+    qCDebug(PROFILER) << "Evicted" << sizeBefore - userMap.size() << "user object(s) out of"
+                      << sizeBefore << "in" << et;
 }
 
 User* Connection::user() { return user(userId()); }
 
 QString Connection::userId() const { return d->data->userId(); }
 
+IdPool& Connection::idPool() { return d->idPool; }
+
 Avatar& Connection::userAvatar(const QString& avatarMediaId)
 {
     return userAvatar(QUrl(avatarMediaId));
@@ -1166,41 +1372,76 @@ void Connection::setAccountData(const QString& type, const QJsonObject& content)
     d->packAndSendAccountData(loadEvent<Event>(type, content));
 }
 
-QHash<QString, QVector<Room*>> Connection::tagsToRooms() const
-{
-    QHash<QString, QVector<Room*>> result;
-    for (auto* r : std::as_const(d->roomMap)) {
-        const auto& tagNames = r->tagNames();
-        for (const auto& tagName : tagNames)
-            result[tagName].push_back(r);
-    }
-    for (auto it = result.begin(); it != result.end(); ++it)
-        std::sort(it->begin(), it->end(), [t = it.key()](Room* r1, Room* r2) {
-            return r1->tags().value(t) < r2->tags().value(t);
-        });
-    return result;
-}
+QHash<QString, QVector<Room*>> Connection::tagsToRooms() const { return d->roomsByTag; }
 
 QStringList Connection::tagNames() const
 {
     QStringList tags({ FavouriteTag });
-    for (auto* r : std::as_const(d->roomMap)) {
-        const auto& tagNames = r->tagNames();
-        for (const auto& tag : tagNames)
-            if (tag != LowPriorityTag && !tags.contains(tag))
-                tags.push_back(tag);
-    }
+    for (auto it = d->roomsByTag.cbegin(); it != d->roomsByTag.cend(); ++it)
+        if (it.key() != FavouriteTag && it.key() != LowPriorityTag)
+            tags.push_back(it.key());
+    std::sort(tags.begin() + 1, tags.end());
     tags.push_back(LowPriorityTag);
     return tags;
 }
 
 QVector<Room*> Connection::roomsWithTag(const QString& tagName) const
 {
-    QVector<Room*> rooms;
-    std::copy_if(d->roomMap.cbegin(), d->roomMap.cend(),
-                 std::back_inserter(rooms),
-                 [&tagName](Room* r) { return r->tags().contains(tagName); });
-    return rooms;
+    return d->roomsByTag.value(tagName);
+}
+
+void Connection::Private::updateTagIndex(Room* room)
+{
+    const auto newTags = room->tags();
+    auto& oldTags = indexedTags[room];
+    QStringList changedTags;
+    // Take the room out of the tags it lost or changed the order in...
+    for (auto it = oldTags.cbegin(); it != oldTags.cend(); ++it)
+        if (const auto newIt = newTags.constFind(it.key());
+            newIt == newTags.cend() || newIt->order != it->order) {
+            auto& rooms = roomsByTag[it.key()];
+            rooms.removeOne(room);
+            if (rooms.isEmpty())
+                roomsByTag.remove(it.key());
+            changedTags.push_back(it.key());
+        }
+    for (auto it = newTags.cbegin(); it != newTags.cend(); ++it)
+        if (!oldTags.contains(it.key()))
+            changedTags.push_back(it.key());
+    oldTags = newTags;
+    if (newTags.isEmpty())
+        indexedTags.remove(room);
+
+    // ...and put it back in order where it gained or changed the order
+    for (const auto& tagName : std::as_const(changedTags)) {
+        if (!newTags.contains(tagName))
+            continue;
+        const auto lessInTag = [this, &tagName](const Room* r1, const Room* r2) {
+            const auto t1 = indexedTags.constFind(r1)->value(tagName);
+            const auto t2 = indexedTags.constFind(r2)->value(tagName);
+            // Per the spec, rooms without order go last; break ties by id to keep the order
+            // stable across updates
+            if (t1.order != t2.order)
+                return t1 < t2;
+            return r1->id() != r2->id() ? r1->id() < r2->id() : std::less<>{}(r1, r2);
+        };
+        auto& rooms = roomsByTag[tagName];
+        rooms.insert(std::ranges::lower_bound(rooms, room, lessInTag), room);
+    }
+    for (const auto& tagName : std::as_const(changedTags))
+        emit q->roomsWithTagChanged(tagName);
+}
+
+void Connection::Private::dropFromTagIndex(Room* room)
+{
+    const auto oldTags = indexedTags.take(room);
+    for (auto it = oldTags.cbegin(); it != oldTags.cend(); ++it) {
+        auto& rooms = roomsByTag[it.key()];
+        rooms.removeOne(room);
+        if (rooms.isEmpty())
+            roomsByTag.remove(it.key());
+        emit q->roomsWithTagChanged(it.key());
+    }
 }
 
 DirectChatsMap Connection::directChats() const
@@ -1211,8 +1452,13 @@ DirectChatsMap Connection::directChats() const
 // Removes room with given id from roomMap
 void Connection::Private::removeRoom(const QString& roomId)
 {
+    if (eventStore)
+        eventStore->clearRoom(roomId);
+    if (searchIndex)
+        searchIndex->clearRoom(roomId);
     for (auto f : { false, true })
         if (auto r = roomMap.take({ roomId, f })) {
+            dropFromTagIndex(r);
             qCDebug(MAIN) << "Room" << r->objectName() << "in state" << terse
                           << r->joinState() << "will be deleted";
             emit r->beforeDestruction(r);
@@ -1230,29 +1476,38 @@ void Connection::addToDirectChats(const Room* room, const QString& userId)
     d->directChats.insert(u, room->id());
     d->directChatMemberIds.insert(room->id(), userId);
     d->dcLocalAdditions.insert(u, room->id());
-    emit directChatsListChanged({ { u, room->id() } }, {});
+    d->notifyDirectChatsChanged({ { u, room->id() } }, {});
 }
 
 void Connection::removeFromDirectChats(const QString& roomId, const QString& userId)
 {
     Q_ASSERT(!roomId.isEmpty());
-    const auto u = user(userId);
-    if ((!userId.isEmpty() && !d->directChats.contains(u, roomId))
-        || d->directChats.key(roomId) == nullptr)
+    const auto memberIds = d->directChatMemberIds.values(roomId);
+    if (userId.isEmpty() ? memberIds.isEmpty() : !memberIds.contains(userId))
         return;
 
     DirectChatsMap removals;
-    if (u != nullptr) {
+    for (const auto& memberId : userId.isEmpty() ? memberIds : QList{ userId }) {
+        auto* u = user(memberId);
         d->directChats.remove(u, roomId);
-        d->directChatMemberIds.remove(roomId, u->id());
+        d->directChatMemberIds.remove(roomId, memberId);
         removals.insert(u, roomId);
-        d->dcLocalRemovals.insert(u, roomId);
-    } else {
-        removals = remove_if(d->directChats,
-                            [&roomId](auto it) { return it.value() == roomId; });
-        d->dcLocalRemovals += removals;
     }
-    emit directChatsListChanged({}, removals);
+    d->dcLocalRemovals += removals;
+    d->notifyDirectChatsChanged({}, removals);
+}
+
+void Connection::Private::notifyDirectChatsChanged(const DirectChatsMap& additions,
+                                                   const DirectChatsMap& removals)
+{
+    emit q->directChatsListChanged(additions, removals);
+    QSet<QString> roomIds;
+    for (const auto& roomId : additions)
+        roomIds.insert(roomId);
+    for (const auto& roomId : removals)
+        roomIds.insert(roomId);
+    for (const auto& roomId : std::as_const(roomIds))
+        emit q->directChatMembersChanged(roomId);
 }
 
 bool Connection::isDirectChat(const QString& roomId) const
@@ -1302,7 +1557,15 @@ void Connection::removeFromIgnoredUsers(const QString& userId)
     }
 }
 
-QStringList Connection::userIds() const { return d->userMap.keys(); }
+QStringList Connection::userIds() const
+{
+    QStringList ids;
+    ids.reserve(d->userMap.size());
+    for (auto it = d->userMap.cbegin(); it != d->userMap.cend(); ++it)
+        ids.push_back(it.key().toString());
+    ids.sort(); // The list has always been sorted
+    return ids;
+}
 
 const ConnectionData* Connection::connectionData() const
 {
@@ -1344,6 +1607,7 @@ Room* Connection::provideRoom(const QString& id, std::optional<JoinState> joinSt
         d->roomMap.insert(roomKey, room);
         connect(room, &Room::beforeDestruction, this,
                 &Connection::aboutToDeleteRoom);
+        connect(room, &Room::tagsChanged, this, [this, room] { d->updateTagIndex(room); });
         connect(room, &Room::baseStateLoaded, this, [this, room] {
             emit loadedRoomState(room);
             if (d->capabilities.roomVersions)
@@ -1368,6 +1632,7 @@ Room* Connection::provideRoom(const QString& id, std::optional<JoinState> joinSt
         else if (*joinState == JoinState::Leave)
             emit leftRoom(room, prevInvite);
         if (prevInvite) {
+            d->dropFromTagIndex(prevInvite);
             for (const auto dcMembers = prevInvite->directChatMembers(); const auto& m : dcMembers)
                 addToDirectChats(room, m.id());
             qCDebug(MAIN) << "Deleting Invite state for room"
@@ -1458,6 +1723,12 @@ void Connection::saveState() const
 {
     if (!d->cacheState)
         return;
+    if (!d->pendingRoomUpdates.empty()) {
+        // The cached sync token must not run ahead of the cached room state
+        qCDebug(MAIN) << "Saving the state cache after pending room updates are applied";
+        d->saveStateDeferred = true;
+        return;
+    }
 
     QElapsedTimer et;
     et.start();
@@ -1571,6 +1842,73 @@ void Connection::setLazyLoading(bool newValue)
     }
 }
 
+SyncTimelineLimits Connection::syncTimelineLimits() const { return d->syncTimelineLimits; }
+
+void Connection::setSyncTimelineLimits(const SyncTimelineLimits& newLimits)
+{
+    d->syncTimelineLimits = newLimits;
+}
+
+int Connection::pendingRoomUpdates() const { return int(d->pendingRoomUpdates.size()); }
+
+void Connection::applyPendingRoomUpdates()
+{
+    if (!d->pendingRoomUpdates.empty())
+        d->applyRoomUpdates(std::chrono::milliseconds::zero());
+}
+
+std::chrono::milliseconds Connection::roomUpdateBudget() const { return d->roomUpdateBudget; }
+
+void Connection::setRoomUpdateBudget(std::chrono::milliseconds budget)
+{
+    d->roomUpdateBudget = budget;
+}
+
+bool Connection::eventStoreEnabled() const { return d->eventStoreEnabled; }
+
+void Connection::setEventStoreEnabled(bool newValue)
+{
+    if (d->eventStoreEnabled != newValue) {
+        d->eventStoreEnabled = newValue;
+        if (!newValue)
+            d->purgeEventStore();
+        emit eventStoreEnabledChanged();
+    }
+}
+
+EventStore* Connection::eventStore()
+{
+    if (d->eventStoreEnabled && !d->eventStore && !userId().isEmpty())
+        d->eventStore = std::make_unique<EventStore>(userId());
+    return d->eventStore.get();
+}
+
+bool Connection::searchIndexEnabled() const { return d->searchIndexEnabled; }
+
+void Connection::setSearchIndexEnabled(bool newValue)
+{
+    if (d->searchIndexEnabled != newValue) {
+        d->searchIndexEnabled = newValue;
+        if (!newValue)
+            d->purgeSearchIndex();
+        emit searchIndexEnabledChanged();
+    }
+}
+
+SearchIndex* Connection::searchIndex() const
+{
+    if (d->searchIndexEnabled && !d->searchIndex && !userId().isEmpty())
+        d->searchIndex = std::make_unique<SearchIndex>(userId());
+    return d->searchIndex.get();
+}
+
+SpaceGraph* Connection::spaceGraph()
+{
+    if (!d->spaceGraph)
+        d->spaceGraph = std::make_unique<SpaceGraph>(this);
+    return d->spaceGraph.get();
+}
+
 BaseJob* Connection::run(BaseJob* job, RunningPolicy runningPolicy)
 {
     // Reparent to protect from #397, #398 and to prevent BaseJob* from being
@@ -1581,6 +1919,32 @@ BaseJob* Connection::run(BaseJob* job, RunningPolicy runningPolicy)
     return job;
 }
 
+BaseJob* Connection::runCoalesced(BaseJob* job, RunningPolicy runningPolicy)
+{
+    if (auto* pendingJob =
+            d->data->attachToIdenticalJob(job, runningPolicy & BackgroundRequest)) {
+        delete job; // Not initiated, not even parented
+        return pendingJob;
+    }
+    return run(job, runningPolicy);
+}
+
+BaseJob* Connection::runWithResponse(BaseJob* job, QJsonDocument response)
+{
+    d->data->replayResponse(job, std::move(response));
+    return run(job);
+}
+
+void Connection::setResponseCacheTtl(std::chrono::milliseconds ttl)
+{
+    d->data->setResponseCacheTtl(ttl);
+}
+
+RequestCoalescingStats Connection::requestCoalescingStats() const
+{
+    return d->data->coalescingStats();
+}
+
 void Connection::getTurnServers()
 {
     auto job = callApi<GetTurnServerJob>();
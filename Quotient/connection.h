@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include "connectiondata.h"
 #include "keyverificationsession.h"
 #include "quotient_common.h"
 #include "ssosession.h"
@@ -24,6 +25,7 @@
 #include <QtCore/QSize>
 #include <QtCore/QUrl>
 
+#include <chrono>
 #include <functional>
 
 Q_DECLARE_METATYPE(Quotient::GetLoginFlowsJob::LoginFlow)
@@ -52,6 +54,10 @@ class SendToDeviceJob;
 class SendMessageJob;
 class LeaveRoomJob;
 class Database;
+class EventStore;
+class SearchIndex;
+class SpaceGraph;
+class IdPool;
 struct EncryptedFileMetadata;
 
 class QOlmAccount;
@@ -111,6 +117,37 @@ auto defaultUserFactory(Connection* c, const QString& id)
 using DirectChatsMap = QMultiHash<const User*, QString>;
 using IgnoredUsersList = IgnoredUsersEvent::value_type;
 
+//! \brief Numbers of timeline events to request for each room, depending on the situation
+//!
+//! A /sync filter has a single timeline limit for all rooms; Connection picks it for each sync
+//! request depending on how long the client has been away from the server. After a long break
+//! a big limit would bring many events for every room with activity, most of which will never
+//! be looked at; it's cheaper to get a few latest events and fill the gaps in the rooms that the
+//! user actually opens (see Room::fillTimelineGap()). In the steady state, when each sync only
+//! brings new events since a few seconds ago, a bigger limit avoids gaps altogether.
+struct QUOTIENT_API SyncTimelineLimits {
+    //! The limit for the very first sync of an account
+    int initialSync = 20;
+    //! The limit for the first sync in the session and syncs after a long break
+    int catchUp = 20;
+    //! The limit for syncs following each other
+    int steadyState = 100;
+    //! The time since the previous sync that counts as a long break
+    std::chrono::seconds catchUpAfter = std::chrono::minutes(15);
+    //! The number of events to load when filling a timeline gap
+    int gapFill = 50;
+    //! \brief Overrides of \p gapFill by room type
+    //!
+    //! The keys are room types as specified in the `m.room.create` event; an empty string stands
+    //! for rooms without a type (normal chat rooms).
+    QHash<QString, int> gapFillByRoomType{};
+
+    int gapFillLimit(const QString& roomType) const
+    {
+        return gapFillByRoomType.value(roomType, gapFill);
+    }
+};
+
 class QUOTIENT_API Connection : public QObject {
     Q_OBJECT
 
@@ -128,6 +165,8 @@ class QUOTIENT_API Connection : public QObject {
     Q_PROPERTY(bool supportsPasswordAuth READ supportsPasswordAuth NOTIFY loginFlowsChanged STORED false)
     Q_PROPERTY(bool cacheState READ cacheState WRITE setCacheState NOTIFY cacheStateChanged)
     Q_PROPERTY(bool lazyLoading READ lazyLoading WRITE setLazyLoading NOTIFY lazyLoadingChanged)
+    Q_PROPERTY(bool eventStoreEnabled READ eventStoreEnabled WRITE setEventStoreEnabled NOTIFY eventStoreEnabledChanged)
+    Q_PROPERTY(bool searchIndexEnabled READ searchIndexEnabled WRITE setSearchIndexEnabled NOTIFY searchIndexEnabledChanged)
     Q_PROPERTY(bool canChangePassword READ canChangePassword NOTIFY capabilitiesLoaded)
     Q_PROPERTY(bool encryptionEnabled READ encryptionEnabled WRITE enableEncryption NOTIFY encryptionChanged)
     Q_PROPERTY(bool directChatEncryptionEnabled READ directChatEncryptionEnabled WRITE enableDirectChatEncryption NOTIFY directChatsEncryptionChanged)
@@ -221,12 +260,18 @@ public:
     //! \return a hashmap from tag name to a vector of room pointers,
     //!         sorted by their order in the tag - details are at
     //!         https://spec.matrix.org/v1.5/client-server-api/#room-tagging
+    //! \note The grouping is maintained as tags change, so this is cheap to call
+    //! \sa roomsWithTagChanged
     QHash<QString, QVector<Room*>> tagsToRooms() const;
 
-    //! Get all room tags known on this connection
+    //! \brief Get all room tags known on this connection
+    //!
+    //! The favourite tag always goes first and the low priority tag always goes last; other
+    //! tags are sorted by name.
     QStringList tagNames() const;
 
-    //! Get the list of rooms with the specified tag
+    //! Get the list of rooms with the specified tag, sorted by their order in the tag
+    //! \sa tagsToRooms, roomsWithTagChanged
     QVector<Room*> roomsWithTag(const QString& tagName) const;
 
     //! \brief Mark the room as a direct chat with the user
@@ -251,13 +296,16 @@ public:
     //! Check whether the room id corresponds to a direct chat
     bool isDirectChat(const QString& roomId) const;
 
-    //! Get the whole map from users to direct chat rooms
+    //! \brief Get the whole map from users to direct chat rooms
+    //!
+    //! To check a particular room, isDirectChat() and directChatMemberIds() are faster.
     DirectChatsMap directChats() const;
 
     //! \brief Retrieve the list of member IDs the room is a direct chat with
     //!
     //! \return The list of member IDs for which this room is marked as
     //!         a direct chat; an empty list if the room is not a direct chat
+    //! \sa directChatMembersChanged
     QList<QString> directChatMemberIds(const Room* room) const;
 
     //! Check whether a particular user id is in the ignore list
@@ -318,11 +366,42 @@ public:
                            const QStringList& previousRoomAliases,
                            const QStringList& roomAliases);
     Q_INVOKABLE Quotient::Room* invitation(const QString& roomId) const;
+    //! \brief Get the user object for \p uId, creating it if necessary
+    //!
+    //! \warning With a user cache capacity set, the returned object may get deleted once
+    //!          the user is not used for a while; see setUserCacheCapacity()
     Q_INVOKABLE Quotient::User* user(const QString& uId);
     const User* user() const;
     User* user();
     QString userId() const;
 
+    //! \brief Keep the user object from being evicted from the user cache
+    //!
+    //! Calls to this function are counted; the user can be evicted again after the same number
+    //! of releaseUser() calls.
+    void holdUser(const User* user);
+    void releaseUser(const User* user);
+
+    //! \brief The maximum number of user objects kept around
+    //! \sa setUserCacheCapacity
+    qsizetype userCacheCapacity() const;
+
+    //! \brief Limit the number of user objects kept around
+    //!
+    //! By default, every user object obtained from user() lives as long as the connection does.
+    //! Accounts that see a lot of different users (such as bots in big federated rooms) can set
+    //! a capacity; once the number of user objects reaches it, the least recently looked up ones
+    //! are deleted, except those held with holdUser(), members of joined rooms, users taking
+    //! part in direct chats and the local user. Pointers to deleted users become invalid;
+    //! aboutToDeleteUser() is emitted for each of them. Pass 0 to remove the limit.
+    void setUserCacheCapacity(qsizetype capacity);
+
+    //! \brief The pool of user, room and event identifiers used by this connection
+    //!
+    //! Rooms and the connection itself key their lookup tables with handles from this pool,
+    //! to avoid storing copies of the same identifier in each of them.
+    IdPool& idPool();
+
     //! \brief Get an avatar object for the given user ID and media ID
     Avatar& userAvatar(const QUrl& avatarUrl);
 
@@ -495,6 +574,62 @@ public:
     bool lazyLoading() const;
     void setLazyLoading(bool newValue);
 
+    //! \brief Timeline limits used for syncing and filling timeline gaps
+    //!
+    //! Each distinct sync filter is uploaded to the homeserver once; its id is remembered in
+    //! the account settings and reused by further syncs, including those in later sessions.
+    //! \sa SyncTimelineLimits
+    SyncTimelineLimits syncTimelineLimits() const;
+    void setSyncTimelineLimits(const SyncTimelineLimits& newLimits);
+
+    //! \brief The number of room updates received from the server and not applied yet
+    //!
+    //! Room updates from sync responses are applied in time slices of roomUpdateBudget()
+    //! each, so that the event loop stays responsive while catching up; rooms that are
+    //! displayed at the moment go first.
+    //! \sa syncApplied, roomUpdatesProgress
+    int pendingRoomUpdates() const;
+    //! Apply all pending room updates at once, without yielding to the event loop
+    Q_INVOKABLE void applyPendingRoomUpdates();
+
+    //! \brief The time to spend on applying room updates per event loop iteration
+    //!
+    //! A large room update may still overshoot the budget by a few dozen events;
+    //! a zero budget means applying all updates at once. The default is 8 ms.
+    std::chrono::milliseconds roomUpdateBudget() const;
+    void setRoomUpdateBudget(std::chrono::milliseconds budget);
+
+    //! \brief Whether timeline events are persisted locally
+    //!
+    //! When enabled, events received from /sync and /messages are stored in the event store
+    //! (see EventStore) and Room::getPreviousContent() serves history from it before going to
+    //! the network. Disabled by default; the store is deleted from the disk when disabled and
+    //! on logout (see also EventStore::purge()).
+    bool eventStoreEnabled() const;
+    void setEventStoreEnabled(bool newValue);
+
+    //! The local event store, or nullptr if it is disabled or the connection is not ready yet
+    EventStore* eventStore();
+
+    //! \brief Whether messages in encrypted rooms are indexed locally for searching
+    //!
+    //! When enabled, messages of encrypted rooms are added to the search index (see SearchIndex)
+    //! as they get decrypted, and MessageSearch uses the index for these rooms since the server
+    //! cannot search them. The index keeps the words of the messages on the disk unencrypted;
+    //! therefore it is disabled by default, and is deleted from the disk when disabled
+    //! and on logout (see also SearchIndex::purge()).
+    bool searchIndexEnabled() const;
+    void setSearchIndexEnabled(bool newValue);
+
+    //! The local search index, or nullptr if it is disabled or the connection is not ready yet
+    SearchIndex* searchIndex() const;
+
+    //! \brief The cache of space hierarchies seen by this connection
+    //!
+    //! The graph is created on the first call and lives as long as the connection; it is kept
+    //! up to date with the `m.space.child` and `m.space.parent` state of joined rooms.
+    SpaceGraph* spaceGraph();
+
     //! Start a pre-created job object on this connection
     Q_INVOKABLE BaseJob* run(BaseJob* job, RunningPolicy runningPolicy = ForegroundRequest);
 
@@ -538,6 +673,68 @@ public:
         return callApi<JobT>(ForegroundRequest, std::forward<JobArgTs>(jobArgs)...);
     }
 
+    //! \brief Start a pre-created job, or attach to an identical one that is already pending
+    //!
+    //! If \p job is a GET request and an identical request (same job type, endpoint and query)
+    //! is already in flight on this connection, \p job is deleted and the pending job is returned
+    //! instead; otherwise, \p job is run as per run(BaseJob*, RunningPolicy). Since the returned
+    //! job can be shared, abandon it through a JobHandle to only detach the caller (see
+    //! JobHandle::abandon()); continuations should be bound to a context object that outlives
+    //! them. A foreground request attaching to a background one turns it into a foreground
+    //! request.
+    //! \sa callApiCoalesced, setResponseCacheTtl
+    BaseJob* runCoalesced(BaseJob* job, RunningPolicy runningPolicy = ForegroundRequest);
+
+    //! \brief Start a job of a given type, or attach to an identical pending one
+    //!
+    //! This is the coalescing counterpart of callApi(): several callers requesting
+    //! the same resource concurrently will get handles to the same job object, and only
+    //! one network request will be made. Each caller gets a JobHandle with a future of its own,
+    //! so continuations attached by one caller don't interfere with those of another.
+    //! \sa runCoalesced
+    template <typename JobT, typename... JobArgTs>
+    JobHandle<JobT> callApiCoalesced(RunningPolicy runningPolicy, JobArgTs&&... jobArgs)
+    {
+        return static_cast<JobT*>(
+            runCoalesced(new JobT(std::forward<JobArgTs>(jobArgs)...), runningPolicy));
+    }
+
+    //! \brief Start a job of a given type, or attach to an identical pending one
+    //!
+    //! This is an overload that runs the job with "foreground" policy.
+    template <typename JobT, typename... JobArgTs>
+    JobHandle<JobT> callApiCoalesced(JobArgTs&&... jobArgs)
+    {
+        return callApiCoalesced<JobT>(ForegroundRequest, std::forward<JobArgTs>(jobArgs)...);
+    }
+
+    //! \brief Start a pre-created job that completes with a known response
+    //!
+    //! This is used to serve requests from local storage without changing the job-based
+    //! interface for the caller: \p job goes through the usual lifecycle except that no network
+    //! request is made, and \p response is processed as if it came from the server.
+    //! \sa callApiWithResponse
+    BaseJob* runWithResponse(BaseJob* job, QJsonDocument response);
+
+    //! \brief Start a job of a given type that completes with a known response
+    //! \sa runWithResponse
+    template <typename JobT, typename... JobArgTs>
+    JobHandle<JobT> callApiWithResponse(QJsonDocument response, JobArgTs&&... jobArgs)
+    {
+        return static_cast<JobT*>(runWithResponse(new JobT(std::forward<JobArgTs>(jobArgs)...),
+                                                  std::move(response)));
+    }
+
+    //! \brief Keep successful responses to coalesced requests for a short time
+    //!
+    //! With a non-zero \p ttl, requests started with callApiCoalesced() within \p ttl after
+    //! an identical one has succeeded are served from memory instead of the network.
+    //! \sa ConnectionData::setResponseCacheTtl
+    void setResponseCacheTtl(std::chrono::milliseconds ttl);
+
+    //! Get the counters of requests sent and saved by coalescing and caching
+    RequestCoalescingStats requestCoalescingStats() const;
+
     //! \brief Get a request URL for a job with specified type and arguments
     //!
     //! This calls JobT::makeRequestUrl() prepending the connection's homeserver
@@ -807,11 +1004,25 @@ Q_SIGNALS:
     void networkError(QString message, QString details, int retriesTaken,
                       int nextRetryInMilliseconds);
 
+    //! \brief A sync response has been received and processed
+    //!
+    //! Room updates from the response may still be pending at this point.
+    //! \sa syncApplied
     void syncDone();
     void syncError(QString message, QString details);
+    //! \brief Room updates are being applied to rooms
+    //! \param applied the number of room updates applied so far
+    //! \param total the number of room updates received since the last syncApplied()
+    void roomUpdatesProgress(int applied, int total);
+    //! All room updates from sync responses (or the state cache) have been applied
+    void syncApplied();
 
     void newUser(Quotient::User* user);
 
+    //! \brief The user object is about to be deleted to keep the user cache within capacity
+    //! \sa setUserCacheCapacity
+    void aboutToDeleteUser(Quotient::User* user);
+
     //! \group Signals emitted on room transitions
     //!
     //! Note: Rooms in Invite state are always stored separately from
@@ -908,11 +1119,26 @@ Q_SIGNALS:
     void directChatsListChanged(Quotient::DirectChatsMap additions,
                                 Quotient::DirectChatsMap removals);
 
+    //! \brief The users the room is a direct chat with have changed
+    //!
+    //! This is emitted after directChatsListChanged() for each room in the change.
+    //! \sa directChatMemberIds, isDirectChat
+    void directChatMembersChanged(QString roomId);
+
+    //! \brief The rooms with the tag, or their order in it, have changed
+    //!
+    //! Unlike Room::tagsChanged(), this is only emitted for the tags a room has been added to,
+    //! removed from, or moved within.
+    //! \sa roomsWithTag, tagsToRooms
+    void roomsWithTagChanged(QString tagName);
+
     void ignoredUsersListChanged(Quotient::IgnoredUsersList additions,
                                  Quotient::IgnoredUsersList removals);
 
     void cacheStateChanged();
     void lazyLoadingChanged();
+    void eventStoreEnabledChanged();
+    void searchIndexEnabledChanged();
     void turnServersChanged(const QJsonObject& servers);
     void devicesListLoaded();
 
@@ -939,6 +1165,8 @@ Q_SIGNALS:
     void ready();
 
     friend class ::TestCrossSigning;
+    friend void syncMockConnection(Connection* connection, SyncData&& data); // for autotests
+    friend class SlidingSync; // to feed its responses to onSyncSuccess()
 protected:
     //! Access the underlying ConnectionData class
     const ConnectionData* connectionData() const;
@@ -8,6 +8,10 @@
 #include "connection.h"
 #include "connectiondata.h"
 #include "connectionencryptiondata_p.h"
+#include "eventstore.h"
+#include "searchindex.h"
+#include "spacegraph.h"
+#include "idpool.h"
 #include "settings.h"
 #include "syncdata.h"
 
@@ -18,6 +22,11 @@
 #include "csapi/wellknown.h"
 
 #include <QtCore/QCoreApplication>
+#include <QtCore/QPointer>
+#include <QtCore/QSet>
+#include <QtCore/QTimer>
+
+#include <deque>
 
 namespace Quotient {
 
@@ -39,16 +48,33 @@ public:
     QHash<QString, QString> roomAliasMap;
     QVector<QString> roomIdsToForget;
     QVector<QString> pendingStateRoomIds;
-    // It's an ordered map to make Connection::userIds() return an already sorted list
-    QMap<QString, User*> userMap;
+    IdPool idPool;
+    struct UserEntry {
+        User* user = nullptr;
+        //! The value of userLookups when the user was last looked up
+        quint64 lastLookup = 0;
+        //! The number of Connection::holdUser() calls not balanced by releaseUser() yet
+        int holds = 0;
+    };
+    QHash<InternedId, UserEntry> userMap;
+    quint64 userLookups = 0;
+    //! The maximum number of users in userMap; 0 means no limit
+    qsizetype userCacheCapacity = 0;
+    //! The size of userMap at which the least recently used users get evicted
+    qsizetype nextUserEviction = 0;
     std::unordered_map<QString, Avatar> userAvatarMap;
     DirectChatsMap directChats;
+    //! The reverse of directChats: ids of users each direct chat room is with
     QMultiHash<QString, QString> directChatMemberIds;
     // The below two variables track local changes between sync completions.
     // See https://github.com/quotient-im/libQuotient/wiki/Handling-direct-chat-events
     DirectChatsMap dcLocalAdditions;
     DirectChatsMap dcLocalRemovals;
     std::unordered_map<QString, EventPtr> accountData;
+    //! Rooms of roomMap with each tag, in the order of the tag (see Connection::tagsToRooms)
+    QHash<QString, QVector<Room*>> roomsByTag;
+    //! Tags of each room as they are accounted in roomsByTag
+    QHash<const Room*, TagsMap> indexedTags;
     QMetaObject::Connection syncLoopConnection {};
     int syncTimeout = -1;
 
@@ -75,6 +101,41 @@ public:
                                             SettingsGroup("libQMatrixClient"_L1).get<QString>("cache_type"_L1))
         != "json"_L1;
     bool lazyLoading = false;
+    SyncTimelineLimits syncTimelineLimits{};
+    //! Wall clock time of the last successful sync in this session; 0 if there was none yet
+    qint64 lastSyncTimeMs = 0;
+    //! Ids of filters defined on the server, by their compact JSON
+    QHash<QByteArray, QString> syncFilterIds;
+    QSet<QByteArray> syncFiltersBeingDefined;
+    bool eventStoreEnabled = false;
+    std::unique_ptr<EventStore> eventStore;
+    bool searchIndexEnabled = false;
+    std::unique_ptr<SearchIndex> searchIndex;
+    std::unique_ptr<SpaceGraph> spaceGraph;
+
+    //! Sync data waiting to be applied to a room
+    struct PendingRoomUpdate {
+        QPointer<Room> room;
+        SyncRoomData data;
+        bool fromCache;
+    };
+    //! Room updates from sync responses that are not applied yet, in the order of arrival
+    std::deque<PendingRoomUpdate> pendingRoomUpdates;
+    //! Fires on the next event loop iteration to apply another slice of pendingRoomUpdates
+    QTimer roomUpdateTimer;
+    std::chrono::milliseconds roomUpdateBudget{ 8 };
+    //! The most state or timeline events applied to a room in one go
+    static constexpr size_t MaxEventsPerRoomUpdateChunk = 100;
+    //! Room updates applied and queued since pendingRoomUpdates was last empty
+    int roomUpdatesApplied = 0;
+    int roomUpdatesTotal = 0;
+    //! Statistics on the time slices taken to apply the current batch of room updates
+    int roomUpdateSlices = 0;
+    qint64 longestRoomUpdateSliceMs = 0;
+    qint64 roomUpdatesTimeMs = 0;
+    bool applyingRoomUpdates = false;
+    //! saveState() was called while room updates were still pending
+    bool saveStateDeferred = false;
 
     //! \brief Check the homeserver and resolve it if needed, before connecting
     //!
@@ -97,8 +158,38 @@ public:
                        const std::optional<QString>& deviceId = {},
                        const std::optional<QString>& accessToken = {});
     void removeRoom(const QString& roomId);
+    //! \brief Delete the least recently used users until userMap is well below the capacity
+    //!
+    //! Users that are held, are members of joined rooms, or take part in direct chats (including
+    //! not yet sent changes to them) are never evicted, as well as the local user.
+    void evictUsers();
+    //! Bring roomsByTag in line with the current tags of \p room
+    void updateTagIndex(Room* room);
+    //! Remove \p room from roomsByTag, before it's removed from roomMap
+    void dropFromTagIndex(Room* room);
+    //! \brief Notify about changes in direct chats
+    //!
+    //! Emits directChatsListChanged() for the whole change, and directChatMembersChanged() for
+    //! each room in it.
+    void notifyDirectChatsChanged(const DirectChatsMap& additions,
+                                  const DirectChatsMap& removals);
+
+    int nextSyncTimelineLimit() const;
+    //! \brief The filter to pass to the next sync request
+    //!
+    //! \return the id of the filter if it is already defined on the server; otherwise, the filter
+    //!         JSON to use inline while the filter is uploaded in the background
+    QString syncFilter();
+    //! Drop the filter id that the server doesn't recognise anymore
+    void forgetSyncFilter(const QString& filterId);
 
     void consumeRoomData(SyncDataList&& roomDataList, bool fromCache);
+    //! \brief Apply pending room updates, taking roughly \p budget of time
+    //!
+    //! Rooms displayed to the user are updated first; large updates are applied in chunks
+    //! so that a single room doesn't take the whole budget. A zero budget means applying
+    //! all pending updates at once.
+    void applyRoomUpdates(std::chrono::milliseconds budget);
     void consumeAccountData(Events&& accountDataEvents);
     void consumePresenceData(Events&& presenceData);
     void consumeToDeviceEvents(Events&& toDeviceEvents);
@@ -125,5 +216,9 @@ public:
 
     void saveAccessTokenToKeychain() const;
     void dropAccessToken();
+    //! Close the event store and delete it from the disk
+    void purgeEventStore();
+    //! Close the search index and delete it from the disk
+    void purgeSearchIndex();
 };
 } // namespace Quotient
@@ -9,11 +9,13 @@
 
 #include "jobs/basejob.h"
 
+#include <QtCore/QDeadlineTimer>
 #include <QtCore/QPointer>
 #include <QtCore/QTimer>
 
 #include <array>
 #include <queue>
+#include <typeinfo>
 
 using namespace Quotient;
 
@@ -39,6 +41,39 @@ public:
     using job_queue_t = std::queue<QPointer<BaseJob>>;
     std::array<job_queue_t, 2> jobs; // 0 - foreground, 1 - background
     QTimer rateLimiter;
+
+    // Coalescing of identical GET requests, see attachToIdenticalJob()
+    struct CachedResponse {
+        QJsonDocument json;
+        QDeadlineTimer expiry;
+    };
+    QHash<QByteArray, QPointer<BaseJob>> coalescingJobs;
+    QHash<QByteArray, CachedResponse> responseCache;
+    QHash<BaseJob*, QJsonDocument> pendingReplays;
+    std::chrono::milliseconds responseCacheTtl{ 0 };
+    RequestCoalescingStats coalescingStats;
+
+    void promoteToForeground(BaseJob* job)
+    {
+        job->promoteToForeground();
+        // Move the job to the foreground queue if it's waiting in the background one
+        job_queue_t backgroundJobs;
+        bool queued = false;
+        for (auto& q = jobs.back(); !q.empty(); q.pop())
+            if (q.front() == job)
+                queued = true;
+            else
+                backgroundJobs.push(q.front());
+        jobs.back() = std::move(backgroundJobs);
+        if (queued)
+            jobs.front().emplace(job);
+    }
+
+    void cacheResponse(const QByteArray& key, const QJsonDocument& json)
+    {
+        responseCache.removeIf([](const auto& it) { return it.value().expiry.hasExpired(); });
+        responseCache.insert(key, { json, QDeadlineTimer(responseCacheTtl) });
+    }
 };
 
 ConnectionData::ConnectionData(QUrl baseUrl)
@@ -81,6 +116,11 @@ ConnectionData::~ConnectionData()
 void ConnectionData::submit(BaseJob* job)
 {
     job->setStatus(BaseJob::Pending);
+    if (const auto it = d->pendingReplays.constFind(job); it != d->pendingReplays.cend()) {
+        qCDebug(JOBS) << job << "is served locally";
+        job->forceResult(*it);
+        return;
+    }
     if (!d->rateLimiter.isActive()) {
         QTimer::singleShot(0, job, &BaseJob::sendRequest);
         return;
@@ -91,6 +131,14 @@ void ConnectionData::submit(BaseJob* job)
                   << "queues";
 }
 
+void ConnectionData::replayResponse(BaseJob* job, QJsonDocument response)
+{
+    // The job will still go through initiate() and submit(), see the latter
+    d->pendingReplays.insert(job, std::move(response));
+    QObject::connect(job, &BaseJob::finished, job,
+                     [this](BaseJob* j) { d->pendingReplays.remove(j); });
+}
+
 void ConnectionData::limitRate(std::chrono::milliseconds nextCallAfter)
 {
     qCDebug(MAIN) << "Jobs for" << (d->userId + u'/' + d->deviceId)
@@ -98,6 +146,54 @@ void ConnectionData::limitRate(std::chrono::milliseconds nextCallAfter)
     d->rateLimiter.start(nextCallAfter);
 }
 
+BaseJob* ConnectionData::attachToIdenticalJob(BaseJob* job, bool inBackground)
+{
+    const auto key = job->coalescingKey();
+    if (key.isEmpty())
+        return nullptr;
+
+    if (auto* pendingJob = d->coalescingJobs.value(key).data();
+        isJobPending(pendingJob) && typeid(*pendingJob) == typeid(*job)) {
+        pendingJob->addSharer();
+        if (pendingJob->isBackground() && !inBackground)
+            d->promoteToForeground(pendingJob);
+        ++d->coalescingStats.attached;
+        qCDebug(JOBS) << "Attaching to pending" << pendingJob << "instead of sending" << job;
+        return pendingJob;
+    }
+
+    if (const auto it = d->responseCache.constFind(key); it != d->responseCache.cend()) {
+        if (!it->expiry.hasExpired()) {
+            replayResponse(job, it->json);
+            ++d->coalescingStats.cached;
+            return nullptr;
+        }
+        d->responseCache.erase(it);
+    }
+
+    d->coalescingJobs.insert(key, job);
+    ++d->coalescingStats.sent;
+    QObject::connect(job, &BaseJob::finished, job, [this, key](BaseJob* j) {
+        if (d->coalescingJobs.value(key) == j)
+            d->coalescingJobs.remove(key);
+        if (d->responseCacheTtl > std::chrono::milliseconds::zero() && j->status().good()
+            && !j->jsonResponse().isNull())
+            d->cacheResponse(key, j->jsonResponse());
+    });
+    return nullptr;
+}
+
+void ConnectionData::setResponseCacheTtl(std::chrono::milliseconds ttl)
+{
+    d->responseCacheTtl = ttl;
+    if (ttl <= std::chrono::milliseconds::zero())
+        d->responseCache.clear();
+}
+
+std::chrono::milliseconds ConnectionData::responseCacheTtl() const { return d->responseCacheTtl; }
+
+RequestCoalescingStats ConnectionData::coalescingStats() const { return d->coalescingStats; }
+
 QByteArray ConnectionData::accessToken() const { return d->accessToken; }
 
 QUrl ConnectionData::baseUrl() const { return d->baseUrl; }
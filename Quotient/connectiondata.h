@@ -6,6 +6,7 @@
 
 #include "util.h"
 
+#include <QtCore/QJsonDocument>
 #include <QtCore/QUrl>
 
 #include <chrono>
@@ -15,6 +16,15 @@ namespace Quotient {
 class NetworkAccessManager;
 class BaseJob;
 
+//! Counters of GET requests that went through the coalescing layer of ConnectionData
+struct QUOTIENT_API RequestCoalescingStats {
+    quint64 sent = 0; //!< Requests actually sent to the server
+    quint64 attached = 0; //!< Requests attached to an identical pending request
+    quint64 cached = 0; //!< Requests served from the short-lived response cache
+
+    quint64 saved() const { return attached + cached; }
+};
+
 class QUOTIENT_API ConnectionData {
 public:
     explicit ConnectionData(QUrl baseUrl);
@@ -24,6 +34,34 @@ public:
     void submit(BaseJob* job);
     void limitRate(std::chrono::milliseconds nextCallAfter);
 
+    //! \brief Find a pending request identical to \p job and share it
+    //!
+    //! If a GET request of the same type, with the same endpoint and query is already pending,
+    //! it is returned, and \p job should be disposed of by the caller without initiating it.
+    //! Otherwise, \p job is remembered for identical requests coming later to attach to, and
+    //! nullptr is returned; if the response cache has a fresh response for \p job, it will be
+    //! replayed instead of sending the request once the job is submitted. A pending background
+    //! request that a foreground request (\p inBackground is false) attaches to becomes
+    //! a foreground one.
+    //! \sa BaseJob::coalescingKey, setResponseCacheTtl
+    BaseJob* attachToIdenticalJob(BaseJob* job, bool inBackground);
+
+    //! \brief Complete \p job with \p response instead of sending its request
+    //!
+    //! The job still goes through the usual lifecycle (initiation, submission, result
+    //! processing and signals); only the network exchange is skipped. This must be called
+    //! before the job is submitted.
+    void replayResponse(BaseJob* job, QJsonDocument response);
+
+    //! \brief Set how long successful responses to coalesced requests are kept around
+    //!
+    //! The default is 0 which disables caching altogether; only pending requests are coalesced
+    //! then. Keep this value short (a few seconds) - there's no invalidation mechanism
+    //! other than expiry.
+    void setResponseCacheTtl(std::chrono::milliseconds ttl);
+    std::chrono::milliseconds responseCacheTtl() const;
+    RequestCoalescingStats coalescingStats() const;
+
     QByteArray accessToken() const;
     QUrl baseUrl() const;
     const QString& deviceId() const;
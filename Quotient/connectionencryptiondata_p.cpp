@@ -322,6 +322,8 @@ void ConnectionEncryptionData::loadOutdatedUserDevices()
 
         emit q->finishedQueryingKeys();
     });
+    // Responses for large accounts can be megabytes of device keys
+    currentQueryKeysJob->setDirectJsonDecoding();
 }
 
 void ConnectionEncryptionData::consumeToDeviceEvent(EventPtr toDeviceEvent)
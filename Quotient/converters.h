@@ -13,6 +13,7 @@
 #include <QtCore/QUrlQuery>
 #include <QtCore/QVector>
 
+#include <tuple>
 #include <type_traits>
 #include <vector>
 #include <array>
@@ -42,6 +43,22 @@ struct JsonObjectConverter;
 // Specialisations should implement either or both of:
 //static void dumpTo(QJsonObject&, const T&); // For toJson() and fillJson() to work
 //static void fillFrom(const QJsonObject&, T&); // For fromJson() and fillFromJson() to work
+// and may additionally define a compile-time field table for readJson() (see JsonReader):
+//static constexpr std::tuple fields { JsonField{ "key"_L1, &T::member }, ... };
+
+//! \brief A data member for a key in a compile-time field table
+//!
+//! Field tables let readJson() fill structures directly from JSON text, without building
+//! a QJsonObject first. Keys are matched as they are, without unescaping or case folding.
+template <typename StructT, typename FieldT>
+struct JsonField {
+    QLatin1StringView key;
+    FieldT StructT::*member;
+};
+
+//! An entry in a compile-time field table referring to the table of a parent structure
+template <typename ParentT>
+struct JsonParent {};
 
 template <typename PodT, typename JsonT>
 PodT fromJson(const JsonT&);
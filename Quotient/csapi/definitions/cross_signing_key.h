@@ -40,6 +40,14 @@ struct JsonObjectConverter<CrossSigningKey> {
         fillFromJson(jo.value("keys"_L1), pod.keys);
         fillFromJson(jo.value("signatures"_L1), pod.signatures);
     }
+
+    using PodT = CrossSigningKey;
+    static constexpr std::tuple fields{
+        JsonField{ "user_id"_L1, &PodT::userId },
+        JsonField{ "usage"_L1, &PodT::usage },
+        JsonField{ "keys"_L1, &PodT::keys },
+        JsonField{ "signatures"_L1, &PodT::signatures }
+    };
 };
 
 } // namespace Quotient
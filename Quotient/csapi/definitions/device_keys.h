@@ -49,6 +49,15 @@ struct JsonObjectConverter<DeviceKeys> {
         fillFromJson(jo.value("keys"_L1), pod.keys);
         fillFromJson(jo.value("signatures"_L1), pod.signatures);
     }
+
+    using PodT = DeviceKeys;
+    static constexpr std::tuple fields{
+        JsonField{ "user_id"_L1, &PodT::userId },
+        JsonField{ "device_id"_L1, &PodT::deviceId },
+        JsonField{ "algorithms"_L1, &PodT::algorithms },
+        JsonField{ "keys"_L1, &PodT::keys },
+        JsonField{ "signatures"_L1, &PodT::signatures }
+    };
 };
 
 } // namespace Quotient
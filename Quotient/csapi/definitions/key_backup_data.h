@@ -39,6 +39,14 @@ struct JsonObjectConverter<KeyBackupData> {
         fillFromJson(jo.value("is_verified"_L1), pod.isVerified);
         fillFromJson(jo.value("session_data"_L1), pod.sessionData);
     }
+
+    using PodT = KeyBackupData;
+    static constexpr std::tuple fields{
+        JsonField{ "first_message_index"_L1, &PodT::firstMessageIndex },
+        JsonField{ "forwarded_count"_L1, &PodT::forwardedCount },
+        JsonField{ "is_verified"_L1, &PodT::isVerified },
+        JsonField{ "session_data"_L1, &PodT::sessionData }
+    };
 };
 
 } // namespace Quotient
@@ -71,6 +71,20 @@ struct JsonObjectConverter<PublicRoomsChunk> {
         fillFromJson(jo.value("join_rule"_L1), pod.joinRule);
         fillFromJson(jo.value("room_type"_L1), pod.roomType);
     }
+
+    using PodT = PublicRoomsChunk;
+    static constexpr std::tuple fields{
+        JsonField{ "num_joined_members"_L1, &PodT::numJoinedMembers },
+        JsonField{ "room_id"_L1, &PodT::roomId },
+        JsonField{ "world_readable"_L1, &PodT::worldReadable },
+        JsonField{ "guest_can_join"_L1, &PodT::guestCanJoin },
+        JsonField{ "canonical_alias"_L1, &PodT::canonicalAlias },
+        JsonField{ "name"_L1, &PodT::name },
+        JsonField{ "topic"_L1, &PodT::topic },
+        JsonField{ "avatar_url"_L1, &PodT::avatarUrl },
+        JsonField{ "join_rule"_L1, &PodT::joinRule },
+        JsonField{ "room_type"_L1, &PodT::roomType }
+    };
 };
 
 } // namespace Quotient
@@ -23,6 +23,9 @@ struct JsonObjectConverter<RoomKeyBackup> {
     {
         fillFromJson(jo.value("sessions"_L1), pod.sessions);
     }
+
+    using PodT = RoomKeyBackup;
+    static constexpr std::tuple fields{ JsonField{ "sessions"_L1, &PodT::sessions } };
 };
 
 } // namespace Quotient
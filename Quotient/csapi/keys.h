@@ -189,8 +189,22 @@ public:
     };
 };
 
+template <>
+struct JsonObjectConverter<QueryKeysJob::Response> {
+    using PodT = QueryKeysJob::Response;
+    static constexpr std::tuple fields{
+        JsonField{ "failures"_L1, &PodT::failures },
+        JsonField{ "device_keys"_L1, &PodT::deviceKeys },
+        JsonField{ "master_keys"_L1, &PodT::masterKeys },
+        JsonField{ "self_signing_keys"_L1, &PodT::selfSigningKeys },
+        JsonField{ "user_signing_keys"_L1, &PodT::userSigningKeys }
+    };
+};
+
 template <std::derived_from<QueryKeysJob> JobT>
 constexpr inline auto doCollectResponse<JobT> = [](JobT* j) -> QueryKeysJob::Response {
+    if (j->directJsonDecoding()) // Decode everything in one pass
+        return fromJsonBytes<QueryKeysJob::Response>(j->rawData());
     return { j->failures(), j->deviceKeys(), j->masterKeys(), j->selfSigningKeys(),
              j->userSigningKeys() };
 };
@@ -201,6 +215,11 @@ struct QUOTIENT_API JsonObjectConverter<QueryKeysJob::UnsignedDeviceInfo> {
     {
         fillFromJson(jo.value("device_display_name"_L1), result.deviceDisplayName);
     }
+
+    using PodT = QueryKeysJob::UnsignedDeviceInfo;
+    static constexpr std::tuple fields{
+        JsonField{ "device_display_name"_L1, &PodT::deviceDisplayName }
+    };
 };
 
 template <>
@@ -210,6 +229,12 @@ struct QUOTIENT_API JsonObjectConverter<QueryKeysJob::DeviceInformation> {
         fillFromJson<DeviceKeys>(jo, result);
         fillFromJson(jo.value("unsigned"_L1), result.unsignedData);
     }
+
+    using PodT = QueryKeysJob::DeviceInformation;
+    static constexpr std::tuple fields{
+        JsonParent<DeviceKeys>{},
+        JsonField{ "unsigned"_L1, &PodT::unsignedData }
+    };
 };
 
 //! \brief Claim one-time encryption keys.
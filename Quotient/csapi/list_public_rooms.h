@@ -128,8 +128,21 @@ public:
     };
 };
 
+template <>
+struct JsonObjectConverter<GetPublicRoomsJob::Response> {
+    using PodT = GetPublicRoomsJob::Response;
+    static constexpr std::tuple fields{
+        JsonField{ "chunk"_L1, &PodT::chunk },
+        JsonField{ "next_batch"_L1, &PodT::nextBatch },
+        JsonField{ "prev_batch"_L1, &PodT::prevBatch },
+        JsonField{ "total_room_count_estimate"_L1, &PodT::totalRoomCountEstimate }
+    };
+};
+
 template <std::derived_from<GetPublicRoomsJob> JobT>
 constexpr inline auto doCollectResponse<JobT> = [](JobT* j) -> GetPublicRoomsJob::Response {
+    if (j->directJsonDecoding()) // Decode everything in one pass
+        return fromJsonBytes<GetPublicRoomsJob::Response>(j->rawData());
     return { j->chunk(), j->nextBatch(), j->prevBatch(), j->totalRoomCountEstimate() };
 };
 
@@ -232,8 +245,21 @@ public:
     };
 };
 
+template <>
+struct JsonObjectConverter<QueryPublicRoomsJob::Response> {
+    using PodT = QueryPublicRoomsJob::Response;
+    static constexpr std::tuple fields{
+        JsonField{ "chunk"_L1, &PodT::chunk },
+        JsonField{ "next_batch"_L1, &PodT::nextBatch },
+        JsonField{ "prev_batch"_L1, &PodT::prevBatch },
+        JsonField{ "total_room_count_estimate"_L1, &PodT::totalRoomCountEstimate }
+    };
+};
+
 template <std::derived_from<QueryPublicRoomsJob> JobT>
 constexpr inline auto doCollectResponse<JobT> = [](JobT* j) -> QueryPublicRoomsJob::Response {
+    if (j->directJsonDecoding()) // Decode everything in one pass
+        return fromJsonBytes<QueryPublicRoomsJob::Response>(j->rawData());
     return { j->chunk(), j->nextBatch(), j->prevBatch(), j->totalRoomCountEstimate() };
 };
 
@@ -255,6 +255,12 @@ struct QUOTIENT_API JsonObjectConverter<SearchJob::UserProfile> {
         fillFromJson(jo.value("displayname"_L1), result.displayname);
         fillFromJson(jo.value("avatar_url"_L1), result.avatarUrl);
     }
+
+    using PodT = SearchJob::UserProfile;
+    static constexpr std::tuple fields{
+        JsonField{ "displayname"_L1, &PodT::displayname },
+        JsonField{ "avatar_url"_L1, &PodT::avatarUrl }
+    };
 };
 
 template <>
@@ -267,6 +273,15 @@ struct QUOTIENT_API JsonObjectConverter<SearchJob::EventContext> {
         fillFromJson(jo.value("events_before"_L1), result.eventsBefore);
         fillFromJson(jo.value("events_after"_L1), result.eventsAfter);
     }
+
+    using PodT = SearchJob::EventContext;
+    static constexpr std::tuple fields{
+        JsonField{ "start"_L1, &PodT::begin },
+        JsonField{ "end"_L1, &PodT::end },
+        JsonField{ "profile_info"_L1, &PodT::profileInfo },
+        JsonField{ "events_before"_L1, &PodT::eventsBefore },
+        JsonField{ "events_after"_L1, &PodT::eventsAfter }
+    };
 };
 
 template <>
@@ -277,6 +292,13 @@ struct QUOTIENT_API JsonObjectConverter<SearchJob::Result> {
         fillFromJson(jo.value("result"_L1), result.result);
         fillFromJson(jo.value("context"_L1), result.context);
     }
+
+    using PodT = SearchJob::Result;
+    static constexpr std::tuple fields{
+        JsonField{ "rank"_L1, &PodT::rank },
+        JsonField{ "result"_L1, &PodT::result },
+        JsonField{ "context"_L1, &PodT::context }
+    };
 };
 
 template <>
@@ -287,6 +309,13 @@ struct QUOTIENT_API JsonObjectConverter<SearchJob::GroupValue> {
         fillFromJson(jo.value("order"_L1), result.order);
         fillFromJson(jo.value("results"_L1), result.results);
     }
+
+    using PodT = SearchJob::GroupValue;
+    static constexpr std::tuple fields{
+        JsonField{ "next_batch"_L1, &PodT::nextBatch },
+        JsonField{ "order"_L1, &PodT::order },
+        JsonField{ "results"_L1, &PodT::results }
+    };
 };
 
 template <>
@@ -300,6 +329,16 @@ struct QUOTIENT_API JsonObjectConverter<SearchJob::ResultRoomEvents> {
         fillFromJson(jo.value("groups"_L1), result.groups);
         fillFromJson(jo.value("next_batch"_L1), result.nextBatch);
     }
+
+    using PodT = SearchJob::ResultRoomEvents;
+    static constexpr std::tuple fields{
+        JsonField{ "count"_L1, &PodT::count },
+        JsonField{ "highlights"_L1, &PodT::highlights },
+        JsonField{ "results"_L1, &PodT::results },
+        JsonField{ "state"_L1, &PodT::state },
+        JsonField{ "groups"_L1, &PodT::groups },
+        JsonField{ "next_batch"_L1, &PodT::nextBatch }
+    };
 };
 
 template <>
@@ -308,6 +347,9 @@ struct QUOTIENT_API JsonObjectConverter<SearchJob::ResultCategories> {
     {
         fillFromJson(jo.value("room_events"_L1), result.roomEvents);
     }
+
+    using PodT = SearchJob::ResultCategories;
+    static constexpr std::tuple fields{ JsonField{ "room_events"_L1, &PodT::roomEvents } };
 };
 
 } // namespace Quotient
@@ -191,6 +191,7 @@ void SSSSHandler::loadMegolmBackup(const QByteArray& megolmDecryptionKey)
         }
         qCDebug(E2EE) << "Loading key backup" << job->version();
         auto keysJob = m_connection->callApi<GetRoomKeysJob>(job->version());
+        keysJob->setDirectJsonDecoding(); // The whole backup comes in one response
         connect(keysJob, &BaseJob::finished, this, [this, keysJob, megolmDecryptionKey](){
             const auto &rooms = keysJob->rooms();
             qCDebug(E2EE) << rooms.size() << "rooms in the backup";
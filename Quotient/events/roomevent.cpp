@@ -7,11 +7,19 @@
 #include "redactionevent.h"
 #include "stateevent.h"
 
+#include "../idpool.h"
 #include "../logging_categories_p.h"
 
 using namespace Quotient;
 
-RoomEvent::RoomEvent(const QJsonObject& json) : Event(json)
+RoomEvent::RoomEvent(const QJsonObject& json)
+    : Event(json)
+    , _id(json[EventIdKey].toString())
+    , _roomId(json[RoomIdKey].toString())
+    , _senderId(json[SenderKey].toString())
+    , _stateKey(json[StateKeyKey].toString())
+    , _transactionId(json[UnsignedKey]["transaction_id"_L1].toString())
+    , _originTimestamp(fromJson<qint64>(json["origin_server_ts"_L1]))
 {
     if (const auto redaction = unsignedPart<QJsonObject>(RedactedCauseKey);
         !redaction.isEmpty())
@@ -22,21 +30,9 @@ RoomEvent::~RoomEvent() = default; // Let the smart pointer do its job
 
 QString RoomEvent::displayId() const { return id().isEmpty() ? transactionId() : id(); }
 
-QString RoomEvent::id() const { return fullJson()[EventIdKey].toString(); }
-
 QDateTime RoomEvent::originTimestamp() const
 {
-    return Quotient::fromJson<QDateTime>(fullJson()["origin_server_ts"_L1]);
-}
-
-QString RoomEvent::roomId() const
-{
-    return fullJson()[RoomIdKey].toString();
-}
-
-QString RoomEvent::senderId() const
-{
-    return fullJson()[SenderKey].toString();
+    return QDateTime::fromMSecsSinceEpoch(_originTimestamp, Qt::UTC);
 }
 
 QString RoomEvent::redactionReason() const
@@ -44,26 +40,18 @@ QString RoomEvent::redactionReason() const
     return isRedacted() ? _redactedBecause->reason() : QString {};
 }
 
-QString RoomEvent::transactionId() const
-{
-    return unsignedPart<QString>("transaction_id"_L1);
-}
-
 bool RoomEvent::isStateEvent() const { return is<StateEvent>(); }
 
-QString RoomEvent::stateKey() const
-{
-    return fullJson()[StateKeyKey].toString();
-}
-
 void RoomEvent::setRoomId(const QString& roomId)
 {
     editJson().insert(RoomIdKey, roomId);
+    _roomId = roomId;
 }
 
 void RoomEvent::setSender(const QString& senderId)
 {
     editJson().insert(SenderKey, senderId);
+    _senderId = senderId;
 }
 
 void RoomEvent::setTransactionId(const QString& txnId)
@@ -71,7 +59,7 @@ void RoomEvent::setTransactionId(const QString& txnId)
     auto unsignedData = fullJson()[UnsignedKey].toObject();
     unsignedData.insert("transaction_id"_L1, txnId);
     editJson().insert(UnsignedKey, unsignedData);
-    Q_ASSERT(transactionId() == txnId);
+    _transactionId = txnId;
 }
 
 void RoomEvent::addId(const QString& newId)
@@ -79,8 +67,8 @@ void RoomEvent::addId(const QString& newId)
     Q_ASSERT(id().isEmpty());
     Q_ASSERT(!newId.isEmpty());
     editJson().insert(EventIdKey, newId);
+    _id = newId;
     qCDebug(EVENTS) << "Event txnId -> id:" << transactionId() << "->" << id();
-    Q_ASSERT(id() == newId);
 }
 
 void RoomEvent::dumpTo(QDebug dbg) const
@@ -89,6 +77,15 @@ void RoomEvent::dumpTo(QDebug dbg) const
     dbg << " (made at " << originTimestamp().toString(Qt::ISODate) << ')';
 }
 
+void RoomEvent::internIds(IdPool& pool)
+{
+    _id = pool.intern(_id).toString();
+    _roomId = pool.intern(_roomId).toString();
+    _senderId = pool.intern(_senderId).toString();
+    if (!_stateKey.isEmpty())
+        _stateKey = pool.intern(_stateKey).toString();
+}
+
 void RoomEvent::setOriginalEvent(event_ptr_tt<EncryptedEvent>&& originalEvent)
 {
     _originalEvent = std::move(originalEvent);
@@ -17,6 +17,7 @@ constexpr inline auto RelatesToKey = "m.relates_to"_L1;
 
 class RedactionEvent;
 class EncryptedEvent;
+class IdPool;
 
 // That check could look into Event and find most stuff already deleted...
 // NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
@@ -33,11 +34,13 @@ public:
     QString displayId() const;
 
     //! The event_id JSON value for the event.
-    QString id() const;
+    const QString& id() const { return _id; }
 
     QDateTime originTimestamp() const;
-    QString roomId() const;
-    QString senderId() const;
+    //! The origin_server_ts JSON value, in milliseconds since the Unix epoch
+    qint64 originTimestampMs() const { return _originTimestamp; }
+    const QString& roomId() const { return _roomId; }
+    const QString& senderId() const { return _senderId; }
     bool isRedacted() const { return bool(_redactedBecause); }
     const event_ptr_tt<RedactionEvent>& redactedBecause() const
     {
@@ -46,7 +49,7 @@ public:
     QString redactionReason() const;
 
     //! The transaction_id JSON value for the event.
-    QString transactionId() const;
+    const QString& transactionId() const { return _transactionId; }
 
     // State events are special in Matrix; so isStateEvent() and stateKey() are here,
     // as an exception. For other event types (including base types), Event::is<>() and
@@ -54,7 +57,7 @@ public:
 
     bool isStateEvent() const;
 
-    QString stateKey() const;
+    const QString& stateKey() const { return _stateKey; }
 
     //! \brief Fill the pending event object with the room id
     void setRoomId(const QString& roomId);
@@ -75,6 +78,12 @@ public:
     //! callback for that in RoomEvent.
     void addId(const QString& newId);
 
+    //! \brief Share the identifiers of this event with those interned in \p pool
+    //!
+    //! This doesn't change the values returned by id(), roomId(), senderId() and stateKey(),
+    //! only makes them use the same string data as other users of the pool.
+    void internIds(IdPool& pool);
+
     void setOriginalEvent(event_ptr_tt<EncryptedEvent>&& originalEvent);
     const EncryptedEvent* originalEvent() const { return _originalEvent.get(); }
     const QJsonObject encryptedJson() const;
@@ -89,6 +98,15 @@ private:
     event_ptr_tt<RedactionEvent> _redactedBecause;
 
     event_ptr_tt<EncryptedEvent> _originalEvent;
+
+    // Header fields are decoded from the JSON once, as they are used in hot loops all over
+    // the place; the JSON remains the source of truth, setters update both.
+    QString _id;
+    QString _roomId;
+    QString _senderId;
+    QString _stateKey;
+    QString _transactionId;
+    qint64 _originTimestamp = 0;
 };
 using RoomEventPtr = event_ptr_tt<RoomEvent>;
 using RoomEvents = EventsArray<RoomEvent>;
@@ -14,21 +14,9 @@ EventStats EventStats::fromRange(const Room* room, const Room::rev_iter_t& from,
     Q_ASSERT(to <= room->historyEdge());
     Q_ASSERT(from >= Room::rev_iter_t(room->syncEdge()));
     Q_ASSERT(from <= to);
-    QElapsedTimer et;
-    et.start();
-    const auto result =
-        accumulate(from, to, init,
-                   [room](EventStats acc, const TimelineItem& ti) {
-                       acc.notableCount += room->isEventNotable(ti);
-                       acc.highlightCount += room->notificationFor(ti).type
-                                             == Notification::Highlight;
-                       return acc;
-                   });
-    if (et.nsecsElapsed() > ProfilerMinNsecs / 10)
-        qCDebug(PROFILER).nospace()
-            << "Event statistics collection over index range [" << from->index()
-            << "," << (to - 1)->index() << "] took " << et;
-    return result;
+    const auto rangeStats = room->countEvents(from, to);
+    return { init.notableCount + rangeStats.notableCount,
+             init.highlightCount + rangeStats.highlightCount, init.isEstimate };
 }
 
 EventStats EventStats::fromMarker(const Room* room,
@@ -60,11 +48,9 @@ bool EventStats::updateOnMarkerMove(const Room* room, const marker_t& oldMarker,
     Q_ASSERT(isValidFor(room, oldMarker));
     Q_ASSERT(oldMarker > newMarker);
 
-    // A bit of optimisation: only calculate the difference if the marker moved
-    // less than half the remaining timeline ahead; otherwise, recalculation
-    // over the remaining timeline will very likely be faster.
-    if (oldMarker != room->historyEdge()
-        && oldMarker - newMarker < newMarker - marker_t(room->syncEdge())) {
+    // Counting over a range is cheap, so just subtract what's between the markers, unless
+    // the old marker is outside the timeline and the stats have to be recalculated
+    if (oldMarker != room->historyEdge()) {
         const auto removedStats = fromRange(room, newMarker, oldMarker);
         Q_ASSERT(notableCount >= removedStats.notableCount
                  && highlightCount >= removedStats.highlightCount);
@@ -63,6 +63,7 @@ public:
     //! notable and highlighted events between \p from and \p to reverse
     //! timeline iterators; the \p init parameter allows to override
     //! the initial statistics object and start from other values.
+    //! The counting takes logarithmic time, see Room::countEvents().
     static EventStats fromRange(const Room* room, const marker_t& from,
                                 const marker_t& to,
                                 const EventStats& init = { 0, 0, false });
@@ -0,0 +1,390 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "eventstore.h"
+
+#include "logging_categories_p.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlError>
+#include <QtSql/QSqlQuery>
+
+#include <utility>
+
+using namespace Quotient;
+
+namespace {
+
+//! How long to accumulate writes before applying them in one transaction
+constexpr auto WriteBatchInterval = std::chrono::milliseconds(500);
+//! Write earlier if this many events have been buffered
+constexpr auto MaxBufferedEvents = 1000;
+
+struct WriteOp {
+    QString roomId;
+    //! The event historical events precede; empty for new events from /sync
+    QString anchorEventId;
+    QJsonArray events;
+    QString prevBatch;
+    bool limited = false;
+    bool clear = false;
+};
+
+bool exec(QSqlQuery& query)
+{
+    if (query.exec())
+        return true;
+    qCritical(DATABASE) << "Failed to execute query";
+    qCritical(DATABASE) << query.lastQuery();
+    qCritical(DATABASE) << query.lastError();
+    return false;
+}
+
+QSqlQuery prepare(const QSqlDatabase& db, const QString& queryString)
+{
+    QSqlQuery query(db);
+    query.prepare(queryString);
+    return query;
+}
+
+void migrate(QSqlDatabase& db)
+{
+    QSqlQuery versionQuery(u"PRAGMA user_version;"_s, db);
+    const auto version = versionQuery.next() ? versionQuery.value(0).toInt() : 0;
+    if (version >= 1)
+        return;
+
+    qCDebug(DATABASE) << "Creating the event store schema";
+    db.transaction();
+    for (const auto& q :
+         { u"CREATE TABLE chunks (chunkId INTEGER PRIMARY KEY AUTOINCREMENT, roomId TEXT NOT NULL, "
+           "prevBatch TEXT, live INTEGER NOT NULL DEFAULT 0);"_s,
+           u"CREATE INDEX chunks_room_idx ON chunks(roomId, live);"_s,
+           u"CREATE TABLE events (roomId TEXT NOT NULL, eventId TEXT NOT NULL, "
+           "chunkId INTEGER NOT NULL, ord INTEGER NOT NULL, json BLOB NOT NULL, "
+           "relatesTo TEXT, relType TEXT, PRIMARY KEY (roomId, eventId));"_s,
+           u"CREATE INDEX events_timeline_idx ON events(roomId, chunkId, ord);"_s,
+           u"CREATE INDEX events_relations_idx ON events(roomId, relatesTo, relType);"_s,
+           u"PRAGMA user_version = 1;"_s }) {
+        QSqlQuery query(db);
+        query.prepare(q);
+        exec(query);
+    }
+    db.commit();
+}
+
+void insertEvent(QSqlQuery& query, const QString& roomId, qint64 chunkId, qint64 ord,
+                 const QJsonObject& json)
+{
+    const auto relation = json["content"_L1]["m.relates_to"_L1].toObject();
+    const auto relatesTo = relation["event_id"_L1].toString();
+    query.bindValue(u":roomId"_s, roomId);
+    query.bindValue(u":eventId"_s, json["event_id"_L1].toString());
+    query.bindValue(u":chunkId"_s, chunkId);
+    query.bindValue(u":ord"_s, ord);
+    query.bindValue(u":json"_s, QJsonDocument(json).toJson(QJsonDocument::Compact));
+    query.bindValue(u":relatesTo"_s, relatesTo.isEmpty() ? QVariant() : relatesTo);
+    query.bindValue(u":relType"_s,
+                    relatesTo.isEmpty() ? QVariant() : relation["rel_type"_L1].toString());
+    exec(query);
+}
+
+qint64 startChunk(const QSqlDatabase& db, const QString& roomId, const QString& prevBatch,
+                  bool live)
+{
+    if (live) {
+        auto query = prepare(db, u"UPDATE chunks SET live = 0 WHERE roomId = :roomId AND live = 1;"_s);
+        query.bindValue(u":roomId"_s, roomId);
+        exec(query);
+    }
+    auto query = prepare(db, u"INSERT INTO chunks (roomId, prevBatch, live) "
+                             "VALUES (:roomId, :prevBatch, :live);"_s);
+    query.bindValue(u":roomId"_s, roomId);
+    query.bindValue(u":prevBatch"_s, prevBatch);
+    query.bindValue(u":live"_s, live ? 1 : 0);
+    exec(query);
+    return query.lastInsertId().toLongLong();
+}
+
+void appendNewEvents(const QSqlDatabase& db, const WriteOp& op)
+{
+    qint64 chunkId = -1;
+    qint64 ord = 0;
+    if (!op.limited) {
+        auto query = prepare(db, u"SELECT chunkId FROM chunks WHERE roomId = :roomId AND live = 1;"_s);
+        query.bindValue(u":roomId"_s, op.roomId);
+        if (exec(query) && query.next()) {
+            chunkId = query.value(0).toLongLong();
+            auto ordQuery = prepare(db, u"SELECT MAX(ord) FROM events "
+                                        "WHERE roomId = :roomId AND chunkId = :chunkId;"_s);
+            ordQuery.bindValue(u":roomId"_s, op.roomId);
+            ordQuery.bindValue(u":chunkId"_s, chunkId);
+            if (exec(ordQuery) && ordQuery.next() && !ordQuery.isNull(0))
+                ord = ordQuery.value(0).toLongLong() + 1;
+        }
+    }
+    if (chunkId < 0)
+        chunkId = startChunk(db, op.roomId, op.prevBatch, true);
+
+    auto query = prepare(db, u"INSERT OR IGNORE INTO events "
+                             "(roomId, eventId, chunkId, ord, json, relatesTo, relType) VALUES "
+                             "(:roomId, :eventId, :chunkId, :ord, :json, :relatesTo, :relType);"_s);
+    for (const auto& e : op.events)
+        insertEvent(query, op.roomId, chunkId, ord++, e.toObject());
+}
+
+void prependHistoricalEvents(const QSqlDatabase& db, const WriteOp& op)
+{
+    qint64 chunkId = -1;
+    qint64 ord = -1;
+    auto anchorQuery = prepare(db, u"SELECT chunkId, ord FROM events "
+                                   "WHERE roomId = :roomId AND eventId = :eventId;"_s);
+    anchorQuery.bindValue(u":roomId"_s, op.roomId);
+    anchorQuery.bindValue(u":eventId"_s, op.anchorEventId);
+    if (exec(anchorQuery) && anchorQuery.next()) {
+        chunkId = anchorQuery.value(0).toLongLong();
+        const auto anchorOrd = anchorQuery.value(1).toLongLong();
+        auto minQuery = prepare(db, u"SELECT MIN(ord) FROM events "
+                                    "WHERE roomId = :roomId AND chunkId = :chunkId;"_s);
+        minQuery.bindValue(u":roomId"_s, op.roomId);
+        minQuery.bindValue(u":chunkId"_s, chunkId);
+        if (exec(minQuery) && minQuery.next() && minQuery.value(0).toLongLong() < anchorOrd) {
+            qCDebug(DATABASE) << "History before" << op.anchorEventId << "in" << op.roomId
+                              << "is already stored";
+            return;
+        }
+        ord = anchorOrd - 1;
+    } else
+        chunkId = startChunk(db, op.roomId, op.prevBatch, false);
+
+    auto query = prepare(db, u"INSERT OR IGNORE INTO events "
+                             "(roomId, eventId, chunkId, ord, json, relatesTo, relType) VALUES "
+                             "(:roomId, :eventId, :chunkId, :ord, :json, :relatesTo, :relType);"_s);
+    for (const auto& e : op.events)
+        insertEvent(query, op.roomId, chunkId, ord--, e.toObject());
+
+    auto chunkQuery = prepare(db, u"UPDATE chunks SET prevBatch = :prevBatch WHERE chunkId = :chunkId;"_s);
+    chunkQuery.bindValue(u":prevBatch"_s, op.prevBatch);
+    chunkQuery.bindValue(u":chunkId"_s, chunkId);
+    exec(chunkQuery);
+}
+
+void clearRoomEvents(const QSqlDatabase& db, const QString& roomId)
+{
+    for (const auto& table : { "events"_L1, "chunks"_L1 }) {
+        auto query = prepare(db, "DELETE FROM %1 WHERE roomId = :roomId;"_L1.arg(table));
+        query.bindValue(u":roomId"_s, roomId);
+        exec(query);
+    }
+}
+
+QString databaseDir(const QString& userId)
+{
+    auto dbDir = userId;
+    dbDir.replace(u':', u'_');
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) % u'/' % dbDir;
+}
+
+constexpr auto DatabaseFileName = "quotient_events.db3"_L1;
+
+} // namespace
+
+class Q_DECL_HIDDEN EventStore::Private {
+public:
+    QString readConnectionName;
+    QString writeConnectionName;
+    QThread writerThread;
+    QObject writer; //!< The context object for writes, lives in writerThread
+    QTimer flushTimer;
+    std::vector<WriteOp> bufferedOps;
+    qsizetype bufferedEvents = 0;
+
+    QSqlDatabase readDb() const { return QSqlDatabase::database(readConnectionName); }
+
+    void enqueue(WriteOp&& op)
+    {
+        bufferedEvents += op.events.size();
+        bufferedOps.push_back(std::move(op));
+        if (bufferedEvents >= MaxBufferedEvents)
+            flush();
+        else if (!flushTimer.isActive())
+            flushTimer.start();
+    }
+
+    void flush()
+    {
+        flushTimer.stop();
+        if (bufferedOps.empty())
+            return;
+        bufferedEvents = 0;
+        QMetaObject::invokeMethod(&writer, [this, ops = std::exchange(bufferedOps, {})] {
+            auto db = QSqlDatabase::database(writeConnectionName);
+            db.transaction();
+            for (const auto& op : ops) {
+                if (op.clear)
+                    clearRoomEvents(db, op.roomId);
+                else if (op.anchorEventId.isEmpty())
+                    appendNewEvents(db, op);
+                else
+                    prependHistoricalEvents(db, op);
+            }
+            if (!db.commit())
+                qCritical(DATABASE) << "Failed to store events:" << db.lastError();
+        });
+    }
+};
+
+EventStore::EventStore(const QString& userId, QObject* parent)
+    : QObject(parent), d(makeImpl<Private>())
+{
+    const auto databasePath = databaseDir(userId);
+    QDir(databasePath).mkpath("."_L1);
+    const QString fileName = databasePath % u'/' % DatabaseFileName;
+    d->readConnectionName = "Quotient_events_"_L1 + userId;
+    d->writeConnectionName = d->readConnectionName + "_writer"_L1;
+
+    d->flushTimer.setSingleShot(true);
+    d->flushTimer.setInterval(WriteBatchInterval);
+    connect(&d->flushTimer, &QTimer::timeout, this, &EventStore::flush);
+
+    d->writer.moveToThread(&d->writerThread);
+    d->writerThread.setObjectName(d->writeConnectionName);
+    d->writerThread.start();
+    // The schema must be in place before the read connection is used, hence blocking
+    QMetaObject::invokeMethod(
+        &d->writer,
+        [this, fileName] {
+            auto db = QSqlDatabase::addDatabase(u"QSQLITE"_s, d->writeConnectionName);
+            db.setDatabaseName(fileName);
+            if (!db.open()) {
+                qCritical(DATABASE) << "Could not open the event store:" << db.lastError();
+                return;
+            }
+            // WAL lets the main thread read while a batch is being written
+            QSqlQuery(u"PRAGMA journal_mode=WAL;"_s, db);
+            QSqlQuery(u"PRAGMA synchronous=NORMAL;"_s, db);
+            migrate(db);
+        },
+        Qt::BlockingQueuedConnection);
+
+    auto db = QSqlDatabase::addDatabase(u"QSQLITE"_s, d->readConnectionName);
+    db.setDatabaseName(fileName);
+    db.setConnectOptions(u"QSQLITE_OPEN_READONLY"_s);
+    if (!db.open())
+        qCritical(DATABASE) << "Could not open the event store for reading:" << db.lastError();
+}
+
+EventStore::~EventStore()
+{
+    d->flush();
+    // Posted after all pending writes, so these are complete once this returns
+    QMetaObject::invokeMethod(
+        &d->writer, [this] { QSqlDatabase::removeDatabase(d->writeConnectionName); },
+        Qt::BlockingQueuedConnection);
+    d->writerThread.quit();
+    d->writerThread.wait();
+    QSqlDatabase::removeDatabase(d->readConnectionName);
+}
+
+void EventStore::storeNewEvents(const QString& roomId, const QJsonArray& events, bool limited,
+                                const QString& prevBatch)
+{
+    if (events.isEmpty())
+        return;
+    d->enqueue({ .roomId = roomId, .events = events, .prevBatch = prevBatch, .limited = limited });
+}
+
+void EventStore::storeHistoricalEvents(const QString& roomId, const QString& anchorEventId,
+                                       const QJsonArray& events, const QString& prevBatch)
+{
+    if (events.isEmpty() || anchorEventId.isEmpty())
+        return;
+    d->enqueue(
+        { .roomId = roomId, .anchorEventId = anchorEventId, .events = events, .prevBatch = prevBatch });
+}
+
+std::optional<EventStore::HistoryBatch> EventStore::loadHistory(const QString& roomId,
+                                                                const QString& eventId,
+                                                                int limit) const
+{
+    const auto db = d->readDb();
+    auto anchorQuery = prepare(db, u"SELECT chunkId, ord FROM events "
+                                   "WHERE roomId = :roomId AND eventId = :eventId;"_s);
+    anchorQuery.bindValue(u":roomId"_s, roomId);
+    anchorQuery.bindValue(u":eventId"_s, eventId);
+    if (!exec(anchorQuery) || !anchorQuery.next())
+        return {};
+    const auto chunkId = anchorQuery.value(0).toLongLong();
+
+    // Ask for one more event than needed, to know whether the chunk is exhausted
+    auto query = prepare(db, u"SELECT json FROM events WHERE roomId = :roomId "
+                             "AND chunkId = :chunkId AND ord < :ord ORDER BY ord DESC LIMIT :limit;"_s);
+    query.bindValue(u":roomId"_s, roomId);
+    query.bindValue(u":chunkId"_s, chunkId);
+    query.bindValue(u":ord"_s, anchorQuery.value(1).toLongLong());
+    query.bindValue(u":limit"_s, limit + 1);
+    if (!exec(query))
+        return {};
+
+    HistoryBatch result;
+    while (query.next() && result.events.size() < limit)
+        result.events.append(QJsonDocument::fromJson(query.value(0).toByteArray()).object());
+    result.chunkExhausted = !query.isValid();
+    if (result.chunkExhausted) {
+        auto chunkQuery = prepare(db, u"SELECT prevBatch FROM chunks WHERE chunkId = :chunkId;"_s);
+        chunkQuery.bindValue(u":chunkId"_s, chunkId);
+        if (exec(chunkQuery) && chunkQuery.next())
+            result.prevBatch = chunkQuery.value(0).toString();
+    }
+    return result;
+}
+
+QJsonArray EventStore::loadRelatedEvents(const QString& roomId, const QString& eventId,
+                                         const QString& relType) const
+{
+    auto query =
+        prepare(d->readDb(), relType.isEmpty()
+                                 ? u"SELECT json FROM events WHERE roomId = :roomId AND "
+                                   "relatesTo = :eventId ORDER BY chunkId, ord;"_s
+                                 : u"SELECT json FROM events WHERE roomId = :roomId AND "
+                                   "relatesTo = :eventId AND relType = :relType "
+                                   "ORDER BY chunkId, ord;"_s);
+    query.bindValue(u":roomId"_s, roomId);
+    query.bindValue(u":eventId"_s, eventId);
+    if (!relType.isEmpty())
+        query.bindValue(u":relType"_s, relType);
+    QJsonArray result;
+    if (exec(query))
+        while (query.next())
+            result.append(QJsonDocument::fromJson(query.value(0).toByteArray()).object());
+    return result;
+}
+
+void EventStore::flush() { d->flush(); }
+
+void EventStore::clearRoom(const QString& roomId)
+{
+    d->enqueue({ .roomId = roomId, .clear = true });
+}
+
+bool EventStore::purge(const QString& userId)
+{
+    const QDir dir(databaseDir(userId));
+    bool result = true;
+    // SQLite keeps the write-ahead log and its index next to the database
+    for (const auto& suffix : { ""_L1, "-wal"_L1, "-shm"_L1 })
+        if (const QString fileName = DatabaseFileName + suffix;
+            dir.exists(fileName) && !dir.remove(fileName)) {
+            qCWarning(DATABASE) << "Could not delete" << dir.filePath(fileName);
+            result = false;
+        }
+    if (result)
+        qCDebug(DATABASE) << "Deleted the event store of" << userId;
+    return result;
+}
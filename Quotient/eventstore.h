@@ -0,0 +1,95 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "quotient_export.h"
+#include "util.h"
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QObject>
+
+#include <optional>
+
+namespace Quotient {
+
+//! \brief A local persistent store of room timeline events
+//!
+//! EventStore keeps timeline events of all rooms of an account in an SQLite database, separate
+//! from the E2EE Database. Events are organised in chunks - contiguous stretches of a room
+//! timeline, each with the pagination token that leads to events before it. Within a chunk,
+//! events are ordered by their position in the timeline; events can also be looked up by their
+//! id and by the event they relate to.
+//!
+//! Writes are buffered and applied in batches, each in a single transaction, on a dedicated
+//! thread; reads are synchronous and only see the events that have already been written.
+//! Encrypted events are stored in their original (encrypted) form and are decrypted again
+//! when loaded.
+class QUOTIENT_API EventStore : public QObject {
+    Q_OBJECT
+public:
+    explicit EventStore(const QString& userId, QObject* parent = nullptr);
+    ~EventStore() override;
+
+    //! Remember events that arrived from /sync
+    //!
+    //! \param roomId the room the events belong to
+    //! \param events the events in chronological order (full JSON)
+    //! \param limited whether there's a gap before \p events; a new chunk is started in that case
+    //! \param prevBatch the token to paginate back from \p events
+    void storeNewEvents(const QString& roomId, const QJsonArray& events, bool limited,
+                        const QString& prevBatch);
+
+    //! Remember historical events loaded before a given event
+    //!
+    //! \param roomId the room the events belong to
+    //! \param anchorEventId the (already stored) event \p events precede
+    //! \param events the events in reverse-chronological order, as returned by /messages
+    //! \param prevBatch the token to paginate further back; empty if the room start is reached
+    void storeHistoricalEvents(const QString& roomId, const QString& anchorEventId,
+                               const QJsonArray& events, const QString& prevBatch);
+
+    struct HistoryBatch {
+        //! Events preceding the anchor, in reverse-chronological order
+        QJsonArray events;
+        //! \brief Whether the events above are the last ones stored before the anchor
+        //!
+        //! If true, history before the batch should be loaded from the server, using
+        //! prevBatch; an empty prevBatch means there's no history left at all.
+        bool chunkExhausted = false;
+        QString prevBatch;
+    };
+
+    //! \brief Load up to \p limit events stored right before \p eventId
+    //!
+    //! \return the events along with the pagination state, or an empty optional if
+    //!         \p eventId has not been stored (yet)
+    std::optional<HistoryBatch> loadHistory(const QString& roomId, const QString& eventId,
+                                            int limit) const;
+
+    //! \brief Load stored events relating to \p eventId
+    //!
+    //! \param relType the relation type (`m.relates_to/rel_type`); any type if empty
+    //! \return events in chronological order, as far as it is known
+    QJsonArray loadRelatedEvents(const QString& roomId, const QString& eventId,
+                                 const QString& relType = {}) const;
+
+    //! Write all buffered events to the database without waiting for the next batch
+    void flush();
+
+    //! Drop all events stored for the room
+    void clearRoom(const QString& roomId);
+
+    //! \brief Delete the event store of \p userId from the disk
+    //!
+    //! The store must not be open at the moment, i.e. there should be no EventStore object
+    //! for \p userId; destroying it closes the database on the writer thread.
+    //! \return true if there's no store for \p userId on the disk by the time this returns
+    static bool purge(const QString& userId);
+
+private:
+    class Private;
+    ImplPtr<Private> d;
+};
+
+} // namespace Quotient
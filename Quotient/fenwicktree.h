@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace Quotient {
+
+//! \brief A Fenwick (binary indexed) tree over a signed range of indices
+//!
+//! The tree stores a value for each integer index and answers prefix and range sums in
+//! logarithmic time. The range of indices grows in both directions as needed, which matches
+//! the way timeline indices grow: new events get increasing indices starting from 0, historical
+//! events get decreasing negative indices. Growing takes amortised constant time per index;
+//! memory is proportional to the span of indices used so far.
+template <typename ValueT>
+class FenwickTree {
+public:
+    //! Add \p delta to the value at \p index
+    void add(std::ptrdiff_t index, ValueT delta)
+    {
+        if (index >= 0)
+            _forward.add(size_t(index), delta);
+        else
+            _backward.add(size_t(-index - 1), delta);
+        _total += delta;
+    }
+
+    //! The sum of all values
+    ValueT total() const { return _total; }
+
+    //! The sum of values at indices up to \p index, inclusive
+    ValueT prefixSum(std::ptrdiff_t index) const
+    {
+        if (index >= 0)
+            return _total - _forward.total() + _forward.prefixSum(size_t(index));
+        // Negative indices go backwards in _backward: -1 is at 0, -2 at 1 and so on
+        return index == -1 ? _total - _forward.total()
+                           : _total - _forward.total() - _backward.prefixSum(size_t(-index - 2));
+    }
+
+    //! The sum of values at indices from \p index onwards
+    ValueT suffixSum(std::ptrdiff_t index) const { return _total - prefixSum(index - 1); }
+
+    //! The sum of values at indices from \p from to \p to, inclusive
+    ValueT rangeSum(std::ptrdiff_t from, std::ptrdiff_t to) const
+    {
+        return from <= to ? prefixSum(to) - prefixSum(from - 1) : ValueT{};
+    }
+
+    void clear() { *this = {}; }
+
+private:
+    //! A classic 1-based Fenwick tree over non-negative positions with power-of-two capacity
+    class Half {
+    public:
+        void add(size_t pos, ValueT delta)
+        {
+            if (pos >= _capacity)
+                grow(pos);
+            for (auto i = pos + 1; i <= _capacity; i += lowBit(i))
+                _tree[i] += delta;
+            _total += delta;
+        }
+
+        //! The sum over positions [0, pos]
+        ValueT prefixSum(size_t pos) const
+        {
+            ValueT sum{};
+            for (auto i = std::min(pos + 1, _capacity); i > 0; i -= lowBit(i))
+                sum += _tree[i];
+            return sum;
+        }
+
+        ValueT total() const { return _total; }
+
+    private:
+        std::vector<ValueT> _tree{ ValueT{} };
+        size_t _capacity = 0;
+        ValueT _total{};
+
+        static size_t lowBit(size_t i) { return i & (~i + 1); }
+
+        void grow(size_t pos)
+        {
+            auto newCapacity = std::max<size_t>(_capacity, 16);
+            while (newCapacity <= pos)
+                newCapacity *= 2;
+            _tree.resize(newCapacity + 1, ValueT{});
+            // All positions added by growing hold zeros, so the only nodes that need a value
+            // are those at the new powers of two, each covering the whole tree before it
+            if (_capacity > 0)
+                for (auto c = _capacity * 2; c <= newCapacity; c *= 2)
+                    _tree[c] = _tree[_capacity];
+            _capacity = newCapacity;
+        }
+    };
+
+    Half _forward;
+    Half _backward;
+    ValueT _total{};
+};
+
+} // namespace Quotient
@@ -0,0 +1,40 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "idpool.h"
+
+#include "logging_categories_p.h"
+
+using namespace Quotient;
+
+//! The pool is not squeezed until it has at least that many entries
+constexpr qsizetype MinSizeToSqueeze = 4096;
+
+InternedId IdPool::intern(const QString& id)
+{
+    if (const auto it = _ids.constFind(id); it != _ids.cend())
+        return *it;
+
+    // Squeezing when the pool doubles keeps its cost amortised constant per interned id
+    if (_ids.size() >= MinSizeToSqueeze && _ids.size() >= 2 * _sizeAfterSqueeze)
+        squeeze();
+    // Make a copy that owns its data even if id comes from QString::fromRawData()
+    const InternedId handle(new InternedId::Entry(QString(id.constData(), id.size())));
+    _ids.insert(handle.toString(), handle);
+    return handle;
+}
+
+InternedId IdPool::find(const QString& id) const { return _ids.value(id); }
+
+void IdPool::squeeze()
+{
+    const auto sizeBefore = _ids.size();
+    // An entry is unused if no handle but the pool's own refers to it, and its string is not
+    // shared with anything either (see RoomEvent::internIds())
+    _ids.removeIf([](const std::pair<const QStringView&, InternedId&>& p) {
+        return p.second._entry->ref.loadRelaxed() == 1 && p.second._entry->str.isDetached();
+    });
+    _sizeAfterSqueeze = _ids.size();
+    qCDebug(MAIN) << "Identifier pool squeezed from" << sizeBefore << "to" << _sizeAfterSqueeze
+                  << "entries";
+}
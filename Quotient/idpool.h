@@ -0,0 +1,85 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "quotient_export.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QHash>
+#include <QtCore/QSharedData>
+#include <QtCore/QString>
+
+namespace Quotient {
+
+//! \brief A handle to an identifier interned in an IdPool
+//!
+//! A handle is a single pointer to the pool entry for the identifier; handles obtained from
+//! the same pool for equal strings point to the same entry, therefore comparing and hashing
+//! them only looks at that pointer, regardless of the identifier length. A default-constructed
+//! handle is null and is different from any handle returned by IdPool::intern(), including
+//! the one for an empty string. The handle keeps its entry alive on its own, so it remains
+//! usable even after the pool is gone; but handles from different pools must not be mixed in
+//! one container.
+class QUOTIENT_API InternedId {
+public:
+    InternedId() = default;
+
+    bool isNull() const { return !_entry; }
+    //! The interned string; an empty string for a null handle
+    const QString& toString() const
+    {
+        static const QString NullString;
+        return _entry ? _entry->str : NullString;
+    }
+    bool isEmpty() const { return toString().isEmpty(); }
+
+    friend bool operator==(const InternedId& lhs, const InternedId& rhs)
+    {
+        return lhs._entry == rhs._entry;
+    }
+    friend size_t qHash(const InternedId& id, size_t seed = 0)
+    {
+        return qHash(reinterpret_cast<quintptr>(id._entry.data()), seed);
+    }
+    friend QDebug operator<<(QDebug dbg, const InternedId& id) { return dbg << id.toString(); }
+
+private:
+    friend class IdPool;
+    struct Entry : QSharedData {
+        explicit Entry(QString s) : str(std::move(s)) {}
+        const QString str;
+    };
+    explicit InternedId(Entry* entry) : _entry(entry) {}
+
+    QExplicitlySharedDataPointer<Entry> _entry;
+};
+
+//! \brief A pool of interned user, room and event identifiers
+//!
+//! Each Connection has a pool that its rooms use for the keys of their lookup tables, so that
+//! an identifier occurring in many places is stored only once. Entries that are no more used
+//! outside the pool are dropped from time to time (see squeeze()).
+class QUOTIENT_API IdPool {
+public:
+    //! Get the handle for \p id, adding it to the pool if it's not there yet
+    InternedId intern(const QString& id);
+
+    //! \brief Get the handle for \p id if it's in the pool
+    //!
+    //! This is the way to look up a string in containers keyed by InternedId: if the string is
+    //! not in the pool, the returned null handle is not in any of those containers either.
+    InternedId find(const QString& id) const;
+
+    qsizetype size() const { return _ids.size(); }
+
+    //! Drop the identifiers that are only referred to by the pool itself
+    void squeeze();
+
+private:
+    //! Keys are views of the strings in the entries that the values point to
+    QHash<QStringView, InternedId> _ids;
+    qsizetype _sizeAfterSqueeze = 0;
+};
+
+} // namespace Quotient
@@ -18,6 +18,7 @@
 #include <QtNetwork/QNetworkRequest>
 
 #include <ranges>
+#include <vector>
 
 using namespace Quotient;
 using std::chrono::seconds, std::chrono::milliseconds;
@@ -106,6 +107,11 @@ public:
      * JSON in jsonResponse.
      */
     Status parseJson();
+    //! \brief Check the JSON syntax of rawResponse without parsing it into jsonResponse
+    //!
+    //! This is used instead of parseJson() with direct JSON decoding.
+    //! \param topLevelKeys the keys of the top-level object, to check expected keys against
+    Status scanJson(QStringList& topLevelKeys) const;
 
     ConnectionData* connection = nullptr;
 
@@ -118,6 +124,9 @@ public:
     bool needsToken;
 
     bool inBackground = false;
+    bool directJsonDecoding = false;
+    //! Whether other requesters have attached to this job, see Connection::callApiCoalesced()
+    bool shared = false;
 
     // There's no use of QMimeType here because we don't want to match
     // content types against the known MIME type hierarchy; and at the same
@@ -131,9 +140,31 @@ public:
     QPointer<QNetworkReply> reply;
 
     QPromise<void> promise{};
+    //! \brief Promises for requesters of a shared job other than the first one
+    //!
+    //! A QFuture only takes a single continuation; so every JobHandle made for this job gets
+    //! a future of its own, see BaseJob::future()
+    std::vector<QPromise<void>> sharerPromises;
+    bool promiseTaken = false;
+
+    void forEachPromise(auto fn)
+    {
+        fn(promise);
+        for (auto& p : sharerPromises)
+            fn(p);
+    }
 
     Status status = Unprepared;
+    //! Retained part of the response body; see RawResponseRetention
     QByteArray rawResponse;
+    //! The full size of the response body, even if it's not retained entirely
+    qsizetype rawResponseSize = 0;
+    //! \brief How much of a successfully parsed JSON response body is retained
+    //!
+    //! Once parsed, the JSON response lives in jsonResponse, and the raw bytes are only needed
+    //! for diagnostics - keeping the entire body of a large /sync response around for
+    //! the lifetime of the job just doubles its memory footprint.
+    static constexpr qsizetype RawResponseRetention = 65536;
     /// Contains a null document in case of non-JSON body (for a successful
     /// or unsuccessful response); a document with QJsonObject or QJsonArray
     /// in case of a successful response with JSON payload, as per the API
@@ -144,6 +175,11 @@ public:
 
     QMessageLogger::CategoryFunction logCat = &JOBS;
 
+    [[nodiscard]] bool expectsJson() const
+    {
+        return expectedContentTypes == QByteArrayList{ "application/json"_ba };
+    }
+
     QTimer timer;
     QTimer retryTimer;
 
@@ -210,6 +246,16 @@ QUrl BaseJob::requestUrl() const { return d->reply ? d->reply->url() : QUrl(); }
 
 bool BaseJob::isBackground() const { return d->inBackground; }
 
+QByteArray BaseJob::coalescingKey() const
+{
+    if (d->verb != HttpVerb::Get)
+        return {};
+    auto key = d->apiEndpoint;
+    if (!d->requestQuery.isEmpty())
+        key += '?' + d->requestQuery.query(QUrl::FullyEncoded).toLatin1();
+    return key;
+}
+
 QByteArray BaseJob::apiEndpoint() const { return d->apiEndpoint; }
 
 void BaseJob::setApiEndpoint(QByteArray apiEndpoint) { d->apiEndpoint = std::move(apiEndpoint); }
@@ -300,10 +346,15 @@ QNetworkRequest BaseJob::Private::prepareRequest() const
                      QNetworkRequest::NoLessSafeRedirectPolicy);
     req.setMaximumRedirectsAllowed(10);
     req.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
-    // Qt doesn't combine HTTP2 with SSL quite right, occasionally crashing at
-    // what seems like an attempt to write to a closed channel. If/when that
-    // changes, false should be turned to true below.
-    req.setAttribute(QNetworkRequest::Http2AllowedAttribute, false);
+    // Accept-Encoding is deliberately left to QNetworkAccessManager: it advertises
+    // every encoding it can decode (gzip and deflate, plus brotli and zstd if Qt is
+    // built with them) and decompresses the body as it arrives - but only as long as
+    // the request doesn't set the header on its own.
+    if (requestHeaders.contains("Accept-Encoding"))
+        qCWarning(logCat) << "Setting Accept-Encoding disables automatic decompression of"
+                          << apiEndpoint << "response";
+    // HTTP/2, keep-alive and TLS session reuse are decided upon by
+    // NetworkAccessManager, along with the fallback to HTTP/1.1
     Q_ASSERT(req.url().isValid());
     for (auto it = requestHeaders.cbegin(); it != requestHeaders.cend(); ++it)
         req.setRawHeader(it.key(), it.value());
@@ -350,7 +401,7 @@ void BaseJob::initiate(ConnectionData* connData, bool inBackground)
         }
         Q_ASSERT(status().code != Pending); // doPrepare() must NOT set this
         if (Q_LIKELY(status().code == Unprepared)) {
-            d->promise.start();
+            d->forEachPromise([](QPromise<void>& p) { p.start(); });
             d->connection->submit(this);
             return;
         }
@@ -377,6 +428,9 @@ void BaseJob::sendRequest()
     Q_ASSERT(d->connection && status().code == Pending);
     auto req = d->prepareRequest();
     emit aboutToSendRequest(&req);
+    // In case of a retry
+    d->rawResponse.clear();
+    d->rawResponseSize = 0;
     d->sendRequest(req);
     Q_ASSERT(d->reply);
     connect(reply(), &QNetworkReply::finished, this, [this] {
@@ -384,6 +438,11 @@ void BaseJob::sendRequest()
         finishJob();
     });
     if (d->reply->isRunning()) {
+        if (d->expectsJson())
+            // Collect the (already decompressed) body while it's still downloading,
+            // instead of draining the whole reply buffer at once in gotReply()
+            connect(reply(), &QNetworkReply::readyRead, this,
+                    [this] { d->rawResponse += reply()->readAll(); });
         connect(reply(), &QNetworkReply::metaDataChanged, this,
                 [this] { checkReply(reply()); });
         connect(reply(), &QNetworkReply::uploadProgress, this,
@@ -408,17 +467,48 @@ BaseJob::Status BaseJob::Private::parseJson()
              error.errorString() };
 }
 
+BaseJob::Status BaseJob::Private::scanJson(QStringList& topLevelKeys) const
+{
+    JsonReader reader(rawResponse);
+    if (reader.peek() == JsonReader::Object) {
+        reader.enterObject();
+        while (const auto key = reader.nextKey()) {
+            topLevelKeys.push_back(QString::fromUtf8(*key));
+            reader.skipValue();
+        }
+    } else
+        reader.skipValue();
+    if (reader.hasError())
+        return { IncorrectResponse, reader.errorString() };
+    if (!reader.atEnd())
+        return { IncorrectResponse, u"Unexpected data after the top-level JSON value"_s };
+    return NoError;
+}
+
 void BaseJob::gotReply()
 {
     // Defer actually updating the status until it's finalised
     auto statusSoFar = checkReply(reply());
-    if (statusSoFar.good() && d->expectedContentTypes == QByteArrayList{ "application/json"_ba }) {
-        d->rawResponse = reply()->readAll();
-        statusSoFar = d->parseJson();
+    if (statusSoFar.good() && d->expectsJson()) {
+        d->rawResponse += reply()->readAll();
+        d->rawResponseSize = d->rawResponse.size();
+        QStringList topLevelKeys;
+        // With direct decoding, the raw response is the only copy of the data and is kept whole
+        if (d->directJsonDecoding)
+            statusSoFar = d->scanJson(topLevelKeys);
+        else {
+            statusSoFar = d->parseJson();
+            if (statusSoFar.good() && d->rawResponseSize > Private::RawResponseRetention) {
+                d->rawResponse.truncate(Private::RawResponseRetention);
+                d->rawResponse.squeeze();
+            }
+            if (!d->expectedKeys.isEmpty())
+                topLevelKeys = jsonData().keys();
+        }
         if (statusSoFar.good()) {
             auto filteredView =
-                std::views::filter(expectedKeys(), [responseObject = jsonData()](const QString& k) {
-                    return !responseObject.contains(k);
+                std::views::filter(expectedKeys(), [&topLevelKeys](const QString& k) {
+                    return !topLevelKeys.contains(k);
                 });
             if (const auto missingKeys =
                     QStringList(filteredView.begin(), filteredView.end()).join(u',');
@@ -440,7 +530,8 @@ void BaseJob::gotReply()
         return;
     }
 
-    d->rawResponse = reply()->readAll();
+    d->rawResponse += reply()->readAll();
+    d->rawResponseSize = d->rawResponse.size();
     qCDebug(d->logCat).noquote()
         << "Error body (truncated if long):" << rawDataSample(500);
     setStatus(prepareError(statusSoFar));
@@ -584,7 +675,7 @@ void BaseJob::stop()
                 << this << "stopped without ready network reply";
             d->reply->abort(); // Keep the reply object in case clients need it
         }
-    } else
+    } else if (d->status.code != Success) // Forced results come without a reply
         qCWarning(d->logCat) << this << "stopped with empty network reply";
 }
 
@@ -623,7 +714,7 @@ void BaseJob::finishJob()
     // Notify those interested in any completion of the job including abandon()
     emit finished(this);
 
-    d->promise.finish();
+    d->forEachPromise([](QPromise<void>& p) { p.finish(); });
     emit result(this); // abandon() doesn't emit this
     if (error())
         emit failure(this);
@@ -685,14 +776,18 @@ const QByteArray& BaseJob::rawData() const { return d->rawResponse; }
 QString BaseJob::rawDataSample(int bytesAtMost) const
 {
     auto data = QString::fromUtf8(rawData(bytesAtMost));
-    Q_ASSERT(data.size() <= d->rawResponse.size());
-    return data.size() == d->rawResponse.size()
+    Q_ASSERT(data.size() <= d->rawResponseSize);
+    return data.size() == d->rawResponseSize
                ? data
                : data + tr("...(truncated, %Ln bytes in total)",
                            "Comes after trimmed raw network response",
-                           static_cast<int>(d->rawResponse.size()));
+                           static_cast<int>(d->rawResponseSize));
 }
 
+bool BaseJob::directJsonDecoding() const { return d->directJsonDecoding; }
+
+void BaseJob::setDirectJsonDecoding(bool enable) { d->directJsonDecoding = enable; }
+
 QJsonObject BaseJob::jsonData() const
 {
     return d->jsonResponse.object();
@@ -789,6 +884,7 @@ void BaseJob::setStatus(int code, QString message)
 void BaseJob::forceResult(QJsonDocument resultDoc, Status s)
 {
     d->jsonResponse = std::move(resultDoc);
+    d->directJsonDecoding = false; // The response is already a QJsonDocument
     setStatus(std::move(s));
     QMetaObject::invokeMethod(this, [this] { finishJob(); }, Qt::QueuedConnection);
 }
@@ -803,7 +899,8 @@ void BaseJob::abandon()
         d->reply->disconnect(this);
     emit finished(this);
     if (QLibraryInfo::version() < QVersionNumber(6, 5))
-        future().cancel(); // Qt 6.4 didn't do it on the promise destruction, see QTBUG-103992
+        // Qt 6.4 didn't do it on the promise destruction, see QTBUG-103992
+        d->forEachPromise([](QPromise<void>& p) { p.future().cancel(); });
 
     deleteLater(); // The promise will cancel itself on deletion
 }
@@ -819,4 +916,47 @@ void BaseJob::setLoggingCategory(QMessageLogger::CategoryFunction lcf)
     d->logCat = lcf;
 }
 
-QFuture<void> BaseJob::future() { return d->promise.future(); }
+QFuture<void> BaseJob::future()
+{
+    if (!std::exchange(d->promiseTaken, true))
+        return d->promise.future();
+
+    auto& p = d->sharerPromises.emplace_back();
+    if (d->promise.future().isStarted())
+        p.start();
+    return p.future();
+}
+
+void BaseJob::addSharer() { d->shared = true; }
+
+void BaseJob::detachRequester(QFuture<void> requesterFuture)
+{
+    if (!d->shared) {
+        abandon();
+        return;
+    }
+    // Cancel the future of this requester and finish it so that its continuations learn
+    // about that; the futures of other requesters are left alone
+    requesterFuture.cancel();
+    qsizetype requestersLeft = 0;
+    const auto detach = [&requestersLeft](QPromise<void>& p) {
+        if (!p.future().isCanceled())
+            ++requestersLeft;
+        else if (!p.future().isFinished())
+            p.finish();
+    };
+    if (d->promiseTaken)
+        detach(d->promise);
+    for (auto& p : d->sharerPromises)
+        detach(p);
+    if (requestersLeft == 0) {
+        abandon();
+        return;
+    }
+    qCDebug(d->logCat) << this << "is still used by" << requestersLeft
+                       << "requester(s), only detaching one";
+}
+
+void BaseJob::promoteToForeground() { d->inBackground = false; }
+
+const QJsonDocument& BaseJob::jsonResponse() const { return d->jsonResponse; }
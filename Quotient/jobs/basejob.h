@@ -12,6 +12,7 @@
 #include <QtCore/QFuture>
 
 #include <Quotient/converters.h> // Common for csapi/ headers even though not used here
+#include <Quotient/jsonreader.h>
 #include <Quotient/quotient_common.h> // For DECL_DEPRECATED_ENUMERATOR
 
 class QNetworkRequest;
@@ -135,6 +136,14 @@ public:
     QUrl requestUrl() const;
     bool isBackground() const;
 
+    //! \brief The key identifying the request for coalescing purposes
+    //!
+    //! Identical GET requests (with the same endpoint and query) can be served by a single
+    //! network request; this key is used to find such requests. Requests with other HTTP verbs
+    //! cannot be coalesced; for them, the returned key is empty.
+    //! \sa Connection::callApiCoalesced
+    QByteArray coalescingKey() const;
+
     //! Current status of the job
     Status status() const;
 
@@ -146,7 +155,11 @@ public:
     //! \sa rawDataSample
     QByteArray rawData(int bytesAtMost) const;
 
-    //! Access the whole response body as received from the server
+    //! \brief Access the response body as received from the server
+    //!
+    //! For jobs expecting JSON, only the first 64 KiB of a successfully parsed response are
+    //! retained; use jsonData() or jsonItems() to access the response contents. Error responses
+    //! and responses of other types are retained entirely.
     const QByteArray& rawData() const;
 
     //! \brief Get UI-friendly sample of raw data
@@ -170,6 +183,19 @@ public:
     //! is not an array, an empty array is returned.
     QJsonArray jsonItems() const;
 
+    //! \brief Whether the response is decoded straight from the JSON text
+    //!
+    //! Jobs with large responses can skip building a QJsonDocument. The response body is
+    //! retained as it is then; loadFromJson() and takeFromJson() decode values from it with
+    //! JsonReader, and collectResponse() decodes responses with several values in one pass.
+    //! jsonData() and jsonItems() return empty values for such jobs.
+    bool directJsonDecoding() const;
+    //! \brief Turn direct decoding of the response on or off
+    //!
+    //! This has to be done before the response arrives, e.g., right after starting the job.
+    //! \sa directJsonDecoding
+    void setDirectJsonDecoding(bool enable = true);
+
     //! \brief Load the property from the JSON response assuming a given C++ type
     //!
     //! If there's no top-level JSON object in the response or if there's
@@ -177,6 +203,8 @@ public:
     template <typename T>
     T loadFromJson(auto keyName, T&& defaultValue = {}) const
     {
+        if (directJsonDecoding())
+            return fromJsonBytes<T>(rawData(), keyName).value_or(std::forward<T>(defaultValue));
         const auto& jv = jsonData().value(keyName);
         return jv.isUndefined() ? std::forward<T>(defaultValue) : fromJson<T>(jv);
     }
@@ -188,6 +216,8 @@ public:
     template <typename T>
     T takeFromJson(auto key, T&& defaultValue = {})
     {
+        if (directJsonDecoding()) // Nothing to delete from, just decode the value
+            return fromJsonBytes<T>(rawData(), key).value_or(std::forward<T>(defaultValue));
         if (const auto& jv = takeValueFromJson(key); !jv.isUndefined())
             return fromJson<T>(jv);
 
@@ -231,6 +261,9 @@ public Q_SLOTS:
     //! This aborts waiting for a reply from the server (if there was
     //! any pending) and deletes the job object. No result signals
     //! (result, success, failure) are emitted, only finished() is.
+    //!
+    //! If the job is shared between several requesters (see Connection::callApiCoalesced()),
+    //! this abandons it for all of them; JobHandle::abandon() only detaches its own requester.
     void abandon();
 
 Q_SIGNALS:
@@ -428,13 +461,22 @@ private Q_SLOTS:
     void gotReply();
 
 private:
-    friend class ConnectionData; // to provide access to sendRequest()
+    friend class ConnectionData; // to provide access to sendRequest() and job sharing
     template <class JobT>
     friend class JobHandle;
 
     void stop();
     void finishJob();
+    //! The first call returns the job's own future; each next one makes a new one for a sharer
     QFuture<void> future();
+    void addSharer();
+    //! \brief Cancel the future of a single requester, abandoning the job if none is left
+    //!
+    //! \p requesterFuture is a future returned by future(); if the job is not shared, it is
+    //! abandoned right away.
+    void detachRequester(QFuture<void> requesterFuture);
+    void promoteToForeground();
+    const QJsonDocument& jsonResponse() const;
 
     class Private;
     ImplPtr<Private> d;
@@ -80,17 +80,21 @@ private:
     //! A placeholder structure with a private type, co-sitting as a no-op function object
     struct Skip : public decltype([](future_value_type) {}) {};
 
-    JobHandle(JobT* job, future_type&& futureToWrap)
-        : pointer_type(job), future_type(std::move(futureToWrap))
+    JobHandle(JobT* job, future_type&& futureToWrap, QFuture<void> jobFuture)
+        : pointer_type(job), future_type(std::move(futureToWrap)), requesterFuture(jobFuture)
     {}
 
-    static future_type setupFuture(JobT* job)
-    {
-        return job ? job->future().then([job] { return future_value_type{ job }; }) : future_type{};
-    }
+    JobHandle(JobT* job, QFuture<void>&& jobFuture)
+        : JobHandle(job,
+                    job ? jobFuture.then([job] { return future_value_type{ job }; })
+                        : future_type{},
+                    jobFuture)
+    {}
 
 public:
-    Q_IMPLICIT JobHandle(JobT* job = nullptr) : JobHandle(job, setupFuture(job)) {}
+    Q_IMPLICIT JobHandle(JobT* job = nullptr)
+        : JobHandle(job, job ? job->future() : QFuture<void>{})
+    {}
 
     //! \brief Attach a continuation to a successful or unsuccessful completion of the future
     //!
@@ -196,13 +200,15 @@ public:
     //!
     //! Unlike cancel() that only applies to the current future object but not the upstream chain,
     //! this actually goes up to the job and calls abandon() on it, thereby cancelling the entire
-    //! chain of futures attached to it.
+    //! chain of futures attached to it. If the job is shared with other requesters (see
+    //! Connection::callApiCoalesced()), only the futures of this handle get cancelled, and
+    //! the job is abandoned once all requesters have abandoned it.
     //! \sa BaseJob::abandon
     void abandon()
     {
         if (auto pJob = pointer_type::get(); isJobPending(pJob)) {
             Q_ASSERT(QThread::currentThread() == pJob->thread());
-            pJob->abandon(); // Triggers cancellation of the future
+            pJob->detachRequester(requesterFuture); // Triggers cancellation of the future
         }
     }
 
@@ -290,7 +296,7 @@ private:
 
     auto rewrap(future_type&& ft) const
     {
-        return JobHandle(pointer_type::get(), std::move(ft));
+        return JobHandle(pointer_type::get(), std::move(ft), requesterFuture);
     }
 
     template <typename NewJobT>
@@ -326,6 +332,9 @@ private:
     }
 
     static auto rewrap(auto someOtherFuture) { return someOtherFuture; }
+
+    //! The future of the job handed out to this requester, see BaseJob::future()
+    QFuture<void> requesterFuture;
 };
 
 template <std::derived_from<BaseJob> JobT>
@@ -0,0 +1,155 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "slidingsyncjob.h"
+
+#include "../logging_categories_p.h"
+
+using namespace Quotient;
+
+static size_t jobId = 0;
+
+namespace {
+
+QJsonObject wrapEvents(const QJsonValue& events) { return { { "events"_L1, events } }; }
+
+//! Find the latest membership of \p userId among \p events, if any
+QString findMembership(const QJsonArray& events, const QString& userId)
+{
+    for (auto it = events.crbegin(); it != events.crend(); ++it) {
+        const auto eventJson = it->toObject();
+        if (eventJson.value(TypeKey) == "m.room.member"_L1
+            && eventJson.value(StateKeyKey) == userId)
+            return eventJson.value(ContentKey).toObject().value("membership"_L1).toString();
+    }
+    return {};
+}
+
+} // namespace
+
+SlidingSyncJob::SlidingSyncJob(QString localUserId, const QJsonObject& requestBody,
+                               const QString& pos, int timeout)
+    : BaseJob(HttpVerb::Post, "SlidingSyncJob-"_L1 + QString::number(++jobId),
+              "_matrix/client/unstable/org.matrix.simplified_msc3575/sync")
+    , localUserId(std::move(localUserId))
+{
+    setLoggingCategory(SYNCJOB);
+    QUrlQuery query;
+    addParam<IfNotEmpty>(query, u"pos"_s, pos);
+    if (timeout >= 0)
+        query.addQueryItem(u"timeout"_s, QString::number(timeout));
+    setRequestQuery(query);
+    setRequestData({ requestBody });
+    addExpectedKey(u"pos"_s);
+
+    setMaxRetries(std::numeric_limits<int>::max());
+}
+
+QJsonObject SlidingSyncJob::toSyncJson(const QJsonObject& slidingSyncJson,
+                                       const QString& localUserId)
+{
+    const auto extensions = slidingSyncJson.value("extensions"_L1).toObject();
+    const auto accountData = extensions.value("account_data"_L1).toObject();
+    const auto e2ee = extensions.value("e2ee"_L1).toObject();
+
+    // Extensions bring data for rooms in their own sections; gather them per room first
+    QHash<QString, QJsonObject> roomsJson;
+    const auto roomAccountData = accountData.value("rooms"_L1).toObject();
+    for (auto it = roomAccountData.begin(); it != roomAccountData.end(); ++it)
+        roomsJson[it.key()].insert("account_data"_L1, wrapEvents(*it));
+    QHash<QString, QJsonArray> ephemeral;
+    for (const auto& extensionName : { "receipts"_L1, "typing"_L1 }) {
+        const auto ephemeralJson = extensions.value(extensionName).toObject().value("rooms"_L1)
+                                       .toObject();
+        for (auto it = ephemeralJson.begin(); it != ephemeralJson.end(); ++it)
+            ephemeral[it.key()].append(*it);
+    }
+    for (auto it = ephemeral.cbegin(); it != ephemeral.cend(); ++it)
+        roomsJson[it.key()].insert("ephemeral"_L1, wrapEvents(*it));
+
+    QJsonObject joinedRooms;
+    QJsonObject invitedRooms;
+    QJsonObject leftRooms;
+    const auto slidingRoomsJson = slidingSyncJson.value("rooms"_L1).toObject();
+    for (auto it = slidingRoomsJson.begin(); it != slidingRoomsJson.end(); ++it) {
+        const auto slidingRoomJson = it->toObject();
+        auto roomJson = roomsJson.take(it.key());
+        if (const auto inviteState = slidingRoomJson.value("invite_state"_L1);
+            inviteState.isArray()) {
+            roomJson.insert("invite_state"_L1, wrapEvents(inviteState));
+            invitedRooms.insert(it.key(), roomJson);
+            continue;
+        }
+        const auto stateJson = slidingRoomJson.value("required_state"_L1).toArray();
+        const auto timelineJson = slidingRoomJson.value("timeline"_L1).toArray();
+        roomJson.insert("state"_L1, wrapEvents(stateJson));
+        roomJson.insert("timeline"_L1,
+                        QJsonObject{ { "events"_L1, timelineJson },
+                                     { "limited"_L1, slidingRoomJson.value("limited"_L1).toBool() },
+                                     { "prev_batch"_L1, slidingRoomJson.value("prev_batch"_L1) } });
+
+        QJsonObject summaryJson{ { "m.joined_member_count"_L1,
+                                   slidingRoomJson.value("joined_count"_L1) },
+                                 { "m.invited_member_count"_L1,
+                                   slidingRoomJson.value("invited_count"_L1) } };
+        if (const auto heroesJson = slidingRoomJson.value("heroes"_L1); heroesJson.isArray()) {
+            QJsonArray heroIds;
+            for (const auto& heroJson : heroesJson.toArray())
+                heroIds.append(heroJson.toObject().value("user_id"_L1));
+            summaryJson.insert("m.heroes"_L1, heroIds);
+        }
+        roomJson.insert("summary"_L1, summaryJson);
+        roomJson.insert(UnreadNotificationsKey,
+                        QJsonObject{ { "notification_count"_L1,
+                                       slidingRoomJson.value("notification_count"_L1) },
+                                     { HighlightCountKey,
+                                       slidingRoomJson.value(HighlightCountKey) } });
+
+        auto membership = findMembership(timelineJson, localUserId);
+        if (membership.isEmpty())
+            membership = findMembership(stateJson, localUserId);
+        (membership == "leave"_L1 || membership == "ban"_L1 ? leftRooms : joinedRooms)
+            .insert(it.key(), roomJson);
+    }
+    // What's left are rooms only updated by extensions
+    for (auto it = roomsJson.cbegin(); it != roomsJson.cend(); ++it)
+        joinedRooms.insert(it.key(), *it);
+
+    return { { "account_data"_L1, wrapEvents(accountData.value("global"_L1)) },
+             { "to_device"_L1, extensions.value("to_device"_L1) },
+             { "device_lists"_L1, e2ee.value("device_lists"_L1) },
+             { "device_one_time_keys_count"_L1, e2ee.value("device_one_time_keys_count"_L1) },
+             { "rooms"_L1, QJsonObject{ { "join"_L1, joinedRooms },
+                                        { "invite"_L1, invitedRooms },
+                                        { "leave"_L1, leftRooms } } } };
+}
+
+BaseJob::Status SlidingSyncJob::prepareResult()
+{
+    const auto json = jsonData();
+    _pos = json.value("pos"_L1).toString();
+    _toDeviceSince = json.value("extensions"_L1)
+                         .toObject()
+                         .value("to_device"_L1)
+                         .toObject()
+                         .value("next_batch"_L1)
+                         .toString();
+    const auto listsJson = json.value("lists"_L1).toObject();
+    for (auto it = listsJson.begin(); it != listsJson.end(); ++it)
+        _listCounts.insert(it.key(), it->toObject().value("count"_L1).toInt());
+    const auto roomsJson = json.value("rooms"_L1).toObject();
+    for (auto it = roomsJson.begin(); it != roomsJson.end(); ++it)
+        if (const auto bumpStamp = it->toObject().value("bump_stamp"_L1); bumpStamp.isDouble())
+            _bumpStamps.insert(it.key(), bumpStamp.toInteger());
+
+    d.parseJson(toSyncJson(json, localUserId));
+    return Success;
+}
+
+BaseJob::Status SlidingSyncJob::prepareError(Status currentStatus)
+{
+    const auto status = BaseJob::prepareError(currentStatus);
+    if (jsonData().value("errcode"_L1) == "M_UNKNOWN_POS"_L1)
+        return { UnknownPosError, status.message };
+    return status;
+}
@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "../syncdata.h"
+#include "basejob.h"
+
+namespace Quotient {
+
+//! \brief A request to the simplified sliding sync endpoint (MSC4186)
+//!
+//! The job posts a request body prepared by SlidingSync and converts the response to SyncData,
+//! so that it can be consumed by Connection and Room the same way as a response from /sync.
+//! The parts that only sliding sync has (room counts in lists, room activity stamps, positions
+//! for the next request) are available separately.
+class QUOTIENT_API SlidingSyncJob : public BaseJob {
+public:
+    enum {
+        //! The server doesn't recognise the position anymore; sync has to start over
+        UnknownPosError = UserDefinedError + 1
+    };
+
+    SlidingSyncJob(QString localUserId, const QJsonObject& requestBody, const QString& pos = {},
+                   int timeout = -1);
+
+    SyncData takeData() { return std::move(d); }
+
+    //! The position to pass to the next request
+    QString pos() const { return _pos; }
+    //! The token to pass in the to-device extension of the next request; empty if not changed
+    QString toDeviceSince() const { return _toDeviceSince; }
+    //! The total numbers of rooms in each requested list
+    const QHash<QString, int>& listCounts() const { return _listCounts; }
+    //! Activity stamps (`bump_stamp`) of the rooms that came with one in the response
+    const QHash<QString, qint64>& bumpStamps() const { return _bumpStamps; }
+
+    //! \brief Convert a sliding sync response to the layout of a /sync response
+    //!
+    //! Rooms with `invite_state` go to the `invite` section; rooms where the latest membership
+    //! of \p localUserId is `leave` or `ban` go to the `leave` section; the rest, including rooms
+    //! only mentioned by extensions, go to `join`. The result has no `next_batch`.
+    static QJsonObject toSyncJson(const QJsonObject& slidingSyncJson, const QString& localUserId);
+
+protected:
+    Status prepareResult() override;
+    Status prepareError(Status currentStatus) override;
+
+private:
+    QString localUserId;
+    SyncData d;
+    QString _pos;
+    QString _toDeviceSince;
+    QHash<QString, int> _listCounts;
+    QHash<QString, qint64> _bumpStamps;
+};
+
+} // namespace Quotient
@@ -0,0 +1,424 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "jsonreader.h"
+
+#include <QtCore/QJsonDocument>
+
+#include <cmath>
+#include <limits>
+
+using namespace Quotient;
+
+namespace {
+
+//! The same as the nesting limit of QJsonDocument
+constexpr int MaxDepth = 1024;
+
+bool isWhitespace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+//! Parse 4 hex digits at \p pos; -1 if they are not there
+int parseHex4(QByteArrayView text, qsizetype pos)
+{
+    if (pos + 4 > text.size())
+        return -1;
+    int result = 0;
+    for (const auto c : text.sliced(pos, 4)) {
+        result <<= 4;
+        if (isDigit(c))
+            result |= c - '0';
+        else if (c >= 'a' && c <= 'f')
+            result |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            result |= c - 'A' + 10;
+        else
+            return -1;
+    }
+    return result;
+}
+
+void appendUtf8(QByteArray& buffer, char32_t cp)
+{
+    if (cp < 0x80)
+        buffer.append(char(cp));
+    else if (cp < 0x800)
+        buffer.append(char(0xC0 | (cp >> 6))).append(char(0x80 | (cp & 0x3F)));
+    else if (cp < 0x10000)
+        buffer.append(char(0xE0 | (cp >> 12)))
+            .append(char(0x80 | ((cp >> 6) & 0x3F)))
+            .append(char(0x80 | (cp & 0x3F)));
+    else
+        buffer.append(char(0xF0 | (cp >> 18)))
+            .append(char(0x80 | ((cp >> 12) & 0x3F)))
+            .append(char(0x80 | ((cp >> 6) & 0x3F)))
+            .append(char(0x80 | (cp & 0x3F)));
+}
+
+} // namespace
+
+void JsonReader::skipWhitespace()
+{
+    while (pos < json.size() && isWhitespace(json[pos]))
+        ++pos;
+}
+
+void JsonReader::fail(const char* what)
+{
+    if (error.isEmpty())
+        error = u"%1 at offset %2"_s.arg(QLatin1StringView(what)).arg(pos);
+    pos = json.size(); // Nothing more to read
+}
+
+bool JsonReader::expectLiteral(QByteArrayView literal)
+{
+    if (!json.sliced(pos).startsWith(literal)) {
+        fail("Invalid literal");
+        return false;
+    }
+    pos += literal.size();
+    return true;
+}
+
+JsonReader::ValueType JsonReader::peek()
+{
+    skipWhitespace();
+    if (pos >= json.size())
+        return Undefined;
+    switch (const auto c = json[pos]) {
+    case '{':
+        return Object;
+    case '[':
+        return Array;
+    case '"':
+        return String;
+    case 't':
+    case 'f':
+        return Bool;
+    case 'n':
+        return Null;
+    default:
+        return c == '-' || isDigit(c) ? Number : Undefined;
+    }
+}
+
+bool JsonReader::enterObject()
+{
+    if (peek() != Object) {
+        skipValue();
+        return false;
+    }
+    if (++depth > MaxDepth) {
+        fail("Too deep nesting");
+        return false;
+    }
+    ++pos;
+    firstInContainer = true;
+    return true;
+}
+
+bool JsonReader::enterArray()
+{
+    if (peek() != Array) {
+        skipValue();
+        return false;
+    }
+    if (++depth > MaxDepth) {
+        fail("Too deep nesting");
+        return false;
+    }
+    ++pos;
+    firstInContainer = true;
+    return true;
+}
+
+bool JsonReader::nextInContainer(char closingChar)
+{
+    skipWhitespace();
+    if (pos >= json.size()) {
+        fail("Unexpected end of JSON");
+        return false;
+    }
+    if (json[pos] == closingChar) {
+        ++pos;
+        --depth;
+        firstInContainer = false; // The enclosing container (if any) already has a value
+        return false;
+    }
+    if (!std::exchange(firstInContainer, false)) {
+        if (json[pos] != ',') {
+            fail("Missing comma");
+            return false;
+        }
+        ++pos;
+        skipWhitespace();
+    }
+    return true;
+}
+
+std::optional<QByteArrayView> JsonReader::nextKey()
+{
+    if (!nextInContainer('}'))
+        return std::nullopt;
+    if (pos >= json.size() || json[pos] != '"') {
+        fail("Missing object key");
+        return std::nullopt;
+    }
+    const auto key = readRawString(keyBuffer);
+    skipWhitespace();
+    if (pos >= json.size() || json[pos] != ':') {
+        fail("Missing colon after object key");
+        return std::nullopt;
+    }
+    ++pos;
+    return key;
+}
+
+bool JsonReader::nextElement() { return nextInContainer(']'); }
+
+QByteArrayView JsonReader::readRawString(QByteArray& unescapeBuffer)
+{
+    const auto start = ++pos; // Skip the opening quote
+    // Most strings have no escapes and can be returned as they are
+    for (; pos < json.size(); ++pos) {
+        const auto c = json[pos];
+        if (c == '"')
+            return json.sliced(start, pos++ - start);
+        if (c == '\\')
+            break;
+        if (uchar(c) < 0x20) {
+            fail("Control character in a string");
+            return {};
+        }
+    }
+    unescapeBuffer.clear();
+    unescapeBuffer.append(json.sliced(start, pos - start));
+    while (pos < json.size()) {
+        const auto c = json[pos++];
+        if (c == '"')
+            return unescapeBuffer;
+        if (uchar(c) < 0x20) {
+            fail("Control character in a string");
+            return {};
+        }
+        if (c != '\\') {
+            unescapeBuffer.append(c);
+            continue;
+        }
+        if (pos >= json.size())
+            break;
+        switch (json[pos++]) {
+        case '"':
+            unescapeBuffer.append('"');
+            break;
+        case '\\':
+            unescapeBuffer.append('\\');
+            break;
+        case '/':
+            unescapeBuffer.append('/');
+            break;
+        case 'b':
+            unescapeBuffer.append('\b');
+            break;
+        case 'f':
+            unescapeBuffer.append('\f');
+            break;
+        case 'n':
+            unescapeBuffer.append('\n');
+            break;
+        case 'r':
+            unescapeBuffer.append('\r');
+            break;
+        case 't':
+            unescapeBuffer.append('\t');
+            break;
+        case 'u': {
+            const auto unit = parseHex4(json, pos);
+            if (unit < 0) {
+                fail("Invalid \\u escape in a string");
+                return {};
+            }
+            pos += 4;
+            char32_t cp = char32_t(unit);
+            if (unit >= 0xD800 && unit < 0xDC00) { // A high surrogate, expecting a low one
+                const auto lowUnit = json.sliced(pos).startsWith("\\u") ? parseHex4(json, pos + 2)
+                                                                        : -1;
+                if (lowUnit >= 0xDC00 && lowUnit < 0xE000) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + char32_t(lowUnit - 0xDC00);
+                    pos += 6;
+                } else
+                    cp = 0xFFFD;
+            } else if (unit >= 0xDC00 && unit < 0xE000) // A lone low surrogate
+                cp = 0xFFFD;
+            appendUtf8(unescapeBuffer, cp);
+            break;
+        }
+        default:
+            fail("Invalid escape sequence in a string");
+            return {};
+        }
+    }
+    fail("Unterminated string");
+    return {};
+}
+
+QByteArrayView JsonReader::readNumberText()
+{
+    const auto start = pos;
+    const auto skipDigits = [this] {
+        const auto digitsStart = pos;
+        while (pos < json.size() && isDigit(json[pos]))
+            ++pos;
+        return pos > digitsStart;
+    };
+    if (json[pos] == '-')
+        ++pos;
+    if (pos < json.size() && json[pos] == '0')
+        ++pos;
+    else if (!skipDigits()) {
+        fail("Invalid number");
+        return {};
+    }
+    if (pos < json.size() && json[pos] == '.') {
+        ++pos;
+        if (!skipDigits()) {
+            fail("Invalid number");
+            return {};
+        }
+    }
+    if (pos < json.size() && (json[pos] == 'e' || json[pos] == 'E')) {
+        ++pos;
+        if (pos < json.size() && (json[pos] == '+' || json[pos] == '-'))
+            ++pos;
+        if (!skipDigits()) {
+            fail("Invalid number");
+            return {};
+        }
+    }
+    return json.sliced(start, pos - start);
+}
+
+bool JsonReader::readBool()
+{
+    if (peek() != Bool) {
+        skipValue();
+        return false;
+    }
+    if (json[pos] == 't')
+        return expectLiteral("true");
+    expectLiteral("false");
+    return false;
+}
+
+int JsonReader::readInt()
+{
+    const auto value = readDouble();
+    return value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max()
+                   && value == std::trunc(value)
+               ? int(value)
+               : 0;
+}
+
+qint64 JsonReader::readInteger()
+{
+    if (peek() != Number) {
+        skipValue();
+        return 0;
+    }
+    const auto text = readNumberText();
+    bool ok = false;
+    if (const auto value = text.toLongLong(&ok); ok)
+        return value;
+    return qint64(text.toDouble());
+}
+
+double JsonReader::readDouble()
+{
+    if (peek() != Number) {
+        skipValue();
+        return 0;
+    }
+    return readNumberText().toDouble();
+}
+
+QString JsonReader::readString()
+{
+    if (peek() != String) {
+        skipValue();
+        return {};
+    }
+    QByteArray unescapeBuffer; // Doesn't allocate unless there are escapes
+    return QString::fromUtf8(readRawString(unescapeBuffer));
+}
+
+void JsonReader::skipValue()
+{
+    switch (peek()) {
+    case Object:
+        if (enterObject())
+            while (nextKey())
+                skipValue();
+        break;
+    case Array:
+        if (enterArray())
+            while (nextElement())
+                skipValue();
+        break;
+    case String:
+        readRawString(keyBuffer);
+        break;
+    case Number:
+        readNumberText();
+        break;
+    case Bool:
+        expectLiteral(json[pos] == 't' ? "true" : "false");
+        break;
+    case Null:
+        expectLiteral("null");
+        break;
+    case Undefined:
+        fail(pos < json.size() ? "Unexpected character" : "Unexpected end of JSON");
+    }
+}
+
+QByteArrayView JsonReader::readRaw()
+{
+    skipWhitespace();
+    const auto start = pos;
+    skipValue();
+    return hasError() ? QByteArrayView() : json.sliced(start, pos - start);
+}
+
+QJsonValue JsonReader::readJsonValue()
+{
+    switch (peek()) {
+    case Object:
+    case Array: {
+        const auto doc = QJsonDocument::fromJson(readRaw().toByteArray());
+        return doc.isObject() ? QJsonValue(doc.object()) : QJsonValue(doc.array());
+    }
+    case String:
+        return readString();
+    case Number: {
+        const auto text = readNumberText();
+        bool ok = false;
+        if (const auto value = text.toLongLong(&ok); ok)
+            return value;
+        return text.toDouble();
+    }
+    case Bool:
+        return readBool();
+    case Null:
+        expectLiteral("null");
+        return QJsonValue::Null;
+    case Undefined:
+        skipValue(); // Report the error
+    }
+    return QJsonValue::Undefined;
+}
+
+bool JsonReader::atEnd()
+{
+    skipWhitespace();
+    return !hasError() && pos == json.size();
+}
@@ -0,0 +1,234 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "converters.h"
+
+#include <QtCore/QByteArrayView>
+
+namespace Quotient {
+
+//! \brief A pull parser reading JSON values straight from UTF-8 text
+//!
+//! Unlike QJsonDocument, JsonReader doesn't build any intermediate representation: callers walk
+//! the text value by value, decoding what they need and skipping the rest. Once the text turns
+//! out to be malformed, hasError() becomes true and all further calls return empty values.
+//! \sa fromJsonBytes
+class QUOTIENT_API JsonReader {
+public:
+    enum ValueType : uint8_t { Undefined, Null, Bool, Number, String, Array, Object };
+
+    explicit JsonReader(QByteArrayView json) : json(json) {}
+
+    //! The type of the value at the current position; Undefined at the end or after an error
+    ValueType peek();
+
+    //! \brief Enter the object at the current position
+    //! \return false if there's no object at the current position, skipping the value
+    bool enterObject();
+    //! \brief Read the next key of the current object, leaving the position at its value
+    //!
+    //! The value has to be read or skipped before the next call; the returned key is only valid
+    //! until then.
+    //! \return the key in UTF-8; std::nullopt once the object ends
+    std::optional<QByteArrayView> nextKey();
+
+    //! \brief Enter the array at the current position
+    //! \return false if there's no array at the current position, skipping the value
+    bool enterArray();
+    //! \brief Move to the next element of the current array
+    //! \return false once the array ends
+    bool nextElement();
+
+    //! \brief Read the value at the current position, expecting a certain type
+    //!
+    //! If the value has a different type it is skipped, and an empty value is returned -
+    //! the same as QJsonValue::toBool(), toString() etc. would do.
+    bool readBool();
+    //! An integral value; 0 for numbers with a fractional part, like QJsonValue::toInt()
+    int readInt();
+    //! The number truncated to an integer, like `qint64(QJsonValue::toDouble())`
+    qint64 readInteger();
+    double readDouble();
+    QString readString();
+
+    //! Skip the value at the current position
+    void skipValue();
+    //! Skip the value at the current position, returning its JSON text
+    QByteArrayView readRaw();
+    //! \brief Read the value at the current position into a QJsonValue
+    //!
+    //! This is the fallback for types that can't be decoded from JSON text directly.
+    QJsonValue readJsonValue();
+
+    //! Check that nothing but whitespace is left after the top-level value
+    bool atEnd();
+    bool hasError() const { return !error.isEmpty(); }
+    QString errorString() const { return error; }
+
+private:
+    QByteArrayView json;
+    qsizetype pos = 0;
+    //! Whether the next key or element will be the first in the current object or array
+    bool firstInContainer = false;
+    int depth = 0;
+    QString error;
+
+    void skipWhitespace();
+    void fail(const char* what);
+    //! Check that the JSON text at the current position starts with \p literal and skip it
+    bool expectLiteral(QByteArrayView literal);
+    bool nextInContainer(char closingChar);
+    //! Unescape the string at the current position into UTF-8
+    QByteArrayView readRawString(QByteArray& unescapeBuffer);
+    QByteArrayView readNumberText();
+    //! Buffer for keys that need unescaping
+    QByteArray keyBuffer;
+};
+
+template <typename T>
+void readJson(JsonReader& reader, T& target);
+
+namespace _impl {
+    template <typename T>
+    concept HasJsonFieldTable = requires { JsonObjectConverter<T>::fields; };
+
+    template <typename T>
+    constexpr bool IsOptional = false;
+    template <typename T>
+    constexpr bool IsOptional<std::optional<T>> = true;
+
+    template <typename T>
+    concept JsonObjectMap = requires(T& m, QString k) {
+        typename T::mapped_type;
+        m[k] = std::declval<typename T::mapped_type>();
+    };
+
+    template <typename T>
+    concept JsonArrayContainer =
+        !std::is_same_v<T, QString> && !std::is_same_v<T, QByteArray>
+        && !std::is_same_v<T, QJsonArray> && requires(T& c) {
+               typename T::value_type;
+               c.emplace_back();
+           };
+
+    template <typename StructT>
+    bool readJsonField(JsonReader& reader, QLatin1StringView key, StructT& target,
+                       const auto& field);
+
+    template <typename StructT>
+    inline bool readJsonFieldFromTable(JsonReader& reader, QLatin1StringView key,
+                                       StructT& target)
+    {
+        return std::apply(
+            [&](const auto&... fields) {
+                return (readJsonField(reader, key, target, fields) || ...);
+            },
+            JsonObjectConverter<StructT>::fields);
+    }
+
+    template <typename StructT>
+    inline bool readJsonField(JsonReader& reader, QLatin1StringView key, StructT& target,
+                              const auto& field)
+    {
+        if constexpr (requires { field.member; }) {
+            if (key != field.key)
+                return false;
+            readJson(reader, target.*field.member);
+            return true;
+        } else // JsonParent
+            return [&]<typename ParentT>(JsonParent<ParentT>) {
+                return readJsonFieldFromTable(reader, key, static_cast<ParentT&>(target));
+            }(field);
+    }
+} // namespace _impl
+
+//! \brief Fill \p target from the JSON value at the current position of \p reader
+//!
+//! Structures with compile-time field tables (see JsonField), containers, optionals and basic
+//! types are decoded in one pass over the text; anything else goes through readJsonValue()
+//! and fromJson(). The conversion rules are the same as those of fromJson().
+template <typename T>
+inline void readJson(JsonReader& reader, T& target)
+{
+    if constexpr (std::is_same_v<T, bool>)
+        target = reader.readBool();
+    else if constexpr (std::is_same_v<T, int>)
+        target = reader.readInt();
+    else if constexpr (std::is_same_v<T, qint64>)
+        target = reader.readInteger();
+    else if constexpr (std::is_floating_point_v<T>)
+        target = T(reader.readDouble());
+    else if constexpr (std::is_same_v<T, QString>)
+        target = reader.readString();
+    else if constexpr (std::is_same_v<T, QUrl>)
+        target = QUrl(reader.readString());
+    else if constexpr (std::is_same_v<T, QJsonValue>)
+        target = reader.readJsonValue();
+    else if constexpr (std::is_same_v<T, QJsonObject>)
+        target = reader.readJsonValue().toObject();
+    else if constexpr (std::is_same_v<T, QJsonArray>)
+        target = reader.readJsonValue().toArray();
+    else if constexpr (_impl::IsOptional<T>) {
+        if (const auto type = reader.peek();
+            type == JsonReader::Null || type == JsonReader::Undefined) {
+            reader.skipValue();
+            target.reset();
+        } else
+            readJson(reader, target.emplace());
+    } else if constexpr (std::is_same_v<T, QSet<QString>>) {
+        if (reader.enterObject())
+            while (const auto key = reader.nextKey()) {
+                target.insert(QString::fromUtf8(*key));
+                reader.skipValue();
+            }
+    } else if constexpr (_impl::JsonObjectMap<T>) {
+        if (reader.enterObject())
+            while (const auto key = reader.nextKey())
+                readJson(reader, target[QString::fromUtf8(*key)]);
+    } else if constexpr (_impl::JsonArrayContainer<T>) {
+        if (reader.enterArray())
+            while (reader.nextElement())
+                readJson(reader, target.emplace_back());
+    } else if constexpr (_impl::HasJsonFieldTable<T>) {
+        if (reader.enterObject())
+            while (const auto key = reader.nextKey())
+                if (!_impl::readJsonFieldFromTable(reader, QLatin1StringView(*key), target))
+                    reader.skipValue();
+    } else
+        target = fromJson<T>(reader.readJsonValue());
+}
+
+//! \brief Decode \p T from JSON text
+//!
+//! This is the counterpart of `fromJson<T>(QJsonDocument::fromJson(json))` that doesn't build
+//! a QJsonDocument; a default-constructed value is returned if \p json is malformed.
+template <typename T>
+inline T fromJsonBytes(QByteArrayView json)
+{
+    T result{};
+    JsonReader reader(json);
+    readJson(reader, result);
+    return reader.atEnd() ? result : T{};
+}
+
+//! \brief Decode \p T from the value at \p key in the JSON object in \p json
+//! \return std::nullopt if \p json is malformed or there's no such key in it
+template <typename T>
+inline std::optional<T> fromJsonBytes(QByteArrayView json, QAnyStringView key)
+{
+    JsonReader reader(json);
+    if (reader.enterObject())
+        while (const auto k = reader.nextKey()) {
+            if (QAnyStringView::equal(QUtf8StringView(k->data(), k->size()), key)) {
+                T result{};
+                readJson(reader, result);
+                return reader.hasError() ? std::nullopt : std::optional(std::move(result));
+            }
+            reader.skipValue();
+        }
+    return std::nullopt;
+}
+
+} // namespace Quotient
@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "membernamesindex.h"
+
+using namespace Quotient;
+
+MemberNamesIndex::MemberNamesIndex(IdPool& idPool) : _idPool(&idPool) {}
+
+bool MemberNamesIndex::insert(const QString& userId, const QString& name)
+{
+    const auto userHandle = _idPool->intern(userId);
+    if (_names.contains(userHandle))
+        return false;
+    _names.insert(userHandle, name);
+    _namesakes[name].insert(userHandle);
+    return true;
+}
+
+bool MemberNamesIndex::remove(const QString& userId)
+{
+    const auto userHandle = _idPool->find(userId);
+    const auto nameIt = _names.find(userHandle);
+    if (nameIt == _names.end())
+        return false;
+    const auto it = _namesakes.find(*nameIt);
+    _names.erase(nameIt);
+    Q_ASSERT(it != _namesakes.end());
+    it->remove(userHandle);
+    if (it->isEmpty())
+        _namesakes.erase(it);
+    return true;
+}
+
+bool MemberNamesIndex::contains(const QString& userId) const
+{
+    return _names.contains(_idPool->find(userId));
+}
+
+QString MemberNamesIndex::nameOf(const QString& userId) const
+{
+    return _names.value(_idPool->find(userId));
+}
+
+qsizetype MemberNamesIndex::namesakeCount(const QString& name) const
+{
+    const auto it = _namesakes.constFind(name);
+    return it != _namesakes.cend() ? it->size() : 0;
+}
+
+QString MemberNamesIndex::onlyMemberNamed(const QString& name) const
+{
+    const auto it = _namesakes.constFind(name);
+    return it != _namesakes.cend() && it->size() == 1 ? it->cbegin()->toString() : QString();
+}
+
+QString MemberNamesIndex::onlyNamesakeOf(const QString& userId) const
+{
+    const auto userHandle = _idPool->find(userId);
+    const auto nameIt = _names.constFind(userHandle);
+    if (nameIt == _names.cend())
+        return {};
+    const auto it = _namesakes.constFind(*nameIt);
+    Q_ASSERT(it != _namesakes.cend());
+    if (it->size() != 2)
+        return {};
+    const auto first = it->cbegin();
+    return (*first == userHandle ? *std::next(first) : *first).toString();
+}
+
+bool MemberNamesIndex::needsDisambiguation(const QString& userId) const
+{
+    const auto it = _names.constFind(_idPool->find(userId));
+    return it != _names.cend() && namesakeCount(*it) > 1;
+}
+
+QStringList MemberNamesIndex::userIds() const
+{
+    QStringList ids;
+    ids.reserve(_names.size());
+    for (auto it = _names.cbegin(); it != _names.cend(); ++it)
+        ids.push_back(it.key().toString());
+    return ids;
+}
@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "idpool.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
+
+namespace Quotient {
+
+//! \brief An index of display names of joined members in a room
+//!
+//! The index maps each member to their display name and each display name to the set of
+//! members having it, so that both finding namesakes of a member and updating the index when
+//! the member joins, leaves or is renamed take constant time, regardless of the number of
+//! members in the room.
+class QUOTIENT_API MemberNamesIndex {
+public:
+    explicit MemberNamesIndex(IdPool& idPool);
+
+    //! \brief Add \p userId with \p name
+    //! \return false if \p userId is already in the index, in which case it's left intact
+    bool insert(const QString& userId, const QString& name);
+    //! \brief Remove \p userId
+    //! \return false if \p userId is not in the index
+    bool remove(const QString& userId);
+
+    bool contains(const QString& userId) const;
+    //! The name \p userId was added with, or an empty string if \p userId is not in the index
+    QString nameOf(const QString& userId) const;
+    //! The number of members having \p name
+    qsizetype namesakeCount(const QString& name) const;
+    //! The id of the member having \p name if there's exactly one, or an empty string
+    QString onlyMemberNamed(const QString& name) const;
+    //! The id of the other member if \p userId has exactly one namesake, or an empty string
+    QString onlyNamesakeOf(const QString& userId) const;
+    //! Whether \p userId is in the index and has namesakes
+    bool needsDisambiguation(const QString& userId) const;
+
+    QStringList userIds() const;
+    qsizetype size() const { return _names.size(); }
+    bool isEmpty() const { return _names.isEmpty(); }
+
+private:
+    IdPool* _idPool;
+    QHash<InternedId, QString> _names;
+    QHash<QString, QSet<InternedId>> _namesakes;
+};
+
+} // namespace Quotient
@@ -0,0 +1,155 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "messagesearch.h"
+
+#include "connection.h"
+#include "logging_categories_p.h"
+#include "room.h"
+#include "searchindex.h"
+
+#include "csapi/search.h"
+
+using namespace Quotient;
+
+class MessageSearch::Private {
+public:
+    Private(MessageSearch* q, Connection* connection, QString query)
+        : q(q), connection(connection), query(std::move(query))
+    {}
+
+    MessageSearch* q;
+    Connection* connection;
+    QString query;
+    int pageSize = 20;
+    std::vector<Result> results;
+    QSet<QString> resultIds;
+
+    //! Rooms for the server to search in; all rooms if empty
+    QStringList serverRoomIds;
+    bool serverAtEnd = false;
+    QString serverNextBatch;
+    JobHandle<SearchJob> serverJob;
+
+    //! Rooms to search in the local index; all indexed rooms if empty
+    QStringList localRoomIds;
+    bool localAtEnd = false;
+    bool localLoading = false;
+    QString localNextBatch;
+
+    void loadServerPage();
+    void loadLocalPage();
+    void appendResults(std::vector<Result>&& page);
+};
+
+void MessageSearch::Private::loadServerPage()
+{
+    SearchJob::RoomEventsCriteria criteria{ .searchTerm = query, .orderBy = u"recent"_s };
+    criteria.filter.limit = pageSize;
+    criteria.filter.rooms = serverRoomIds;
+    serverJob = connection->callApi<SearchJob>(SearchJob::Categories{ criteria }, serverNextBatch);
+    serverJob->setDirectJsonDecoding();
+    QObject::connect(serverJob, &BaseJob::success, q, [this, job = serverJob.get()] {
+        auto categories = collectResponse(job);
+        serverNextBatch.clear();
+        std::vector<Result> page;
+        if (categories.roomEvents) {
+            for (auto& r : categories.roomEvents->results)
+                if (r.result) {
+                    const auto& e = *r.result;
+                    page.push_back({ e.roomId(), e.id(), e.senderId(), e.originTimestamp(),
+                                     std::move(r.result) });
+                }
+            serverNextBatch = categories.roomEvents->nextBatch;
+        }
+        serverAtEnd = serverNextBatch.isEmpty();
+        appendResults(std::move(page));
+    });
+    QObject::connect(serverJob, &BaseJob::failure, q, [this, job = serverJob.get()] {
+        qCWarning(MAIN) << "Server-side search failed:" << job->errorString();
+        emit q->searchError(job->errorString());
+    });
+    QObject::connect(serverJob, &BaseJob::finished, q, &MessageSearch::loadingChanged);
+    emit q->loadingChanged();
+}
+
+void MessageSearch::Private::loadLocalPage()
+{
+    auto* index = connection->searchIndex();
+    if (!index) { // The index has been disabled since the search was created
+        localAtEnd = true;
+        return;
+    }
+    localLoading = true;
+    index->search(query, localRoomIds, pageSize, localNextBatch)
+        .then(q, [this](const SearchIndex::Results& found) {
+            localLoading = false;
+            localNextBatch = found.nextBatch;
+            localAtEnd = localNextBatch.isEmpty();
+            std::vector<Result> page;
+            page.reserve(size_t(found.hits.size()));
+            for (const auto& hit : found.hits)
+                page.push_back({ hit.roomId, hit.eventId, hit.senderId, hit.timestamp, nullptr });
+            appendResults(std::move(page));
+            emit q->loadingChanged();
+        });
+    emit q->loadingChanged();
+}
+
+void MessageSearch::Private::appendResults(std::vector<Result>&& page)
+{
+    // The sources search different rooms but the server may still know a few encrypted
+    // messages, e.g. from before encryption was switched on in the room
+    std::erase_if(page, [this](const Result& r) { return resultIds.contains(r.eventId); });
+    if (page.empty())
+        return;
+    const auto first = int(results.size());
+    for (auto& r : page) {
+        resultIds.insert(r.eventId);
+        results.push_back(std::move(r));
+    }
+    emit q->resultsAdded(first, int(page.size()));
+}
+
+MessageSearch::MessageSearch(Connection* connection, const QString& query,
+                             const QStringList& roomIds, QObject* parent)
+    : QObject(parent), d(makeImpl<Private>(this, connection, query))
+{
+    const auto useIndex = connection->searchIndex() != nullptr;
+    d->localAtEnd = !useIndex;
+    // With no rooms given, each source searches everything it can: the server skips encrypted
+    // rooms, and the index only has messages from encrypted rooms
+    for (const auto& roomId : roomIds) {
+        auto* room = connection->room(roomId);
+        (useIndex && room && room->usesEncryption() ? d->localRoomIds : d->serverRoomIds)
+            .push_back(roomId);
+    }
+    if (!roomIds.isEmpty()) {
+        d->serverAtEnd = d->serverRoomIds.isEmpty();
+        d->localAtEnd = d->localRoomIds.isEmpty();
+    }
+    if (query.trimmed().isEmpty())
+        d->serverAtEnd = d->localAtEnd = true;
+}
+
+MessageSearch::~MessageSearch() { d->serverJob.abandon(); }
+
+QString MessageSearch::query() const { return d->query; }
+
+const std::vector<MessageSearch::Result>& MessageSearch::results() const { return d->results; }
+
+int MessageSearch::pageSize() const { return d->pageSize; }
+
+void MessageSearch::setPageSize(int newSize) { d->pageSize = std::max(newSize, 1); }
+
+bool MessageSearch::isLoading() const { return isJobPending(d->serverJob) || d->localLoading; }
+
+bool MessageSearch::canFetchMore() const { return !d->serverAtEnd || !d->localAtEnd; }
+
+void MessageSearch::fetchMore()
+{
+    if (!d->serverAtEnd && !isJobPending(d->serverJob))
+        d->loadServerPage();
+    if (!d->localAtEnd && !d->localLoading)
+        d->loadLocalPage();
+}
@@ -0,0 +1,77 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "quotient_export.h"
+#include "util.h"
+
+#include "events/roomevent.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QObject>
+
+namespace Quotient {
+
+class Connection;
+
+//! \brief A search for messages containing given text
+//!
+//! MessageSearch combines two sources of results. Rooms without encryption are searched by
+//! the server (see SearchJob), page by page as fetchMore() is called; encrypted rooms, which
+//! the server cannot look into, are searched in the local index (see SearchIndex), if it is
+//! enabled on the connection. Both sources are queried at the same time; each page of results
+//! is appended to results() as soon as it arrives, most recent messages first within the page,
+//! and announced with resultsAdded().
+//!
+//! The first page is requested by calling fetchMore(), after adjusting pageSize() if needed.
+class QUOTIENT_API MessageSearch : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(QString query READ query CONSTANT)
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged)
+public:
+    struct Result {
+        QString roomId;
+        QString eventId;
+        QString senderId;
+        QDateTime timestamp;
+        //! \brief The message as returned by the server
+        //!
+        //! This is nullptr for messages found in the local index; these can be looked up
+        //! with Room::findInTimeline() if they are loaded.
+        RoomEventPtr event;
+    };
+
+    //! \brief Prepare a search for \p query on \p connection
+    //! \param roomIds the rooms to search in; all rooms are searched if empty
+    MessageSearch(Connection* connection, const QString& query, const QStringList& roomIds = {},
+                  QObject* parent = nullptr);
+    ~MessageSearch() override;
+
+    QString query() const;
+    //! The results found so far, in the order of arrival
+    const std::vector<Result>& results() const;
+
+    //! The number of results requested at once from each source
+    int pageSize() const;
+    void setPageSize(int newSize);
+
+    //! Whether a request to either source is pending
+    bool isLoading() const;
+    //! Whether either source may have more results
+    bool canFetchMore() const;
+    //! Request the next page of results from each source that has more of them
+    Q_INVOKABLE void fetchMore();
+
+Q_SIGNALS:
+    //! \p count results have been appended to results(), starting at \p first
+    void resultsAdded(int first, int count);
+    void loadingChanged();
+    void searchError(QString message);
+
+private:
+    class Private;
+    ImplPtr<Private> d;
+};
+
+} // namespace Quotient
@@ -11,11 +11,14 @@
 #include "jobs/downloadfilejob.h" // For DownloadFileJob::makeRequestUrl() only
 
 #include <QtCore/QCoreApplication>
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QHash>
 #include <QtCore/QReadWriteLock>
 #include <QtCore/QSettings>
 #include <QtCore/QStringBuilder>
 #include <QtCore/QThread>
 #include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QSslConfiguration>
 
 using namespace Quotient;
 
@@ -88,12 +91,86 @@ public:
         }
     }
 
+
+    struct TransportOptions {
+        bool http2Allowed = true;
+        std::chrono::seconds keepAliveTimeout{ 300 };
+        bool tlsSessionResumption = true;
+        std::chrono::milliseconds http2FallbackPeriod = std::chrono::hours(1);
+    };
+
+    TransportOptions getTransportOptions() const
+    {
+        const QReadLocker _(&namLock);
+        return transportOptions;
+    }
+    void updateTransportOptions(std::invocable<TransportOptions&> auto updater)
+    {
+        const QWriteLocker _(&namLock);
+        updater(transportOptions);
+    }
+    bool isHttp2FallbackHost(const QString& host) const
+    {
+        const QReadLocker _(&namLock);
+        const auto it = http2FallbackHosts.constFind(host);
+        return it != http2FallbackHosts.cend() && !it->hasExpired();
+    }
+    void addHttp2FallbackHost(const QString& host)
+    {
+        const QWriteLocker _(&namLock);
+        if (const auto it = http2FallbackHosts.constFind(host);
+            it == http2FallbackHosts.cend() || it->hasExpired()) {
+            qCWarning(NETWORK) << "HTTP/2 failed at the protocol level with" << host
+                               << "- falling back to HTTP/1.1 for this host for"
+                               << transportOptions.http2FallbackPeriod.count() << "ms";
+            http2FallbackHosts.insert(host, QDeadlineTimer(transportOptions.http2FallbackPeriod));
+        }
+    }
+    void clearHttp2FallbackHosts()
+    {
+        const QWriteLocker _(&namLock);
+        http2FallbackHosts.clear();
+    }
+
 private:
     mutable QReadWriteLock namLock{};
     std::vector<ConnectionData> connectionData{};
     QList<QSslError> ignoredSslErrors{};
+    TransportOptions transportOptions{};
+    QHash<QString, QDeadlineTimer> http2FallbackHosts{};
 } d;
 
+void applyTransportOptions(QNetworkRequest& request)
+{
+    const auto options = d.getTransportOptions();
+    // Only touch the HTTP/2 attribute if the client code didn't set it explicitly
+    if (!request.attribute(QNetworkRequest::Http2AllowedAttribute).isValid())
+        request.setAttribute(QNetworkRequest::Http2AllowedAttribute,
+                             options.http2Allowed && !d.isHttp2FallbackHost(request.url().host()));
+    if (options.keepAliveTimeout.count() > 0)
+        request.setAttribute(QNetworkRequest::ConnectionCacheExpiryTimeoutSecondsAttribute,
+                             int(options.keepAliveTimeout.count()));
+    if (options.tlsSessionResumption && request.url().scheme() == "https"_L1) {
+        auto sslConfig = request.sslConfiguration();
+        sslConfig.setSslOption(QSsl::SslOptionDisableSessionTickets, false);
+        sslConfig.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+        request.setSslConfiguration(sslConfig);
+    }
+}
+
+void watchForHttp2Failures(QNetworkReply* reply)
+{
+    if (!reply->request().attribute(QNetworkRequest::Http2AllowedAttribute).toBool())
+        return;
+    QObject::connect(reply, &QNetworkReply::errorOccurred, reply,
+                     [reply](QNetworkReply::NetworkError code) {
+                         // Only protocol violations count; a closed connection is what servers
+                         // normally do to HTTP/2 clients with GOAWAY or on idle timeout
+                         if (code == QNetworkReply::ProtocolFailure)
+                             d.addHttp2FallbackHost(reply->url().host());
+                     });
+}
+
 } // anonymous namespace
 
 void NetworkAccessManager::addAccount(const QString& accountId, const QUrl& homeserver,
@@ -135,6 +212,31 @@ void NetworkAccessManager::clearIgnoredSslErrors()
     d.clearIgnoredSslErrors();
 }
 
+void NetworkAccessManager::setHttp2Allowed(bool allowed)
+{
+    d.updateTransportOptions([allowed](auto& options) { options.http2Allowed = allowed; });
+}
+
+bool NetworkAccessManager::http2Allowed() { return d.getTransportOptions().http2Allowed; }
+
+void NetworkAccessManager::setHttp2FallbackPeriod(std::chrono::milliseconds period)
+{
+    d.updateTransportOptions([period](auto& options) { options.http2FallbackPeriod = period; });
+}
+
+void NetworkAccessManager::clearHttp2Fallbacks() { d.clearHttp2FallbackHosts(); }
+
+void NetworkAccessManager::setKeepAliveTimeout(std::chrono::seconds timeout)
+{
+    d.updateTransportOptions([timeout](auto& options) { options.keepAliveTimeout = timeout; });
+}
+
+void NetworkAccessManager::setTlsSessionResumption(bool enabled)
+{
+    d.updateTransportOptions(
+        [enabled](auto& options) { options.tlsSessionResumption = enabled; });
+}
+
 NetworkAccessManager* NetworkAccessManager::instance()
 {
     thread_local auto* nam = [] {
@@ -151,9 +253,12 @@ QNetworkReply* NetworkAccessManager::createRequest(
 {
     const auto url = request.url();
     if (url.scheme() != "mxc"_L1) {
+        QNetworkRequest tunedRequest(request);
+        applyTransportOptions(tunedRequest);
         auto reply =
-            QNetworkAccessManager::createRequest(op, request, outgoingData);
+            QNetworkAccessManager::createRequest(op, tunedRequest, outgoingData);
         reply->ignoreSslErrors(d.getIgnoredSslErrors());
+        watchForHttp2Failures(reply);
         return reply;
     }
     const QUrlQuery query{ url.query() };
@@ -186,9 +291,11 @@ QNetworkReply* NetworkAccessManager::createRequest(
     QNetworkRequest rewrittenRequest(request);
     rewrittenRequest.setUrl(DownloadFileJob::makeRequestUrl(hsData, url));
     rewrittenRequest.setRawHeader("Authorization", "Bearer "_ba + hsData.accessToken);
+    applyTransportOptions(rewrittenRequest);
 
     auto* implReply = QNetworkAccessManager::createRequest(op, rewrittenRequest);
     implReply->ignoreSslErrors(d.getIgnoredSslErrors());
+    watchForHttp2Failures(implReply);
     const auto& fileMetadata = FileMetadataMap::lookup(query.queryItemValue(u"room_id"_s),
                                                        query.queryItemValue(u"event_id"_s));
     return new MxcReply(implReply, fileMetadata);
@@ -7,6 +7,8 @@
 
 #include <QtNetwork/QNetworkAccessManager>
 
+#include <chrono>
+
 namespace Quotient {
 
 class QUOTIENT_API NetworkAccessManager : public QNetworkAccessManager {
@@ -25,6 +27,35 @@ public:
 
     static void setAccessToken(const QString& userId, const QByteArray& token);
 
+    //! \brief Allow or disallow HTTP/2 for requests made through this class
+    //!
+    //! HTTP/2 is allowed by default. Even when it is allowed, a host that fails a request at
+    //! the HTTP/2 protocol level is switched to HTTP/1.1 for some time (see
+    //! setHttp2FallbackPeriod()); the failed request is retried over HTTP/1.1 as per the usual
+    //! job retry logic. Requests that have QNetworkRequest::Http2AllowedAttribute set explicitly
+    //! are not affected.
+    static void setHttp2Allowed(bool allowed);
+    static bool http2Allowed();
+
+    //! \brief Set for how long a host that failed at the HTTP/2 level is used with HTTP/1.1
+    //!
+    //! The default is one hour. Only hosts that fail after this call are affected.
+    static void setHttp2FallbackPeriod(std::chrono::milliseconds period);
+
+    //! Let all hosts that failed at the HTTP/2 level use HTTP/2 again
+    static void clearHttp2Fallbacks();
+
+    //! \brief Set how long idle connections are kept open for reuse
+    //!
+    //! Zero or negative value leaves the Qt default (2 minutes as of Qt 6.7).
+    static void setKeepAliveTimeout(std::chrono::seconds timeout);
+
+    //! \brief Enable or disable TLS session resumption
+    //!
+    //! When enabled (the default), TLS sessions and session tickets are reused when opening
+    //! further connections to the same host, saving a full handshake for each of them.
+    static void setTlsSessionResumption(bool enabled);
+
     //! Get a NAM instance for the current thread
     static NetworkAccessManager* instance();
 
@@ -3,6 +3,8 @@
 
 #include "networksettings.h"
 
+#include "networkaccessmanager.h"
+
 using namespace Quotient;
 
 void NetworkSettings::setupApplicationProxy() const
@@ -11,9 +13,22 @@ void NetworkSettings::setupApplicationProxy() const
         { proxyType(), proxyHostName(), proxyPort() });
 }
 
+void NetworkSettings::setupTransport() const
+{
+    NetworkAccessManager::setHttp2Allowed(http2Allowed());
+    NetworkAccessManager::setKeepAliveTimeout(std::chrono::seconds(keepAliveSeconds()));
+    NetworkAccessManager::setTlsSessionResumption(tlsSessionResumption());
+}
+
 QUO_DEFINE_SETTING(NetworkSettings, QNetworkProxy::ProxyType, proxyType,
                    "proxy_type", QNetworkProxy::DefaultProxy, setProxyType)
 QUO_DEFINE_SETTING(NetworkSettings, QString, proxyHostName, "proxy_hostname",
                    {}, setProxyHostName)
 QUO_DEFINE_SETTING(NetworkSettings, quint16, proxyPort, "proxy_port", -1,
                    setProxyPort)
+QUO_DEFINE_SETTING(NetworkSettings, bool, http2Allowed, "http2_allowed", true,
+                   setHttp2Allowed)
+QUO_DEFINE_SETTING(NetworkSettings, int, keepAliveSeconds, "keep_alive_seconds",
+                   300, setKeepAliveSeconds)
+QUO_DEFINE_SETTING(NetworkSettings, bool, tlsSessionResumption,
+                   "tls_session_resumption", true, setTlsSessionResumption)
@@ -16,9 +16,17 @@ class QUOTIENT_API NetworkSettings : public SettingsGroup {
     QUO_DECLARE_SETTING(QString, proxyHostName, setProxyHostName)
     QUO_DECLARE_SETTING(quint16, proxyPort, setProxyPort)
     Q_PROPERTY(QString proxyHost READ proxyHostName WRITE setProxyHostName)
+    QUO_DECLARE_SETTING(bool, http2Allowed, setHttp2Allowed)
+    QUO_DECLARE_SETTING(int, keepAliveSeconds, setKeepAliveSeconds)
+    QUO_DECLARE_SETTING(bool, tlsSessionResumption, setTlsSessionResumption)
 public:
     explicit NetworkSettings() : SettingsGroup(u"Network"_s) {}
 
     Q_INVOKABLE void setupApplicationProxy() const;
+
+    //! \brief Apply HTTP/2, keep-alive and TLS session settings to network requests
+    //! \sa NetworkAccessManager::setHttp2Allowed, NetworkAccessManager::setKeepAliveTimeout,
+    //!     NetworkAccessManager::setTlsSessionResumption
+    Q_INVOKABLE void setupTransport() const;
 };
 } // namespace Quotient
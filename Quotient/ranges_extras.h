@@ -1,6 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
 #include <ranges>
+#include <unordered_set>
 
 namespace Quotient {
 
@@ -39,4 +42,22 @@ inline constexpr auto findIndirect(RangeT&& range, const ValT& value, Proj proj
     return findIndirect(std::ranges::begin(range), std::ranges::end(range), value, std::move(proj));
 }
 
+//! \brief Remove elements with repeating keys, keeping the first occurrence of each key
+//!
+//! Unlike std::unique, this doesn't need the range to be sorted; keys are remembered in a hash
+//! set instead, so it takes linear time. As with std::remove_if, the kept elements retain their
+//! relative order, and the new end of the range is returned; the elements past it are left
+//! in a valid but unspecified state and should be erased by the caller.
+template <std::forward_iterator IterT, typename Proj = std::identity>
+    requires std::indirectly_regular_unary_invocable<Proj, IterT>
+inline IterT removeDuplicates(IterT from, IterT to, Proj proj = {})
+{
+    using KeyT = std::remove_cvref_t<std::indirect_result_t<Proj&, IterT>>;
+    std::unordered_set<KeyT> seenKeys;
+    seenKeys.reserve(static_cast<size_t>(std::distance(from, to)));
+    return std::remove_if(from, to, [&seenKeys, &proj](const auto& item) {
+        return !seenKeys.insert(std::invoke(proj, item)).second;
+    });
+}
+
 }
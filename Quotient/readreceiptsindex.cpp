@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "readreceiptsindex.h"
+
+using namespace Quotient;
+
+ReadReceiptsIndex::ReadReceiptsIndex(IdPool& idPool) : _idPool(&idPool) {}
+
+std::optional<ReadReceiptsIndex::index_t> ReadReceiptsIndex::indexOf(const QString& userId) const
+{
+    const auto it = _positions.constFind(_idPool->find(userId));
+    return it != _positions.cend() ? it->index : std::nullopt;
+}
+
+void ReadReceiptsIndex::remove(InternedId userId, const Position& position)
+{
+    if (position.index) {
+        if (const auto it = _usersAtIndex.find(*position.index); it != _usersAtIndex.end()) {
+            it->second.remove(userId);
+            if (it->second.isEmpty())
+                _usersAtIndex.erase(it);
+            _counts.add(*position.index, -1);
+        }
+    } else if (const auto it = _usersAtDetachedEvent.find(position.eventId);
+               it != _usersAtDetachedEvent.end()) {
+        it->remove(userId);
+        if (it->isEmpty())
+            _usersAtDetachedEvent.erase(it);
+    }
+}
+
+void ReadReceiptsIndex::setAt(const QString& userId, const QString& eventId, index_t index)
+{
+    const auto userHandle = _idPool->intern(userId);
+    auto& position = _positions[userHandle];
+    remove(userHandle, position);
+    position = { _idPool->intern(eventId), index };
+    _usersAtIndex[index].insert(userHandle);
+    _counts.add(index, 1);
+}
+
+void ReadReceiptsIndex::setDetached(const QString& userId, const QString& eventId)
+{
+    const auto userHandle = _idPool->intern(userId);
+    auto& position = _positions[userHandle];
+    remove(userHandle, position);
+    position = { _idPool->intern(eventId), std::nullopt };
+    _usersAtDetachedEvent[position.eventId].insert(userHandle);
+}
+
+void ReadReceiptsIndex::attach(const QString& eventId, index_t index)
+{
+    if (_usersAtDetachedEvent.isEmpty())
+        return;
+    const auto users = _usersAtDetachedEvent.take(_idPool->find(eventId));
+    if (users.isEmpty())
+        return;
+    for (const auto& userId : users)
+        _positions[userId].index = index;
+    _usersAtIndex[index].unite(users);
+    _counts.add(index, users.size());
+}
+
+void ReadReceiptsIndex::detach(index_t index, const QString& eventId)
+{
+    const auto it = _usersAtIndex.find(index);
+    if (it == _usersAtIndex.end())
+        return;
+    const auto users = std::move(it->second);
+    _usersAtIndex.erase(it);
+    for (const auto& userId : users)
+        _positions[userId].index.reset();
+    _usersAtDetachedEvent[_idPool->intern(eventId)].unite(users);
+    _counts.add(index, -users.size());
+}
+
+QSet<QString> ReadReceiptsIndex::toStrings(const QSet<InternedId>& ids) const
+{
+    QSet<QString> strings;
+    strings.reserve(ids.size());
+    for (const auto& id : ids)
+        strings.insert(id.toString());
+    return strings;
+}
+
+QSet<QString> ReadReceiptsIndex::usersAt(index_t index) const
+{
+    const auto it = _usersAtIndex.find(index);
+    return it != _usersAtIndex.end() ? toStrings(it->second) : QSet<QString>();
+}
+
+QSet<QString> ReadReceiptsIndex::usersAt(const QString& eventId) const
+{
+    return toStrings(_usersAtDetachedEvent.value(_idPool->find(eventId)));
+}
+
+QSet<QString> ReadReceiptsIndex::usersReadUpTo(index_t index) const
+{
+    QSet<QString> userIds;
+    userIds.reserve(readCount(index));
+    for (auto it = _usersAtIndex.lower_bound(index); it != _usersAtIndex.end(); ++it)
+        for (const auto& userId : it->second)
+            userIds.insert(userId.toString());
+    return userIds;
+}
+
+qsizetype ReadReceiptsIndex::readCount(index_t index) const { return _counts.suffixSum(index); }
@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "eventitem.h"
+#include "fenwicktree.h"
+#include "idpool.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+
+#include <map>
+#include <optional>
+
+namespace Quotient {
+
+//! \brief An index of read receipts in a room, ordered by the timeline
+//!
+//! Each user has at most one read receipt in the room. A receipt on an event in the timeline
+//! is stored by the timeline index of that event, so that receipts are ordered the same way as
+//! events; receipts on events that are not in the timeline (not loaded yet, or evicted) are
+//! stored by the event id until the event shows up in the timeline. On top of that, a Fenwick
+//! tree of receipt counts per timeline index allows to count users who have read a given event
+//! in logarithmic time.
+class QUOTIENT_API ReadReceiptsIndex {
+public:
+    using index_t = TimelineItem::index_t;
+
+    explicit ReadReceiptsIndex(IdPool& idPool);
+
+    //! \brief The timeline index of the event \p userId's receipt is on
+    //! \return the index, or an empty optional if there's no receipt or its event is not in
+    //!         the timeline
+    std::optional<index_t> indexOf(const QString& userId) const;
+
+    //! Put the receipt of \p userId on the event at \p index in the timeline
+    void setAt(const QString& userId, const QString& eventId, index_t index);
+    //! Put the receipt of \p userId on \p eventId that is not in the timeline
+    void setDetached(const QString& userId, const QString& eventId);
+
+    //! Let the receipts on \p eventId know that the event is now in the timeline at \p index
+    void attach(const QString& eventId, index_t index);
+    //! Let the receipts at \p index know that the event there (\p eventId) leaves the timeline
+    void detach(index_t index, const QString& eventId);
+
+    //! Ids of users with receipts on the event at \p index
+    QSet<QString> usersAt(index_t index) const;
+    //! Ids of users with receipts on \p eventId that is not in the timeline
+    QSet<QString> usersAt(const QString& eventId) const;
+    //! \brief Ids of users who have read the event at \p index
+    //!
+    //! These are users with receipts at \p index or later in the timeline; receipts on events
+    //! outside of the timeline are not taken into account.
+    QSet<QString> usersReadUpTo(index_t index) const;
+    //! The number of users who have read the event at \p index, see usersReadUpTo()
+    qsizetype readCount(index_t index) const;
+
+private:
+    struct Position {
+        InternedId eventId;
+        std::optional<index_t> index;
+    };
+
+    IdPool* _idPool;
+    QHash<InternedId, Position> _positions;
+    std::map<index_t, QSet<InternedId>> _usersAtIndex;
+    QHash<InternedId, QSet<InternedId>> _usersAtDetachedEvent;
+    FenwickTree<qsizetype> _counts;
+
+    void remove(InternedId userId, const Position& position);
+    QSet<QString> toStrings(const QSet<InternedId>& ids) const;
+};
+
+} // namespace Quotient
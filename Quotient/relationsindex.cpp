@@ -0,0 +1,182 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "relationsindex.h"
+
+#include "logging_categories_p.h"
+
+#include "events/reactionevent.h"
+
+#include <algorithm>
+
+using namespace Quotient;
+
+std::optional<EventRelation> RelationsIndex::relationOf(const RoomEvent& evt)
+{
+    const auto relationJson = evt.contentPart<QJsonObject>(RelatesToKey);
+    if (relationJson.isEmpty())
+        return {};
+    auto relation = fromJson<EventRelation>(relationJson);
+    if (relation.type.isEmpty() || relation.eventId.isEmpty())
+        return {};
+    return relation;
+}
+
+RelationsIndex::RelationsIndex(IdPool& idPool) : _idPool(&idPool) {}
+
+QString RelationsIndex::add(const RoomEvent& evt)
+{
+    if (evt.isRedacted())
+        return {}; // Whatever is left of the relation, it no more counts
+    const auto relation = relationOf(evt);
+    if (!relation)
+        return {};
+    const auto targetId = _idPool->intern(relation->eventId);
+
+    if (relation->type == EventRelation::AnnotationType) {
+        // Encrypted reactions only get indexed once decrypted
+        const auto* reaction = eventCast<const ReactionEvent>(&evt);
+        if (!reaction)
+            return {};
+        auto& bySender = _reactions[targetId][relation->key];
+        const auto senderId = _idPool->intern(evt.senderId());
+        if (bySender.contains(senderId)) {
+            qCDebug(MESSAGES) << "Skipping a duplicate reaction from" << evt.senderId();
+            return {};
+        }
+        bySender.insert(senderId, reaction);
+        _related[{ targetId, relation->type }].push_back(&evt);
+        return relation->eventId;
+    }
+
+    auto& related = _related[{ targetId, relation->type }];
+    if (relation->type == EventRelation::ReplacementType) {
+        // Historical edits come in reverse order; keep the chain sorted by origin timestamp
+        const auto ts = evt.originTimestampMs();
+        related.insert(std::upper_bound(related.begin(), related.end(), ts,
+                                        [](qint64 lhs, const RoomEvent* rhs) {
+                                            return lhs < rhs->originTimestampMs();
+                                        }),
+                       &evt);
+        return relation->eventId;
+    }
+    related.push_back(&evt);
+    if (relation->type == EventRelation::ThreadType) {
+        auto& summary = _threads[targetId];
+        ++summary.replyCount;
+        if (!summary.latestEvent
+            || summary.latestEvent->originTimestampMs() <= evt.originTimestampMs())
+            summary.latestEvent = &evt;
+        return relation->eventId;
+    }
+    return {};
+}
+
+QString RelationsIndex::remove(const RoomEvent& evt)
+{
+    const auto relation = relationOf(evt);
+    if (!relation)
+        return {};
+    const auto targetId = _idPool->find(relation->eventId);
+    const auto relatedIt = _related.find({ targetId, relation->type });
+    if (relatedIt == _related.end() || !relatedIt->removeOne(&evt))
+        return {}; // Not indexed, e.g. a duplicate reaction
+
+    if (relation->type == EventRelation::AnnotationType) {
+        if (const auto reactionsIt = _reactions.find(targetId); reactionsIt != _reactions.end()) {
+            if (const auto keyIt = reactionsIt->find(relation->key); keyIt != reactionsIt->end()) {
+                keyIt->remove(_idPool->find(evt.senderId()));
+                if (keyIt->isEmpty())
+                    reactionsIt->erase(keyIt);
+            }
+            if (reactionsIt->isEmpty())
+                _reactions.erase(reactionsIt);
+        }
+    } else if (relation->type == EventRelation::ThreadType) {
+        if (const auto threadIt = _threads.find(targetId); threadIt != _threads.end()) {
+            if (--threadIt->replyCount == 0)
+                _threads.erase(threadIt);
+            else if (threadIt->latestEvent == &evt) {
+                threadIt->latestEvent = *std::max_element(
+                    relatedIt->cbegin(), relatedIt->cend(),
+                    [](const RoomEvent* lhs, const RoomEvent* rhs) {
+                        return lhs->originTimestampMs() < rhs->originTimestampMs();
+                    });
+            }
+        }
+    }
+    const auto isAggregated = relation->type == EventRelation::AnnotationType
+                              || relation->type == EventRelation::ThreadType
+                              || relation->type == EventRelation::ReplacementType;
+    if (relatedIt->isEmpty())
+        _related.erase(relatedIt);
+    return isAggregated ? relation->eventId : QString();
+}
+
+RelationsIndex::RelatedEvents RelationsIndex::relatedEvents(
+    const QString& eventId, EventRelation::reltypeid_t relType) const
+{
+    return _related.value({ _idPool->find(eventId), relType });
+}
+
+QStringList RelationsIndex::reactionKeys(const QString& eventId) const
+{
+    const auto it = _reactions.constFind(_idPool->find(eventId));
+    return it != _reactions.cend() ? it->keys() : QStringList();
+}
+
+qsizetype RelationsIndex::reactionCount(const QString& eventId, const QString& key) const
+{
+    const auto it = _reactions.constFind(_idPool->find(eventId));
+    return it != _reactions.cend() ? it->value(key).size() : 0;
+}
+
+const ReactionEvent* RelationsIndex::reaction(const QString& eventId, const QString& key,
+                                              const QString& userId) const
+{
+    const auto it = _reactions.constFind(_idPool->find(eventId));
+    return it != _reactions.cend() ? it->value(key).value(_idPool->find(userId), nullptr)
+                                   : nullptr;
+}
+
+QStringList RelationsIndex::reactionSenders(const QString& eventId, const QString& key) const
+{
+    QStringList senders;
+    if (const auto it = _reactions.constFind(_idPool->find(eventId)); it != _reactions.cend()) {
+        const auto bySender = it->value(key);
+        senders.reserve(bySender.size());
+        for (auto senderIt = bySender.cbegin(); senderIt != bySender.cend(); ++senderIt)
+            senders.push_back(senderIt.key().toString());
+    }
+    return senders;
+}
+
+RelationsIndex::ThreadSummary RelationsIndex::threadSummary(const QString& rootId) const
+{
+    return _threads.value(_idPool->find(rootId));
+}
+
+QStringList RelationsIndex::threadRootIds() const
+{
+    QStringList ids;
+    ids.reserve(_threads.size());
+    for (auto it = _threads.cbegin(); it != _threads.cend(); ++it)
+        ids.push_back(it.key().toString());
+    return ids;
+}
+
+RelationsIndex::RelatedEvents RelationsIndex::edits(const QString& eventId) const
+{
+    return relatedEvents(eventId, EventRelation::ReplacementType);
+}
+
+const RoomEvent* RelationsIndex::latestEdit(const QString& eventId) const
+{
+    const auto it = _related.constFind({ _idPool->find(eventId), EventRelation::ReplacementType });
+    return it != _related.cend() && !it->isEmpty() ? it->back() : nullptr;
+}
+
+RelationsIndex::RelatedEvents RelationsIndex::replies(const QString& eventId) const
+{
+    return relatedEvents(eventId, EventRelation::ReplyType);
+}
@@ -0,0 +1,90 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "idpool.h"
+
+#include "events/eventrelation.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QVector>
+
+namespace Quotient {
+
+class RoomEvent;
+class ReactionEvent;
+
+//! \brief An index of relations between events in a room timeline
+//!
+//! Every event with `m.relates_to` in its content gets indexed by its target event and the
+//! relation type as it enters the timeline, and gets removed from the index when it is redacted,
+//! edited or otherwise replaced. On top of that, the index maintains aggregates for the most
+//! used relation types: reactions are grouped by key and sender, threads keep the number of
+//! replies and the latest event, replacements (edits) are kept in the order of their origin
+//! timestamps. All lookups below take constant time, save for those returning lists, which are
+//! linear in the size of the list.
+//!
+//! Event pointers returned by the index are only valid while the events are in the timeline.
+class QUOTIENT_API RelationsIndex {
+public:
+    using RelatedEvents = QVector<const RoomEvent*>;
+
+    struct ThreadSummary {
+        qsizetype replyCount = 0;
+        const RoomEvent* latestEvent = nullptr;
+    };
+
+    explicit RelationsIndex(IdPool& idPool);
+
+    //! \brief Get the relation of \p evt from its content
+    //! \return the relation, or an empty optional if the event doesn't relate to another one
+    static std::optional<EventRelation> relationOf(const RoomEvent& evt);
+
+    //! \brief Index the relation of \p evt, if it has one
+    //! \return the id of the event which aggregated relations (reactions, the thread summary
+    //!         or the edits) changed as a result, or an empty string if there's none
+    QString add(const RoomEvent& evt);
+
+    //! \brief Remove \p evt from the index, if it's there
+    //! \return the id of the event which aggregated relations changed as a result,
+    //!         or an empty string if there's none
+    QString remove(const RoomEvent& evt);
+
+    //! All events relating to \p eventId with a given relation type, in the order of indexing
+    RelatedEvents relatedEvents(const QString& eventId, EventRelation::reltypeid_t relType) const;
+
+    //! Keys of the reactions to \p eventId
+    QStringList reactionKeys(const QString& eventId) const;
+    //! The number of users who reacted to \p eventId with \p key
+    qsizetype reactionCount(const QString& eventId, const QString& key) const;
+    //! The reaction of \p userId to \p eventId with \p key, if there's one
+    const ReactionEvent* reaction(const QString& eventId, const QString& key,
+                                  const QString& userId) const;
+    //! Ids of the users who reacted to \p eventId with \p key
+    QStringList reactionSenders(const QString& eventId, const QString& key) const;
+
+    //! The number of replies in the thread started by \p rootId and its latest event
+    ThreadSummary threadSummary(const QString& rootId) const;
+    //! Ids of all thread roots known to the index
+    QStringList threadRootIds() const;
+
+    //! Replacements of \p eventId, from the oldest to the newest
+    RelatedEvents edits(const QString& eventId) const;
+    //! The newest replacement of \p eventId, if there's one
+    const RoomEvent* latestEdit(const QString& eventId) const;
+
+    //! Events replying to \p eventId (using `m.in_reply_to` outside of threads)
+    RelatedEvents replies(const QString& eventId) const;
+
+private:
+    using RelationKey = std::pair<InternedId, QString>;
+    using ReactionsBySender = QHash<InternedId, const ReactionEvent*>;
+
+    IdPool* _idPool;
+    QHash<RelationKey, RelatedEvents> _related;
+    QHash<InternedId, QHash<QString, ReactionsBySender>> _reactions;
+    QHash<InternedId, ThreadSummary> _threads;
+};
+
+} // namespace Quotient
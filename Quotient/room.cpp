@@ -14,14 +14,23 @@
 #include "converters.h"
 #include "database.h"
 #include "eventstats.h"
+#include "eventstore.h"
+#include "fenwicktree.h"
+#include "idpool.h"
 #include "keyverificationsession.h"
 #include "logging_categories_p.h"
+#include "membernamesindex.h"
 #include "qt_connection_util.h"
 #include "quotient_common.h"
 #include "ranges_extras.h"
+#include "readreceiptsindex.h"
+#include "relationsindex.h"
 #include "roommember.h"
 #include "roomstateview.h"
+#include "searchindex.h"
+#include "spacegraph.h"
 #include "syncdata.h"
+#include "timelinecolumns.h"
 #include "user.h"
 
 #include "csapi/account-data.h"
@@ -43,6 +52,7 @@
 #include "e2ee/qolminboundsession.h"
 
 #include "events/callevents.h"
+#include "events/encryptedevent.h"
 #include "events/encryptionevent.h"
 #include "events/event.h"
 #include "events/reactionevent.h"
@@ -68,6 +78,7 @@
 #include <QtCore/QRegularExpression>
 #include <QtCore/QStringBuilder> // for efficient string concats (operator%)
 #include <QtCore/QTemporaryFile>
+#include <QtCore/QThreadPool>
 
 #include <array>
 #include <cmath>
@@ -109,12 +120,17 @@ public:
     QSet<QString> aliasServers;
 
     Timeline timeline;
+    //! Hot fields of timeline events for scanning, row by row with the timeline
+    TimelineColumns timelineColumns{ connection->idPool() };
     PendingEvents unsyncedEvents;
-    QHash<QString, TimelineItem::index_t> eventsIndex;
-    // A map from event id/relation type pairs to a vector of event pointers. Not using QMultiHash,
-    // because we want to quickly return a number of relations for a given event without enumerating
-    // them.
-    QHash<std::pair<QString, QString>, RelatedEvents> relations;
+    // Ids in the lookup tables below are interned in the connection's pool, see lookupId()
+    QHash<InternedId, TimelineItem::index_t> eventsIndex;
+    RelationsIndex relations{ connection->idPool() };
+    //! Thread timelines by the root event id, see Room::thread()
+    QHash<QString, RoomThread*> threads;
+    //! The token for the next page of thread roots; std::nullopt once all are loaded
+    std::optional<QString> threadsNextBatch = QString();
+    JobHandle<GetThreadRootsJob> threadsJob;
     QString displayname;
     Avatar avatar;
     QHash<QString, Notification> notifications;
@@ -122,18 +138,24 @@ public:
     // Starting up with estimate event statistics as there's zero knowledge
     // about the timeline.
     EventStats partiallyReadStats {}, unreadStats {};
+    //! Notable and highlighted events in the timeline, by timeline index
+    FenwickTree<qsizetype> notableCounts, highlightCounts;
 
     // For storing a list of current member names for the purpose of disambiguation.
-    QMultiHash<QString, QString> memberNameMap;
+    MemberNamesIndex memberNames{ connection->idPool() };
+    //! Set while updating the state from a batch of events, see updateStateFrom()
+    bool batchingNameUpdates = false;
+    //! Members whose names have changed in the current batch, see memberNamesUpdated()
+    QSet<QString> renamedMembers;
     QStringList membersInvited;
     QStringList membersLeft;
     QStringList membersTyping;
 
-    QHash<QString, QSet<QString>> eventIdReadUsers;
+    ReadReceiptsIndex readReceipts{ connection->idPool() };
     bool displayed = false;
     QString firstDisplayedEventId;
     QString lastDisplayedEventId;
-    QHash<QString, ReadReceipt> lastReadReceipts;
+    QHash<InternedId, ReadReceipt> lastReadReceipts;
     QString fullyReadUntilEventId;
     TagsMap tags;
     std::unordered_map<QString, EventPtr> accountData;
@@ -145,9 +167,24 @@ public:
     //! that the server previously reported that all events have been loaded and there's no point in
     //! requesting further historical batches.
     std::optional<QString> prevBatch = QString();
+    //! \brief Pagination tokens for the history preceding a given timeline index
+    //!
+    //! Each entry maps the index of the oldest event in a loaded batch to the token that loads
+    //! the events before it. evictHistory() only cuts the timeline at these points, so that
+    //! the evicted events could be loaded again with the same indices.
+    std::map<TimelineItem::index_t, QString> historyTokens;
+    //! The index of the first event after a gap left by a limited sync response, if there's one
+    std::optional<TimelineItem::index_t> timelineGap;
+    //! Set when a sync update applied in chunks has started filling an empty room state
+    bool baseStateLoadPending = false;
+    //! Changes from the parts of a sync update applied so far, see Room::applySyncChunk()
+    Changes chunkedSyncChanges {};
+    int timelineWindow = 0;
     int lastRequestedHistorySize = 0;
     JobHandle<GetRoomEventsJob> eventsHistoryJob;
     JobHandle<GetMembersByRoomJob> allMembersJob;
+    //! Parsing and merging of the members loaded by allMembersJob, see mergeMembers()
+    QFuture<void> allMembersMerge;
     //! Map from megolm sessionId to set of eventIds
     std::unordered_map<QString, QSet<QString>> undecryptedEvents;
     //! Map from event id of the request event to the session object
@@ -208,6 +245,12 @@ public:
 
     void insertMemberIntoMap(const QString& memberId);
     void removeMemberFromMap(const QString& memberId);
+    //! Emit memberNameAboutToUpdate(), unless name updates are batched
+    void memberNameAboutToUpdate(const QString& memberId, const QString& newName);
+    //! Emit memberNameUpdated(), or remember the member to emit memberNamesUpdated() later
+    void memberNameUpdated(const QString& memberId);
+    //! Stop batching name updates and emit memberNamesUpdated() for the batch, if needed
+    void finishNameUpdatesBatch();
 
     // This updates the room displayname field (which is the way a room
     // should be shown in the room list); called whenever the list of
@@ -228,6 +271,8 @@ public:
         if (!events.empty()) {
             QElapsedTimer et;
             et.start();
+            // Name updates are coalesced into a single memberNamesUpdated() for the whole batch
+            batchingNameUpdates = true;
             for (auto&& eptr : std::move(events)) {
                 const auto& evt = *eptr;
                 Q_ASSERT(evt.isStateEvent());
@@ -237,6 +282,7 @@ public:
                         std::move(eptr);
                 }
             }
+            finishNameUpdatesBatch();
             if (events.size() > 9 || et.nsecsElapsed() >= ProfilerMinNsecs)
                 qCDebug(PROFILER)
                     << "Updated" << q->objectName() << "room state from"
@@ -244,19 +290,80 @@ public:
         }
         return changes;
     }
-    void addRelation(const ReactionEvent& reactionEvt);
     void addRelations(auto from, auto to)
     {
         for (auto it = from; it != to; ++it)
-            if (const auto* reaction = it->template viewAs<ReactionEvent>())
-                addRelation(*reaction);
+            if (const auto targetId = relations.add(*it->event()); !targetId.isEmpty())
+                emit q->updatedEvent(targetId);
     }
 
+    //! The open thread \p evt belongs to, or is the root of
+    RoomThread* threadOf(const RoomEvent& evt) const;
+    //! Pass events between \p from and \p to in the timeline to the threads they belong to
+    void updateThreads(auto from, auto to)
+    {
+        if (threads.isEmpty())
+            return;
+        QHash<RoomThread*, std::vector<const RoomEvent*>> threadEvents;
+        for (auto it = from; it != to; ++it)
+            if (auto* thread = threadOf(*it->event()))
+                threadEvents[thread].push_back(it->event());
+        for (auto it = threadEvents.begin(); it != threadEvents.end(); ++it)
+            it.key()->addTimelineEvents(std::move(it.value()));
+    }
+    //! \brief Apply a redaction or an edit to thread events that are not in the timeline
+    //!
+    //! Events in the timeline are taken care of by processRedaction() and processReplacement().
+    void updateOwnThreadEvents(const RoomEvent& editingEvent);
+
     Changes addNewMessageEvents(RoomEvents&& events);
     std::pair<Changes, rev_iter_t> addHistoricalMessageEvents(RoomEvents&& events);
 
+    //! Add events from the timeline section of a sync response
+    Changes addSyncTimeline(RoomEvents&& events, bool limited, const QString& prevBatchToken,
+                            bool fromCache);
+    //! Update the default power levels for the room creator to have full power
+    void onCreationArrived();
+    //! \brief Emit signals for \p changes coming from a sync response
+    //!
+    //! If \p partial is true, \p changes come from a part of the response applied by
+    //! Room::applySyncChunk(); the display name and the saved state are only updated once
+    //! the rest of the response is applied.
+    void emitSyncChanges(Changes changes, bool fromCache, bool partial = false);
+
+    //! Drop the oldest events outside the timeline window, see Room::setTimelineWindow()
+    void evictHistory();
+    //! Drop the events before the cut point at \p tokenIt from the timeline
+    void dropHistoryBefore(std::map<TimelineItem::index_t, QString>::iterator tokenIt);
+    //! Remove all references to the event in \p ti from the room indices before eviction
+    void forgetTimelineItem(TimelineItem& ti);
+
+    //! \brief Add the event in \p ti to the event counters
+    //!
+    //! Whether the event is notable and highlighted is taken from isEventNotable() and
+    //! notificationFor() at the moment of the call, and is not evaluated again until
+    //! the event changes or recountEvents() is called.
+    //! \return the counts for the event alone, i.e. whether it's notable and highlighted
+    EventStats countEvent(const TimelineItem& ti);
+    //! \brief Count the event in \p ti again after it has been redacted, replaced or decrypted
+    //!
+    //! Along with the event counters, this updates exact unread and partially read statistics
+    //! if the event is after the respective marker.
+    //! \param before the result of uncountEvent() called before the event changed
+    void recountEvent(const TimelineItem& ti, const EventStats& before);
+    //! \brief Take the event at \p index off the event counters
+    //!
+    //! This subtracts exactly what has been counted for the event, no matter what
+    //! isEventNotable() and notificationFor() return for it by now.
+    //! \return the counts that have been subtracted
+    EventStats uncountEvent(TimelineItem::index_t index);
     Changes updateStatsFromSyncData(const SyncRoomData &data, bool fromCache);
-    void postprocessChanges(Changes changes, bool saveState = true);
+    //! \brief Update the display name, emit signals for \p changes and save the room state
+    //! \param earlierChanges changes that have already been signalled but have yet to be
+    //!                       reflected in the display name and the saved state
+    void postprocessChanges(Changes changes, bool saveState = true, Changes earlierChanges = {});
+    //! Emit signals for \p changes, without updating anything else
+    void emitChangeSignals(Changes changes);
 
     /** Move events into the timeline
      *
@@ -290,6 +397,17 @@ public:
     bool markMessagesAsRead(const rev_iter_t& upToMarker);
 
     void getAllMembers();
+    //! \brief Parse state events from \p eventsJson on a thread from the global pool
+    //!
+    //! The result is wrapped in a shared pointer because futures don't work well with move-only
+    //! types in older Qt versions.
+    static QFuture<std::shared_ptr<StateEvents>> parseStateEvents(QJsonArray eventsJson);
+    //! \brief Merge a (large) list of member events into the room state at once
+    //!
+    //! New joined members are added to the state directly, bypassing Room::processStateEvent();
+    //! their names are indexed after the whole list is merged, with name update signals coalesced.
+    //! Events for already known members and unexpected events take the usual path.
+    Changes mergeMembers(StateEvents&& events);
 
     const PendingEventItem& sendEvent(RoomEventPtr&& event);
 
@@ -337,6 +455,11 @@ public:
 
     bool isLocalMember(const QString& memberId) const { return memberId == connection->userId(); }
 
+    //! Find the handle for \p id to look it up in the tables keyed by InternedId
+    InternedId lookupId(const QString& id) const { return connection->idPool().find(id); }
+    //! Get the handle for \p id to use as a key in the tables keyed by InternedId
+    InternedId internId(const QString& id) const { return connection->idPool().intern(id); }
+
     std::unordered_map<QByteArray, QOlmInboundGroupSession> groupSessions;
     std::optional<QOlmOutboundGroupSession> currentOutboundMegolmSession = {};
 
@@ -444,7 +567,7 @@ public:
     QMultiHash<QString, QString> getDevicesWithoutKey() const
     {
         QMultiHash<QString, QString> devices;
-        for (const auto& user : memberNameMap.values() + membersInvited)
+        for (const auto& user : memberNames.userIds() + membersInvited)
             for (const auto& deviceId : connection->devicesForUser(user))
                 devices.insert(user, deviceId);
 
@@ -565,6 +688,14 @@ bool Room::allHistoryLoaded() const
     return !d->prevBatch;
 }
 
+int Room::timelineWindow() const { return d->timelineWindow; }
+
+void Room::setTimelineWindow(int eventsCount)
+{
+    d->timelineWindow = std::max(eventsCount, 0);
+    d->evictHistory();
+}
+
 QString Room::name() const
 {
     return currentState().content<RoomNameEvent>().value;
@@ -729,7 +860,9 @@ QStringList Room::memberIds() const
 
 bool Room::needsDisambiguation(const QString& userId) const
 {
-    return d->memberNameMap.count(member(userId).name()) > 1;
+    return d->memberNames.contains(userId)
+               ? d->memberNames.needsDisambiguation(userId)
+               : d->memberNames.namesakeCount(member(userId).name()) > 1;
 }
 
 Membership Room::memberState(const QString& userId) const
@@ -763,10 +896,11 @@ std::optional<QString> Room::Private::setLastReadReceipt(const QString& userId,
         newMarker = q->findInTimeline(newReceipt.eventId);
     if (newMarker != historyEdge()) {
         // Try to auto-promote the read marker over the user's own messages
-        // (switch to direct iterators for that).
-        const auto eagerMarker =
-            find_if(newMarker.base(), syncEdge(),
-                    [userId](const TimelineItem& ti) { return ti->senderId() != userId; });
+        // (switch to direct iterators for that); scan the column of senders
+        // rather than the events themselves.
+        const auto eagerIndex =
+            timelineColumns.findNotSentBy(newMarker->index() + 1, lookupId(userId));
+        const auto eagerMarker = syncEdge() - (timelineColumns.endIndex() - eagerIndex);
         // eagerMarker is now just after the desired event for newMarker
         if (eagerMarker != newMarker.base()) {
             newMarker = rev_iter_t(eagerMarker);
@@ -779,8 +913,9 @@ std::optional<QString> Room::Private::setLastReadReceipt(const QString& userId,
         if (newReceipt.timestamp.isNull())
             newReceipt.timestamp = QDateTime::currentDateTime();
     }
+    const auto userHandle = internId(userId);
     auto& storedReceipt =
-            lastReadReceipts[userId]; // clazy:exclude=detaching-member
+            lastReadReceipts[userHandle]; // clazy:exclude=detaching-member
     const auto prevEventId = storedReceipt.eventId;
     // Check that either the new marker is actually "newer" than the current one
     // or, if both markers are at historyEdge(), event ids are different.
@@ -790,21 +925,18 @@ std::optional<QString> Room::Private::setLastReadReceipt(const QString& userId,
     // the previous marker is kept because read receipts are not supposed
     // to move backwards. If neither new nor old event is found, the new receipt
     // is blindly stored, in a hope it's also "newer" in the timeline.
-    // NB: with reverse iterators, timeline history edge >= sync edge
-    if (prevEventId == newReceipt.eventId
-        || newMarker > q->findInTimeline(prevEventId))
+    if (prevEventId == newReceipt.eventId)
+        return {};
+    if (const auto prevIndex = readReceipts.indexOf(userId);
+        prevIndex && (newMarker == historyEdge() || newMarker->index() < *prevIndex))
         return {};
 
     // Finally make the change
 
-    auto oldEventReadUsersIt =
-        eventIdReadUsers.find(prevEventId); // clazy:exclude=detaching-member
-    if (oldEventReadUsersIt != eventIdReadUsers.end()) {
-        oldEventReadUsersIt->remove(userId);
-        if (oldEventReadUsersIt->isEmpty())
-            eventIdReadUsers.erase(oldEventReadUsersIt);
-    }
-    eventIdReadUsers[newReceipt.eventId].insert(userId);
+    if (newMarker != historyEdge())
+        readReceipts.setAt(userId, newReceipt.eventId, newMarker->index());
+    else
+        readReceipts.setDetached(userId, newReceipt.eventId);
     storedReceipt = std::move(newReceipt);
 
     {
@@ -1050,6 +1182,63 @@ Notification Room::notificationFor(const TimelineItem &ti) const
     return d->notifications.value(ti->id());
 }
 
+EventStats Room::Private::countEvent(const TimelineItem& ti)
+{
+    const EventStats counts{ q->isEventNotable(ti),
+                             q->notificationFor(ti).type == Notification::Highlight, false };
+    if (counts.notableCount > 0)
+        notableCounts.add(ti.index(), 1);
+    if (counts.highlightCount > 0)
+        highlightCounts.add(ti.index(), 1);
+    return counts;
+}
+
+void Room::Private::recountEvent(const TimelineItem& ti, const EventStats& before)
+{
+    const auto after = countEvent(ti);
+    if (after == before)
+        return;
+    // Exact statistics count events after (but not at) the marker
+    for (auto&& [stats, marker] : { std::pair{ &unreadStats, q->localReadReceiptMarker() },
+                                    std::pair{ &partiallyReadStats, q->fullyReadMarker() } })
+        if (!stats->isEstimate && marker != historyEdge() && ti.index() > marker->index()) {
+            stats->notableCount += after.notableCount - before.notableCount;
+            stats->highlightCount += after.highlightCount - before.highlightCount;
+            Q_ASSERT(stats->notableCount >= 0 && stats->highlightCount >= 0);
+        }
+}
+
+EventStats Room::Private::uncountEvent(TimelineItem::index_t index)
+{
+    const EventStats counts{ notableCounts.rangeSum(index, index),
+                             highlightCounts.rangeSum(index, index), false };
+    notableCounts.add(index, -counts.notableCount);
+    highlightCounts.add(index, -counts.highlightCount);
+    return counts;
+}
+
+void Room::recountEvents()
+{
+    const auto statsBefore = std::pair{ d->unreadStats, d->partiallyReadStats };
+    for (const auto& ti : d->timeline)
+        d->recountEvent(ti, d->uncountEvent(ti.index()));
+    if (d->unreadStats != statsBefore.first)
+        emit unreadStatsChanged();
+    if (d->partiallyReadStats != statsBefore.second)
+        emit partiallyReadStatsChanged();
+}
+
+EventStats Room::countEvents(const rev_iter_t& from, const rev_iter_t& to) const
+{
+    Q_ASSERT(from >= rev_iter_t(syncEdge()) && from <= to && to <= historyEdge());
+    if (from == to)
+        return { 0, 0, false };
+    // Reverse iterators go from newer to older events, i.e. from greater to lesser indices
+    const auto oldestIndex = (to - 1)->index();
+    return { d->notableCounts.rangeSum(oldestIndex, from->index()),
+             d->highlightCounts.rangeSum(oldestIndex, from->index()), false };
+}
+
 Notification Room::checkForNotifications(const TimelineItem &ti)
 {
     return { Notification::None };
@@ -1092,14 +1281,20 @@ Room::rev_iter_t Room::findInTimeline(TimelineItem::index_t index) const
 
 Room::rev_iter_t Room::findInTimeline(const QString& evtId) const
 {
-    if (!d->timeline.empty() && d->eventsIndex.contains(evtId)) {
-        auto it = findInTimeline(d->eventsIndex.value(evtId));
+    if (const auto idxIt = d->eventsIndex.constFind(d->lookupId(evtId));
+        !d->timeline.empty() && idxIt != d->eventsIndex.cend()) {
+        auto it = findInTimeline(*idxIt);
         Q_ASSERT(it != historyEdge() && (*it)->id() == evtId);
         return it;
     }
     return historyEdge();
 }
 
+Room::rev_iter_t Room::findInTimeline(const QDateTime& timestamp) const
+{
+    return findInTimeline(d->timelineColumns.findNotBefore(timestamp.toMSecsSinceEpoch()));
+}
+
 Room::PendingEvents::iterator Room::findPendingEvent(const QString& txnId)
 {
     return findIndirect(d->unsyncedEvents, txnId, &RoomEvent::transactionId);
@@ -1110,10 +1305,12 @@ Room::PendingEvents::const_iterator Room::findPendingEvent(const QString& txnId)
     return findIndirect(d->unsyncedEvents, txnId, &RoomEvent::transactionId);
 }
 
+const RelationsIndex& Room::relations() const { return d->relations; }
+
 const Room::RelatedEvents Room::relatedEvents(
     const QString& evtId, EventRelation::reltypeid_t relType) const
 {
-    return d->relations.value({ evtId, relType });
+    return d->relations.relatedEvents(evtId, relType);
 }
 
 const Room::RelatedEvents Room::relatedEvents(
@@ -1122,6 +1319,48 @@ const Room::RelatedEvents Room::relatedEvents(
     return relatedEvents(evt.id(), relType);
 }
 
+RoomThread* Room::thread(const QString& rootId)
+{
+    if (rootId.isEmpty())
+        return nullptr;
+    auto& thread = d->threads[rootId];
+    if (!thread) {
+        thread = new RoomThread(this, rootId);
+        const auto events = d->relations.relatedEvents(rootId, EventRelation::ThreadType);
+        thread->addTimelineEvents(
+            std::vector<const RoomEvent*>(events.cbegin(), events.cend()));
+    }
+    return thread;
+}
+
+QList<RoomThread*> Room::threads() const { return d->threads.values(); }
+
+JobHandle<GetThreadRootsJob> Room::loadThreads(int limit)
+{
+    if (!d->threadsNextBatch)
+        return {};
+    if (isJobPending(d->threadsJob))
+        return d->threadsJob;
+
+    d->threadsJob =
+        connection()->callApi<GetThreadRootsJob>(id(), QString(), limit, *d->threadsNextBatch);
+    connect(d->threadsJob, &BaseJob::success, this, [this] {
+        if (const auto nextBatch = d->threadsJob->nextBatch(); !nextBatch.isEmpty())
+            *d->threadsNextBatch = nextBatch;
+        else
+            d->threadsNextBatch.reset();
+        QStringList rootIds;
+        for (auto&& root : d->threadsJob->chunk()) {
+            rootIds.push_back(root->id());
+            thread(rootIds.back())->setRoot(std::move(root));
+        }
+        emit threadsLoaded(rootIds);
+    });
+    return d->threadsJob;
+}
+
+bool Room::allThreadsLoaded() const { return !d->threadsNextBatch; }
+
 const RoomCreateEvent* Room::creation() const
 {
     return currentState().get<RoomCreateEvent>();
@@ -1135,27 +1374,91 @@ const RoomTombstoneEvent* Room::tombstone() const
 void Room::Private::getAllMembers()
 {
     // If already loaded or already loading, there's nothing to do here.
-    if (q->joinedCount() <= currentState.eventsOfType(RoomMemberEvent::TypeId).size() || isJobPending(allMembersJob))
+    if (q->joinedCount() <= currentState.eventsOfType(RoomMemberEvent::TypeId).size()
+        || isJobPending(allMembersJob) || !allMembersMerge.isFinished())
         return;
 
     allMembersJob = connection->callApi<GetMembersByRoomJob>(
         id, connection->nextBatchToken(), "join"_L1);
     auto nextIndex = timeline.empty() ? 0 : timeline.back().index() + 1;
     connect(allMembersJob, &BaseJob::success, q, [this, nextIndex] {
-        Q_ASSERT(timeline.empty() || nextIndex <= q->maxTimelineIndex() + 1);
-        auto roomChanges = updateStateFrom(allMembersJob->chunk());
-        // Replay member events that arrived after the point for which
-        // the full members list was requested.
-        if (!timeline.empty())
-            for (auto it = q->findInTimeline(nextIndex).base();
-                 it != syncEdge(); ++it)
-                if (is<RoomMemberEvent>(**it))
-                    roomChanges |= q->processStateEvent(**it);
-        postprocessChanges(roomChanges);
-        emit q->allMembersLoaded();
+        allMembersMerge =
+            parseStateEvents(allMembersJob->jsonData().value("chunk"_L1).toArray())
+                .then(q, [this, nextIndex](const std::shared_ptr<StateEvents>& events) {
+                    Q_ASSERT(timeline.empty() || nextIndex <= q->maxTimelineIndex() + 1);
+                    auto roomChanges = mergeMembers(std::move(*events));
+                    // Replay member events that arrived after the point for which
+                    // the full members list was requested.
+                    if (!timeline.empty())
+                        for (auto it = q->findInTimeline(nextIndex).base(); it != syncEdge(); ++it)
+                            if (is<RoomMemberEvent>(**it))
+                                roomChanges |= q->processStateEvent(**it);
+                    postprocessChanges(roomChanges);
+                    emit q->allMembersLoaded();
+                });
     });
 }
 
+QFuture<std::shared_ptr<StateEvents>> Room::Private::parseStateEvents(QJsonArray eventsJson)
+{
+    auto promise = std::make_shared<QPromise<std::shared_ptr<StateEvents>>>();
+    auto future = promise->future();
+    QThreadPool::globalInstance()->start([promise, eventsJson = std::move(eventsJson)] {
+        promise->start();
+        QElapsedTimer et;
+        et.start();
+        promise->addResult(std::make_shared<StateEvents>(fromJson<StateEvents>(eventsJson)));
+        qCDebug(PROFILER) << "Parsed" << eventsJson.size() << "state event(s) in" << et;
+        promise->finish();
+    });
+    return future;
+}
+
+Room::Changes Room::Private::mergeMembers(StateEvents&& events)
+{
+    QElapsedTimer et;
+    et.start();
+    Changes changes {};
+    currentState.reserve(currentState.size() + qsizetype(events.size()));
+    baseState.reserve(baseState.size() + events.size());
+    QStringList newMemberIds;
+    newMemberIds.reserve(qsizetype(events.size()));
+    batchingNameUpdates = true;
+    for (auto&& eptr : events) {
+        StateEventKey key{ eptr->matrixType(), eptr->stateKey() };
+        const auto* rme = eventCast<const RoomMemberEvent>(eptr);
+        if (!rme || rme->membership() != Membership::Join || currentState.contains(key)) {
+            // Same as in updateStateFrom()
+            if (const auto change = q->processStateEvent(*eptr); change) {
+                changes |= change;
+                baseState[std::move(key)] = std::move(eptr);
+            }
+            continue;
+        }
+        currentState.insert(key, eptr.get());
+        newMemberIds.push_back(rme->userId());
+        baseState[std::move(key)] = std::move(eptr);
+    }
+    // Now that all new members are in the state, index their names in one go
+    for (const auto& memberId : std::as_const(newMemberIds))
+        insertMemberIntoMap(memberId);
+    finishNameUpdatesBatch();
+    if (!newMemberIds.isEmpty())
+        changes |= Change::Members;
+    if (events.size() > 9 || et.nsecsElapsed() >= ProfilerMinNsecs)
+        qCDebug(PROFILER) << "Merged" << events.size() << "member event(s) into" << q->objectName()
+                          << "in" << et << "-" << newMemberIds.size() << "new member(s)";
+    return changes;
+}
+
+QFuture<void> Room::mergeMembers(const QJsonArray& memberEventsJson)
+{
+    return Private::parseStateEvents(memberEventsJson)
+        .then(this, [this](const std::shared_ptr<StateEvents>& events) {
+            d->postprocessChanges(d->mergeMembers(std::move(*events)));
+        });
+}
+
 bool Room::displayed() const { return d->displayed; }
 
 void Room::setDisplayed(bool displayed)
@@ -1226,12 +1529,12 @@ void Room::setLastDisplayedEvent(TimelineItem::index_t index)
 
 ReadReceipt Room::lastReadReceipt(const QString& userId) const
 {
-    return d->lastReadReceipts.value(userId);
+    return d->lastReadReceipts.value(d->lookupId(userId));
 }
 
 ReadReceipt Room::lastLocalReadReceipt() const
 {
-    return d->lastReadReceipts.value(localMember().id());
+    return d->lastReadReceipts.value(d->lookupId(localMember().id()));
 }
 
 Room::rev_iter_t Room::localReadReceiptMarker() const
@@ -1248,7 +1551,21 @@ Room::rev_iter_t Room::fullyReadMarker() const
 
 QSet<QString> Room::userIdsAtEvent(const QString& eventId) const
 {
-    return d->eventIdReadUsers.value(eventId);
+    const auto it = findInTimeline(eventId);
+    return it != historyEdge() ? d->readReceipts.usersAt(it->index())
+                               : d->readReceipts.usersAt(eventId);
+}
+
+QSet<QString> Room::userIdsReadUpTo(const QString& eventId) const
+{
+    const auto it = findInTimeline(eventId);
+    return it != historyEdge() ? d->readReceipts.usersReadUpTo(it->index()) : QSet<QString>();
+}
+
+qsizetype Room::readCount(const QString& eventId) const
+{
+    const auto it = findInTimeline(eventId);
+    return it != historyEdge() ? d->readReceipts.readCount(it->index()) : 0;
 }
 
 qsizetype Room::notificationCount() const
@@ -1582,21 +1899,36 @@ void Room::handleRoomKeyEvent(const RoomKeyEvent& roomKeyEvent,
                         << d->groupSessions.size();
         const auto undecryptedEvents =
             d->undecryptedEvents[roomKeyEvent.sessionId()];
+        const auto statsBefore = std::pair{ d->unreadStats, d->partiallyReadStats };
         for (const auto& eventId : undecryptedEvents) {
-            const auto pIdx = d->eventsIndex.constFind(eventId);
+            const auto pIdx = d->eventsIndex.constFind(d->lookupId(eventId));
             if (pIdx == d->eventsIndex.cend())
                 continue;
             auto& ti = d->timeline[Timeline::size_type(*pIdx - minTimelineIndex())];
             if (auto encryptedEvent = ti.viewAs<EncryptedEvent>()) {
                 if (auto decrypted = decryptMessage(*encryptedEvent)) {
+                    d->relations.remove(*encryptedEvent);
+                    const auto countsBefore = d->uncountEvent(ti.index());
                     auto&& oldEvent = eventCast<EncryptedEvent>(
                         ti.replaceEvent(std::move(decrypted)));
                     ti->setOriginalEvent(std::move(oldEvent));
+                    d->timelineColumns.update(ti);
+                    d->recountEvent(ti, countsBefore);
+                    if (auto* searchIndex = connection()->searchIndex())
+                        searchIndex->addEvent(id(), *ti);
                     emit replacedEvent(ti.event(), ti->originalEvent());
+                    if (const auto targetId = d->relations.add(*ti); !targetId.isEmpty())
+                        emit updatedEvent(targetId);
                     d->undecryptedEvents[roomKeyEvent.sessionId()] -= eventId;
                 }
             }
         }
+        if (d->unreadStats != statsBefore.first)
+            emit unreadStatsChanged();
+        if (d->partiallyReadStats != statsBefore.second)
+            emit partiallyReadStatsChanged();
+        for (auto* thread : std::as_const(d->threads))
+            thread->onRoomKey(roomKeyEvent.sessionId());
     }
 }
 
@@ -1634,14 +1966,10 @@ void Room::Private::insertMemberIntoMap(const QString& memberId)
         qCDebug(MEMBERS) << "insertMemberIntoMap():" << memberId
                            << "has no name (even empty)";
     const auto userName = maybeUserName.value_or(QString());
-    const auto namesakes = memberNameMap.values(userName);
-    qCDebug(MEMBERS) << "insertMemberIntoMap(), user" << memberId
-                     << "with name" << userName << '-'
-                     << namesakes.size() << "namesake(s) found";
 
     // Callers should make sure they are not adding an existing user once more
-    Q_ASSERT(!namesakes.contains(memberId));
-    if (namesakes.contains(memberId)) { // Release version whines but continues
+    Q_ASSERT(!memberNames.contains(memberId));
+    if (memberNames.contains(memberId)) { // Release version whines but continues
         qCCritical(MEMBERS) << "Trying to add a user" << memberId << "to room"
                             << q->objectName() << "but that's already in it";
         return;
@@ -1649,58 +1977,48 @@ void Room::Private::insertMemberIntoMap(const QString& memberId)
 
     // If there is exactly one namesake of the added user, signal member
     // renaming for that other one because the two should be disambiguated now
-    if (namesakes.size() == 1) {
-        auto otherMember = q->member(namesakes.front());
-        emit q->memberNameAboutToUpdate(otherMember, otherMember.fullName());
-    }
-    memberNameMap.insert(userName, memberId);
-    if (namesakes.size() == 1) {
-        emit q->memberNameUpdated(q->member(namesakes.front()));
-    }
+    const auto namesakeId = memberNames.onlyMemberNamed(userName);
+    if (!namesakeId.isEmpty())
+        memberNameAboutToUpdate(namesakeId, q->member(namesakeId).fullName());
+    memberNames.insert(memberId, userName);
+    if (!namesakeId.isEmpty())
+        memberNameUpdated(namesakeId);
 }
 
 void Room::Private::removeMemberFromMap(const QString& memberId)
 {
-    const auto userName = currentState.queryOr(memberId,
-                                               &RoomMemberEvent::newDisplayName,
-                                               QString());
-
-    qCDebug(MEMBERS) << "removeMemberFromMap(), username" << userName
-                     << "for user" << memberId;
-
-    QString namesakeId{};
-    auto namesakes = memberNameMap.values(userName);
     // If there was one namesake besides the removed user, signal member
     // renaming for it because it doesn't need to be disambiguated any more.
-    if (namesakes.size() == 2) {
-        namesakeId =
-            namesakes.front() == memberId ? namesakes.back() : namesakes.front();
-        Q_ASSERT_X(namesakeId != memberId, __FUNCTION__, "Room members list is broken");
-        emit q->memberNameAboutToUpdate(q->member(namesakeId), userName);
-    }
-    if (memberNameMap.remove(userName, memberId) == 0) {
-        qCDebug(MEMBERS) << "No entries removed; checking the whole list";
-        // Unless at the stage of initial filling, this no removed entries
-        // is suspicious; double-check that this user is not found in
-        // the whole map, and stop (for debug builds) or shout in the logs
-        // (for release builds) if there's one. That search is O(n), which
-        // may come rather expensive for larger rooms.
-        QElapsedTimer et;
-        auto it = std::find(memberNameMap.cbegin(), memberNameMap.cend(), memberId);
-        if (et.nsecsElapsed() > ProfilerMinNsecs / 10)
-            qCDebug(MEMBERS) << "...done in" << et;
-        if (it != memberNameMap.cend()) {
-            // The assert (still) does more harm than good, it seems
-//            Q_ASSERT_X(false, __FUNCTION__,
-//                       "Mismatched name in the room members list");
-            qCCritical(MEMBERS) << "Mismatched name in the room members list;"
-                                   " avoiding the list corruption";
-            memberNameMap.remove(it.key(), memberId);
-        }
-    }
-    if (!namesakeId.isEmpty()) {
-        emit q->memberNameUpdated(q->member(namesakeId));
-    }
+    const auto namesakeId = memberNames.onlyNamesakeOf(memberId);
+    if (!namesakeId.isEmpty())
+        memberNameAboutToUpdate(namesakeId, memberNames.nameOf(memberId));
+    if (!memberNames.remove(memberId))
+        qCDebug(MEMBERS) << "removeMemberFromMap():" << memberId
+                         << "is not among joined members of" << q->objectName();
+    if (!namesakeId.isEmpty())
+        memberNameUpdated(namesakeId);
+}
+
+void Room::Private::memberNameAboutToUpdate(const QString& memberId, const QString& newName)
+{
+    // There's no "about to" counterpart to memberNamesUpdated()
+    if (!batchingNameUpdates)
+        emit q->memberNameAboutToUpdate(q->member(memberId), newName);
+}
+
+void Room::Private::memberNameUpdated(const QString& memberId)
+{
+    if (batchingNameUpdates)
+        renamedMembers.insert(memberId);
+    else
+        emit q->memberNameUpdated(q->member(memberId));
+}
+
+void Room::Private::finishNameUpdatesBatch()
+{
+    batchingNameUpdates = false;
+    if (!renamedMembers.isEmpty())
+        emit q->memberNamesUpdated(std::exchange(renamedMembers, {}).values());
 }
 
 inline auto makeErrorStr(const Event& e, QByteArray msg)
@@ -1728,18 +2046,24 @@ Room::Private::moveEventsToTimeline(RoomEventsRange events,
     auto baseIndex = index;
     for (auto&& e : events) {
         Q_ASSERT_X(e, __FUNCTION__, "Attempt to add nullptr to timeline");
+        e->internIds(connection->idPool());
         const auto eId = e->id();
         Q_ASSERT_X(
             !eId.isEmpty(), __FUNCTION__,
             makeErrorStr(*e, "Event with empty id cannot be in the timeline"));
         Q_ASSERT_X(
-            !eventsIndex.contains(eId), __FUNCTION__,
+            !eventsIndex.contains(lookupId(eId)), __FUNCTION__,
             makeErrorStr(*e, "Event is already in the timeline; "
                              "incoming events were not properly deduplicated"));
         const auto& ti = placement == Older
                              ? timeline.emplace_front(std::move(e), --index)
                              : timeline.emplace_back(std::move(e), ++index);
-        eventsIndex.insert(eId, index);
+        if (placement == Older)
+            timelineColumns.prepend(ti);
+        else
+            timelineColumns.append(ti);
+        eventsIndex.insert(internId(eId), index);
+        readReceipts.attach(eId, index);
         if (usesEncryption)
             if (const auto* const rme = ti.viewAs<RoomMessageEvent>())
                 if (const auto fileContent = rme->get<EventContent::FileContentBase>())
@@ -1751,6 +2075,7 @@ Room::Private::moveEventsToTimeline(RoomEventsRange events,
 
         if (auto n = q->checkForNotifications(ti); n.type != Notification::None)
             notifications.insert(eId, n);
+        countEvent(ti);
         Q_ASSERT(q->findInTimeline(eId)->event()->id() == eId);
     }
     const auto insertedSize = (index - baseIndex) * placement;
@@ -1840,10 +2165,78 @@ Room::Changes Room::Private::updateStatsFromSyncData(const SyncRoomData& data, b
     return changes;
 }
 
+//! The JSON to persist for a timeline event - encrypted events are stored as received
+inline QJsonObject storedJson(const RoomEvent& evt)
+{
+    return evt.originalEvent() ? evt.originalEvent()->fullJson() : evt.fullJson();
+}
+
+Room::Changes Room::Private::addSyncTimeline(RoomEvents&& events, bool limited,
+                                             const QString& prevBatchToken, bool fromCache)
+{
+    const bool timelineWasEmpty = timeline.empty();
+    const auto timelineSizeBefore = timeline.size();
+    const auto changes = addNewMessageEvents(std::move(events));
+    if (auto* store = connection->eventStore(); store && !fromCache) {
+        QJsonArray newEvents;
+        for (auto it = timeline.cbegin() + ptrdiff_t(timelineSizeBefore); it != timeline.cend();
+             ++it)
+            newEvents.append(storedJson(**it));
+        store->storeNewEvents(id, newEvents, limited, prevBatchToken);
+    }
+    if (timelineWasEmpty && !timeline.empty() && !prevBatchToken.isEmpty())
+        historyTokens.try_emplace(q->minTimelineIndex(), prevBatchToken);
+    else if (limited && timeline.size() > timelineSizeBefore && !prevBatchToken.isEmpty()) {
+        // The server has skipped some events between the previous and this sync response;
+        // remember where to load them from, in case the room gets opened
+        const auto firstNewIndex = timeline[timelineSizeBefore].index();
+        historyTokens.insert_or_assign(firstNewIndex, prevBatchToken);
+        timelineGap = firstNewIndex;
+        qCDebug(MESSAGES) << "Room" << q->objectName() << "has a timeline gap before index"
+                          << firstNewIndex;
+        emit q->timelineGapChanged();
+    }
+    return changes;
+}
+
+void Room::Private::onCreationArrived()
+{
+    if (q->currentState().get<RoomPowerLevelsEvent>() != defaultPowerLevels.get())
+        return;
+    // Handle a special case when RoomCreateEvent just arrived but RoomPowerLevelsEvent
+    // did not. Usually that means that a power levels event is not in the room at all,
+    // which is a somewhat extreme but still valid situation. In such a case the spec says
+    // to rely on the default power levels save for the room creator who is effectively
+    // allowed to do everything.
+    // The entire defaultPowerLevels event gets replaced in order to maintain its constness
+    // everywhere else.
+    defaultPowerLevels = std::make_unique<const RoomPowerLevelsEvent>(
+        PowerLevelsEventContent{ .users = { { q->creation()->senderId(), 100 } } });
+    currentState[{ RoomPowerLevelsEvent::TypeId, {} }] = defaultPowerLevels.get();
+}
+
+void Room::Private::emitSyncChanges(Changes changes, bool fromCache, bool partial)
+{
+    // First test for changes that can only come from /sync calls and not
+    // other interactions (/members, /messages etc.)
+    if ((changes & Change::Topic) > 0)
+        emit q->topicChanged();
+
+    if ((changes & Change::RoomNames) > 0)
+        emit q->namesChanged(q);
+
+    // And now test for changes that can occur from /sync or otherwise
+    if (partial) {
+        chunkedSyncChanges |= changes;
+        emitChangeSignals(changes);
+    } else
+        postprocessChanges(changes, !fromCache, std::exchange(chunkedSyncChanges, {}));
+}
+
 void Room::updateData(SyncRoomData&& data, bool fromCache)
 {
     qCDebug(MAIN) << "--- Updating room" << id() << "/" << objectName();
-    const bool firstUpdate = d->baseState.empty();
+    const bool firstUpdate = std::exchange(d->baseStateLoadPending, false) || d->baseState.empty();
     const bool createEventPreviouslyMissing = creation() == nullptr;
 
     if (d->prevBatch && d->prevBatch->isEmpty())
@@ -1854,7 +2247,8 @@ void Room::updateData(SyncRoomData&& data, bool fromCache)
     // The order of calculation is important - don't merge the lines!
     roomChanges |= d->updateStateFrom(std::move(data.state));
     roomChanges |= d->setSummary(std::move(data.summary));
-    roomChanges |= d->addNewMessageEvents(std::move(data.timeline));
+    roomChanges |= d->addSyncTimeline(std::move(data.timeline), data.timelineLimited,
+                                      data.timelinePrevBatch, fromCache);
 
     for (auto&& ephemeralEvent : data.ephemeral)
         roomChanges |= processEphemeralEvent(std::move(ephemeralEvent));
@@ -1864,38 +2258,68 @@ void Room::updateData(SyncRoomData&& data, bool fromCache)
 
     roomChanges |= d->updateStatsFromSyncData(data, fromCache);
 
-    if (roomChanges != 0) {
-        if (createEventPreviouslyMissing && creation()
-            && currentState().get<RoomPowerLevelsEvent>() == d->defaultPowerLevels.get()) {
-            // Handle a special case when RoomCreateEvent just arrived but RoomPowerLevelsEvent
-            // did not. Usually that means that a power levels event is not in the room at all,
-            // which is a somewhat extreme but still valid situation. In such a case the spec says
-            // to rely on the default power levels save for the room creator who is effectively
-            // allowed to do everything.
-            // The entire defaultPowerLevels event gets replaced in order to maintain its constness
-            // everywhere else.
-            d->defaultPowerLevels = std::make_unique<const RoomPowerLevelsEvent>(
-                PowerLevelsEventContent{ .users = { { creation()->senderId(), 100 } } });
-            d->currentState[{ RoomPowerLevelsEvent::TypeId, {} }] = d->defaultPowerLevels.get();
-        }
+    if (createEventPreviouslyMissing && creation())
+        d->onCreationArrived();
+    d->emitSyncChanges(roomChanges, fromCache);
+    if (firstUpdate)
+        emit baseStateLoaded();
+    d->evictHistory();
+    qCDebug(MAIN) << "--- Finished updating room" << id() << "/" << objectName();
+}
 
-        // First test for changes that can only come from /sync calls and not
-        // other interactions (/members, /messages etc.)
-        if ((roomChanges & Change::Topic) > 0)
-            emit topicChanged();
+bool Room::applySyncChunk(SyncRoomData& data, size_t maxEvents, bool fromCache)
+{
+    if (data.state.size() + data.timeline.size() <= maxEvents)
+        return false;
 
-        if ((roomChanges & Change::RoomNames) > 0)
-            emit namesChanged(this);
+    if (d->baseState.empty())
+        d->baseStateLoadPending = true; // To be emitted when the whole update is applied
+    const bool createEventPreviouslyMissing = creation() == nullptr;
+    if (d->prevBatch && d->prevBatch->isEmpty())
+        *d->prevBatch = data.timelinePrevBatch;
+    setJoinState(data.joinState);
 
-        // And now test for changes that can occur from /sync or otherwise
-        d->postprocessChanges(roomChanges, !fromCache);
+    auto changes = d->setSummary(std::move(data.summary));
+    data.summary = {};
+    // State goes first, then the timeline, in the same order as in updateData()
+    if (!data.state.empty()) {
+        const auto chunkEnd =
+            data.state.begin() + ptrdiff_t(std::min(maxEvents, data.state.size()));
+        StateEvents chunk(std::make_move_iterator(data.state.begin()),
+                          std::make_move_iterator(chunkEnd));
+        data.state.erase(data.state.begin(), chunkEnd);
+        changes |= d->updateStateFrom(std::move(chunk));
+    } else {
+        const auto chunkEnd = data.timeline.begin() + ptrdiff_t(maxEvents);
+        RoomEvents chunk(std::make_move_iterator(data.timeline.begin()),
+                         std::make_move_iterator(chunkEnd));
+        data.timeline.erase(data.timeline.begin(), chunkEnd);
+        changes |= d->addSyncTimeline(std::move(chunk), data.timelineLimited,
+                                      data.timelinePrevBatch, fromCache);
+        // Only the oldest part of the timeline follows the gap (if any)
+        data.timelineLimited = false;
     }
-    if (firstUpdate)
-        emit baseStateLoaded();
-    qCDebug(MAIN) << "--- Finished updating room" << id() << "/" << objectName();
+    if (createEventPreviouslyMissing && creation())
+        d->onCreationArrived();
+    d->emitSyncChanges(changes, fromCache, true);
+    return true;
 }
 
-void Room::Private::postprocessChanges(Changes changes, bool saveState)
+void Room::Private::postprocessChanges(Changes changes, bool saveState, Changes earlierChanges)
+{
+    const auto allChanges = changes | earlierChanges;
+    if (!allChanges)
+        return;
+
+    if ((allChanges & (Change::RoomNames | Change::Members | Change::Summary)) > 0)
+        updateDisplayname();
+
+    emitChangeSignals(changes);
+    if (saveState)
+        connection->saveRoomState(q);
+}
+
+void Room::Private::emitChangeSignals(Changes changes)
 {
     if (!changes)
         return;
@@ -1903,9 +2327,6 @@ void Room::Private::postprocessChanges(Changes changes, bool saveState)
     if ((changes & Change::Members) > 0)
         emit q->memberListChanged();
 
-    if ((changes & (Change::RoomNames | Change::Members | Change::Summary)) > 0)
-        updateDisplayname();
-
     if ((changes & Change::PartiallyReadStats) > 0)
         emit q->partiallyReadStatsChanged();
 
@@ -1918,8 +2339,6 @@ void Room::Private::postprocessChanges(Changes changes, bool saveState)
     qCDebug(MAIN).nospace() << terse << changes << " = 0x" << Qt::hex
                             << uint(changes) << " in " << q->objectName();
     emit q->changed(changes);
-    if (saveState)
-        connection->saveRoomState(q);
 }
 
 Room::PendingEvents::iterator Room::Private::addAsPending(RoomEventPtr&& event)
@@ -2333,6 +2752,21 @@ JobHandle<GetRoomEventsJob> Room::getPreviousContent(int limit, const QString& f
     return d->getPreviousContent(limit, filter);
 }
 
+std::optional<TimelineItem::index_t> Room::timelineGap() const { return d->timelineGap; }
+
+void Room::fillTimelineGap()
+{
+    if (!d->timelineGap)
+        return;
+    const auto tokenIt = d->historyTokens.find(*d->timelineGap);
+    Q_ASSERT(tokenIt != d->historyTokens.end());
+    // Events before the gap are dropped, to be loaded again after the events in the gap
+    d->eventsHistoryJob.abandon();
+    d->dropHistoryBefore(tokenIt);
+    const auto roomType = creation() ? creation()->contentPart<QString>("type"_L1) : QString();
+    d->getPreviousContent(connection()->syncTimelineLimits().gapFillLimit(roomType));
+}
+
 JobHandle<GetRoomEventsJob> Room::Private::getPreviousContent(int limit, const QString& filter)
 {
     if (!prevBatch)
@@ -2342,21 +2776,54 @@ JobHandle<GetRoomEventsJob> Room::Private::getPreviousContent(int limit, const Q
         return eventsHistoryJob;
 
     lastRequestedHistorySize = limit;
-    eventsHistoryJob =
-        connection->callApi<GetRoomEventsJob>(id, "b"_L1, *prevBatch, QString(), limit, filter);
+    std::optional<EventStore::HistoryBatch> storedBatch;
+    if (auto* store = connection->eventStore(); store && !timeline.empty()) {
+        storedBatch = store->loadHistory(id, timeline.front()->id(), limit);
+        if (storedBatch && storedBatch->events.isEmpty()) {
+            // Nothing stored before the timeline start; but the stored chunk may know better
+            // where to paginate from, if history has been served from the store before
+            if (storedBatch->chunkExhausted && !storedBatch->prevBatch.isEmpty())
+                *prevBatch = storedBatch->prevBatch;
+            storedBatch.reset();
+        }
+    }
+    if (storedBatch) {
+        qCDebug(MESSAGES) << "Loading" << storedBatch->events.size() << "events of"
+                          << q->objectName() << "history from the event store";
+        eventsHistoryJob = connection->callApiWithResponse<GetRoomEventsJob>(
+            QJsonDocument(QJsonObject{ { "start"_L1, *prevBatch },
+                                       { "end"_L1, storedBatch->prevBatch },
+                                       { "chunk"_L1, storedBatch->events } }),
+            id, "b"_L1, *prevBatch, QString(), limit, filter);
+    } else
+        eventsHistoryJob =
+            connection->callApi<GetRoomEventsJob>(id, "b"_L1, *prevBatch, QString(), limit, filter);
     emit q->eventsHistoryJobChanged();
-    connect(eventsHistoryJob, &BaseJob::success, q, [this] {
-        if (const auto newPrevBatch = eventsHistoryJob->end();
-            !newPrevBatch.isEmpty() && *prevBatch != newPrevBatch) //
-        {
-            *prevBatch = newPrevBatch;
-        } else {
-            qCDebug(MESSAGES)
-                << "Room" << q->objectName() << "has loaded all history";
-            prevBatch.reset();
+    connect(eventsHistoryJob, &BaseJob::success, q,
+            [this, fromStore = storedBatch.has_value(),
+             chunkExhausted = storedBatch && storedBatch->chunkExhausted] {
+        const auto newPrevBatch = eventsHistoryJob->end();
+        // While there's more history in the store, prevBatch is left alone - it only
+        // matters once the store runs out of events
+        if (!fromStore || chunkExhausted) {
+            if (!newPrevBatch.isEmpty() && (fromStore || *prevBatch != newPrevBatch)) {
+                *prevBatch = newPrevBatch;
+            } else {
+                qCDebug(MESSAGES) << "Room" << q->objectName() << "has loaded all history";
+                prevBatch.reset();
+            }
         }
 
+        if (auto* store = connection->eventStore(); store && !fromStore && !timeline.empty())
+            store->storeHistoricalEvents(id, timeline.front()->id(),
+                                         eventsHistoryJob->jsonData()["chunk"_L1].toArray(),
+                                         newPrevBatch);
         auto [changes, from] = addHistoricalMessageEvents(eventsHistoryJob->chunk());
+        // A batch from the middle of a stored chunk has no token of its own; prevBatch still
+        // leads to the server history before the previous timeline start, and recording it
+        // for the new start would make evictHistory() cut the timeline at a wrong point
+        if (prevBatch && !timeline.empty() && (!fromStore || chunkExhausted))
+            historyTokens.insert_or_assign(timeline.front().index(), *prevBatch);
         // The following condition will only trigger once, next time getPreviousContent()
         // will return without spawning GetRoomEventsJob
         if (!prevBatch)
@@ -2528,15 +2995,13 @@ void Room::Private::dropExtraneousEvents(RoomEvents& events) const
     //    users
     auto newEnd =
         remove_if(events.begin(), events.end(), [this](const RoomEventPtr& e) {
-            return eventsIndex.contains(e->id())
+            return eventsIndex.contains(lookupId(e->id()))
                    || connection->isIgnored(e->senderId());
         });
 
-    // 2. Check for duplicates within the batch if there are still events.
-    for (auto eIt = events.begin(); distance(eIt, newEnd) > 1; ++eIt)
-        newEnd = remove_if(eIt + 1, newEnd, [eIt](const RoomEventPtr& e) {
-            return e->id() == (*eIt)->id();
-        });
+    // 2. Check for duplicates within the batch, the first occurrence wins
+    newEnd = removeDuplicates(events.begin(), newEnd,
+                              [](const RoomEventPtr& e) -> const QString& { return e->id(); });
 
     if (newEnd == events.end())
         return;
@@ -2556,6 +3021,7 @@ void Room::Private::decryptIncomingEvents(RoomEvents& events)
     QElapsedTimer et;
     et.start();
     size_t totalDecrypted = 0;
+    auto* const searchIndex = connection->searchIndex();
     for (auto& eptr : events) {
         if (eptr->isRedacted())
             continue;
@@ -2565,6 +3031,8 @@ void Room::Private::decryptIncomingEvents(RoomEvents& events)
                 auto&& oldEvent = eventCast<EncryptedEvent>(
                         std::exchange(eptr, std::move(decrypted)));
                 eptr->setOriginalEvent(std::move(oldEvent));
+                if (searchIndex)
+                    searchIndex->addEvent(id, *eptr);
             } else
                 undecryptedEvents[eeptr->sessionId()] += eeptr->id();
         }
@@ -2636,7 +3104,7 @@ bool Room::Private::processRedaction(const RedactionEvent& redaction)
 {
     // Can't use findInTimeline because it returns a const iterator, and
     // we need to change the underlying TimelineItem.
-    const auto pIdx = eventsIndex.constFind(redaction.redactedEvent());
+    const auto pIdx = eventsIndex.constFind(lookupId(redaction.redactedEvent()));
     if (pIdx == eventsIndex.cend())
         return false;
 
@@ -2653,7 +3121,10 @@ bool Room::Private::processRedaction(const RedactionEvent& redaction)
 
     // Make a new event from the redacted JSON and put it in the timeline
     // instead of the redacted one. oldEvent will be deleted on return.
+    const auto countsBefore = uncountEvent(ti.index());
     auto oldEvent = ti.replaceEvent(makeRedacted(*ti, redaction));
+    timelineColumns.update(ti);
+    recountEvent(ti, countsBefore);
     qCDebug(EVENTS) << "Redacted" << oldEvent->id() << "with" << redaction.id();
     if (oldEvent->isStateEvent()) {
         // Check whether the old event was a part of current state; if it was,
@@ -2673,14 +3144,8 @@ bool Room::Private::processRedaction(const RedactionEvent& redaction)
             updateDisplayname();
         }
     }
-    if (const auto* reaction = eventCast<ReactionEvent>(oldEvent)) {
-        const auto& content = reaction->content().value;
-        const std::pair lookupKey { content.eventId, content.type };
-        if (relations.contains(lookupKey)) {
-            relations[lookupKey].removeOne(reaction);
-            emit q->updatedEvent(content.eventId);
-        }
-    }
+    if (const auto targetId = relations.remove(*oldEvent); !targetId.isEmpty())
+        emit q->updatedEvent(targetId);
     q->onRedaction(*oldEvent, *ti);
     emit q->replacedEvent(ti.event(), std::to_address(oldEvent));
     // By now, all references to oldEvent must have been updated to ti.event()
@@ -2706,11 +3171,39 @@ RoomEventPtr makeReplaced(const RoomEvent& target,
     return loadEvent<RoomEvent>(originalJson);
 }
 
+RoomThread* Room::Private::threadOf(const RoomEvent& evt) const
+{
+    if (auto* thread = threads.value(evt.id()))
+        return thread;
+    const auto relation = RelationsIndex::relationOf(evt);
+    return relation && relation->type == EventRelation::ThreadType
+               ? threads.value(relation->eventId)
+               : nullptr;
+}
+
+void Room::Private::updateOwnThreadEvents(const RoomEvent& editingEvent)
+{
+    if (const auto* r = eventCast<const RedactionEvent>(&editingEvent)) {
+        for (auto* thread : std::as_const(threads))
+            if (const auto* target = thread->ownEvent(r->redactedEvent());
+                target
+                && !(target->isRedacted() && target->redactedBecause()->id() == r->id()))
+                thread->replaceOwnEvent(makeRedacted(*target, *r));
+    } else if (const auto* msg = eventCast<const RoomMessageEvent>(&editingEvent);
+               msg && !msg->replacedEvent().isEmpty()) {
+        for (auto* thread : std::as_const(threads))
+            if (const auto* target =
+                    eventCast<const RoomMessageEvent>(thread->ownEvent(msg->replacedEvent()));
+                target && target->replacedBy() != msg->id())
+                thread->replaceOwnEvent(makeReplaced(*target, *msg));
+    }
+}
+
 bool Room::Private::processReplacement(const RoomMessageEvent& newEvent)
 {
     // Can't use findInTimeline because it returns a const iterator, and
     // we need to change the underlying TimelineItem.
-    const auto pIdx = eventsIndex.constFind(newEvent.replacedEvent());
+    const auto pIdx = eventsIndex.constFind(lookupId(newEvent.replacedEvent()));
     if (pIdx == eventsIndex.cend())
         return false;
 
@@ -2731,9 +3224,20 @@ bool Room::Private::processReplacement(const RoomMessageEvent& newEvent)
 
     // Make a new event from the redacted JSON and put it in the timeline
     // instead of the redacted one. oldEvent will be deleted on return.
+    const auto countsBefore = uncountEvent(ti.index());
     auto oldEvent = ti.replaceEvent(makeReplaced(*ti, newEvent));
+    timelineColumns.update(ti);
+    recountEvent(ti, countsBefore);
     qCDebug(STATE) << "Replaced" << oldEvent->id() << "with" << newEvent.id();
+    // The edited event may itself be a thread reply or a reaction; re-index it in case
+    // the edit changed what it relates to
+    const auto oldTargetId = relations.remove(*oldEvent);
+    const auto newTargetId = relations.add(*ti);
     emit q->replacedEvent(ti.event(), std::to_address(oldEvent));
+    if (!oldTargetId.isEmpty())
+        emit q->updatedEvent(oldTargetId);
+    if (!newTargetId.isEmpty() && newTargetId != oldTargetId)
+        emit q->updatedEvent(newTargetId);
     return true;
 }
 
@@ -2743,31 +3247,6 @@ Connection* Room::connection() const
     return d->connection;
 }
 
-void Room::Private::addRelation(const ReactionEvent& reactionEvt)
-{
-    const auto& content = reactionEvt.content().value;
-    // See ReactionEvent::isValid()
-    Q_ASSERT(content.type == EventRelation::AnnotationType);
-    const auto isSameReaction = [&reactionEvt](const RoomEvent* existingEvent) {
-        const auto* reactionEvt2 = eventCast<const ReactionEvent>(existingEvent);
-        const auto& r1 = reactionEvt.content().value;
-        const auto& r2 = reactionEvt2->content().value;
-        return reactionEvt2 != nullptr
-               && reactionEvt.senderId() == reactionEvt2->senderId()
-               && r1.eventId == r2.eventId && r1.key == r2.key;
-    };
-
-    auto& thisEventReactions = relations[{ content.eventId, content.type }];
-    if (std::any_of(thisEventReactions.cbegin(), thisEventReactions.cend(),
-                    isSameReaction)) {
-        qDebug(MESSAGES) << "Skipping a duplicate reaction from"
-                         << reactionEvt.senderId();
-        return;
-    }
-    thisEventReactions << &reactionEvt;
-    emit q->updatedEvent(content.eventId);
-}
-
 /// Whether the event is a redaction or a replacement
 inline bool isEditing(const RoomEventPtr& ep)
 {
@@ -2818,7 +3297,9 @@ Room::Changes Room::Private::addNewMessageEvents(RoomEvents&& events)
     QElapsedTimer et;
     et.start();
 
+    Changes roomChanges {};
     {
+        const auto statsBefore = std::pair{ unreadStats, partiallyReadStats };
         // Pre-process redactions and edits so that events that get
         // redacted/replaced in the same batch landed in the timeline already
         // treated.
@@ -2827,6 +3308,9 @@ Room::Changes Room::Private::addNewMessageEvents(RoomEvents&& events)
         auto it = std::find_if(events.begin(), events.end(), isEditing);
         for (const auto& eptr : std::ranges::subrange(it, events.end())) {
             if (auto* r = eventCast<RedactionEvent>(eptr)) {
+                if (auto* searchIndex = connection->searchIndex();
+                    searchIndex && q->usesEncryption())
+                    searchIndex->removeEvent(r->redactedEvent());
                 // Try to find the target in the timeline, then in the batch.
                 if (processRedaction(*r))
                     continue;
@@ -2856,6 +3340,11 @@ Room::Changes Room::Private::addNewMessageEvents(RoomEvents&& events)
                 // later will come already with the new content.
             }
         }
+        // Redactions and edits of events after the read markers update exact statistics
+        if (unreadStats != statsBefore.first)
+            roomChanges |= Change::UnreadStats;
+        if (partiallyReadStats != statsBefore.second)
+            roomChanges |= Change::PartiallyReadStats;
     }
 
     // State changes arrive as a part of timeline; the current room state gets
@@ -2863,7 +3352,6 @@ Room::Changes Room::Private::addNewMessageEvents(RoomEvents&& events)
     // clients historically expect. This may eventually change though if we
     // postulate that the current state is only current between syncs but not
     // within a sync.
-    Changes roomChanges {};
     for (const auto& eptr : events)
         roomChanges |= q->processStateEvent(*eptr);
 
@@ -2937,6 +3425,10 @@ Room::Changes Room::Private::addNewMessageEvents(RoomEvents&& events)
 
     if (totalInserted > 0) {
         addRelations(from, syncEdge());
+        updateThreads(from, syncEdge());
+        if (!threads.isEmpty())
+            for (auto it = from; it != syncEdge(); ++it)
+                updateOwnThreadEvents(**it);
 
         qCDebug(MESSAGES) << "Room" << q->objectName() << "received"
                        << totalInserted << "new events; the last event is now"
@@ -2996,6 +3488,7 @@ std::pair<Room::Changes, Room::rev_iter_t> Room::Private::addHistoricalMessageEv
     emit q->addedMessages(timeline.front().index(), from->index());
 
     addRelations(from, historyEdge());
+    updateThreads(from, historyEdge());
     Q_ASSERT(timeline.size() == timelineSize + insertedSize);
     if (insertedSize > 9 || et.nsecsElapsed() >= ProfilerMinNsecs)
         qCDebug(PROFILER) << "Added" << insertedSize << "historical event(s) to" << q->objectName()
@@ -3003,6 +3496,104 @@ std::pair<Room::Changes, Room::rev_iter_t> Room::Private::addHistoricalMessageEv
     return { changes, from };
 }
 
+void Room::Private::forgetTimelineItem(TimelineItem& ti)
+{
+    const auto eventId = ti->id();
+    uncountEvent(ti.index());
+    eventsIndex.remove(lookupId(eventId));
+    notifications.remove(eventId);
+    if (ti->is<RoomMessageEvent>())
+        FileMetadataMap::remove(id, eventId);
+    relations.remove(*ti);
+    readReceipts.detach(ti.index(), eventId);
+    if (const auto* encrypted = ti.viewAs<EncryptedEvent>())
+        if (auto it = undecryptedEvents.find(encrypted->sessionId());
+            it != undecryptedEvents.end())
+            it->second.remove(eventId);
+    if (ti->isStateEvent()
+        && currentState.get(ti->matrixType(), ti->stateKey()) == ti.event()) {
+        // currentState points to this very event; move it out of the timeline to keep it alive
+        const StateEventKey key{ ti->matrixType(), ti->stateKey() };
+        baseState[key].reset(static_cast<StateEvent*>(ti.replaceEvent({}).release()));
+    }
+    // Keep the event alive for the thread it belongs to
+    if (ti.event() != nullptr)
+        if (auto* thread = threadOf(*ti))
+            thread->keepEvent(ti.replaceEvent({}));
+}
+
+void Room::Private::evictHistory()
+{
+    if (timelineWindow <= 0 || std::ssize(timeline) <= timelineWindow
+        || isJobPending(eventsHistoryJob))
+        return;
+
+    // Events from keepFrom onwards stay in the timeline
+    auto keepFrom = timeline.back().index() - timelineWindow + 1;
+    const auto keepEvent = [this, &keepFrom](const QString& eventId) {
+        if (const auto it = eventsIndex.constFind(lookupId(eventId)); it != eventsIndex.cend())
+            keepFrom = std::min(keepFrom, *it);
+    };
+    keepEvent(fullyReadUntilEventId);
+    keepEvent(lastReadReceipts.value(lookupId(connection->userId())).eventId);
+    keepEvent(firstDisplayedEventId);
+    for (auto it = keyVerificationSessions.cbegin(); it != keyVerificationSessions.cend(); ++it)
+        keepEvent(it.key());
+
+    // Only cut at a point from which the evicted part can be loaded back
+    auto tokenIt = historyTokens.upper_bound(keepFrom);
+    if (tokenIt == historyTokens.begin())
+        return;
+    dropHistoryBefore(--tokenIt);
+}
+
+void Room::Private::dropHistoryBefore(std::map<TimelineItem::index_t, QString>::iterator tokenIt)
+{
+    const auto [cutIndex, token] = *tokenIt;
+    const auto firstIndex = timeline.front().index();
+    if (cutIndex <= firstIndex)
+        return;
+
+    const auto isDropped = [this, cutIndex](const rev_iter_t& marker) {
+        return marker != historyEdge() && marker->index() < cutIndex;
+    };
+    const bool fullyReadMarkerDropped = isDropped(q->fullyReadMarker());
+    const bool readReceiptDropped = isDropped(q->localReadReceiptMarker());
+
+    QElapsedTimer et;
+    et.start();
+    emit q->aboutToEvictHistoricalMessages(firstIndex, cutIndex - 1);
+    const auto cutIt = timeline.begin() + (cutIndex - firstIndex);
+    for (auto& ti : std::ranges::subrange(timeline.begin(), cutIt))
+        forgetTimelineItem(ti);
+    timeline.erase(timeline.begin(), cutIt);
+    timelineColumns.dropOldest(size_t(cutIndex - firstIndex));
+    historyTokens.erase(historyTokens.begin(), tokenIt);
+    const bool allHistoryWasLoaded = !prevBatch;
+    prevBatch = token;
+    qCDebug(MESSAGES) << "Evicted" << cutIndex - firstIndex << "historical event(s) from"
+                      << q->objectName() << "in" << et;
+    emit q->evictedHistoricalMessages(firstIndex, cutIndex - 1);
+    if (allHistoryWasLoaded)
+        emit q->allHistoryLoadedChanged();
+    if (timelineGap && *timelineGap <= cutIndex) {
+        timelineGap.reset();
+        emit q->timelineGapChanged();
+    }
+    // Counting from markers that are no more in the timeline can only give an estimate
+    Changes changes = Change::None;
+    if (fullyReadMarkerDropped && !partiallyReadStats.isEstimate) {
+        partiallyReadStats.isEstimate = true;
+        changes |= Change::PartiallyReadStats;
+    }
+    if (readReceiptDropped && !unreadStats.isEstimate) {
+        unreadStats.isEstimate = true;
+        changes |= Change::UnreadStats;
+    }
+    if (changes != 0)
+        postprocessChanges(changes);
+}
+
 void Room::Private::preprocessStateEvent(const RoomEvent& newEvent,
                                          const RoomEvent* curEvent)
 {
@@ -3022,7 +3613,7 @@ void Room::Private::preprocessStateEvent(const RoomEvent& newEvent,
                 if (rme.membership() == Membership::Join) {
                     // rename/avatar change or no-op
                     if (rme.newDisplayName()) {
-                        emit q->memberNameAboutToUpdate(q->member(rme.userId()), *rme.newDisplayName());
+                        memberNameAboutToUpdate(rme.userId(), *rme.newDisplayName());
                         removeMemberFromMap(rme.userId());
                     }
                     if (!rme.newDisplayName() && !rme.newAvatarUrl())
@@ -3088,6 +3679,8 @@ Room::Changes Room::processStateEvent(const RoomEvent& e)
         qCDebug(STATE) << "Updated room state:" << e;
 
     const auto result = d->processStateEvent(*curStateEvent, oldStateEvent);
+    if (e.matrixType() == SpaceChildEventType || e.matrixType() == SpaceParentEventType)
+        connection()->spaceGraph()->processStateEvent(id(), *curStateEvent);
 
     Q_ASSERT(result != Change::None);
     // Whatever the outcome, the relevant piece of state should stay valid
@@ -3143,7 +3736,7 @@ Room::Change Room::Private::processStateEvent(const RoomEvent& curEvent,
                 } else {
                     if (evt.newDisplayName()) {
                         insertMemberIntoMap(evt.userId());
-                        emit q->memberNameUpdated(q->member(evt.userId()));
+                        memberNameUpdated(evt.userId());
                     }
                     if (evt.newAvatarUrl()) {
                         emit q->memberAvatarUpdated(q->member(evt.userId()));
@@ -3337,11 +3930,11 @@ QString Room::Private::calculateDisplayname() const
     // "heroes" if available.
     const bool localUserIsIn = joinState == JoinState::Join;
     const bool emptyRoom =
-        memberNameMap.isEmpty()
-        || (memberNameMap.size() == 1 && isLocalMember(*memberNameMap.cbegin()));
+        memberNames.isEmpty()
+        || (memberNames.size() == 1 && memberNames.contains(connection->userId()));
     const bool nonEmptySummary = summary.heroes && !summary.heroes->empty();
     auto shortlist = nonEmptySummary ? buildShortlist(*summary.heroes)
-                                     : !emptyRoom ? buildShortlist(memberNameMap.values())
+                                     : !emptyRoom ? buildShortlist(memberNames.userIds())
                                                   : users_shortlist_t {};
 
     // When the heroes list is there, we can rely on it. If the heroes list is
@@ -12,10 +12,13 @@
 #include "connection.h"
 #include "roommember.h"
 #include "roomstateview.h"
+#include "relationsindex.h"
+#include "roomthread.h"
 #include "eventitem.h"
 #include "quotient_common.h"
 
 #include "csapi/message_pagination.h"
+#include "csapi/threads_list.h"
 
 #include "events/accountdataevents.h"
 #include "events/encryptedevent.h"
@@ -359,6 +362,38 @@ public:
     //!         no further history to load; false otherwise
     bool allHistoryLoaded() const;
 
+    //! \brief The number of the newest events always kept in the timeline
+    //! \return the window size, or 0 if the timeline is not limited (the default)
+    //! \sa setTimelineWindow
+    int timelineWindow() const;
+
+    //! \brief Limit the number of events kept in memory
+    //!
+    //! With a non-zero window, events older than the newest \p eventsCount ones are evicted from
+    //! the timeline after each sync, unless they are at or after the fully read marker, the local
+    //! user's read receipt or the first displayed event (see setFirstDisplayedEvent()), or are
+    //! parts of an ongoing key verification. Eviction only happens at the boundaries of loaded
+    //! batches so that getPreviousContent() can load the evicted events back; the indices of
+    //! the remaining events don't change, and events loaded back get the same indices as before.
+    //! \sa aboutToEvictHistoricalMessages, evictedHistoricalMessages
+    void setTimelineWindow(int eventsCount);
+
+    //! \brief The index of the first event after a gap in the timeline, if there's a gap
+    //!
+    //! A sync response for a room that had more new events than the timeline limit of the sync
+    //! (see Connection::syncTimelineLimits()) leaves a gap between the events received before
+    //! and the newest events. Only the most recent gap is tracked; events before it stay in
+    //! the timeline until fillTimelineGap() is called.
+    //! \sa fillTimelineGap, timelineGapChanged
+    std::optional<TimelineItem::index_t> timelineGap() const;
+
+    //! \brief Load the events missing in the timeline gap
+    //!
+    //! Events before the gap are evicted from the timeline (see evictedHistoricalMessages()) and
+    //! the history is loaded anew from the gap backwards, using the gap filling limit for the room
+    //! type from Connection::syncTimelineLimits(). Does nothing if there's no gap.
+    Q_INVOKABLE void fillTimelineGap();
+
     //! \brief Get a reverse iterator at the position before the "oldest" event
     //!
     //! Same as messageEvents().crend()
@@ -373,14 +408,45 @@ public:
 
     rev_iter_t findInTimeline(TimelineItem::index_t index) const;
     rev_iter_t findInTimeline(const QString& evtId) const;
+    //! \brief Find the oldest loaded event sent at or after \p timestamp
+    //!
+    //! \return the iterator to that event, or historyEdge() if all loaded events are older
+    rev_iter_t findInTimeline(const QDateTime& timestamp) const;
     PendingEvents::iterator findPendingEvent(const QString& txnId);
     PendingEvents::const_iterator findPendingEvent(const QString& txnId) const;
 
+    //! \brief The index of relations between events in the timeline
+    //!
+    //! Use it to get reaction counts and senders, thread summaries and edit chains without
+    //! scanning the timeline.
+    const RelationsIndex& relations() const;
+
     const RelatedEvents relatedEvents(const QString& evtId,
                                       EventRelation::reltypeid_t relType) const;
     const RelatedEvents relatedEvents(const RoomEvent& evt,
                                       EventRelation::reltypeid_t relType) const;
 
+    //! \brief Get the timeline of the thread started by \p rootId
+    //!
+    //! The thread object is created on the first call for a given root, with the thread events
+    //! already in the main timeline; use RoomThread::loadHistory() to load the rest of the thread
+    //! without paginating the main timeline. The room owns the object.
+    //! \return the thread object, or nullptr if \p rootId is empty
+    Q_INVOKABLE Quotient::RoomThread* thread(const QString& rootId);
+
+    //! Threads obtained with thread() or loadThreads() so far
+    QList<RoomThread*> threads() const;
+
+    //! \brief Load the next page of the list of threads in the room
+    //!
+    //! Threads are listed from the one with the most recent activity; every loaded root event
+    //! gets a RoomThread object. Room::threadsLoaded() is emitted once the page arrives.
+    //! \sa allThreadsLoaded
+    JobHandle<GetThreadRootsJob> loadThreads(int limit = 20);
+
+    //! Check whether there are no more threads to load with loadThreads()
+    bool allThreadsLoaded() const;
+
     const RoomCreateEvent* creation() const;
     const RoomTombstoneEvent* tombstone() const;
 
@@ -393,6 +459,19 @@ public:
      * measure that "screen time".
      */
     void setDisplayed(bool displayed = true);
+
+    //! \brief Merge a full list of member events into the room state at once
+    //!
+    //! This is the bulk path used to load all members of a room with lazy-loaded members (see
+    //! setDisplayed()); it can also be used to feed a member list obtained in another way.
+    //! \p memberEventsJson, in the format of the `chunk` array of a `/members` response, is
+    //! parsed off the main thread and then merged into the room state in one go. Unlike state
+    //! events coming with syncs, events that add new joined members don't go through
+    //! processStateEvent() and don't cause memberJoined() signals; instead, memberListChanged()
+    //! is emitted once after the merge, along with memberNamesUpdated() for the members that
+    //! need disambiguation because of their new namesakes.
+    //! \return a future that finishes once the members are merged
+    QFuture<void> mergeMembers(const QJsonArray& memberEventsJson);
     QString firstDisplayedEventId() const;
     rev_iter_t firstDisplayedMarker() const;
     void setFirstDisplayedEventId(const QString& eventId);
@@ -457,6 +536,19 @@ public:
     //! \sa lastReadReceipt, allMembersLoaded
     QSet<QString> userIdsAtEvent(const QString& eventId) const;
 
+    //! \brief Get the ids of users who have read up to a given event
+    //!
+    //! This returns users whose read receipts are on the event with \p eventId or on a later
+    //! event in the timeline. Both the event and the receipts must be in the loaded timeline
+    //! to be taken into account.
+    //! \sa readCount, userIdsAtEvent
+    QSet<QString> userIdsReadUpTo(const QString& eventId) const;
+
+    //! \brief Get the number of users who have read up to a given event
+    //!
+    //! This is the size of userIdsReadUpTo() result, computed in logarithmic time.
+    qsizetype readCount(const QString& eventId) const;
+
     //! \brief Mark the event with uptoEventId as fully read
     //!
     //! Marks the event with the specified id as fully read locally and also
@@ -484,7 +576,12 @@ public:
     //!   the original event usually is);
     //! - from a non-local user (events from other devices of the local
     //!   user are not notable).
-    //! \sa partiallyReadStats, unreadStats
+    //!
+    //! The event counters behind countEvents(), unreadStats() and partiallyReadStats() call
+    //! this once for each event when it's added to the timeline, and again when the event is
+    //! redacted, replaced or decrypted; the results are snapshots. An override that depends on
+    //! anything else (e.g., client settings) should call recountEvents() when that changes.
+    //! \sa partiallyReadStats, unreadStats, recountEvents
     virtual bool isEventNotable(const TimelineItem& ti) const;
 
     //! \brief Get notification details for an event
@@ -493,6 +590,26 @@ public:
     //! generated for \p evt.
     Notification notificationFor(const TimelineItem& ti) const;
 
+    //! \brief Count notable and highlighted events in a range of the timeline
+    //!
+    //! Returns exact statistics (<tt>isEstimate == false</tt>) on events between \p from
+    //! (inclusive) and \p to (exclusive). The counters behind this are maintained as events
+    //! are added to the timeline, redacted, replaced or decrypted, using isEventNotable() and
+    //! notificationFor() at that moment; so this takes logarithmic time regardless of
+    //! the length of the range, but doesn't reflect later changes in what these return for
+    //! the same event until recountEvents() is called.
+    //! \sa EventStats::fromRange
+    EventStats countEvents(const rev_iter_t& from, const rev_iter_t& to) const;
+
+    //! \brief Count all events in the loaded timeline anew
+    //!
+    //! Call this when isEventNotable() may return something different for events that are
+    //! already in the timeline. This updates the event counters and
+    //! exact unread and partially read statistics, emitting unreadStatsChanged() and
+    //! partiallyReadStatsChanged() if these change; it takes linear time in the timeline size.
+    //! \sa countEvents, isEventNotable
+    void recountEvents();
+
     //! \brief Get event statistics since the fully read marker
     //!
     //! This call returns a structure containing:
@@ -835,6 +952,11 @@ Q_SIGNALS:
     void aboutToAddHistoricalMessages(Quotient::RoomEventsRange events);
     void aboutToAddNewMessages(Quotient::RoomEventsRange events);
     void addedMessages(int fromIndex, int toIndex);
+    //! Historical events with indices from \p fromIndex to \p toIndex are about to be evicted
+    //! \sa setTimelineWindow
+    void aboutToEvictHistoricalMessages(int fromIndex, int toIndex);
+    //! Historical events with indices from \p fromIndex to \p toIndex have been evicted
+    void evictedHistoricalMessages(int fromIndex, int toIndex);
     /// The event is about to be appended to the list of pending events
     void pendingEventAboutToAdd(Quotient::RoomEvent* event);
     /// An event has been appended to the list of pending events
@@ -896,12 +1018,27 @@ Q_SIGNALS:
     //! from Membership::Join to anything else.
     void memberLeft(RoomMember member);
 
-    //! A known joined member is about to update their display name
+    //! \brief A known joined member is about to update their display name
+    //!
+    //! This is also emitted when the disambiguated name of the member is about to change because
+    //! a namesake joins or leaves. Not emitted for changes coming in a batch of state events,
+    //! see memberNamesUpdated().
     void memberNameAboutToUpdate(RoomMember member, QString newName);
 
-    //! A known joined member has updated their display name
+    //! \brief A known joined member has updated their display name
+    //!
+    //! Not emitted for changes coming in a batch of state events, see memberNamesUpdated().
     void memberNameUpdated(RoomMember member);
 
+    //! \brief Display names of joined members have been updated in a batch
+    //!
+    //! When the room state is updated from a batch of events (the state part of a sync, or
+    //! the full member list of a lazy-loaded room), this signal is emitted once for the whole
+    //! batch, instead of memberNameAboutToUpdate() and memberNameUpdated() for each member whose
+    //! name or disambiguation has changed.
+    //! \param userIds ids of all such members
+    void memberNamesUpdated(QStringList userIds);
+
     //! A known joined member has updated their avatar
     void memberAvatarUpdated(RoomMember member);
 
@@ -915,7 +1052,7 @@ Q_SIGNALS:
     void memberListChanged();
 
     /// The previously lazy-loaded members list is now loaded entirely
-    /// \sa setDisplayed
+    /// \sa setDisplayed, mergeMembers
     void allMembersLoaded();
     void encryption();
 
@@ -938,6 +1075,7 @@ Q_SIGNALS:
     void partiallyReadStatsChanged();
     void unreadStatsChanged();
     void allHistoryLoadedChanged();
+    void timelineGapChanged();
 
     void accountDataAboutToChange(QString type);
     void accountDataChanged(QString type);
@@ -945,6 +1083,10 @@ Q_SIGNALS:
     void tagsChanged();
 
     void updatedEvent(QString eventId);
+    //! \brief A page of the thread list has been loaded
+    //! \param rootIds ids of the thread roots in the page, the most recently active first
+    //! \sa loadThreads
+    void threadsLoaded(QStringList rootIds);
     void replacedEvent(const Quotient::RoomEvent* newEvent,
                        const Quotient::RoomEvent* oldEvent);
 
@@ -992,6 +1134,16 @@ private:
     // arrived from the server. Clients should use
     // Connection::joinRoom() and Room::leaveRoom() to change the state.
     void setJoinState(JoinState state);
+
+    //! \brief Apply a part of a large sync update, leaving the rest in \p data
+    //!
+    //! Connection calls this to spread heavy room updates across several event loop
+    //! iterations; the remainder of \p data has to be passed to updateData() eventually.
+    //! Signals for the applied part are emitted right away, while the display name is only
+    //! recalculated, and the room state saved, by that final updateData() call.
+    //! \return false if \p data has no more than \p maxEvents state and timeline events,
+    //!         in which case nothing is applied
+    bool applySyncChunk(SyncRoomData& data, size_t maxEvents, bool fromCache);
 };
 
 template <template <class> class ContT>
@@ -0,0 +1,476 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "roomdirectorymodel.h"
+
+#include "connection.h"
+#include "logging_categories_p.h"
+
+#include "csapi/list_public_rooms.h"
+
+#include <QtCore/QTimer>
+
+#include <algorithm>
+#include <deque>
+
+using namespace Quotient;
+
+namespace {
+
+struct DirectoryRoom {
+    explicit DirectoryRoom(PublicRoomsChunk&& chunk)
+        : info(std::move(chunk))
+        , nameKey(QString(info.name + u'\n' + info.canonicalAlias).toCaseFolded())
+        , topicKey(info.topic.toCaseFolded())
+    {}
+
+    PublicRoomsChunk info;
+    QString nameKey; //!< The name and the alias, case-folded for matching
+    QString topicKey;
+};
+
+//! Check whether \p term starts a word somewhere in \p text
+bool startsWord(const QString& text, const QString& term)
+{
+    for (auto pos = text.indexOf(term); pos != -1; pos = text.indexOf(term, pos + 1))
+        if (pos == 0 || !text[pos - 1].isLetterOrNumber())
+            return true;
+    return false;
+}
+
+} // namespace
+
+class RoomDirectoryModel::Private {
+public:
+    Private(RoomDirectoryModel* q, Connection* connection) : q(q), connection(connection) {}
+
+    RoomDirectoryModel* q;
+    Connection* connection;
+    QString server;
+    int pageSize = 50;
+    int prefetchDistance = 20;
+    int maxRooms = 10'000;
+    int totalRoomCountEstimate = -1;
+    bool prefetchScheduled = false;
+
+    //! The paginated listing of the directory, without any filter
+    std::deque<DirectoryRoom> listing;
+    QSet<QString> listingIds;
+    QString listingNextBatch;
+    bool listingAtEnd = false;
+    bool listingTrimmed = false;
+    JobHandle<GetPublicRoomsJob> listingJob;
+
+    QString filterText;
+    QStringList filterTerms; //!< Case-folded words of filterText
+    FilterMode filterMode = FilterMode::Prefix;
+    //! Rooms from the listing that match the filter, in the listing order; these go first
+    std::vector<const DirectoryRoom*> localMatches;
+    //! Rooms found by the server and not among localMatches; these go after localMatches
+    std::deque<DirectoryRoom> found;
+    QSet<QString> matchedIds; //!< Ids of rooms in localMatches and found
+    QString searchNextBatch;
+    bool searchStarted = false;
+    bool searchAtEnd = false;
+    QTimer searchTimer;
+    JobHandle<QueryPublicRoomsJob> searchJob;
+
+    bool filtered() const { return !filterTerms.isEmpty(); }
+    bool matches(const DirectoryRoom& room) const;
+    const DirectoryRoom* roomAt(int row) const;
+    void rebuildMatches(bool narrowing);
+
+    void loadListingPage();
+    void addListingPage(GetPublicRoomsJob::Response&& response);
+    void trimListing();
+    void cancelSearch();
+    void loadSearchPage();
+    void addSearchPage(QueryPublicRoomsJob::Response&& response);
+    //! Drop everything, to load the listing anew with the next fetchMore()
+    void reset();
+    void setupJob(BaseJob* job);
+};
+
+bool RoomDirectoryModel::Private::matches(const DirectoryRoom& room) const
+{
+    return std::ranges::all_of(filterTerms, [this, &room](const QString& term) {
+        return filterMode == FilterMode::Prefix
+                   ? startsWord(room.nameKey, term)
+                   : room.nameKey.contains(term) || room.topicKey.contains(term);
+    });
+}
+
+const DirectoryRoom* RoomDirectoryModel::Private::roomAt(int row) const
+{
+    if (row < 0)
+        return nullptr;
+    if (!filtered())
+        return size_t(row) < listing.size() ? &listing[size_t(row)] : nullptr;
+    if (size_t(row) < localMatches.size())
+        return localMatches[size_t(row)];
+    row -= int(localMatches.size());
+    return size_t(row) < found.size() ? &found[size_t(row)] : nullptr;
+}
+
+void RoomDirectoryModel::Private::rebuildMatches(bool narrowing)
+{
+    matchedIds.clear();
+    if (!filtered()) {
+        localMatches.clear();
+        return;
+    }
+    if (narrowing) // Only rooms that matched the previous filter can match the new one
+        std::erase_if(localMatches, [this](const DirectoryRoom* room) { return !matches(*room); });
+    else {
+        localMatches.clear();
+        for (const auto& room : listing)
+            if (matches(room))
+                localMatches.push_back(&room);
+    }
+    for (const auto* room : localMatches)
+        matchedIds.insert(room->info.roomId);
+}
+
+void RoomDirectoryModel::Private::setupJob(BaseJob* job)
+{
+    job->setDirectJsonDecoding(); // Directory pages can be large, see BaseJob
+    QObject::connect(job, &BaseJob::finished, q, &RoomDirectoryModel::loadingChanged);
+    QObject::connect(job, &BaseJob::failure, q, [this, job] {
+        qCWarning(MAIN) << "Failed to load the room directory:" << job->errorString();
+        emit q->loadError(job->errorString());
+    });
+    emit q->loadingChanged();
+}
+
+void RoomDirectoryModel::Private::loadListingPage()
+{
+    if (isJobPending(listingJob) || listingAtEnd)
+        return;
+    listingJob = connection->callApi<GetPublicRoomsJob>(pageSize, listingNextBatch, server);
+    QObject::connect(listingJob, &BaseJob::success, q,
+                     [this, job = listingJob.get()] { addListingPage(collectResponse(job)); });
+    setupJob(listingJob);
+}
+
+void RoomDirectoryModel::Private::addListingPage(GetPublicRoomsJob::Response&& response)
+{
+    listingNextBatch = response.nextBatch;
+    listingAtEnd = response.nextBatch.isEmpty() || response.chunk.isEmpty();
+    totalRoomCountEstimate = response.totalRoomCountEstimate.value_or(-1);
+
+    // The directory may change between requests, making pages overlap
+    response.chunk.removeIf([this](const PublicRoomsChunk& chunk) {
+        return listingIds.contains(chunk.roomId);
+    });
+    if (!filtered() && !response.chunk.isEmpty())
+        q->beginInsertRows({}, int(listing.size()),
+                           int(listing.size() + size_t(response.chunk.size())) - 1);
+    const auto firstNew = listing.size();
+    for (auto& chunk : response.chunk) {
+        listingIds.insert(chunk.roomId);
+        listing.emplace_back(std::move(chunk));
+    }
+    if (!filtered()) {
+        if (!response.chunk.isEmpty())
+            q->endInsertRows();
+    } else {
+        std::vector<const DirectoryRoom*> newMatches;
+        for (auto it = listing.cbegin() + qsizetype(firstNew); it != listing.cend(); ++it)
+            if (!matchedIds.contains(it->info.roomId) && matches(*it))
+                newMatches.push_back(&*it);
+        if (!newMatches.empty()) {
+            const auto firstRow = int(localMatches.size());
+            q->beginInsertRows({}, firstRow, firstRow + int(newMatches.size()) - 1);
+            for (const auto* room : newMatches) {
+                localMatches.push_back(room);
+                matchedIds.insert(room->info.roomId);
+            }
+            q->endInsertRows();
+        }
+    }
+    trimListing();
+}
+
+void RoomDirectoryModel::Private::trimListing()
+{
+    const auto excess = qsizetype(listing.size()) - maxRooms;
+    if (excess <= 0)
+        return;
+
+    QSet<QString> evictedIds;
+    for (auto it = listing.cbegin(); it != listing.cbegin() + excess; ++it)
+        evictedIds.insert(it->info.roomId);
+    auto removedRows = int(excess);
+    if (filtered()) {
+        // Local matches are in the listing order, so the evicted ones are at the top
+        const auto isEvicted = [&evictedIds](const DirectoryRoom* room) {
+            return evictedIds.contains(room->info.roomId);
+        };
+        removedRows = int(std::ranges::find_if_not(localMatches, isEvicted) - localMatches.begin());
+    }
+    if (removedRows > 0)
+        q->beginRemoveRows({}, 0, removedRows - 1);
+    if (filtered()) {
+        for (auto i = 0; i < removedRows; ++i)
+            matchedIds.remove(localMatches[size_t(i)]->info.roomId);
+        localMatches.erase(localMatches.begin(), localMatches.begin() + removedRows);
+    }
+    listingIds -= evictedIds;
+    listing.erase(listing.begin(), listing.begin() + excess);
+    if (removedRows > 0)
+        q->endRemoveRows();
+    listingTrimmed = true;
+    qCDebug(MAIN) << "Dropped" << excess << "earliest loaded room(s) from the directory of"
+                  << (server.isEmpty() ? connection->domain() : server);
+}
+
+void RoomDirectoryModel::Private::cancelSearch()
+{
+    searchTimer.stop();
+    searchJob.abandon();
+    found.clear();
+    searchNextBatch.clear();
+    searchStarted = false;
+    searchAtEnd = false;
+}
+
+void RoomDirectoryModel::Private::loadSearchPage()
+{
+    if (isJobPending(searchJob) || !filtered() || (searchStarted && searchAtEnd))
+        return;
+    searchStarted = true;
+    searchJob = connection->callApi<QueryPublicRoomsJob>(
+        server, pageSize, searchNextBatch, QueryPublicRoomsJob::Filter{ filterText, {} });
+    QObject::connect(searchJob, &BaseJob::success, q,
+                     [this, job = searchJob.get()] { addSearchPage(collectResponse(job)); });
+    setupJob(searchJob);
+}
+
+void RoomDirectoryModel::Private::addSearchPage(QueryPublicRoomsJob::Response&& response)
+{
+    searchNextBatch = response.nextBatch;
+    searchAtEnd = response.nextBatch.isEmpty() || response.chunk.isEmpty();
+    response.chunk.removeIf([this](const PublicRoomsChunk& chunk) {
+        return matchedIds.contains(chunk.roomId);
+    });
+    if (!response.chunk.isEmpty()) {
+        const auto firstRow = int(localMatches.size() + found.size());
+        q->beginInsertRows({}, firstRow, firstRow + int(response.chunk.size()) - 1);
+        for (auto& chunk : response.chunk) {
+            matchedIds.insert(chunk.roomId);
+            found.emplace_back(std::move(chunk));
+        }
+        q->endInsertRows();
+    }
+    if (found.size() >= size_t(maxRooms))
+        searchAtEnd = true;
+}
+
+void RoomDirectoryModel::Private::reset()
+{
+    q->beginResetModel();
+    listingJob.abandon();
+    cancelSearch();
+    listing.clear();
+    listingIds.clear();
+    listingNextBatch.clear();
+    listingAtEnd = false;
+    listingTrimmed = false;
+    totalRoomCountEstimate = -1;
+    rebuildMatches(false);
+    q->endResetModel();
+    if (filtered())
+        searchTimer.start();
+}
+
+RoomDirectoryModel::RoomDirectoryModel(Connection* connection, QObject* parent)
+    : QAbstractListModel(parent), d(makeImpl<Private>(this, connection))
+{
+    d->searchTimer.setSingleShot(true);
+    d->searchTimer.setInterval(std::chrono::milliseconds(500));
+    connect(&d->searchTimer, &QTimer::timeout, this, [this] { d->loadSearchPage(); });
+}
+
+RoomDirectoryModel::~RoomDirectoryModel()
+{
+    d->listingJob.abandon();
+    d->searchJob.abandon();
+}
+
+QString RoomDirectoryModel::server() const { return d->server; }
+
+void RoomDirectoryModel::setServer(const QString& serverName)
+{
+    if (serverName == d->server)
+        return;
+    d->server = serverName;
+    d->reset();
+    emit serverChanged();
+}
+
+QString RoomDirectoryModel::filterText() const { return d->filterText; }
+
+void RoomDirectoryModel::setFilterText(const QString& text)
+{
+    if (text == d->filterText)
+        return;
+    // Appending to the filter text can only narrow down the set of matching rooms
+    const auto narrowing = d->filtered() && text.startsWith(d->filterText);
+    d->filterText = text;
+    d->filterTerms = text.toCaseFolded().split(u' ', Qt::SkipEmptyParts);
+    beginResetModel();
+    d->cancelSearch();
+    d->rebuildMatches(narrowing);
+    endResetModel();
+    // With the whole directory at hand, the server can't find anything new
+    if (d->filtered() && !isComplete())
+        d->searchTimer.start();
+    emit filterTextChanged();
+}
+
+RoomDirectoryModel::FilterMode RoomDirectoryModel::filterMode() const { return d->filterMode; }
+
+void RoomDirectoryModel::setFilterMode(FilterMode mode)
+{
+    if (mode == d->filterMode)
+        return;
+    d->filterMode = mode;
+    if (!d->filtered())
+        return;
+    // Server results don't depend on the mode; only local matches change
+    beginResetModel();
+    auto oldFound = std::exchange(d->found, {});
+    d->rebuildMatches(mode == FilterMode::Prefix); // Prefix matches are also substring matches
+    for (auto& room : oldFound)
+        if (!d->matchedIds.contains(room.info.roomId)) {
+            d->matchedIds.insert(room.info.roomId);
+            d->found.push_back(std::move(room));
+        }
+    endResetModel();
+}
+
+int RoomDirectoryModel::pageSize() const { return d->pageSize; }
+
+void RoomDirectoryModel::setPageSize(int newSize) { d->pageSize = std::max(newSize, 1); }
+
+int RoomDirectoryModel::prefetchDistance() const { return d->prefetchDistance; }
+
+void RoomDirectoryModel::setPrefetchDistance(int rows) { d->prefetchDistance = std::max(rows, 0); }
+
+std::chrono::milliseconds RoomDirectoryModel::searchDelay() const
+{
+    return d->searchTimer.intervalAsDuration();
+}
+
+void RoomDirectoryModel::setSearchDelay(std::chrono::milliseconds delay)
+{
+    d->searchTimer.setInterval(delay);
+}
+
+int RoomDirectoryModel::maxRooms() const { return d->maxRooms; }
+
+void RoomDirectoryModel::setMaxRooms(int newMax)
+{
+    d->maxRooms = std::max(newMax, d->pageSize);
+    d->trimListing();
+}
+
+bool RoomDirectoryModel::isLoading() const
+{
+    return isJobPending(d->listingJob) || isJobPending(d->searchJob);
+}
+
+int RoomDirectoryModel::totalRoomCountEstimate() const { return d->totalRoomCountEstimate; }
+
+bool RoomDirectoryModel::isComplete() const { return d->listingAtEnd && !d->listingTrimmed; }
+
+void RoomDirectoryModel::refresh() { d->reset(); }
+
+QVariant RoomDirectoryModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid())
+        return {};
+    const auto* room = d->roomAt(index.row());
+    if (room == nullptr)
+        return {};
+
+    // Load the next page before the view runs out of rows
+    if (index.row() + d->prefetchDistance >= rowCount() && !d->prefetchScheduled
+        && canFetchMore()) {
+        d->prefetchScheduled = true;
+        QMetaObject::invokeMethod(
+            const_cast<RoomDirectoryModel*>(this),
+            [this] {
+                d->prefetchScheduled = false;
+                const_cast<RoomDirectoryModel*>(this)->fetchMore();
+            },
+            Qt::QueuedConnection);
+    }
+
+    const auto& info = room->info;
+    switch (role) {
+    case NameRole:
+        return !info.name.isEmpty()             ? info.name
+               : !info.canonicalAlias.isEmpty() ? info.canonicalAlias
+                                                : info.roomId;
+    case AvatarUrlRole:
+        return info.avatarUrl;
+    case RoomIdRole:
+        return info.roomId;
+    case CanonicalAliasRole:
+        return info.canonicalAlias;
+    case TopicRole:
+        return info.topic;
+    case JoinedMembersCountRole:
+        return info.numJoinedMembers;
+    case WorldReadableRole:
+        return info.worldReadable;
+    case GuestCanJoinRole:
+        return info.guestCanJoin;
+    case JoinRuleRole:
+        return info.joinRule.isEmpty() ? u"public"_s : info.joinRule;
+    case RoomTypeRole:
+        return info.roomType;
+    default:
+        return {};
+    }
+}
+
+int RoomDirectoryModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return int(d->filtered() ? d->localMatches.size() + d->found.size() : d->listing.size());
+}
+
+QHash<int, QByteArray> RoomDirectoryModel::roleNames() const
+{
+    return { { NameRole, QByteArrayLiteral("name") },
+             { AvatarUrlRole, QByteArrayLiteral("avatarUrl") },
+             { RoomIdRole, QByteArrayLiteral("roomId") },
+             { CanonicalAliasRole, QByteArrayLiteral("canonicalAlias") },
+             { TopicRole, QByteArrayLiteral("topic") },
+             { JoinedMembersCountRole, QByteArrayLiteral("joinedMembersCount") },
+             { WorldReadableRole, QByteArrayLiteral("worldReadable") },
+             { GuestCanJoinRole, QByteArrayLiteral("guestCanJoin") },
+             { JoinRuleRole, QByteArrayLiteral("joinRule") },
+             { RoomTypeRole, QByteArrayLiteral("roomType") } };
+}
+
+bool RoomDirectoryModel::canFetchMore(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+        return false;
+    // While the user is typing, only the search timer starts a search
+    return d->filtered() ? d->searchStarted && !d->searchAtEnd : !d->listingAtEnd;
+}
+
+void RoomDirectoryModel::fetchMore(const QModelIndex& parent)
+{
+    if (!canFetchMore(parent))
+        return;
+    if (d->filtered())
+        d->loadSearchPage();
+    else
+        d->loadListingPage();
+}
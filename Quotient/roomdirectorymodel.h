@@ -0,0 +1,122 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "quotient_export.h"
+#include "util.h"
+
+#include <QtCore/QAbstractListModel>
+
+#include <chrono>
+
+namespace Quotient {
+
+class Connection;
+
+//! \brief A model of the public room directory of a server
+//!
+//! The model pages through the directory (see the `/publicRooms` endpoints) as the view scrolls.
+//! As with other incrementally loaded models, the first page is requested by the view calling
+//! fetchMore(); further pages are requested a bit before the view reaches the end of the loaded
+//! rooms (see prefetchDistance()). Rooms loaded so far are indexed so that setting filterText()
+//! narrows the model down to matching rooms instantly; unless the whole directory is already
+//! loaded, the filter is also sent to the server once the user stops typing for searchDelay(),
+//! and rooms found by the server are appended after the local matches. Requests that have
+//! become irrelevant (e.g., searches for previous filter texts) are cancelled.
+//!
+//! To keep memory bounded for directories with hundreds of thousands of rooms, the model keeps
+//! at most maxRooms() rooms from the paginated listing, dropping the earliest loaded ones when
+//! scrolling further; search results are capped at the same number.
+class QUOTIENT_API RoomDirectoryModel : public QAbstractListModel {
+    Q_OBJECT
+    Q_PROPERTY(QString server READ server WRITE setServer NOTIFY serverChanged)
+    Q_PROPERTY(QString filterText READ filterText WRITE setFilterText NOTIFY filterTextChanged)
+    Q_PROPERTY(FilterMode filterMode READ filterMode WRITE setFilterMode)
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged)
+    Q_PROPERTY(int totalRoomCountEstimate READ totalRoomCountEstimate NOTIFY loadingChanged)
+public:
+    enum Roles {
+        NameRole = Qt::DisplayRole,
+        AvatarUrlRole = Qt::DecorationRole,
+        RoomIdRole = Qt::UserRole + 1,
+        CanonicalAliasRole,
+        TopicRole,
+        JoinedMembersCountRole,
+        WorldReadableRole,
+        GuestCanJoinRole,
+        JoinRuleRole,
+        RoomTypeRole,
+    };
+    Q_ENUM(Roles)
+
+    enum class FilterMode : uint8_t {
+        //! Each word of the filter text should start a word in the room name or alias
+        Prefix,
+        //! Each word of the filter text should occur in the room name, alias or topic
+        Substring
+    };
+    Q_ENUM(FilterMode)
+
+    //! Browse the directory of the homeserver of \p connection
+    explicit RoomDirectoryModel(Connection* connection, QObject* parent = nullptr);
+    ~RoomDirectoryModel() override;
+
+    //! The server whose directory is browsed; empty for the homeserver of the connection
+    QString server() const;
+    //! Browse the directory of another server, dropping the loaded rooms
+    void setServer(const QString& serverName);
+
+    QString filterText() const;
+    //! \brief Filter the rooms by \p text
+    //!
+    //! The model is updated immediately from the rooms loaded so far; the server is queried
+    //! after searchDelay() unless the text changes again in the meantime.
+    void setFilterText(const QString& text);
+    FilterMode filterMode() const;
+    void setFilterMode(FilterMode mode);
+
+    //! The number of rooms requested from the server at once
+    int pageSize() const;
+    void setPageSize(int newSize);
+    //! \brief How close to the end of the loaded rooms (in rows) the next page is requested
+    //!
+    //! Views request rows with data() as they scroll; once a requested row is within this
+    //! distance from the last row, the next page is loaded without waiting for fetchMore().
+    int prefetchDistance() const;
+    void setPrefetchDistance(int rows);
+    //! How long to wait after the last change of filterText() before querying the server
+    std::chrono::milliseconds searchDelay() const;
+    void setSearchDelay(std::chrono::milliseconds delay);
+    //! The maximum number of rooms kept from the listing and from the server search each
+    int maxRooms() const;
+    void setMaxRooms(int newMax);
+
+    //! Whether a directory request is pending
+    bool isLoading() const;
+    //! The estimated number of public rooms on the server; -1 if the server doesn't tell
+    int totalRoomCountEstimate() const;
+    //! Whether the whole directory has been loaded, with no rooms dropped
+    bool isComplete() const;
+
+    //! Drop all loaded rooms to load the directory again
+    Q_INVOKABLE void refresh();
+
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    int rowCount(const QModelIndex& parent = {}) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    bool canFetchMore(const QModelIndex& parent = {}) const override;
+    void fetchMore(const QModelIndex& parent = {}) override;
+
+Q_SIGNALS:
+    void serverChanged();
+    void filterTextChanged();
+    void loadingChanged();
+    void loadError(QString message);
+
+private:
+    class Private;
+    ImplPtr<Private> d;
+};
+
+} // namespace Quotient
@@ -0,0 +1,291 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "roomthread.h"
+
+#include "connection.h"
+#include "logging_categories_p.h"
+#include "room.h"
+
+#include "csapi/relations.h"
+#include "csapi/rooms.h"
+
+#include "events/encryptedevent.h"
+#include "events/eventrelation.h"
+
+#include <QtCore/QSet>
+
+#include <algorithm>
+#include <unordered_map>
+
+using namespace Quotient;
+
+class RoomThread::Private {
+public:
+    Private(RoomThread* parent, Room* r, const QString& root) : q(parent), room(r), rootId(root) {}
+
+    struct Entry {
+        QString eventId;
+        qint64 originTimestamp;
+    };
+
+    RoomThread* q;
+    Room* room;
+    QString rootId;
+    //! Events of the thread, ordered by their origin timestamps
+    std::vector<Entry> entries;
+    QSet<QString> eventIds;
+    //! The root event, if the thread has to keep it on its own
+    RoomEventPtr ownRoot;
+    //! Events of the thread that are not in the main timeline
+    std::unordered_map<QString, RoomEventPtr> ownEvents;
+    //! Map from megolm sessionId to ids of own events that await the key
+    std::unordered_map<QString, QSet<QString>> undecryptedEvents;
+    //! \brief The token to load events preceding the loaded ones
+    //!
+    //! A null string means loading from the most recent thread event, as no events have been
+    //! loaded from the server yet; std::nullopt means the server has no more events.
+    std::optional<QString> nextBatch = QString();
+    JobHandle<GetRelatingEventsWithRelTypeJob> historyJob;
+    JobHandle<GetOneRoomEventJob> rootJob;
+
+    //! Find the event in the main timeline, or among own events
+    const RoomEvent* find(const QString& eventId) const
+    {
+        if (const auto it = room->findInTimeline(eventId); it != room->historyEdge())
+            return it->event();
+        const auto it = ownEvents.find(eventId);
+        return it != ownEvents.end() ? it->second.get() : nullptr;
+    }
+
+    //! Insert events that are not in the thread yet, in any order
+    void insertEvents(std::vector<const RoomEvent*> events);
+    void decrypt(RoomEventPtr& eptr);
+    void fetchRoot();
+};
+
+void RoomThread::Private::insertEvents(std::vector<const RoomEvent*> events)
+{
+    std::ranges::stable_sort(events, {}, &RoomEvent::originTimestampMs);
+    for (auto it = events.begin(); it != events.end();) {
+        const auto pos =
+            std::ranges::upper_bound(entries, (*it)->originTimestampMs(), {}, &Entry::originTimestamp);
+        // Insert all events that go to the same position at once - usually the whole batch
+        // goes either before or after all loaded events
+        const auto runEnd = pos == entries.end()
+                                ? events.end()
+                                : std::find_if(it, events.end(), [ts = pos->originTimestamp](
+                                                                     const RoomEvent* e) {
+                                      return e->originTimestampMs() >= ts;
+                                  });
+        const auto fromIndex = int(pos - entries.begin());
+        const auto toIndex = fromIndex + int(runEnd - it) - 1;
+        std::vector<Entry> run;
+        run.reserve(size_t(runEnd - it));
+        for (; it != runEnd; ++it)
+            run.push_back({ (*it)->id(), (*it)->originTimestampMs() });
+        emit q->aboutToAddEvents(fromIndex, toIndex);
+        entries.insert(entries.begin() + fromIndex, run.cbegin(), run.cend());
+        emit q->addedEvents(fromIndex, toIndex);
+    }
+}
+
+void RoomThread::Private::decrypt(RoomEventPtr& eptr)
+{
+    if (!room->connection()->encryptionEnabled() || !room->usesEncryption() || eptr->isRedacted())
+        return;
+    if (const auto* encrypted = eventCast<EncryptedEvent>(eptr)) {
+        if (auto decrypted = room->decryptMessage(*encrypted)) {
+            auto&& oldEvent = eventCast<EncryptedEvent>(std::exchange(eptr, std::move(decrypted)));
+            eptr->setOriginalEvent(std::move(oldEvent));
+        } else
+            undecryptedEvents[encrypted->sessionId()] += encrypted->id();
+    }
+}
+
+void RoomThread::Private::fetchRoot()
+{
+    if (isJobPending(rootJob))
+        return;
+    rootJob = room->connection()->callApi<GetOneRoomEventJob>(room->id(), rootId);
+    QObject::connect(rootJob, &BaseJob::success, q, [this] { q->setRoot(rootJob->event()); });
+}
+
+RoomThread::RoomThread(Room* room, const QString& rootId)
+    : QObject(room), d(makeImpl<Private>(this, room, rootId))
+{
+    Q_ASSERT(!rootId.isEmpty());
+    setObjectName(rootId);
+    // Redactions, edits and decryption of events in the main timeline replace event objects
+    // there; the thread only has to let its clients know
+    connect(room, &Room::replacedEvent, this,
+            [this](const RoomEvent* newEvent, const RoomEvent* oldEvent) {
+                if (newEvent->id() == d->rootId)
+                    emit rootChanged();
+                else if (d->eventIds.contains(newEvent->id()))
+                    emit replacedEvent(newEvent, oldEvent);
+            });
+}
+
+RoomThread::~RoomThread() = default;
+
+Room* RoomThread::room() const { return d->room; }
+
+QString RoomThread::rootId() const { return d->rootId; }
+
+const RoomEvent* RoomThread::root() const
+{
+    if (const auto it = d->room->findInTimeline(d->rootId); it != d->room->historyEdge())
+        return it->event();
+    return d->ownRoot.get();
+}
+
+int RoomThread::size() const { return int(d->entries.size()); }
+
+QString RoomThread::eventId(int index) const
+{
+    return index >= 0 && index < size() ? d->entries[size_t(index)].eventId : QString();
+}
+
+const RoomEvent* RoomThread::event(int index) const
+{
+    return index >= 0 && index < size() ? d->find(d->entries[size_t(index)].eventId) : nullptr;
+}
+
+int RoomThread::indexOf(const QString& eventId) const
+{
+    if (!d->eventIds.contains(eventId))
+        return -1;
+    const auto* evt = d->find(eventId);
+    if (evt == nullptr)
+        return -1;
+    const auto [from, to] =
+        std::ranges::equal_range(d->entries, evt->originTimestampMs(), {}, &Private::Entry::originTimestamp);
+    const auto it = std::ranges::find(from, to, eventId, &Private::Entry::eventId);
+    return it != to ? int(it - d->entries.cbegin()) : -1;
+}
+
+bool RoomThread::historyLoading() const { return isJobPending(d->historyJob); }
+
+bool RoomThread::allHistoryLoaded() const { return !d->nextBatch; }
+
+void RoomThread::loadHistory(int limit)
+{
+    if (!d->nextBatch || isJobPending(d->historyJob))
+        return;
+
+    d->historyJob = d->room->connection()->callApi<GetRelatingEventsWithRelTypeJob>(
+        d->room->id(), d->rootId, EventRelation::ThreadType, *d->nextBatch, QString(), limit,
+        "b"_L1);
+    emit historyLoadingChanged();
+    connect(d->historyJob, &BaseJob::success, this, [this] {
+        if (const auto newNextBatch = d->historyJob->nextBatch(); !newNextBatch.isEmpty())
+            *d->nextBatch = newNextBatch;
+        else {
+            qCDebug(MESSAGES) << "Thread" << d->rootId << "has loaded all history";
+            d->nextBatch.reset();
+        }
+
+        std::vector<const RoomEvent*> newEvents;
+        for (auto&& eptr : d->historyJob->chunk()) {
+            const auto eventId = eptr->id();
+            if (d->eventIds.contains(eventId))
+                continue;
+            d->eventIds.insert(eventId);
+            if (const auto it = d->room->findInTimeline(eventId); it != d->room->historyEdge()) {
+                newEvents.push_back(it->event()); // Share the instance with the main timeline
+                continue;
+            }
+            d->decrypt(eptr);
+            newEvents.push_back(eptr.get());
+            d->ownEvents.emplace(eventId, std::move(eptr));
+        }
+        d->insertEvents(std::move(newEvents));
+        if (!d->nextBatch)
+            emit allHistoryLoadedChanged();
+    });
+    connect(d->historyJob, &QObject::destroyed, this, &RoomThread::historyLoadingChanged);
+    if (root() == nullptr)
+        d->fetchRoot();
+}
+
+void RoomThread::addTimelineEvents(std::vector<const RoomEvent*> events)
+{
+    std::vector<const RoomEvent*> newEvents;
+    newEvents.reserve(events.size());
+    for (const auto* evt : events) {
+        if (evt->id() == d->rootId) {
+            if (d->ownRoot) {
+                d->ownRoot.reset(); // The main timeline has it now
+                emit rootChanged();
+            }
+            continue;
+        }
+        if (d->eventIds.contains(evt->id())) {
+            // Switch from the own copy of the event to the one in the main timeline
+            if (auto node = d->ownEvents.extract(evt->id()); !node.empty())
+                emit replacedEvent(evt, node.mapped().get());
+            continue;
+        }
+        d->eventIds.insert(evt->id());
+        newEvents.push_back(evt);
+    }
+    d->insertEvents(std::move(newEvents));
+}
+
+void RoomThread::keepEvent(RoomEventPtr&& event)
+{
+    if (event->id() == d->rootId)
+        d->ownRoot = std::move(event);
+    else if (d->eventIds.contains(event->id())) {
+        const auto eventId = event->id();
+        d->ownEvents.insert_or_assign(eventId, std::move(event));
+    }
+}
+
+void RoomThread::setRoot(RoomEventPtr&& root)
+{
+    if (!root || this->root() != nullptr)
+        return;
+    d->decrypt(root);
+    d->ownRoot = std::move(root);
+    emit rootChanged();
+}
+
+const RoomEvent* RoomThread::ownEvent(const QString& eventId) const
+{
+    if (eventId == d->rootId)
+        return d->ownRoot.get();
+    const auto it = d->ownEvents.find(eventId);
+    return it != d->ownEvents.end() ? it->second.get() : nullptr;
+}
+
+void RoomThread::replaceOwnEvent(RoomEventPtr&& newEvent)
+{
+    if (newEvent->id() == d->rootId) {
+        d->ownRoot = std::move(newEvent);
+        emit rootChanged();
+        return;
+    }
+    const auto it = d->ownEvents.find(newEvent->id());
+    if (it == d->ownEvents.end())
+        return;
+    const auto oldEvent = std::exchange(it->second, std::move(newEvent));
+    emit replacedEvent(it->second.get(), oldEvent.get());
+}
+
+void RoomThread::onRoomKey(const QString& sessionId)
+{
+    const auto node = d->undecryptedEvents.extract(sessionId);
+    if (node.empty())
+        return;
+    for (const auto& eventId : node.mapped()) {
+        const auto* own = ownEvent(eventId);
+        if (own == nullptr || !own->is<EncryptedEvent>())
+            continue;
+        auto eptr = loadEvent<RoomEvent>(own->fullJson());
+        d->decrypt(eptr);
+        if (!eptr->is<EncryptedEvent>())
+            replaceOwnEvent(std::move(eptr));
+    }
+}
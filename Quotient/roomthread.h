@@ -0,0 +1,94 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "util.h"
+
+#include "events/roomevent.h"
+
+#include <QtCore/QObject>
+
+namespace Quotient {
+
+class Room;
+class RedactionEvent;
+class RoomMessageEvent;
+
+//! \brief A timeline of a single thread in a room
+//!
+//! RoomThread keeps events that belong to the thread started by a given root event (i.e. events
+//! with `"rel_type": "m.thread"` pointing to it) in chronological order. Older events are loaded
+//! through the relations endpoint, page by page, without touching the main timeline of the room;
+//! new events are picked up from sync as they arrive to the room. Events that are in the main
+//! timeline are shared with it rather than copied - the thread only owns events loaded or kept
+//! on its own, such as those evicted from the main timeline.
+//!
+//! Thread objects are created and owned by Room, see Room::thread().
+class QUOTIENT_API RoomThread : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(QString rootId READ rootId CONSTANT)
+    Q_PROPERTY(bool historyLoading READ historyLoading NOTIFY historyLoadingChanged)
+    Q_PROPERTY(bool allHistoryLoaded READ allHistoryLoaded NOTIFY allHistoryLoadedChanged)
+public:
+    ~RoomThread() override;
+
+    Room* room() const;
+    QString rootId() const;
+    //! \brief The root event of the thread
+    //! \return the event, or nullptr if it's neither in the main timeline nor fetched yet
+    const RoomEvent* root() const;
+
+    //! The number of events in the thread loaded so far, not counting the root
+    int size() const;
+    //! \brief The id of the event at \p index, in chronological order
+    QString eventId(int index) const;
+    //! \brief The event at \p index, in chronological order
+    //! \return the event, or nullptr if \p index is out of bounds
+    const RoomEvent* event(int index) const;
+    //! \brief Find the position of \p eventId in the thread
+    //! \return the index, or -1 if the event is not in the thread
+    int indexOf(const QString& eventId) const;
+
+    bool historyLoading() const;
+    bool allHistoryLoaded() const;
+
+public Q_SLOTS:
+    //! \brief Load up to \p limit older events of the thread from the server
+    //!
+    //! Does nothing if there's a pending request already or all history is loaded.
+    void loadHistory(int limit = 30);
+
+Q_SIGNALS:
+    void rootChanged();
+    void aboutToAddEvents(int fromIndex, int toIndex);
+    void addedEvents(int fromIndex, int toIndex);
+    //! \brief An event in the thread has been replaced with another instance
+    //!
+    //! Same as Room::replacedEvent(), emitted for events of this thread, including those not in
+    //! the main timeline; \p oldEvent is still valid while this signal is being handled.
+    void replacedEvent(const Quotient::RoomEvent* newEvent, const Quotient::RoomEvent* oldEvent);
+    void historyLoadingChanged();
+    void allHistoryLoadedChanged();
+
+private:
+    friend class Room;
+    RoomThread(Room* room, const QString& rootId);
+
+    //! Take \p events from the main timeline into the thread, see Room::Private::updateThreads()
+    void addTimelineEvents(std::vector<const RoomEvent*> events);
+    //! Take ownership of \p event that is about to leave the main timeline
+    void keepEvent(RoomEventPtr&& event);
+    //! Set the root event if it's not available from the main timeline
+    void setRoot(RoomEventPtr&& root);
+    //! Get an event owned by the thread, to redact or replace it with replaceOwnEvent()
+    const RoomEvent* ownEvent(const QString& eventId) const;
+    void replaceOwnEvent(RoomEventPtr&& newEvent);
+    //! Try to decrypt the thread's own events encrypted with \p sessionId
+    void onRoomKey(const QString& sessionId);
+
+    class Private;
+    ImplPtr<Private> d;
+};
+
+} // namespace Quotient
@@ -0,0 +1,571 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "searchindex.h"
+
+#include "logging_categories_p.h"
+
+#include "events/roommessageevent.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QPromise>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlError>
+#include <QtSql/QSqlQuery>
+
+#include <array>
+#include <utility>
+
+using namespace Quotient;
+
+namespace {
+
+//! How long to accumulate updates before applying them in one transaction
+constexpr auto UpdateBatchInterval = std::chrono::milliseconds(500);
+//! Apply updates earlier if this many have been buffered
+constexpr auto MaxBufferedUpdates = 1000;
+//! Longer words are cut to this length, both when indexing and when searching
+constexpr auto MaxTermLength = 32;
+//! The maximum number of indexed words the last (incomplete) word of a query can stand for
+constexpr auto MaxPrefixExpansions = 32;
+
+struct IndexUpdate {
+    enum Kind : uint8_t { Add, Replace, Remove, ClearRoom };
+    Kind kind;
+    QString roomId;
+    QString eventId;
+    QString senderId;
+    qint64 timestamp = 0;
+    QString text;
+    //! For Replace, the timestamp of the edit the text comes from
+    qint64 editTimestamp = 0;
+};
+
+bool exec(QSqlQuery& query)
+{
+    if (query.exec())
+        return true;
+    qCritical(DATABASE) << "Failed to execute query";
+    qCritical(DATABASE) << query.lastQuery();
+    qCritical(DATABASE) << query.lastError();
+    return false;
+}
+
+QSqlQuery prepare(const QSqlDatabase& db, const QString& queryString)
+{
+    QSqlQuery query(db);
+    query.prepare(queryString);
+    return query;
+}
+
+void migrate(QSqlDatabase& db)
+{
+    QSqlQuery versionQuery(u"PRAGMA user_version;"_s, db);
+    const auto version = versionQuery.next() ? versionQuery.value(0).toInt() : 0;
+    if (version >= 2)
+        return;
+
+    db.transaction();
+    const auto execAll = [&db](const auto& queries) {
+        for (const auto& q : queries) {
+            QSqlQuery query(db);
+            query.prepare(q);
+            exec(query);
+        }
+    };
+    if (version < 1) {
+        qCDebug(DATABASE) << "Creating the search index schema";
+        // The words of each message are kept along with it in `events`, so that postings can
+        // be removed along with the message
+        execAll(std::array{
+            u"CREATE TABLE events (id INTEGER PRIMARY KEY, roomId TEXT NOT NULL, "
+            "eventId TEXT NOT NULL UNIQUE, senderId TEXT, ts INTEGER NOT NULL, "
+            "terms TEXT NOT NULL);"_s,
+            u"CREATE INDEX events_room_idx ON events(roomId);"_s,
+            u"CREATE TABLE postings (term TEXT NOT NULL, ts INTEGER NOT NULL, "
+            "eventRowId INTEGER NOT NULL, PRIMARY KEY (term, ts, eventRowId)) WITHOUT ROWID;"_s,
+            u"CREATE TABLE terms (term TEXT PRIMARY KEY, frequency INTEGER NOT NULL) "
+            "WITHOUT ROWID;"_s });
+    }
+    // The timestamp of the edit the indexed text comes from; 0 if the message is not edited
+    execAll(std::array{ u"ALTER TABLE events ADD COLUMN editTs INTEGER NOT NULL DEFAULT 0;"_s,
+                        u"PRAGMA user_version = 2;"_s });
+    db.commit();
+}
+
+bool isWordChar(char32_t c) { return QChar::isLetterOrNumber(c); }
+
+//! Call \p fn for each word in \p text, with the word's position and length
+void forEachWord(QStringView text, auto fn)
+{
+    qsizetype wordStart = -1;
+    for (qsizetype i = 0; i < text.size();) {
+        char32_t c = text[i].unicode();
+        qsizetype length = 1;
+        if (QChar::isHighSurrogate(c) && i + 1 < text.size() && text[i + 1].isLowSurrogate()) {
+            c = QChar::surrogateToUcs4(text[i], text[i + 1]);
+            length = 2;
+        }
+        if (!isWordChar(c)) {
+            if (wordStart >= 0)
+                fn(text.sliced(wordStart, i - wordStart));
+            wordStart = -1;
+        } else if (wordStart < 0)
+            wordStart = i;
+        i += length;
+    }
+    if (wordStart >= 0)
+        fn(text.sliced(wordStart));
+}
+
+bool endsWithWord(QStringView text)
+{
+    if (text.isEmpty())
+        return false;
+    if (text.size() > 1 && text.back().isLowSurrogate() && text[text.size() - 2].isHighSurrogate())
+        return isWordChar(QChar::surrogateToUcs4(text[text.size() - 2], text.back()));
+    return isWordChar(text.back().unicode());
+}
+
+struct Cursor {
+    qint64 timestamp;
+    qint64 rowId;
+};
+
+std::optional<Cursor> parseBatchToken(const QString& token)
+{
+    const auto parts = QStringView(token).split(u':');
+    if (parts.size() != 2)
+        return {};
+    bool tsOk = false;
+    bool rowIdOk = false;
+    Cursor c{ parts[0].toLongLong(&tsOk), parts[1].toLongLong(&rowIdOk) };
+    return tsOk && rowIdOk ? std::optional(c) : std::nullopt;
+}
+
+QString placeholders(qsizetype count)
+{
+    QString result = u"?"_s;
+    for (qsizetype i = 1; i < count; ++i)
+        result += u",?"_s;
+    return result;
+}
+
+void addToIndex(const QSqlDatabase& db, const IndexUpdate& update)
+{
+    const auto terms = SearchIndex::tokenize(update.text);
+    if (terms.isEmpty())
+        return;
+    auto eventQuery = prepare(db, u"INSERT OR IGNORE INTO events (roomId, eventId, senderId, "
+                                  "ts, terms, editTs) VALUES (?, ?, ?, ?, ?, ?);"_s);
+    eventQuery.addBindValue(update.roomId);
+    eventQuery.addBindValue(update.eventId);
+    eventQuery.addBindValue(update.senderId);
+    eventQuery.addBindValue(update.timestamp);
+    eventQuery.addBindValue(terms.join(u' '));
+    eventQuery.addBindValue(update.editTimestamp);
+    if (!exec(eventQuery) || eventQuery.numRowsAffected() == 0)
+        return; // Already indexed
+    const auto rowId = eventQuery.lastInsertId().toLongLong();
+
+    auto postingQuery =
+        prepare(db, u"INSERT OR IGNORE INTO postings (term, ts, eventRowId) VALUES (?, ?, ?);"_s);
+    auto termQuery = prepare(db, u"INSERT INTO terms (term, frequency) VALUES (?, 1) "
+                                 "ON CONFLICT(term) DO UPDATE SET frequency = frequency + 1;"_s);
+    for (const auto& term : terms) {
+        postingQuery.addBindValue(term);
+        postingQuery.addBindValue(update.timestamp);
+        postingQuery.addBindValue(rowId);
+        exec(postingQuery);
+        termQuery.addBindValue(term);
+        exec(termQuery);
+    }
+}
+
+//! Remove the events selected by \p whereClause (with \p key bound to it), with their postings
+void removeFromIndex(const QSqlDatabase& db, const QString& whereClause, const QString& key)
+{
+    auto eventsQuery =
+        prepare(db, "SELECT id, ts, terms FROM events WHERE %1;"_L1.arg(whereClause));
+    eventsQuery.addBindValue(key);
+    if (!exec(eventsQuery))
+        return;
+    auto postingQuery =
+        prepare(db, u"DELETE FROM postings WHERE term = ? AND ts = ? AND eventRowId = ?;"_s);
+    auto termQuery =
+        prepare(db, u"UPDATE terms SET frequency = frequency - 1 WHERE term = ?;"_s);
+    while (eventsQuery.next()) {
+        const auto rowId = eventsQuery.value(0).toLongLong();
+        const auto timestamp = eventsQuery.value(1).toLongLong();
+        for (const auto& term : eventsQuery.value(2).toString().split(u' ')) {
+            postingQuery.addBindValue(term);
+            postingQuery.addBindValue(timestamp);
+            postingQuery.addBindValue(rowId);
+            exec(postingQuery);
+            termQuery.addBindValue(term);
+            exec(termQuery);
+        }
+    }
+    auto deleteQuery = prepare(db, "DELETE FROM events WHERE %1;"_L1.arg(whereClause));
+    deleteQuery.addBindValue(key);
+    exec(deleteQuery);
+}
+
+//! \brief Replace the indexed text of a message with that of its edit
+//!
+//! The message keeps its place in the index; if it's not indexed yet, it gets the timestamp of
+//! the edit, and the original text is ignored when it comes later. Edits older than the one
+//! already indexed are ignored.
+void replaceInIndex(const QSqlDatabase& db, IndexUpdate update)
+{
+    auto existingQuery = prepare(db, u"SELECT ts, editTs FROM events WHERE eventId = ?;"_s);
+    existingQuery.addBindValue(update.eventId);
+    if (!exec(existingQuery))
+        return;
+    if (existingQuery.next()) {
+        if (existingQuery.value(1).toLongLong() > update.editTimestamp)
+            return;
+        update.timestamp = existingQuery.value(0).toLongLong();
+        existingQuery.finish();
+        removeFromIndex(db, u"eventId = ?"_s, update.eventId);
+    }
+    addToIndex(db, update);
+}
+
+struct FoundPosting {
+    SearchIndex::Hit hit;
+    qint64 rowId;
+};
+
+//! \brief Look up the most recent messages containing \p drivingTerm and satisfying the rest
+//!
+//! Postings of \p drivingTerm are scanned in the order of the primary key, i.e. from the most
+//! recent; each of \p requiredTerms must occur in the message, as well as at least one of
+//! \p anyOfTerms, unless it's empty.
+std::vector<FoundPosting> findPostings(const QSqlDatabase& db, const QString& drivingTerm,
+                                       const QStringList& requiredTerms,
+                                       const QStringList& anyOfTerms, const QStringList& roomIds,
+                                       std::optional<Cursor> after, int limit)
+{
+    QString queryString =
+        u"SELECT e.roomId, e.eventId, e.senderId, p.ts, p.eventRowId FROM postings p "
+        "JOIN events e ON e.id = p.eventRowId WHERE p.term = ?"_s;
+    if (after)
+        queryString += u" AND (p.ts, p.eventRowId) < (?, ?)"_s;
+    if (!roomIds.isEmpty())
+        queryString += " AND e.roomId IN (%1)"_L1.arg(placeholders(roomIds.size()));
+    static const auto existsClause =
+        u" AND EXISTS (SELECT 1 FROM postings q WHERE q.term %1 "
+        "AND q.ts = p.ts AND q.eventRowId = p.eventRowId)"_s;
+    for (qsizetype i = 0; i < requiredTerms.size(); ++i)
+        queryString += existsClause.arg("= ?"_L1);
+    if (!anyOfTerms.isEmpty())
+        queryString += existsClause.arg("IN (%1)"_L1.arg(placeholders(anyOfTerms.size())));
+    queryString += u" ORDER BY p.ts DESC, p.eventRowId DESC LIMIT ?;"_s;
+
+    auto query = prepare(db, queryString);
+    query.setForwardOnly(true);
+    query.addBindValue(drivingTerm);
+    if (after) {
+        query.addBindValue(after->timestamp);
+        query.addBindValue(after->rowId);
+    }
+    for (const auto& values : { roomIds, requiredTerms, anyOfTerms })
+        for (const auto& v : values)
+            query.addBindValue(v);
+    query.addBindValue(limit);
+
+    std::vector<FoundPosting> result;
+    if (exec(query))
+        while (query.next())
+            result.push_back(
+                { { query.value(0).toString(), query.value(1).toString(),
+                    query.value(2).toString(),
+                    QDateTime::fromMSecsSinceEpoch(query.value(3).toLongLong(), Qt::UTC) },
+                  query.value(4).toLongLong() });
+    return result;
+}
+
+SearchIndex::Results runSearch(const QSqlDatabase& db, const QString& queryText,
+                               const QStringList& roomIds, int limit, const QString& nextBatch)
+{
+    auto words = SearchIndex::tokenize(queryText);
+    if (words.isEmpty() || limit <= 0)
+        return {};
+
+    // Complete words that don't occur anywhere mean no results; among the rest, the rarest one
+    // is the cheapest to scan
+    QString rarestWord;
+    qint64 rarestFrequency = std::numeric_limits<qint64>::max();
+    QStringList prefixExpansions;
+    const auto prefix = endsWithWord(queryText) ? words.takeLast() : QString();
+    auto frequencyQuery = prepare(db, u"SELECT frequency FROM terms WHERE term = ?;"_s);
+    for (const auto& w : std::as_const(words)) {
+        frequencyQuery.addBindValue(w);
+        if (!exec(frequencyQuery) || !frequencyQuery.next())
+            return {};
+        const auto frequency = frequencyQuery.value(0).toLongLong();
+        if (frequency <= 0)
+            return {};
+        if (frequency < rarestFrequency) {
+            rarestFrequency = frequency;
+            rarestWord = w;
+        }
+        frequencyQuery.finish();
+    }
+    if (!prefix.isEmpty()) {
+        // U+10FFFF sorts after any continuation of the prefix in UTF-8 (and therefore SQLite)
+        auto expansionQuery = prepare(db, u"SELECT term FROM terms WHERE term >= ? AND term < ? "
+                                          "AND frequency > 0 ORDER BY frequency DESC LIMIT ?;"_s);
+        expansionQuery.addBindValue(prefix);
+        expansionQuery.addBindValue(QString(prefix + u"\U0010FFFF"_s));
+        expansionQuery.addBindValue(MaxPrefixExpansions);
+        if (exec(expansionQuery))
+            while (expansionQuery.next())
+                prefixExpansions.push_back(expansionQuery.value(0).toString());
+        if (prefixExpansions.isEmpty())
+            return {};
+    }
+
+    const auto after = nextBatch.isEmpty() ? std::nullopt : parseBatchToken(nextBatch);
+    // Fetch one more hit than requested, to know whether there's a next page
+    std::vector<FoundPosting> found;
+    if (!rarestWord.isEmpty()) {
+        words.removeOne(rarestWord);
+        found = findPostings(db, rarestWord, words, prefixExpansions, roomIds, after, limit + 1);
+    } else {
+        // A single incomplete word: merge the most recent postings of each of its expansions
+        for (const auto& term : std::as_const(prefixExpansions)) {
+            auto termPostings = findPostings(db, term, {}, {}, roomIds, after, limit + 1);
+            found.insert(found.end(), std::make_move_iterator(termPostings.begin()),
+                         std::make_move_iterator(termPostings.end()));
+        }
+        std::ranges::sort(found, [](const FoundPosting& lhs, const FoundPosting& rhs) {
+            return std::pair(lhs.hit.timestamp, lhs.rowId)
+                   > std::pair(rhs.hit.timestamp, rhs.rowId);
+        });
+        // The same message may contain several expansions
+        const auto [first, last] = std::ranges::unique(found, {}, &FoundPosting::rowId);
+        found.erase(first, last);
+    }
+
+    SearchIndex::Results results;
+    const auto hitCount = std::min(found.size(), size_t(limit));
+    results.hits.reserve(qsizetype(hitCount));
+    for (size_t i = 0; i < hitCount; ++i)
+        results.hits.push_back(std::move(found[i].hit));
+    if (found.size() > hitCount) {
+        const auto& lastHit = found[hitCount - 1];
+        results.nextBatch = u"%1:%2"_s.arg(lastHit.hit.timestamp.toMSecsSinceEpoch())
+                                .arg(lastHit.rowId);
+    }
+    return results;
+}
+
+QString databaseDir(const QString& userId)
+{
+    auto dbDir = userId;
+    dbDir.replace(u':', u'_');
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) % u'/' % dbDir;
+}
+
+constexpr auto DatabaseFileName = "quotient_search.db3"_L1;
+
+} // namespace
+
+class Q_DECL_HIDDEN SearchIndex::Private {
+public:
+    QString connectionName;
+    QThread workerThread;
+    QObject worker; //!< The context object for database access, lives in workerThread
+    QTimer flushTimer;
+    std::vector<IndexUpdate> bufferedUpdates;
+
+    QSqlDatabase db() const { return QSqlDatabase::database(connectionName); }
+
+    void enqueue(IndexUpdate&& update)
+    {
+        bufferedUpdates.push_back(std::move(update));
+        if (std::ssize(bufferedUpdates) >= MaxBufferedUpdates)
+            flush();
+        else if (!flushTimer.isActive())
+            flushTimer.start();
+    }
+
+    void flush()
+    {
+        flushTimer.stop();
+        if (bufferedUpdates.empty())
+            return;
+        QMetaObject::invokeMethod(&worker, [this, updates = std::exchange(bufferedUpdates, {})] {
+            QElapsedTimer et;
+            et.start();
+            auto db = this->db();
+            db.transaction();
+            for (const auto& u : updates)
+                switch (u.kind) {
+                case IndexUpdate::Add:
+                    addToIndex(db, u);
+                    break;
+                case IndexUpdate::Replace:
+                    replaceInIndex(db, u);
+                    break;
+                case IndexUpdate::Remove:
+                    removeFromIndex(db, u"eventId = ?"_s, u.eventId);
+                    break;
+                case IndexUpdate::ClearRoom:
+                    removeFromIndex(db, u"roomId = ?"_s, u.roomId);
+                    break;
+                }
+            if (!db.commit())
+                qCritical(DATABASE) << "Failed to update the search index:" << db.lastError();
+            if (et.nsecsElapsed() >= ProfilerMinNsecs)
+                qCDebug(PROFILER) << "Applied" << updates.size() << "search index update(s) in"
+                                  << et;
+        });
+    }
+};
+
+SearchIndex::SearchIndex(const QString& userId, QObject* parent)
+    : QObject(parent), d(makeImpl<Private>())
+{
+    const auto databasePath = databaseDir(userId);
+    QDir(databasePath).mkpath("."_L1);
+    const QString fileName = databasePath % u'/' % DatabaseFileName;
+    d->connectionName = "Quotient_search_"_L1 + userId;
+
+    d->flushTimer.setSingleShot(true);
+    d->flushTimer.setInterval(UpdateBatchInterval);
+    connect(&d->flushTimer, &QTimer::timeout, this, &SearchIndex::flush);
+
+    d->worker.moveToThread(&d->workerThread);
+    d->workerThread.setObjectName(d->connectionName);
+    d->workerThread.start();
+    QMetaObject::invokeMethod(&d->worker, [this, fileName] {
+        auto db = QSqlDatabase::addDatabase(u"QSQLITE"_s, d->connectionName);
+        db.setDatabaseName(fileName);
+        if (!db.open()) {
+            qCritical(DATABASE) << "Could not open the search index:" << db.lastError();
+            return;
+        }
+        QSqlQuery(u"PRAGMA journal_mode=WAL;"_s, db);
+        QSqlQuery(u"PRAGMA synchronous=NORMAL;"_s, db);
+        migrate(db);
+    });
+}
+
+SearchIndex::~SearchIndex()
+{
+    d->flush();
+    // Posted after all pending updates and searches, so these are complete once this returns
+    QMetaObject::invokeMethod(
+        &d->worker, [this] { QSqlDatabase::removeDatabase(d->connectionName); },
+        Qt::BlockingQueuedConnection);
+    d->workerThread.quit();
+    d->workerThread.wait();
+}
+
+void SearchIndex::addMessage(const QString& roomId, const QString& eventId,
+                             const QString& senderId, const QDateTime& timestamp,
+                             const QString& text)
+{
+    if (text.isEmpty() || eventId.isEmpty())
+        return;
+    d->enqueue({ .kind = IndexUpdate::Add,
+                 .roomId = roomId,
+                 .eventId = eventId,
+                 .senderId = senderId,
+                 .timestamp = timestamp.toMSecsSinceEpoch(),
+                 .text = text });
+}
+
+void SearchIndex::addEvent(const QString& roomId, const RoomEvent& event)
+{
+    if (event.isRedacted())
+        return;
+    const auto* message = eventCast<const RoomMessageEvent>(&event);
+    if (!message)
+        return;
+    // An edit is indexed under the id of the message it replaces, with the new text rather than
+    // the fallback body ("* new text") which is meant for clients that don't support edits
+    if (const auto replacedId = message->replacedEvent(); !replacedId.isEmpty()) {
+        const auto timestamp = message->originTimestamp().toMSecsSinceEpoch();
+        d->enqueue(
+            { .kind = IndexUpdate::Replace,
+              .roomId = roomId,
+              .eventId = replacedId,
+              .senderId = message->senderId(),
+              .timestamp = timestamp,
+              .text = message->contentPart<QJsonObject>("m.new_content"_L1)[BodyKey].toString(),
+              .editTimestamp = timestamp });
+        return;
+    }
+    addMessage(roomId, message->id(), message->senderId(), message->originTimestamp(),
+               message->plainBody());
+}
+
+void SearchIndex::removeEvent(const QString& eventId)
+{
+    d->enqueue({ .kind = IndexUpdate::Remove, .eventId = eventId });
+}
+
+void SearchIndex::clearRoom(const QString& roomId)
+{
+    d->enqueue({ .kind = IndexUpdate::ClearRoom, .roomId = roomId });
+}
+
+QFuture<SearchIndex::Results> SearchIndex::search(const QString& query,
+                                                  const QStringList& roomIds, int limit,
+                                                  const QString& nextBatch)
+{
+    d->flush();
+    auto promise = std::make_shared<QPromise<Results>>();
+    promise->start();
+    QMetaObject::invokeMethod(&d->worker, [this, promise, query, roomIds, limit, nextBatch] {
+        QElapsedTimer et;
+        et.start();
+        auto results = runSearch(d->db(), query, roomIds, limit, nextBatch);
+        qCDebug(PROFILER) << "Search for" << query << "found" << results.hits.size()
+                          << "message(s) in" << et;
+        promise->addResult(std::move(results));
+        promise->finish();
+    });
+    return promise->future();
+}
+
+void SearchIndex::flush() { d->flush(); }
+
+QStringList SearchIndex::tokenize(QStringView text)
+{
+    QStringList terms;
+    forEachWord(text, [&terms](QStringView word) {
+        auto term = word.left(MaxTermLength).toString().toCaseFolded();
+        if (term.size() > MaxTermLength) // Case folding may expand some characters
+            term.truncate(MaxTermLength);
+        if (term.back().isHighSurrogate())
+            term.chop(1);
+        if (!terms.contains(term))
+            terms.push_back(std::move(term));
+    });
+    return terms;
+}
+
+bool SearchIndex::purge(const QString& userId)
+{
+    const QDir dir(databaseDir(userId));
+    bool result = true;
+    // SQLite keeps the write-ahead log and its index next to the database
+    for (const auto& suffix : { ""_L1, "-wal"_L1, "-shm"_L1 })
+        if (const QString fileName = DatabaseFileName + suffix;
+            dir.exists(fileName) && !dir.remove(fileName)) {
+            qCWarning(DATABASE) << "Could not delete" << dir.filePath(fileName);
+            result = false;
+        }
+    if (result)
+        qCDebug(DATABASE) << "Deleted the search index of" << userId;
+    return result;
+}
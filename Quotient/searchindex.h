@@ -0,0 +1,92 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "quotient_export.h"
+#include "util.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QFuture>
+#include <QtCore/QObject>
+
+namespace Quotient {
+
+class RoomEvent;
+
+//! \brief A local full-text index of messages
+//!
+//! Servers cannot search end-to-end encrypted rooms; SearchIndex fills the gap by keeping
+//! an inverted index of decrypted messages in an SQLite database, separate from the E2EE
+//! Database and the EventStore. Message bodies are split into words (see tokenize()); for each
+//! word the index keeps the list of messages containing it, ordered by time, so that a query
+//! only touches the messages containing its rarest word. The message text itself is not stored.
+//!
+//! As with EventStore, updates are buffered and applied in batches, each in a single
+//! transaction, on a dedicated thread; searches run on the same thread and see all updates
+//! made before they were started.
+//! \sa MessageSearch, Connection::searchIndexEnabled
+class QUOTIENT_API SearchIndex : public QObject {
+    Q_OBJECT
+public:
+    struct Hit {
+        QString roomId;
+        QString eventId;
+        QString senderId;
+        QDateTime timestamp;
+    };
+    struct Results {
+        //! Matching messages, most recent first
+        QVector<Hit> hits;
+        //! The token to pass to search() for the next page; empty if there are no more hits
+        QString nextBatch;
+    };
+
+    explicit SearchIndex(const QString& userId, QObject* parent = nullptr);
+    ~SearchIndex() override;
+
+    //! \brief Index the text of a message
+    //!
+    //! Messages that are already in the index are left as they are.
+    void addMessage(const QString& roomId, const QString& eventId, const QString& senderId,
+                    const QDateTime& timestamp, const QString& text);
+    //! \brief Index \p event if it is a (non-redacted) message with some text in it
+    //!
+    //! An edit (`m.replace`) updates the indexed text of the message it replaces, unless a later
+    //! edit of it has already been indexed; search hits always refer to the original message.
+    void addEvent(const QString& roomId, const RoomEvent& event);
+    //! Drop the message from the index, e.g. because it has been redacted
+    void removeEvent(const QString& eventId);
+    //! Drop all messages of the room from the index
+    void clearRoom(const QString& roomId);
+
+    //! \brief Find messages containing all words of \p query
+    //!
+    //! Words match case-insensitively; the last word of the query also matches as a prefix
+    //! unless the query ends with a space or punctuation, so that results can be shown as
+    //! the user types.
+    //! \param roomIds limit the search to these rooms; all rooms are searched if empty
+    //! \param limit the maximum number of hits to return
+    //! \param nextBatch the token from the previous page of results, if any
+    QFuture<Results> search(const QString& query, const QStringList& roomIds = {},
+                            int limit = 20, const QString& nextBatch = {});
+
+    //! Apply all buffered updates without waiting for the next batch
+    void flush();
+
+    //! Split \p text into case-folded unique words, the way it is indexed
+    static QStringList tokenize(QStringView text);
+
+    //! \brief Delete the search index of \p userId from the disk
+    //!
+    //! The index must not be open at the moment, i.e. there should be no SearchIndex object
+    //! for \p userId.
+    //! \return true if there's no index for \p userId on the disk by the time this returns
+    static bool purge(const QString& userId);
+
+private:
+    class Private;
+    ImplPtr<Private> d;
+};
+
+} // namespace Quotient
@@ -3,6 +3,7 @@
 
 #include "settings.h"
 
+#include <QtCore/QCryptographicHash>
 #include <QtCore/QUrl>
 
 using namespace Quotient;
@@ -102,6 +103,13 @@ QUO_DEFINE_SETTING(AccountSettings, bool, keepLoggedIn, "keep_logged_in", false,
 namespace {
 constexpr auto HomeserverKey = "homeserver"_L1;
 constexpr auto EncryptionAccountPickleKey = "encryption_account_pickle"_L1;
+
+QString filterKey(const QByteArray& filterJson)
+{
+    return "filters/"_L1
+           + QString::fromLatin1(
+               QCryptographicHash::hash(filterJson, QCryptographicHash::Sha256).toHex());
+}
 }
 
 QUrl AccountSettings::homeserver() const
@@ -131,3 +139,16 @@ void AccountSettings::clearEncryptionAccountPickle()
 {
     remove(EncryptionAccountPickleKey); // TODO: Force to re-issue it?
 }
+
+QString AccountSettings::filterId(const QByteArray& filterJson) const
+{
+    return get<QString>(filterKey(filterJson));
+}
+
+void AccountSettings::setFilterId(const QByteArray& filterJson, const QString& filterId)
+{
+    if (filterId.isEmpty())
+        remove(filterKey(filterJson));
+    else
+        setValue(filterKey(filterJson), filterId);
+}
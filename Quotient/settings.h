@@ -139,5 +139,12 @@ public:
     QByteArray encryptionAccountPickle();
     void setEncryptionAccountPickle(const QByteArray& encryptionAccountPickle);
     Q_INVOKABLE void clearEncryptionAccountPickle();
+
+    //! \brief The id of a filter defined on the homeserver
+    //! \param filterJson the filter definition as it was uploaded
+    //! \return the filter id, or an empty string if the filter is not known to be defined
+    QString filterId(const QByteArray& filterJson) const;
+    //! Remember the id of the filter defined by \p filterJson; an empty id forgets it
+    void setFilterId(const QByteArray& filterJson, const QString& filterId);
 };
 } // namespace Quotient
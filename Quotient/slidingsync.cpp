@@ -0,0 +1,331 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "slidingsync.h"
+
+#include "connection.h"
+#include "logging_categories_p.h"
+
+#include "jobs/slidingsyncjob.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonArray>
+
+#include <vector>
+
+using namespace Quotient;
+
+namespace {
+
+using StateKeys = std::initializer_list<std::pair<QLatin1StringView, QLatin1StringView>>;
+
+QJsonArray toJson(StateKeys stateKeys)
+{
+    QJsonArray json;
+    for (const auto& [type, stateKey] : stateKeys)
+        json.append(QJsonArray{ type, stateKey });
+    return json;
+}
+
+//! State needed to show a room in the room list
+const QJsonArray& listRequiredState()
+{
+    static const auto json = toJson({ { "m.room.create"_L1, ""_L1 },
+                                      { "m.room.name"_L1, ""_L1 },
+                                      { "m.room.avatar"_L1, ""_L1 },
+                                      { "m.room.canonical_alias"_L1, ""_L1 },
+                                      { "m.room.topic"_L1, ""_L1 },
+                                      { "m.room.encryption"_L1, ""_L1 },
+                                      { "m.room.tombstone"_L1, ""_L1 },
+                                      { "m.room.member"_L1, "$ME"_L1 } });
+    return json;
+}
+
+//! State needed to show the room timeline; the members are lazy-loaded
+const QJsonArray& subscriptionRequiredState()
+{
+    static const auto json = toJson({ { "m.room.create"_L1, ""_L1 },
+                                      { "m.room.name"_L1, ""_L1 },
+                                      { "m.room.avatar"_L1, ""_L1 },
+                                      { "m.room.canonical_alias"_L1, ""_L1 },
+                                      { "m.room.topic"_L1, ""_L1 },
+                                      { "m.room.encryption"_L1, ""_L1 },
+                                      { "m.room.tombstone"_L1, ""_L1 },
+                                      { "m.room.power_levels"_L1, ""_L1 },
+                                      { "m.room.join_rules"_L1, ""_L1 },
+                                      { "m.room.history_visibility"_L1, ""_L1 },
+                                      { "m.room.guest_access"_L1, ""_L1 },
+                                      { "m.room.pinned_events"_L1, ""_L1 },
+                                      { "m.room.server_acl"_L1, ""_L1 },
+                                      { "m.space.parent"_L1, "*"_L1 },
+                                      { "m.space.child"_L1, "*"_L1 },
+                                      { "m.room.member"_L1, "$LAZY"_L1 },
+                                      { "m.room.member"_L1, "$ME"_L1 } });
+    return json;
+}
+
+} // namespace
+
+class SlidingSync::Private {
+public:
+    explicit Private(SlidingSync* q, Connection* connection) : q(q), connection(connection) {}
+
+    struct RoomList {
+        int first = 0;
+        int last = 0;
+        int timelineLimit = 1;
+        QJsonObject filters;
+        int count = -1;
+    };
+
+    SlidingSync* q;
+    Connection* connection;
+    QHash<QString, RoomList> lists;
+    QHash<QString, int> subscriptions; //!< Timeline limits by room id
+    QString pos;
+    QString toDeviceSince;
+    JobHandle<SlidingSyncJob> job;
+    qint64 currentJobBytes = 0;
+    qint64 bytesReceived = 0;
+    int timeout = -1;
+    QMetaObject::Connection syncLoopConnection;
+    bool restartScheduled = false;
+
+    //! Room ids with their activity stamps, the most recently active first
+    std::vector<std::pair<qint64, QString>> roomOrder;
+    QHash<QString, qint64> bumpStamps;
+
+    QJsonObject requestBody() const;
+    bool updateLists(const QHash<QString, int>& listCounts);
+    bool updateRoomOrder(const QHash<QString, qint64>& newBumpStamps);
+    //! Restart the pending request (if there's one) to apply the changed parameters
+    void restartSync();
+};
+
+QJsonObject SlidingSync::Private::requestBody() const
+{
+    QJsonObject listsJson;
+    for (auto it = lists.cbegin(); it != lists.cend(); ++it) {
+        QJsonObject listJson{ { "ranges"_L1, QJsonArray{ QJsonArray{ it->first, it->last } } },
+                              { "timeline_limit"_L1, it->timelineLimit },
+                              { "required_state"_L1, listRequiredState() } };
+        addParam<IfNotEmpty>(listJson, "filters"_L1, it->filters);
+        listsJson.insert(it.key(), listJson);
+    }
+    QJsonObject subscriptionsJson;
+    for (auto it = subscriptions.cbegin(); it != subscriptions.cend(); ++it)
+        subscriptionsJson.insert(it.key(),
+                                 QJsonObject{ { "timeline_limit"_L1, *it },
+                                              { "required_state"_L1,
+                                                subscriptionRequiredState() } });
+
+    const QJsonObject enabled{ { "enabled"_L1, true } };
+    auto toDeviceJson = enabled;
+    addParam<IfNotEmpty>(toDeviceJson, "since"_L1, toDeviceSince);
+    return { { "lists"_L1, listsJson },
+             { "room_subscriptions"_L1, subscriptionsJson },
+             { "extensions"_L1, QJsonObject{ { "to_device"_L1, toDeviceJson },
+                                             { "e2ee"_L1, enabled },
+                                             { "account_data"_L1, enabled },
+                                             { "receipts"_L1, enabled },
+                                             { "typing"_L1, enabled } } } };
+}
+
+bool SlidingSync::Private::updateLists(const QHash<QString, int>& listCounts)
+{
+    bool changed = false;
+    for (auto it = listCounts.cbegin(); it != listCounts.cend(); ++it)
+        if (auto listIt = lists.find(it.key()); listIt != lists.end() && listIt->count != *it) {
+            listIt->count = *it;
+            changed = true;
+        }
+    return changed;
+}
+
+bool SlidingSync::Private::updateRoomOrder(const QHash<QString, qint64>& newBumpStamps)
+{
+    // Higher stamps go first; the room id breaks ties to keep the order stable
+    static constexpr auto moreRecent = [](const auto& lhs, const auto& rhs) {
+        return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+    };
+    bool changed = false;
+    for (auto it = newBumpStamps.cbegin(); it != newBumpStamps.cend(); ++it) {
+        if (const auto oldIt = bumpStamps.constFind(it.key()); oldIt != bumpStamps.cend()) {
+            if (*oldIt == *it)
+                continue;
+            const auto oldPos = std::lower_bound(roomOrder.begin(), roomOrder.end(),
+                                                 std::pair{ *oldIt, it.key() }, moreRecent);
+            Q_ASSERT(oldPos != roomOrder.end() && oldPos->second == it.key());
+            roomOrder.erase(oldPos);
+        }
+        bumpStamps.insert(it.key(), *it);
+        std::pair entry{ *it, it.key() };
+        const auto newPos = std::lower_bound(roomOrder.begin(), roomOrder.end(), entry, moreRecent);
+        roomOrder.insert(newPos, std::move(entry));
+        changed = true;
+    }
+    Q_ASSERT(qsizetype(roomOrder.size()) == bumpStamps.size());
+    return changed;
+}
+
+void SlidingSync::Private::restartSync()
+{
+    if (!isJobPending(job) || restartScheduled)
+        return;
+    restartScheduled = true;
+    // Let several changes made in a row go into a single request
+    QMetaObject::invokeMethod(
+        q,
+        [this] {
+            restartScheduled = false;
+            if (!isJobPending(job))
+                return; // The request has finished in the meantime and the next one will do
+            qCDebug(SYNCJOB) << "Restarting sliding sync with updated parameters";
+            job.abandon();
+            q->sync(timeout);
+        },
+        Qt::QueuedConnection);
+}
+
+SlidingSync::SlidingSync(Connection* connection)
+    : QObject(connection), d(makeImpl<Private>(this, connection))
+{}
+
+SlidingSync::~SlidingSync() = default;
+
+void SlidingSync::setList(const QString& listName, int windowSize, int timelineLimit,
+                          const QJsonObject& filters)
+{
+    auto& list = d->lists[listName];
+    list.first = 0;
+    list.last = std::max(windowSize, 1) - 1;
+    list.timelineLimit = timelineLimit;
+    list.filters = filters;
+    d->restartSync();
+}
+
+void SlidingSync::setListWindow(const QString& listName, int first, int last)
+{
+    auto it = d->lists.find(listName);
+    if (it == d->lists.end()) {
+        qCWarning(SYNCJOB) << "No sliding sync list named" << listName;
+        return;
+    }
+    if (it->first == first && it->last == last)
+        return;
+    it->first = first;
+    it->last = std::max(first, last);
+    d->restartSync();
+}
+
+void SlidingSync::removeList(const QString& listName)
+{
+    if (d->lists.remove(listName))
+        d->restartSync();
+}
+
+QStringList SlidingSync::listNames() const { return d->lists.keys(); }
+
+int SlidingSync::roomCount(const QString& listName) const
+{
+    return d->lists.value(listName).count;
+}
+
+void SlidingSync::subscribeToRoom(const QString& roomId, int timelineLimit)
+{
+    if (auto it = d->subscriptions.find(roomId);
+        it != d->subscriptions.end() && *it == timelineLimit)
+        return;
+    d->subscriptions.insert(roomId, timelineLimit);
+    d->restartSync();
+}
+
+void SlidingSync::unsubscribeFromRoom(const QString& roomId)
+{
+    if (d->subscriptions.remove(roomId))
+        d->restartSync();
+}
+
+QStringList SlidingSync::subscribedRoomIds() const { return d->subscriptions.keys(); }
+
+QStringList SlidingSync::roomIds() const
+{
+    QStringList result;
+    result.reserve(qsizetype(d->roomOrder.size()));
+    for (const auto& [_, roomId] : d->roomOrder)
+        result.push_back(roomId);
+    return result;
+}
+
+bool SlidingSync::isActive() const { return isJobPending(d->job); }
+
+qint64 SlidingSync::bytesReceived() const { return d->bytesReceived; }
+
+void SlidingSync::sync(int timeout)
+{
+    if (isJobPending(d->job)) {
+        qCInfo(SYNCJOB) << d->job.get() << "is already running";
+        return;
+    }
+    if (!d->connection->isLoggedIn()) {
+        qCWarning(SYNCJOB) << "Not logged in, not going to sync";
+        return;
+    }
+
+    d->timeout = timeout;
+    d->currentJobBytes = 0;
+    auto job = d->job = d->connection->callApi<SlidingSyncJob>(BackgroundRequest,
+                                                               d->connection->userId(),
+                                                               d->requestBody(), d->pos, timeout);
+    connect(job, &BaseJob::downloadProgress, this,
+            [this](qint64 bytesReceived) { d->currentJobBytes = bytesReceived; });
+    connect(job, &BaseJob::success, this, [this, job] {
+        QElapsedTimer et;
+        et.start();
+        d->bytesReceived += d->currentJobBytes;
+        d->pos = job->pos();
+        if (const auto& since = job->toDeviceSince(); !since.isEmpty())
+            d->toDeviceSince = since;
+        const auto listsChanged = d->updateLists(job->listCounts());
+        const auto orderChanged = d->updateRoomOrder(job->bumpStamps());
+        d->connection->onSyncSuccess(job->takeData());
+        if (listsChanged || orderChanged)
+            emit roomListChanged();
+        if (job->bumpStamps().size() > 9 || et.nsecsElapsed() >= ProfilerMinNsecs)
+            qCDebug(PROFILER) << "Processed sliding sync response with"
+                              << job->bumpStamps().size() << "ordered room(s),"
+                              << d->currentJobBytes << "bytes in" << et;
+        emit syncDone();
+    });
+    connect(job, &BaseJob::failure, this, [this, job] {
+        if (job->error() == SlidingSyncJob::UnknownPosError) {
+            // The server has forgotten the sync position; start over, with the same lists
+            qCWarning(SYNCJOB) << "Sliding sync position" << d->pos
+                               << "has expired, restarting from scratch";
+            d->pos.clear();
+            QMetaObject::invokeMethod(this, [this] { sync(d->timeout); }, Qt::QueuedConnection);
+            return;
+        }
+        // SlidingSyncJob persists with retries on transient errors; if it fails,
+        // there's likely something serious enough to stop the loop.
+        stopSync();
+        emit syncError(job->errorString(), job->rawDataSample());
+    });
+}
+
+void SlidingSync::syncLoop(int timeout)
+{
+    d->timeout = timeout;
+    if (d->syncLoopConnection)
+        return;
+    d->syncLoopConnection = connect(this, &SlidingSync::syncDone, this,
+                                    [this] { sync(d->timeout); }, Qt::QueuedConnection);
+    sync(timeout);
+}
+
+void SlidingSync::stopSync()
+{
+    if (d->syncLoopConnection)
+        disconnect(std::exchange(d->syncLoopConnection, {}));
+    d->job.abandon();
+}
@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "quotient_export.h"
+#include "util.h"
+
+#include <QtCore/QJsonObject>
+#include <QtCore/QObject>
+
+namespace Quotient {
+
+class Connection;
+
+//! \brief A sliding sync (MSC4186) driver for a connection
+//!
+//! This is an alternative to Connection::sync() and Connection::syncLoop() for homeservers that
+//! support simplified sliding sync. Instead of getting updates for all rooms of the account with
+//! every response, the client asks for windows of room lists sorted by recent activity - just
+//! enough to fill the visible part of the room list - and subscribes to the rooms it needs in
+//! more detail (e.g., the room opened by the user), each with its own timeline limit.
+//!
+//! Responses are fed to the connection and its rooms the same way as /sync responses, so Room
+//! objects appear and get updated as usual; on top of that, SlidingSync keeps the order of rooms
+//! by activity and the total room counts in lists.
+//!
+//! Changing lists or subscriptions while a request is pending restarts the request with the new
+//! parameters. Don't run sliding sync and the /sync loop on the same connection at the same time.
+class QUOTIENT_API SlidingSync : public QObject {
+    Q_OBJECT
+public:
+    explicit SlidingSync(Connection* connection);
+    ~SlidingSync() override;
+
+    //! \brief Add a room list or update its parameters
+    //!
+    //! \param listName the name identifying the list in requests and responses
+    //! \param windowSize the number of rooms to sync from the top of the list
+    //! \param timelineLimit the number of latest events to get for each room in the window
+    //! \param filters the list filters as defined by MSC4186, e.g. `{ "is_dm": true }`
+    void setList(const QString& listName, int windowSize, int timelineLimit = 1,
+                 const QJsonObject& filters = {});
+    //! Sync rooms from \p first to \p last (inclusive) in the list, e.g. when it is scrolled
+    void setListWindow(const QString& listName, int first, int last);
+    void removeList(const QString& listName);
+    QStringList listNames() const;
+    //! The total number of rooms in the list as reported by the server; -1 if not known yet
+    int roomCount(const QString& listName) const;
+
+    //! \brief Get the whole state of the room and \p timelineLimit latest events in it
+    //!
+    //! Unlike rooms in lists, the room is synced regardless of its position in any list.
+    void subscribeToRoom(const QString& roomId, int timelineLimit = 20);
+    void unsubscribeFromRoom(const QString& roomId);
+    QStringList subscribedRoomIds() const;
+
+    //! Ids of all rooms received so far, the most recently active first
+    QStringList roomIds() const;
+
+    //! Whether a sliding sync request is pending
+    bool isActive() const;
+    //! The total size of response bodies received since the driver has been created
+    qint64 bytesReceived() const;
+
+public Q_SLOTS:
+    //! Make a single sliding sync request
+    void sync(int timeout = -1);
+    //! Keep making sliding sync requests one after another
+    void syncLoop(int timeout = 30000);
+    void stopSync();
+
+Q_SIGNALS:
+    //! The order of rooms or room counts in lists have changed
+    void roomListChanged();
+    void syncDone();
+    void syncError(QString message, QString details);
+
+private:
+    class Private;
+    ImplPtr<Private> d;
+};
+
+} // namespace Quotient
@@ -0,0 +1,316 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "spacegraph.h"
+
+#include "connection.h"
+#include "logging_categories_p.h"
+
+#include "csapi/space_hierarchy.h"
+
+#include <QtCore/QJsonArray>
+
+#include <deque>
+#include <unordered_map>
+
+using namespace Quotient;
+
+namespace {
+
+//! A link from a space to a child room, as defined by an `m.space.child` event
+struct ChildLink {
+    QString order;
+    qint64 timestamp = 0;
+    bool suggested = false;
+};
+
+std::optional<ChildLink> makeLink(const StateEvent& childEvent)
+{
+    // A child event without `via` is how a child gets removed from the space
+    if (childEvent.contentPart<QJsonArray>("via"_L1).isEmpty())
+        return std::nullopt;
+    auto order = childEvent.contentPart<QString>("order"_L1);
+    // The specification says to ignore orders that are too long or have weird characters
+    if (order.size() > 50
+        || !std::ranges::all_of(order, [](QChar c) { return c >= u'\x20' && c <= u'\x7E'; }))
+        order.clear();
+    return ChildLink{ order, childEvent.originTimestamp().toMSecsSinceEpoch(),
+                      childEvent.contentPart<bool>("suggested"_L1) };
+}
+
+//! Order children as the specification defines: children with `order` go first, sorted by it;
+//! then by the timestamp of the child event and the room id
+QStringList orderedChildren(const QHash<QString, ChildLink>& links)
+{
+    QStringList result = links.keys();
+    std::ranges::sort(result, [&links](const QString& lhs, const QString& rhs) {
+        const auto& l = *links.constFind(lhs);
+        const auto& r = *links.constFind(rhs);
+        if (l.order.isEmpty() != r.order.isEmpty())
+            return !l.order.isEmpty();
+        return std::tie(l.order, l.timestamp, lhs) < std::tie(r.order, r.timestamp, rhs);
+    });
+    return result;
+}
+
+} // namespace
+
+class SpaceGraph::Private {
+public:
+    Private(SpaceGraph* q, Connection* connection) : q(q), connection(connection) {}
+
+    SpaceGraph* q;
+    Connection* connection;
+    int pageSize = 100;
+    //! All known nodes; never removed, so that pointers to them stay valid
+    std::unordered_map<QString, Node> nodes;
+    QHash<QString, QHash<QString, ChildLink>> childLinks;
+    QHash<QString, QSet<QString>> parentsByChild;
+
+    struct PendingLoad {
+        JobHandle<GetSpaceHierarchyJob> job;
+        //! The generation of the space at the start of loading, to detect concurrent changes
+        quint64 generation = 0;
+    };
+    QHash<QString, PendingLoad> loads;
+
+    Node& nodeFor(const QString& roomId)
+    {
+        auto [it, inserted] = nodes.try_emplace(roomId);
+        if (inserted)
+            it->second.roomId = roomId;
+        return it->second;
+    }
+
+    void setLinks(Node& space, QHash<QString, ChildLink>&& links);
+    void applyChunk(GetSpaceHierarchyJob::SpaceHierarchyRoomsChunk&& chunk);
+    void loadPage(const QString& spaceId, const QString& from);
+};
+
+void SpaceGraph::Private::setLinks(Node& space, QHash<QString, ChildLink>&& links)
+{
+    auto newChildIds = orderedChildren(links);
+    for (const auto& childId : std::as_const(space.childIds))
+        if (!links.contains(childId))
+            if (auto it = parentsByChild.find(childId); it != parentsByChild.end()) {
+                it->remove(space.roomId);
+                if (it->isEmpty())
+                    parentsByChild.erase(it);
+            }
+    space.suggestedChildIds.clear();
+    for (const auto& childId : std::as_const(newChildIds)) {
+        nodeFor(childId); // Make sure there's a node to visit
+        parentsByChild[childId].insert(space.roomId);
+        if (links.value(childId).suggested)
+            space.suggestedChildIds.insert(childId);
+    }
+    space.childIds = std::move(newChildIds);
+    childLinks.insert(space.roomId, std::move(links));
+}
+
+void SpaceGraph::Private::applyChunk(GetSpaceHierarchyJob::SpaceHierarchyRoomsChunk&& chunk)
+{
+    auto& node = nodeFor(chunk.roomId);
+    node.name = std::move(chunk.name);
+    node.topic = std::move(chunk.topic);
+    node.canonicalAlias = std::move(chunk.canonicalAlias);
+    node.avatarUrl = std::move(chunk.avatarUrl);
+    node.joinRule = std::move(chunk.joinRule);
+    node.roomType = std::move(chunk.roomType);
+    node.numJoinedMembers = chunk.numJoinedMembers;
+    node.worldReadable = chunk.worldReadable;
+    node.guestCanJoin = chunk.guestCanJoin;
+    node.hasSummary = true;
+    if (!node.isSpace())
+        return;
+    // The server lists all child events of each space it returns
+    QHash<QString, ChildLink> links;
+    for (const auto& e : chunk.childrenState)
+        if (e && e->matrixType() == SpaceChildEventType)
+            if (const auto link = makeLink(*e))
+                links.insert(e->stateKey(), *link);
+    setLinks(node, std::move(links));
+}
+
+void SpaceGraph::Private::loadPage(const QString& spaceId, const QString& from)
+{
+    auto& load = loads[spaceId];
+    if (from.isEmpty())
+        load.generation = nodeFor(spaceId).generation;
+    // One level at a time: the traversal decides whether to go deeper
+    load.job = connection->callApi<GetSpaceHierarchyJob>(spaceId, std::nullopt, pageSize, 1, from);
+    QObject::connect(load.job, &BaseJob::success, q, [this, spaceId, job = load.job.get()] {
+        auto response = collectResponse(job);
+        for (auto& chunk : response.rooms)
+            applyChunk(std::move(chunk));
+        if (!response.nextBatch.isEmpty()) {
+            loadPage(spaceId, response.nextBatch);
+            return;
+        }
+        const auto startGeneration = loads.take(spaceId).generation;
+        auto& space = nodeFor(spaceId);
+        if (space.generation != startGeneration) {
+            qCDebug(MAIN) << "Space" << spaceId << "changed while loading, reloading";
+            loadPage(spaceId, {});
+            return;
+        }
+        space.childrenLoaded = true;
+        ++space.generation;
+        emit q->spaceLoaded(spaceId);
+    });
+    QObject::connect(load.job, &BaseJob::failure, q, [this, spaceId, job = load.job.get()] {
+        loads.remove(spaceId);
+        qCWarning(MAIN) << "Failed to load the hierarchy of space" << spaceId << "-"
+                        << job->errorString();
+        emit q->loadFailed(spaceId, job->errorString());
+    });
+}
+
+SpaceGraph::SpaceGraph(Connection* connection)
+    : QObject(), d(makeImpl<Private>(this, connection))
+{}
+
+SpaceGraph::~SpaceGraph()
+{
+    for (auto& load : d->loads)
+        load.job.abandon();
+}
+
+const SpaceGraph::Node* SpaceGraph::node(const QString& roomId) const
+{
+    const auto it = d->nodes.find(roomId);
+    return it != d->nodes.end() ? &it->second : nullptr;
+}
+
+QSet<QString> SpaceGraph::parentSpaces(const QString& roomId) const
+{
+    return d->parentsByChild.value(roomId);
+}
+
+void SpaceGraph::loadSpace(const QString& spaceId)
+{
+    if (isLoading(spaceId) || d->nodeFor(spaceId).childrenLoaded)
+        return;
+    d->loadPage(spaceId, {});
+}
+
+bool SpaceGraph::isLoading(const QString& spaceId) const { return d->loads.contains(spaceId); }
+
+void SpaceGraph::invalidate(const QString& spaceId)
+{
+    auto& space = d->nodeFor(spaceId);
+    space.childrenLoaded = false;
+    ++space.generation;
+    emit spaceChanged(spaceId);
+}
+
+int SpaceGraph::pageSize() const { return d->pageSize; }
+
+void SpaceGraph::setPageSize(int newSize) { d->pageSize = std::max(newSize, 1); }
+
+void SpaceGraph::processStateEvent(const QString& roomId, const StateEvent& event)
+{
+    if (event.matrixType() == SpaceChildEventType) {
+        auto links = d->childLinks.value(roomId);
+        if (const auto link = makeLink(event))
+            links.insert(event.stateKey(), *link);
+        else
+            links.remove(event.stateKey());
+        d->setLinks(d->nodeFor(roomId), std::move(links));
+        invalidate(roomId);
+    } else if (event.matrixType() == SpaceParentEventType) {
+        // The parent may have changed its children along with this; nothing to do if it's not
+        // cached yet
+        if (d->nodes.contains(event.stateKey()))
+            invalidate(event.stateKey());
+    }
+}
+
+class SpaceTraversal::Private {
+public:
+    struct QueueItem {
+        QString roomId;
+        int depth;
+        QString parentId;
+    };
+
+    SpaceGraph* graph;
+    int maxDepth;
+    QVector<Visit> visits;
+    std::deque<QueueItem> queue;
+    QSet<QString> seenIds;
+    //! Spaces that failed to load; these are visited with the children known so far, if any
+    QSet<QString> failedIds;
+    QString awaitedSpaceId;
+    int remaining = 0;
+    bool finished = false;
+
+    void proceed(SpaceTraversal* q);
+};
+
+void SpaceTraversal::Private::proceed(SpaceTraversal* q)
+{
+    const auto first = int(visits.size());
+    while (remaining > 0 && !queue.empty()) {
+        const auto& item = queue.front();
+        const auto* node = graph->node(item.roomId);
+        // The root is always loaded, for its summary; subspaces only if they are to be entered
+        const auto enter = item.depth == 0 || (item.depth < maxDepth && node && node->isSpace());
+        if (enter && !(node && node->childrenLoaded) && !failedIds.contains(item.roomId)) {
+            awaitedSpaceId = item.roomId;
+            graph->loadSpace(item.roomId);
+            break;
+        }
+        Q_ASSERT(node); // Loaded spaces and their children all have nodes
+        visits.push_back({ node, item.depth, item.parentId });
+        if (item.depth < maxDepth)
+            for (const auto& childId : node->childIds)
+                if (!seenIds.contains(childId)) {
+                    seenIds.insert(childId);
+                    queue.push_back({ childId, item.depth + 1, item.roomId });
+                }
+        queue.pop_front();
+        --remaining;
+    }
+    if (const auto added = int(visits.size()) - first; added > 0)
+        emit q->visitsAdded(first, added);
+    if (queue.empty() && !finished) {
+        finished = true;
+        emit q->finished();
+    }
+}
+
+SpaceTraversal::SpaceTraversal(SpaceGraph* graph, const QString& rootId, int maxDepth,
+                               QObject* parent)
+    : QObject(parent), d(makeImpl<Private>(graph, std::max(maxDepth, 0)))
+{
+    d->queue.push_back({ rootId, 0, {} });
+    d->seenIds.insert(rootId);
+    const auto onLoaded = [this](const QString& spaceId) {
+        if (spaceId != d->awaitedSpaceId)
+            return;
+        d->awaitedSpaceId.clear();
+        d->proceed(this);
+    };
+    connect(graph, &SpaceGraph::spaceLoaded, this, onLoaded);
+    connect(graph, &SpaceGraph::loadFailed, this, [this, onLoaded](const QString& spaceId) {
+        if (spaceId == d->awaitedSpaceId)
+            d->failedIds.insert(spaceId);
+        onLoaded(spaceId);
+    });
+}
+
+SpaceTraversal::~SpaceTraversal() = default;
+
+const QVector<SpaceTraversal::Visit>& SpaceTraversal::visits() const { return d->visits; }
+
+bool SpaceTraversal::isLoading() const { return !d->awaitedSpaceId.isEmpty(); }
+
+bool SpaceTraversal::isFinished() const { return d->finished; }
+
+void SpaceTraversal::fetchMore(int count)
+{
+    d->remaining = std::max(d->remaining, count);
+    if (!isLoading())
+        d->proceed(this);
+}
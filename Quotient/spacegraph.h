@@ -0,0 +1,148 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "quotient_export.h"
+#include "util.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QUrl>
+
+namespace Quotient {
+
+class Connection;
+class StateEvent;
+
+constexpr inline auto SpaceChildEventType = "m.space.child"_L1;
+constexpr inline auto SpaceParentEventType = "m.space.parent"_L1;
+
+//! \brief A shared cache of space hierarchies known to a connection
+//!
+//! SpaceGraph keeps one node per room that has been seen in any space hierarchy, so spaces
+//! that share rooms or subspaces share nodes as well. Children of a space are loaded from
+//! the server (see GetSpaceHierarchyJob) one level at a time, when a traversal needs them
+//! (see SpaceTraversal); the loaded children are then served from the cache until a change
+//! of `m.space.child` state in the space, or of `m.space.parent` state pointing to it, arrives
+//! from the server. Each such change bumps the node's generation() and marks its children
+//! as stale; the next traversal through the space reloads them.
+//!
+//! Parent-child links are also picked up from the state of joined spaces, without any
+//! requests; parentSpaces() looks up the spaces containing a given room in constant time.
+//! \sa Connection::spaceGraph
+class QUOTIENT_API SpaceGraph : public QObject {
+    Q_OBJECT
+public:
+    struct Node {
+        QString roomId;
+        //! \name The room summary, as returned by the server
+        //! These are empty until the room is listed in a loaded space, or loaded itself.
+        //! \{
+        QString name;
+        QString topic;
+        QString canonicalAlias;
+        QUrl avatarUrl;
+        QString joinRule;
+        QString roomType;
+        int numJoinedMembers = 0;
+        bool worldReadable = false;
+        bool guestCanJoin = false;
+        bool hasSummary = false;
+        //! \}
+
+        //! Children of the space in the order defined by the specification
+        QStringList childIds;
+        //! Children the space administrators suggest joining
+        QSet<QString> suggestedChildIds;
+        //! \brief Whether the summaries of the children are loaded and up to date
+        //!
+        //! childIds may be known from the local state or a parent's hierarchy before that.
+        bool childrenLoaded = false;
+        //! Incremented on every change of the space's children, loaded or stale
+        quint64 generation = 0;
+
+        bool isSpace() const { return roomType == "m.space"_L1; }
+    };
+
+    explicit SpaceGraph(Connection* connection);
+    ~SpaceGraph() override;
+
+    //! The node for \p roomId, or nullptr if the room hasn't been seen in any hierarchy yet
+    const Node* node(const QString& roomId) const;
+    //! The spaces that are known to have \p roomId as a child
+    QSet<QString> parentSpaces(const QString& roomId) const;
+
+    //! \brief Load the summaries of the children of \p spaceId
+    //!
+    //! This does nothing if the children are already loaded and up to date, or being loaded.
+    //! \sa spaceLoaded, loadFailed
+    void loadSpace(const QString& spaceId);
+    bool isLoading(const QString& spaceId) const;
+    //! Mark the children of \p spaceId as stale, to reload them on the next loadSpace()
+    void invalidate(const QString& spaceId);
+
+    //! The number of rooms requested per page of a space hierarchy
+    int pageSize() const;
+    void setPageSize(int newSize);
+
+    //! \brief Update the graph with a state event of \p roomId
+    //!
+    //! Rooms call this for each `m.space.child` and `m.space.parent` event in their state.
+    void processStateEvent(const QString& roomId, const StateEvent& event);
+
+Q_SIGNALS:
+    //! The children of \p spaceId have been (re)loaded from the server
+    void spaceLoaded(QString spaceId);
+    //! The children of \p spaceId have changed and will be reloaded by the next loadSpace()
+    void spaceChanged(QString spaceId);
+    void loadFailed(QString spaceId, QString message);
+
+private:
+    class Private;
+    ImplPtr<Private> d;
+};
+
+//! \brief A lazy breadth-first walk of a space hierarchy
+//!
+//! The traversal goes through the nodes of SpaceGraph level by level, starting from the root
+//! space, and asks the graph to load the children of each space it reaches (within
+//! the maximum depth) unless they are cached already. Rooms are only visited when fetchMore()
+//! asks for them; each room is visited once even if it is in several spaces of the hierarchy.
+class QUOTIENT_API SpaceTraversal : public QObject {
+    Q_OBJECT
+public:
+    struct Visit {
+        const SpaceGraph::Node* node;
+        //! The number of links from the root space; 0 for the root itself
+        int depth;
+        //! The space the room was reached through; empty for the root
+        QString parentId;
+    };
+
+    //! \param maxDepth how deep to go below \p rootId; subspaces deeper than that are visited
+    //!                 but not entered
+    SpaceTraversal(SpaceGraph* graph, const QString& rootId, int maxDepth,
+                   QObject* parent = nullptr);
+    ~SpaceTraversal() override;
+
+    //! The rooms visited so far, in the breadth-first order
+    const QVector<Visit>& visits() const;
+    //! Whether the traversal waits for a space to load
+    bool isLoading() const;
+    //! Whether all rooms within the maximum depth have been visited
+    bool isFinished() const;
+
+    //! Visit up to \p count more rooms, loading spaces from the server as needed
+    void fetchMore(int count = 100);
+
+Q_SIGNALS:
+    //! \p count rooms have been appended to visits(), starting at \p first
+    void visitsAdded(int first, int count);
+    void finished();
+
+private:
+    class Private;
+    ImplPtr<Private> d;
+};
+
+} // namespace Quotient
@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "timelinecolumns.h"
+
+#include <algorithm>
+
+using namespace Quotient;
+
+TimelineColumns::TimelineColumns(IdPool& idPool) : _idPool(&idPool) {}
+
+void TimelineColumns::append(const TimelineItem& ti)
+{
+    if (isEmpty())
+        _minIndex = ti.index();
+    Q_ASSERT(ti.index() == endIndex());
+    _senders.push_back(_idPool->intern(ti->senderId()));
+    _timestamps.push_back(ti->originTimestampMs());
+}
+
+void TimelineColumns::prepend(const TimelineItem& ti)
+{
+    if (isEmpty())
+        _minIndex = ti.index() + 1;
+    Q_ASSERT(ti.index() == _minIndex - 1);
+    _senders.push_front(_idPool->intern(ti->senderId()));
+    _timestamps.push_front(ti->originTimestampMs());
+    --_minIndex;
+}
+
+void TimelineColumns::update(const TimelineItem& ti)
+{
+    const auto p = pos(ti.index());
+    _senders[p] = _idPool->intern(ti->senderId());
+    _timestamps[p] = ti->originTimestampMs();
+}
+
+void TimelineColumns::dropOldest(size_t count)
+{
+    Q_ASSERT(count <= size());
+    const auto cutPos = static_cast<std::ptrdiff_t>(count);
+    _senders.erase(_senders.begin(), _senders.begin() + cutPos);
+    _timestamps.erase(_timestamps.begin(), _timestamps.begin() + cutPos);
+    _minIndex += index_t(count);
+}
+
+TimelineColumns::index_t TimelineColumns::findNotSentBy(index_t from, InternedId senderId) const
+{
+    if (from >= endIndex())
+        return endIndex();
+    const auto it = std::find_if(_senders.begin() + std::ptrdiff_t(pos(from)), _senders.end(),
+                                 [&senderId](const InternedId& id) { return id != senderId; });
+    return _minIndex + index_t(it - _senders.begin());
+}
+
+TimelineColumns::index_t TimelineColumns::findNotBefore(qint64 timestamp) const
+{
+    const auto it = std::ranges::find_if(_timestamps, [timestamp](qint64 ts) {
+        return ts >= timestamp;
+    });
+    return _minIndex + index_t(it - _timestamps.begin());
+}
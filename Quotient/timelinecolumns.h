@@ -0,0 +1,68 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "eventitem.h"
+#include "idpool.h"
+
+#include <deque>
+
+namespace Quotient {
+
+//! \brief Frequently scanned fields of timeline events, stored column-wise
+//!
+//! This is a side table to the room timeline that keeps the sender and the timestamp of each
+//! event in separate contiguous columns, in the same order as the timeline. The sender is kept
+//! as an InternedId, i.e. a single pointer. Scanning the timeline for these fields (e.g., to
+//! find the first event not sent by a given user) goes through densely packed arrays instead
+//! of dereferencing each event object and the strings in it.
+class QUOTIENT_API TimelineColumns {
+public:
+    using index_t = TimelineItem::index_t;
+
+    explicit TimelineColumns(IdPool& idPool);
+
+    //! Add a row for the event in \p ti that is just after the last one
+    void append(const TimelineItem& ti);
+    //! Add a row for the event in \p ti that is just before the first one
+    void prepend(const TimelineItem& ti);
+    //! Update the row for \p ti after the event in it has been replaced, e.g. redacted
+    void update(const TimelineItem& ti);
+    //! Drop \p count rows from the beginning, as the oldest events get evicted
+    void dropOldest(size_t count);
+
+    bool isEmpty() const { return _senders.empty(); }
+    size_t size() const { return _senders.size(); }
+    index_t minIndex() const { return _minIndex; }
+    //! The index after the last row, i.e. maxIndex() + 1
+    index_t endIndex() const { return _minIndex + index_t(_senders.size()); }
+
+    InternedId senderId(index_t index) const { return _senders[pos(index)]; }
+    qint64 timestamp(index_t index) const { return _timestamps[pos(index)]; }
+
+    //! \brief Find the first event at or after \p from that is not sent by \p senderId
+    //! \return the index of that event, or endIndex() if there's none
+    index_t findNotSentBy(index_t from, InternedId senderId) const;
+
+    //! \brief Find the first event with the timestamp not earlier than \p timestamp
+    //!
+    //! Timestamps in the timeline are not guaranteed to grow monotonically, so the whole
+    //! column is scanned rather than bisected.
+    //! \return the index of that event, or endIndex() if there's none
+    index_t findNotBefore(qint64 timestamp) const;
+
+private:
+    IdPool* _idPool;
+    index_t _minIndex = 0;
+    std::deque<InternedId> _senders;
+    std::deque<qint64> _timestamps;
+
+    size_t pos(index_t index) const
+    {
+        Q_ASSERT(index >= _minIndex && index < endIndex());
+        return size_t(index - _minIndex);
+    }
+};
+
+} // namespace Quotient
@@ -44,12 +44,14 @@ Connection* User::connection() const
 
 void User::load()
 {
-    connection()->callApi<GetUserProfileJob>(id()).then([this](const auto* profileJob) {
-        d->defaultName = profileJob->displayname();
-        d->defaultAvatarUrl = profileJob->avatarUrl();
-        emit defaultNameChanged();
-        emit defaultAvatarChanged();
-    });
+    // Several rooms can ask for the same profile at once; only one request is needed
+    connection()->callApiCoalesced<GetUserProfileJob>(id()).then(
+        this, [this](const auto* profileJob) {
+            d->defaultName = profileJob->displayname();
+            d->defaultAvatarUrl = profileJob->avatarUrl();
+            emit defaultNameChanged();
+            emit defaultAvatarChanged();
+        });
 }
 
 QString User::id() const { return d->id; }
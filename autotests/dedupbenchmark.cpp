@@ -0,0 +1,133 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include <Quotient/events/roommessageevent.h>
+#include <Quotient/ranges_extras.h>
+
+#include <QtTest/QtTest>
+
+#include <random>
+
+using namespace Quotient;
+
+namespace {
+
+using EventPtrs = std::vector<const RoomEvent*>;
+
+const QString& eventId(const RoomEvent* e) { return e->id(); }
+
+//! The within-batch deduplication Room used to do, kept as a reference
+EventPtrs::iterator removeDuplicatesQuadratic(EventPtrs::iterator from, EventPtrs::iterator to)
+{
+    for (auto eIt = from; std::distance(eIt, to) > 1; ++eIt)
+        to = std::remove_if(eIt + 1, to, [eIt](const RoomEvent* e) { return e->id() == (*eIt)->id(); });
+    return to;
+}
+
+//! Make a batch of \p size events following a given duplication \p pattern
+RoomEvents makeBatch(int size, const QString& pattern)
+{
+    std::mt19937 rng(size); // Reproducible
+    RoomEvents batch;
+    batch.reserve(size_t(size));
+    for (int i = 0; i < size; ++i) {
+        int idNumber = i;
+        if (pattern == "all same"_L1)
+            idNumber = 0;
+        else if (pattern == "repeated halves"_L1) // Second half repeats the first one
+            idNumber = i % (size / 2);
+        else if (pattern == "mirrored"_L1) // Duplicates come in reverse order, farthest first
+            idNumber = std::min(i, size - 1 - i);
+        else if (pattern == "random 50%"_L1)
+            idNumber = int(rng() % unsigned(size / 2));
+        batch.push_back(loadEvent<RoomEvent>(QJsonObject{
+            { TypeKey, RoomMessageEvent::TypeId },
+            { EventIdKey, u"$event%1:example.org"_s.arg(idNumber) },
+            { SenderKey, u"@user:example.org"_s },
+            { ContentKey, QJsonObject{ { "msgtype"_L1, "m.text"_L1 },
+                                       { "body"_L1, QString::number(i) } } } }));
+    }
+    return batch;
+}
+
+EventPtrs pointers(const RoomEvents& events)
+{
+    EventPtrs result;
+    result.reserve(events.size());
+    for (const auto& e : events)
+        result.push_back(e.get());
+    return result;
+}
+
+} // namespace
+
+class DedupBenchmark : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void firstOccurrenceWins_data();
+    void firstOccurrenceWins();
+    void benchmarkDedup_data();
+    void benchmarkDedup();
+
+private:
+    static void addPatternRows(bool withQuadratic);
+};
+
+void DedupBenchmark::addPatternRows(bool withQuadratic)
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<bool>("quadratic");
+    for (const auto size : { 1000, 10'000 })
+        for (const auto& pattern :
+             { u"unique"_s, u"all same"_s, u"repeated halves"_s, u"mirrored"_s, u"random 50%"_s })
+            for (const auto quadratic : { false, true }) {
+                // The old algorithm takes too long on bigger batches to be worth measuring
+                if (quadratic && (!withQuadratic || size > 1000))
+                    continue;
+                QTest::addRow("%d, %s%s", size, qPrintable(pattern),
+                              quadratic ? ", quadratic" : "")
+                    << size << pattern << quadratic;
+            }
+}
+
+void DedupBenchmark::firstOccurrenceWins_data() { addPatternRows(false); }
+
+void DedupBenchmark::firstOccurrenceWins()
+{
+    QFETCH(int, size);
+    QFETCH(QString, pattern);
+    const auto batch = makeBatch(size, pattern);
+
+    auto expected = pointers(batch);
+    expected.erase(removeDuplicatesQuadratic(expected.begin(), expected.end()), expected.end());
+    auto actual = pointers(batch);
+    actual.erase(removeDuplicates(actual.begin(), actual.end(), eventId), actual.end());
+    // Same events (not only the same ids) in the same order
+    QCOMPARE(actual, expected);
+}
+
+void DedupBenchmark::benchmarkDedup_data() { addPatternRows(true); }
+
+void DedupBenchmark::benchmarkDedup()
+{
+    QFETCH(int, size);
+    QFETCH(QString, pattern);
+    QFETCH(bool, quadratic);
+    const auto batch = makeBatch(size, pattern);
+    const auto original = pointers(batch);
+
+    qsizetype keptCount = 0;
+    QBENCHMARK {
+        auto events = original;
+        const auto newEnd = quadratic ? removeDuplicatesQuadratic(events.begin(), events.end())
+                                      : removeDuplicates(events.begin(), events.end(), eventId);
+        keptCount = std::distance(events.begin(), newEnd);
+    }
+    QVERIFY(keptCount > 0);
+}
+
+QTEST_APPLESS_MAIN(DedupBenchmark)
+#include "dedupbenchmark.moc"
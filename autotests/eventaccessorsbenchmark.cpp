@@ -0,0 +1,98 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include <Quotient/events/roommessageevent.h>
+
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+class EventAccessorsBenchmark : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void headerFields();
+    void benchmarkIds();
+    void benchmarkSenderScan();
+    void benchmarkTimestamps();
+
+private:
+    static constexpr auto TimelineSize = 100'000;
+    static constexpr qint64 BaseTimestamp = 1'700'000'000'000;
+    RoomEvents timeline;
+};
+
+void EventAccessorsBenchmark::initTestCase()
+{
+    timeline.reserve(TimelineSize);
+    for (int i = 0; i < TimelineSize; ++i)
+        timeline.push_back(loadEvent<RoomEvent>(QJsonObject{
+            { TypeKey, RoomMessageEvent::TypeId },
+            { EventIdKey, u"$event%1:example.org"_s.arg(i) },
+            { RoomIdKey, u"!room:example.org"_s },
+            { SenderKey, u"@user%1:example.org"_s.arg(i % 100) },
+            { "origin_server_ts"_L1, BaseTimestamp + i },
+            { ContentKey, QJsonObject{ { "msgtype"_L1, "m.text"_L1 },
+                                       { "body"_L1, u"Message %1"_s.arg(i) } } },
+            { UnsignedKey, QJsonObject{ { "transaction_id"_L1, u"txn%1"_s.arg(i) } } } }));
+    QCOMPARE(timeline.size(), size_t(TimelineSize));
+}
+
+void EventAccessorsBenchmark::headerFields()
+{
+    const auto& e = timeline[42];
+    QCOMPARE(e->id(), u"$event42:example.org");
+    QCOMPARE(e->roomId(), u"!room:example.org");
+    QCOMPARE(e->senderId(), u"@user42:example.org");
+    QCOMPARE(e->transactionId(), u"txn42");
+    QVERIFY(e->stateKey().isEmpty());
+    QCOMPARE(e->originTimestampMs(), BaseTimestamp + 42);
+    QCOMPARE(e->originTimestamp(), QDateTime::fromMSecsSinceEpoch(BaseTimestamp + 42, Qt::UTC));
+
+    RoomMessageEvent pending(u"Pending"_s);
+    pending.setTransactionId(u"txn"_s);
+    pending.setSender(u"@me:example.org"_s);
+    pending.addId(u"$sent:example.org"_s);
+    QCOMPARE(pending.transactionId(), u"txn");
+    QCOMPARE(pending.senderId(), u"@me:example.org");
+    QCOMPARE(pending.id(), u"$sent:example.org");
+    QCOMPARE(pending.fullJson()[EventIdKey].toString(), pending.id());
+}
+
+void EventAccessorsBenchmark::benchmarkIds()
+{
+    qsizetype totalLength = 0;
+    QBENCHMARK {
+        for (const auto& e : timeline)
+            totalLength += e->id().size() + e->roomId().size() + e->transactionId().size();
+    }
+    QVERIFY(totalLength > 0);
+}
+
+void EventAccessorsBenchmark::benchmarkSenderScan()
+{
+    // Similar to what Room does looking for the last event of a given sender
+    const auto senderId = u"@user0:example.org"_s;
+    QBENCHMARK {
+        const auto it = std::find_if(timeline.crbegin(), timeline.crend(),
+                                     [&senderId](const RoomEventPtr& e) {
+                                         return e->senderId() == senderId && e->id().isEmpty();
+                                     });
+        QVERIFY(it == timeline.crend());
+    }
+}
+
+void EventAccessorsBenchmark::benchmarkTimestamps()
+{
+    qint64 maxTs = 0;
+    QBENCHMARK {
+        for (const auto& e : timeline)
+            maxTs = std::max(maxTs, e->originTimestampMs());
+    }
+    QCOMPARE(maxTs, BaseTimestamp + TimelineSize - 1);
+}
+
+QTEST_APPLESS_MAIN(EventAccessorsBenchmark)
+#include "eventaccessorsbenchmark.moc"
@@ -0,0 +1,165 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include <Quotient/idpool.h>
+
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+// A synthetic large account: every room has its members drawn from a common population
+constexpr auto RoomsCount = 4000;
+constexpr auto MembersPerRoom = 100;
+constexpr auto UsersCount = 20'000;
+
+// Each id "arrives" from JSON separately, so it doesn't share data with its other copies
+QString freshUserId(int n)
+{
+    return QString::fromUtf8(QByteArray("@user") + QByteArray::number(n)
+                             + ":some-homeserver.example.org");
+}
+
+int memberOf(int room, int n) { return (room * 7919 + n * 104729) % UsersCount; }
+
+//! Estimate the heap used by the string data, counting each shared buffer once
+qsizetype stringBytes(const auto& idsPerRoom)
+{
+    QSet<const QChar*> seenBuffers;
+    qsizetype bytes = 0;
+    for (const auto& ids : idsPerRoom)
+        for (const auto& id : ids) {
+            const auto& s = [&id]() -> const QString& {
+                if constexpr (std::is_same_v<std::decay_t<decltype(id)>, InternedId>)
+                    return id.toString();
+                else
+                    return id;
+            }();
+            if (!seenBuffers.contains(s.constData())) {
+                seenBuffers.insert(s.constData());
+                bytes += qsizetype(sizeof(QArrayData)) + (s.capacity() + 1) * qsizetype(sizeof(QChar));
+            }
+        }
+    return bytes;
+}
+
+} // namespace
+
+class IdPoolBenchmark : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void interning();
+    void squeezing();
+    void memorySavings();
+    void benchmarkLookup_data();
+    void benchmarkLookup();
+};
+
+void IdPoolBenchmark::interning()
+{
+    IdPool pool;
+    const auto id1 = pool.intern(freshUserId(1));
+    const auto id1again = pool.intern(freshUserId(1));
+    const auto id2 = pool.intern(freshUserId(2));
+    QCOMPARE(id1, id1again);
+    QVERIFY(id1 != id2);
+    QCOMPARE(qHash(id1), qHash(id1again));
+    QCOMPARE(id1.toString(), freshUserId(1));
+    QCOMPARE(pool.find(freshUserId(2)), id2);
+    QVERIFY(pool.find(freshUserId(3)).isNull());
+    QVERIFY(pool.find({}).isNull());
+    // An empty string is interned like any other; its handle is not the null one
+    const auto emptyId = pool.intern({});
+    QVERIFY(!emptyId.isNull());
+    QVERIFY(emptyId.isEmpty());
+    QCOMPARE(pool.find(QStringLiteral("")), emptyId);
+    QVERIFY(emptyId != InternedId());
+    QCOMPARE(pool.size(), qsizetype(3));
+    QCOMPARE(sizeof(InternedId), sizeof(void*));
+}
+
+void IdPoolBenchmark::squeezing()
+{
+    IdPool pool;
+    const auto kept = pool.intern(freshUserId(1));
+    pool.intern(freshUserId(2)); // Dropped right away
+    pool.squeeze();
+    QCOMPARE(pool.size(), qsizetype(1));
+    QCOMPARE(pool.find(freshUserId(1)), kept);
+    QVERIFY(pool.find(freshUserId(2)).isNull());
+
+    // Strings shared with the pool entries keep them, even without handles
+    auto sharedString = pool.intern(freshUserId(3)).toString();
+    pool.squeeze();
+    QVERIFY(!pool.find(freshUserId(3)).isNull());
+    sharedString.clear();
+    pool.squeeze();
+    QVERIFY(pool.find(freshUserId(3)).isNull());
+    QCOMPARE(pool.size(), qsizetype(1));
+}
+
+void IdPoolBenchmark::memorySavings()
+{
+    std::vector<QSet<QString>> plainMembers(RoomsCount);
+    for (int r = 0; r < RoomsCount; ++r)
+        for (int n = 0; n < MembersPerRoom; ++n)
+            plainMembers[size_t(r)].insert(freshUserId(memberOf(r, n)));
+
+    IdPool pool;
+    std::vector<QSet<InternedId>> internedMembers(RoomsCount);
+    for (int r = 0; r < RoomsCount; ++r)
+        for (int n = 0; n < MembersPerRoom; ++n)
+            internedMembers[size_t(r)].insert(pool.intern(freshUserId(memberOf(r, n))));
+
+    const auto plainBytes = stringBytes(plainMembers);
+    const auto internedBytes = stringBytes(internedMembers);
+    qInfo().nospace() << RoomsCount << " rooms x " << MembersPerRoom << " members out of "
+                      << UsersCount << " users: " << plainBytes / 1024 << " KiB of ids without "
+                      << "interning, " << internedBytes / 1024 << " KiB with interning ("
+                      << pool.size() << " distinct ids)";
+    QVERIFY(internedBytes < plainBytes);
+    QVERIFY(pool.size() <= UsersCount);
+}
+
+void IdPoolBenchmark::benchmarkLookup_data()
+{
+    QTest::addColumn<bool>("interned");
+    QTest::newRow("QString keys") << false;
+    QTest::newRow("InternedId keys") << true;
+}
+
+void IdPoolBenchmark::benchmarkLookup()
+{
+    QFETCH(bool, interned);
+    // Lookups with ids that are already at hand, as in the room's internal tables
+    IdPool pool;
+    QHash<QString, int> plainTable;
+    QHash<InternedId, int> internedTable;
+    std::vector<QString> plainKeys;
+    std::vector<InternedId> internedKeys;
+    for (int n = 0; n < UsersCount; ++n) {
+        plainKeys.push_back(freshUserId(n));
+        plainTable.insert(freshUserId(n), n);
+        internedKeys.push_back(pool.intern(freshUserId(n)));
+        internedTable.insert(internedKeys.back(), n);
+    }
+    qint64 sum = 0;
+    if (interned) {
+        QBENCHMARK {
+            for (const auto& k : internedKeys)
+                sum += internedTable.value(k);
+        }
+    } else {
+        QBENCHMARK {
+            for (const auto& k : plainKeys)
+                sum += plainTable.value(k);
+        }
+    }
+    QVERIFY(sum > 0);
+}
+
+QTEST_APPLESS_MAIN(IdPoolBenchmark)
+#include "idpoolbenchmark.moc"
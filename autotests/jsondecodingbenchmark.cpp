@@ -0,0 +1,287 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+#include <Quotient/jsonreader.h>
+
+#include <Quotient/csapi/keys.h>
+#include <Quotient/csapi/list_public_rooms.h>
+
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+// The shapes of responses that are large in real life: a server-wide room directory
+// and a key query for an account sharing rooms with many users
+constexpr auto PublicRoomsCount = 5'000;
+constexpr auto KeyQueryUsers = 500;
+constexpr auto DevicesPerUser = 8;
+
+QString userId(int n) { return u"@user%1:example.org"_s.arg(n); }
+
+QJsonObject publicRoomsResponse(int count)
+{
+    QJsonArray chunk;
+    for (int n = 0; n < count; ++n) {
+        QJsonObject room{ { "room_id"_L1, u"!room%1:example.org"_s.arg(n) },
+                          { "num_joined_members"_L1, count - n },
+                          { "world_readable"_L1, n % 2 == 0 },
+                          { "guest_can_join"_L1, n % 3 == 0 },
+                          { "name"_L1, u"Room \"%1\" – café ☕"_s.arg(n) },
+                          { "topic"_L1, u"A topic for room %1\nwith\ttabs"_s.arg(n) },
+                          { "join_rule"_L1, "public"_L1 } };
+        if (n % 4 != 0) {
+            room.insert("canonical_alias"_L1, u"#room%1:example.org"_s.arg(n));
+            room.insert("avatar_url"_L1, u"mxc://example.org/avatar%1"_s.arg(n));
+        }
+        chunk.append(room);
+    }
+    return { { "chunk"_L1, chunk },
+             { "next_batch"_L1, "p190q"_L1 },
+             { "total_room_count_estimate"_L1, count * 3 } };
+}
+
+QJsonObject keysQueryResponse(int usersCount, int devicesCount)
+{
+    QJsonObject deviceKeys;
+    QJsonObject masterKeys;
+    for (int u = 0; u < usersCount; ++u) {
+        QJsonObject devices;
+        for (int d = 0; d < devicesCount; ++d) {
+            const auto deviceId = u"DEVICE%1"_s.arg(d);
+            const auto keyBase = QByteArray::number(u * 100 + d).repeated(5).toBase64();
+            devices.insert(
+                deviceId,
+                QJsonObject{
+                    { "user_id"_L1, userId(u) },
+                    { "device_id"_L1, deviceId },
+                    { "algorithms"_L1, QJsonArray{ "m.olm.v1.curve25519-aes-sha2"_L1,
+                                                   "m.megolm.v1.aes-sha2"_L1 } },
+                    { "keys"_L1,
+                      QJsonObject{ { "curve25519:"_L1 + deviceId, QString::fromLatin1(keyBase) },
+                                   { "ed25519:"_L1 + deviceId,
+                                     QString::fromLatin1(keyBase + "ed") } } },
+                    { "signatures"_L1,
+                      QJsonObject{ { userId(u),
+                                     QJsonObject{ { "ed25519:"_L1 + deviceId,
+                                                    QString::fromLatin1(keyBase + "sig") } } } } },
+                    { "unsigned"_L1,
+                      QJsonObject{ { "device_display_name"_L1, u"Device %1"_s.arg(d) } } } });
+        }
+        deviceKeys.insert(userId(u), devices);
+        masterKeys.insert(userId(u),
+                          QJsonObject{ { "user_id"_L1, userId(u) },
+                                       { "usage"_L1, QJsonArray{ "master"_L1 } },
+                                       { "keys"_L1, QJsonObject{ { "ed25519:master"_L1,
+                                                                   u"masterkey%1"_s.arg(u) } } } });
+    }
+    return { { "failures"_L1, QJsonObject{} },
+             { "device_keys"_L1, deviceKeys },
+             { "master_keys"_L1, masterKeys } };
+}
+
+//! How the library decoded responses before: build a document, then convert each property
+template <typename ResponseT>
+ResponseT decodeViaDom(const QByteArray& json);
+
+template <>
+GetPublicRoomsJob::Response decodeViaDom(const QByteArray& json)
+{
+    const auto jo = QJsonDocument::fromJson(json).object();
+    return { fromJson<QVector<PublicRoomsChunk>>(jo.value("chunk"_L1)),
+             fromJson<QString>(jo.value("next_batch"_L1)),
+             fromJson<QString>(jo.value("prev_batch"_L1)),
+             fromJson<std::optional<int>>(jo.value("total_room_count_estimate"_L1)) };
+}
+
+template <>
+QueryKeysJob::Response decodeViaDom(const QByteArray& json)
+{
+    const auto jo = QJsonDocument::fromJson(json).object();
+    return { fromJson<QHash<QString, QJsonObject>>(jo.value("failures"_L1)),
+             fromJson<QHash<UserId, QHash<QString, QueryKeysJob::DeviceInformation>>>(
+                 jo.value("device_keys"_L1)),
+             fromJson<QHash<UserId, CrossSigningKey>>(jo.value("master_keys"_L1)),
+             fromJson<QHash<UserId, CrossSigningKey>>(jo.value("self_signing_keys"_L1)),
+             fromJson<QHash<UserId, CrossSigningKey>>(jo.value("user_signing_keys"_L1)) };
+}
+
+void comparePublicRooms(const GetPublicRoomsJob::Response& actual,
+                        const GetPublicRoomsJob::Response& expected)
+{
+    QCOMPARE(actual.chunk.size(), expected.chunk.size());
+    for (qsizetype i = 0; i < actual.chunk.size(); ++i) {
+        const auto &a = actual.chunk[i], &e = expected.chunk[i];
+        QCOMPARE(a.roomId, e.roomId);
+        QCOMPARE(a.numJoinedMembers, e.numJoinedMembers);
+        QCOMPARE(a.worldReadable, e.worldReadable);
+        QCOMPARE(a.guestCanJoin, e.guestCanJoin);
+        QCOMPARE(a.canonicalAlias, e.canonicalAlias);
+        QCOMPARE(a.name, e.name);
+        QCOMPARE(a.topic, e.topic);
+        QCOMPARE(a.avatarUrl, e.avatarUrl);
+        QCOMPARE(a.joinRule, e.joinRule);
+    }
+    QCOMPARE(actual.nextBatch, expected.nextBatch);
+    QCOMPARE(actual.prevBatch, expected.prevBatch);
+    QCOMPARE(actual.totalRoomCountEstimate, expected.totalRoomCountEstimate);
+}
+
+} // namespace
+
+class JsonDecodingBenchmark : public QObject {
+    Q_OBJECT
+
+    QByteArray publicRoomsJson =
+        QJsonDocument(publicRoomsResponse(PublicRoomsCount)).toJson(QJsonDocument::Compact);
+    QByteArray keysQueryJson = QJsonDocument(keysQueryResponse(KeyQueryUsers, DevicesPerUser))
+                                   .toJson(QJsonDocument::Compact);
+
+    StandInServer server{ [this](const StandInServer::Request& request) -> StandInServer::Reply {
+        if (request.path.endsWith("/publicRooms"_L1))
+            return publicRoomsResponse(10);
+        return {};
+    } };
+
+private Q_SLOTS:
+    void strings();
+    void malformedJson_data();
+    void malformedJson();
+    void sameAsDom();
+    void directJob();
+    void benchmarkPublicRooms_data();
+    void benchmarkPublicRooms();
+    void benchmarkKeysQuery_data();
+    void benchmarkKeysQuery();
+};
+
+void JsonDecodingBenchmark::strings()
+{
+    const auto json = R"({"plain": "text", "escaped": "a\"b\\c\/d\né😀",
+                         "lone": "x\ud800y\udc00z", "unknown": [1, {"a": null}], "n": 2.5e1})"_ba;
+    QCOMPARE(fromJsonBytes<QString>(json, u"plain"), std::optional(u"text"_s));
+    QCOMPARE(fromJsonBytes<QString>(json, u"escaped"), std::optional(u"a\"b\\c/d\né😀"_s));
+    QCOMPARE(fromJsonBytes<QString>(json, u"lone"), std::optional(u"x\uFFFDy\uFFFDz"_s));
+    QCOMPARE(fromJsonBytes<double>(json, u"n"), std::optional(25.0));
+    QCOMPARE(fromJsonBytes<int>(json, u"n"), std::optional(25));
+    QCOMPARE(fromJsonBytes<QString>(json, u"missing"), std::optional<QString>());
+    // Values of unexpected types give empty values, like QJsonValue::toString() etc. do
+    QCOMPARE(fromJsonBytes<QString>(json, u"unknown"), std::optional(QString()));
+    const QJsonArray unknownValue{ 1, QJsonObject{ { "a"_L1, QJsonValue::Null } } };
+    QCOMPARE(fromJsonBytes<QJsonValue>(json, u"unknown"), std::optional(QJsonValue(unknownValue)));
+}
+
+void JsonDecodingBenchmark::malformedJson_data()
+{
+    QTest::addColumn<QByteArray>("json");
+    QTest::newRow("empty") << ""_ba;
+    QTest::newRow("unterminated object") << R"({"chunk": [)"_ba;
+    QTest::newRow("missing colon") << R"({"chunk" []})"_ba;
+    QTest::newRow("missing comma") << R"({"chunk": [] "next_batch": "x"})"_ba;
+    QTest::newRow("trailing comma") << R"({"chunk": [],})"_ba;
+    QTest::newRow("bad escape") << R"({"next_batch": "\x"})"_ba;
+    QTest::newRow("bad number") << R"({"total_room_count_estimate": 01})"_ba;
+    QTest::newRow("bad literal") << R"({"chunk": [{"world_readable": ture}]})"_ba;
+    QTest::newRow("trailing data") << R"({"chunk": []} {})"_ba;
+    QTest::newRow("deep nesting") << QByteArray(2000, '[') + QByteArray(2000, ']');
+}
+
+void JsonDecodingBenchmark::malformedJson()
+{
+    QFETCH(QByteArray, json);
+    JsonReader reader(json);
+    reader.skipValue();
+    QVERIFY(!reader.atEnd());
+    const auto response = fromJsonBytes<GetPublicRoomsJob::Response>(json);
+    QVERIFY(response.chunk.isEmpty());
+    QVERIFY(response.nextBatch.isEmpty());
+    QVERIFY(!response.totalRoomCountEstimate);
+}
+
+void JsonDecodingBenchmark::sameAsDom()
+{
+    comparePublicRooms(fromJsonBytes<GetPublicRoomsJob::Response>(publicRoomsJson),
+                       decodeViaDom<GetPublicRoomsJob::Response>(publicRoomsJson));
+
+    const auto keys = fromJsonBytes<QueryKeysJob::Response>(keysQueryJson);
+    const auto expectedKeys = decodeViaDom<QueryKeysJob::Response>(keysQueryJson);
+    QCOMPARE(keys.deviceKeys.size(), qsizetype(KeyQueryUsers));
+    QCOMPARE(keys.deviceKeys.keys(), expectedKeys.deviceKeys.keys());
+    for (const auto& [user, devices] : keys.deviceKeys.asKeyValueRange())
+        for (const auto& [deviceId, device] : devices.asKeyValueRange()) {
+            const auto& expected = expectedKeys.deviceKeys[user][deviceId];
+            QCOMPARE(device.userId, expected.userId);
+            QCOMPARE(device.deviceId, expected.deviceId);
+            QCOMPARE(device.algorithms, expected.algorithms);
+            QCOMPARE(device.keys, expected.keys);
+            QCOMPARE(device.signatures, expected.signatures);
+            QVERIFY(device.unsignedData.has_value());
+            QCOMPARE(device.unsignedData->deviceDisplayName,
+                     expected.unsignedData->deviceDisplayName);
+        }
+    QCOMPARE(keys.masterKeys.size(), qsizetype(KeyQueryUsers));
+    for (const auto& [user, key] : keys.masterKeys.asKeyValueRange()) {
+        QCOMPARE(key.usage, expectedKeys.masterKeys[user].usage);
+        QCOMPARE(key.keys, expectedKeys.masterKeys[user].keys);
+    }
+    QVERIFY(keys.selfSigningKeys.isEmpty());
+}
+
+void JsonDecodingBenchmark::directJob()
+{
+    QVERIFY(server.isListening());
+    auto* connection = connectToStandInServer(server, userId(0));
+    auto job = connection->callApi<GetPublicRoomsJob>(10);
+    job->setDirectJsonDecoding();
+    QVERIFY(waitForFuture(job));
+    QVERIFY(job->status().good());
+    QVERIFY(job->jsonData().isEmpty()); // No document was built
+    const auto expectedJson = QJsonDocument(publicRoomsResponse(10)).toJson();
+    comparePublicRooms(collectResponse(job.get()),
+                       decodeViaDom<GetPublicRoomsJob::Response>(expectedJson));
+    QCOMPARE(job->chunk().size(), qsizetype(10)); // Accessors work too
+    QCOMPARE(job->totalRoomCountEstimate(), std::optional(30));
+    delete connection;
+}
+
+void JsonDecodingBenchmark::benchmarkPublicRooms_data()
+{
+    QTest::addColumn<bool>("direct");
+    QTest::newRow("QJsonDocument") << false;
+    QTest::newRow("field tables") << true;
+}
+
+void JsonDecodingBenchmark::benchmarkPublicRooms()
+{
+    QFETCH(bool, direct);
+    qsizetype roomsCount = 0;
+    QBENCHMARK {
+        roomsCount =
+            (direct ? fromJsonBytes<GetPublicRoomsJob::Response>(publicRoomsJson)
+                    : decodeViaDom<GetPublicRoomsJob::Response>(publicRoomsJson))
+                .chunk.size();
+    }
+    QCOMPARE(roomsCount, qsizetype(PublicRoomsCount));
+}
+
+void JsonDecodingBenchmark::benchmarkKeysQuery_data() { benchmarkPublicRooms_data(); }
+
+void JsonDecodingBenchmark::benchmarkKeysQuery()
+{
+    QFETCH(bool, direct);
+    qsizetype usersCount = 0;
+    QBENCHMARK {
+        usersCount = (direct ? fromJsonBytes<QueryKeysJob::Response>(keysQueryJson)
+                             : decodeViaDom<QueryKeysJob::Response>(keysQueryJson))
+                         .deviceKeys.size();
+    }
+    QCOMPARE(usersCount, qsizetype(KeyQueryUsers));
+}
+
+QTEST_MAIN(JsonDecodingBenchmark)
+#include "jsondecodingbenchmark.moc"
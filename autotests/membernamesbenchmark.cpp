@@ -0,0 +1,162 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+#include <Quotient/membernamesindex.h>
+#include <Quotient/room.h>
+#include <Quotient/syncdata.h>
+
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+// A big public room with lazy-loaded members: many members share a few common names
+constexpr auto MembersCount = 50'000;
+const auto RoomId = u"!names-test:example.org"_s;
+
+QString userId(int n) { return u"@user%1:example.org"_s.arg(n); }
+QString userName(int n) { return n % 10 == 0 ? u"Alex"_s : u"User %1"_s.arg(n); }
+
+QJsonObject memberEvent(int n)
+{
+    return { { TypeKey, u"m.room.member"_s },
+             { EventIdKey, u"$member%1:example.org"_s.arg(n) },
+             { SenderKey, userId(n) },
+             { StateKeyKey, userId(n) },
+             { "origin_server_ts"_L1, 1000 + n },
+             { ContentKey,
+               QJsonObject{ { "membership"_L1, "join"_L1 }, { "displayname"_L1, userName(n) } } } };
+}
+
+void syncState(Connection* c, const QString& nextBatch, const QJsonArray& stateEvents)
+{
+    const QJsonObject roomJson{ { "state"_L1, QJsonObject{ { "events"_L1, stateEvents } } } };
+    SyncData data;
+    data.parseJson({ { "next_batch"_L1, nextBatch },
+                     { "rooms"_L1, QJsonObject{ { "join"_L1, QJsonObject{ { RoomId, roomJson } } } } } });
+    syncMockConnection(c, std::move(data));
+}
+
+} // namespace
+
+class MemberNamesBenchmark : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void namesakes();
+    void batchedRoomUpdate();
+    void benchmarkFilling_data();
+    void benchmarkFilling();
+};
+
+void MemberNamesBenchmark::namesakes()
+{
+    IdPool pool;
+    MemberNamesIndex index(pool);
+    QVERIFY(index.insert(userId(1), u"Alice"_s));
+    QVERIFY(!index.insert(userId(1), u"Bob"_s));
+    QCOMPARE(index.nameOf(userId(1)), u"Alice"_s);
+    QCOMPARE(index.onlyMemberNamed(u"Alice"_s), userId(1));
+    QVERIFY(!index.needsDisambiguation(userId(1)));
+
+    QVERIFY(index.insert(userId(2), u"Alice"_s));
+    QVERIFY(index.onlyMemberNamed(u"Alice"_s).isEmpty());
+    QCOMPARE(index.onlyNamesakeOf(userId(1)), userId(2));
+    QCOMPARE(index.onlyNamesakeOf(userId(2)), userId(1));
+    QVERIFY(index.needsDisambiguation(userId(1)));
+
+    QVERIFY(index.insert(userId(3), u"Alice"_s));
+    QCOMPARE(index.namesakeCount(u"Alice"_s), qsizetype(3));
+    QVERIFY(index.onlyNamesakeOf(userId(1)).isEmpty());
+
+    QVERIFY(index.remove(userId(3)));
+    QVERIFY(!index.remove(userId(3)));
+    QVERIFY(index.remove(userId(2)));
+    QVERIFY(!index.needsDisambiguation(userId(1)));
+    QVERIFY(!index.needsDisambiguation(userId(2)));
+    QCOMPARE(index.userIds(), QStringList{ userId(1) });
+
+    // Members without a name are namesakes of each other
+    QVERIFY(index.insert(userId(4), {}));
+    QVERIFY(index.insert(userId(5), u""_s));
+    QVERIFY(index.needsDisambiguation(userId(4)));
+    QVERIFY(index.remove(userId(4)));
+    QCOMPARE(index.size(), qsizetype(2));
+}
+
+void MemberNamesBenchmark::batchedRoomUpdate()
+{
+    auto* connection = Connection::makeMockConnection(u"@alice:example.org"_s);
+    QJsonArray stateEvents;
+    for (int n = 0; n < 100; ++n)
+        stateEvents.append(memberEvent(n));
+    syncState(connection, u"s1"_s, stateEvents);
+    auto* room = connection->room(RoomId);
+    QVERIFY(room);
+    QVERIFY(room->needsDisambiguation(userId(10)));
+    QVERIFY(!room->needsDisambiguation(userId(11)));
+
+    // A second batch: another Alex joins and one of them is renamed
+    QSignalSpy namesUpdatedSpy(room, &Room::memberNamesUpdated);
+    QSignalSpy nameUpdatedSpy(room, &Room::memberNameUpdated);
+    QJsonArray moreEvents{ memberEvent(100) };
+    auto renamed = memberEvent(20);
+    renamed[EventIdKey] = u"$rename:example.org"_s;
+    renamed[ContentKey] = QJsonObject{ { "membership"_L1, "join"_L1 }, { "displayname"_L1, u"Sam"_s } };
+    moreEvents.append(renamed);
+    syncState(connection, u"s2"_s, moreEvents);
+    QCOMPARE(namesUpdatedSpy.size(), 1);
+    QCOMPARE(nameUpdatedSpy.size(), 0);
+    QVERIFY(namesUpdatedSpy.front().front().toStringList().contains(userId(20)));
+    QVERIFY(!room->needsDisambiguation(userId(20)));
+    QVERIFY(room->needsDisambiguation(userId(100)));
+}
+
+void MemberNamesBenchmark::benchmarkFilling_data()
+{
+    QTest::addColumn<bool>("multiHash");
+    QTest::newRow("QMultiHash of names") << true;
+    QTest::newRow("index") << false;
+}
+
+void MemberNamesBenchmark::benchmarkFilling()
+{
+    QFETCH(bool, multiHash);
+    QStringList ids;
+    QStringList names;
+    for (int n = 0; n < MembersCount; ++n) {
+        ids.append(userId(n));
+        names.append(userName(n));
+    }
+    // Filling the list of members of a lazy-loaded room the way it was done before, with
+    // a lookup of namesakes for each added member, vs. the index
+    QBENCHMARK {
+        if (multiHash) {
+            QMultiHash<QString, QString> memberNameMap;
+            for (int n = 0; n < MembersCount; ++n) {
+                const auto namesakes = memberNameMap.values(names[n]);
+                if (namesakes.contains(ids[n]))
+                    continue;
+                memberNameMap.insert(names[n], ids[n]);
+            }
+            QCOMPARE(memberNameMap.size(), qsizetype(MembersCount));
+        } else {
+            IdPool pool;
+            MemberNamesIndex index(pool);
+            for (int n = 0; n < MembersCount; ++n) {
+                index.onlyMemberNamed(names[n]);
+                index.insert(ids[n], names[n]);
+            }
+            QCOMPARE(index.size(), qsizetype(MembersCount));
+        }
+    }
+}
+
+QTEST_MAIN(MemberNamesBenchmark)
+#include "membernamesbenchmark.moc"
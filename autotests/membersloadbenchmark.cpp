@@ -0,0 +1,135 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+#include <Quotient/room.h>
+#include <Quotient/syncdata.h>
+
+#include <QtCore/QFutureWatcher>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+// The shape of a /members response for a big public room: most members have a display name
+// and an avatar; some names are common enough to need disambiguation
+constexpr auto MembersCount = 100'000;
+
+QString userId(int n) { return u"@user%1:example.org"_s.arg(n); }
+
+QJsonArray membersResponseChunk(int count)
+{
+    QJsonArray chunk;
+    for (int n = 0; n < count; ++n) {
+        QJsonObject content{ { "membership"_L1, "join"_L1 },
+                             { "displayname"_L1, n % 50 == 0 ? u"Alex"_s : u"User %1"_s.arg(n) } };
+        if (n % 3 != 0)
+            content.insert("avatar_url"_L1, u"mxc://example.org/avatar%1"_s.arg(n));
+        chunk.append(QJsonObject{ { TypeKey, u"m.room.member"_s },
+                                  { EventIdKey, u"$member%1:example.org"_s.arg(n) },
+                                  { SenderKey, userId(n) },
+                                  { StateKeyKey, userId(n) },
+                                  { "origin_server_ts"_L1, 1'000'000 + n },
+                                  { ContentKey, content } });
+    }
+    return chunk;
+}
+
+void syncState(Connection* c, const QString& roomId, const QJsonArray& stateEvents)
+{
+    const QJsonObject roomJson{ { "state"_L1, QJsonObject{ { "events"_L1, stateEvents } } } };
+    SyncData data;
+    data.parseJson({ { "next_batch"_L1, u"s_"_s + roomId },
+                     { "rooms"_L1, QJsonObject{ { "join"_L1, QJsonObject{ { roomId, roomJson } } } } } });
+    syncMockConnection(c, std::move(data));
+}
+
+void waitFor(const QFuture<void>& future)
+{
+    QEventLoop loop;
+    QFutureWatcher<void> watcher;
+    QObject::connect(&watcher, &QFutureWatcherBase::finished, &loop, &QEventLoop::quit);
+    watcher.setFuture(future);
+    if (!future.isFinished())
+        loop.exec();
+}
+
+} // namespace
+
+class MembersLoadBenchmark : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void mergedMembers();
+    void benchmarkLoading_data();
+    void benchmarkLoading();
+
+private:
+    Connection* connection = nullptr;
+    QJsonArray chunk;
+    int roomCounter = 0;
+
+    Room* makeRoom(const QJsonArray& stateEvents = {})
+    {
+        const auto roomId = u"!room%1:example.org"_s.arg(++roomCounter);
+        syncState(connection, roomId, stateEvents);
+        return connection->room(roomId);
+    }
+};
+
+void MembersLoadBenchmark::initTestCase()
+{
+    connection = Connection::makeMockConnection(u"@alice:example.org"_s);
+    chunk = membersResponseChunk(MembersCount);
+}
+
+void MembersLoadBenchmark::mergedMembers()
+{
+    // The only member known from the lazy-loaded state gets a namesake from the full list
+    auto* room = makeRoom(membersResponseChunk(1));
+    QVERIFY(room);
+    QCOMPARE(room->joinedMemberIds(), QStringList{ userId(0) });
+
+    QSignalSpy listChangedSpy(room, &Room::memberListChanged);
+    QSignalSpy joinedSpy(room, &Room::memberJoined);
+    QSignalSpy namesUpdatedSpy(room, &Room::memberNamesUpdated);
+    waitFor(room->mergeMembers(membersResponseChunk(1000)));
+    QCOMPARE(listChangedSpy.size(), 1);
+    QCOMPARE(joinedSpy.size(), 0);
+    QCOMPARE(namesUpdatedSpy.size(), 1);
+    QCOMPARE(room->joinedMemberIds().size(), 1000);
+    QCOMPARE(room->member(userId(999)).name(), u"User 999"_s);
+    QVERIFY(room->needsDisambiguation(userId(50)));
+    QVERIFY(!room->needsDisambiguation(userId(51)));
+}
+
+void MembersLoadBenchmark::benchmarkLoading_data()
+{
+    QTest::addColumn<bool>("bulk");
+    QTest::newRow("state events one by one") << false;
+    QTest::newRow("bulk merge") << true;
+}
+
+void MembersLoadBenchmark::benchmarkLoading()
+{
+    QFETCH(bool, bulk);
+    Room* room = nullptr;
+    QBENCHMARK_ONCE {
+        if (bulk) {
+            room = makeRoom();
+            waitFor(room->mergeMembers(chunk));
+        } else
+            room = makeRoom(chunk);
+    }
+    QVERIFY(room);
+    QCOMPARE(room->joinedMemberIds().size(), MembersCount);
+}
+
+QTEST_MAIN(MembersLoadBenchmark)
+#include "membersloadbenchmark.moc"
@@ -0,0 +1,155 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include <Quotient/readreceiptsindex.h>
+
+#include <QtTest/QtTest>
+
+#include <random>
+
+using namespace Quotient;
+
+namespace {
+
+// A big public room after an initial sync: thousands of users with receipts scattered over
+// the last events of a long timeline
+constexpr auto UsersCount = 20'000;
+constexpr auto TimelineSize = 10'000;
+
+QString userId(int n) { return u"@user%1:example.org"_s.arg(n); }
+QString eventId(int index) { return u"$event%1:example.org"_s.arg(index); }
+
+//! Who has read the event at \p index, the way it was done before - by scanning all receipts
+qsizetype countByScanning(const QHash<QString, int>& receipts, int index)
+{
+    return std::ranges::count_if(receipts,
+                                 [index](int receiptIndex) { return receiptIndex >= index; });
+}
+
+} // namespace
+
+class ReadReceiptsBenchmark : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void movingReceipts();
+    void detachedReceipts();
+    void historicalIndices();
+    void benchmarkSetting();
+    void benchmarkReadCount_data();
+    void benchmarkReadCount();
+};
+
+void ReadReceiptsBenchmark::movingReceipts()
+{
+    IdPool pool;
+    ReadReceiptsIndex index(pool);
+    index.setAt(userId(1), eventId(5), 5);
+    index.setAt(userId(2), eventId(5), 5);
+    index.setAt(userId(3), eventId(9), 9);
+    QCOMPARE(index.indexOf(userId(1)).value_or(-1), 5);
+    QCOMPARE(index.usersAt(5), (QSet<QString>{ userId(1), userId(2) }));
+    QCOMPARE(index.readCount(5), qsizetype(3));
+    QCOMPARE(index.readCount(6), qsizetype(1));
+    QCOMPARE(index.readCount(10), qsizetype(0));
+    QCOMPARE(index.usersReadUpTo(6), QSet<QString>{ userId(3) });
+
+    index.setAt(userId(1), eventId(7), 7);
+    QCOMPARE(index.usersAt(5), QSet<QString>{ userId(2) });
+    QCOMPARE(index.readCount(6), qsizetype(2));
+    QCOMPARE(index.usersReadUpTo(6), (QSet<QString>{ userId(1), userId(3) }));
+    QVERIFY(!index.indexOf(userId(4)));
+}
+
+void ReadReceiptsBenchmark::detachedReceipts()
+{
+    IdPool pool;
+    ReadReceiptsIndex index(pool);
+    // The receipt arrives before its event gets into the timeline
+    index.setDetached(userId(1), eventId(3));
+    QVERIFY(!index.indexOf(userId(1)));
+    QCOMPARE(index.usersAt(eventId(3)), QSet<QString>{ userId(1) });
+    QCOMPARE(index.readCount(0), qsizetype(0));
+
+    index.attach(eventId(3), 3);
+    QCOMPARE(index.indexOf(userId(1)).value_or(-1), 3);
+    QVERIFY(index.usersAt(eventId(3)).isEmpty());
+    QCOMPARE(index.usersAt(3), QSet<QString>{ userId(1) });
+    QCOMPARE(index.readCount(2), qsizetype(1));
+
+    // ...and the event gets evicted from the timeline later
+    index.detach(3, eventId(3));
+    QVERIFY(!index.indexOf(userId(1)));
+    QCOMPARE(index.usersAt(eventId(3)), QSet<QString>{ userId(1) });
+    QCOMPARE(index.readCount(2), qsizetype(0));
+
+    index.setAt(userId(1), eventId(4), 4);
+    QVERIFY(index.usersAt(eventId(3)).isEmpty());
+    QCOMPARE(index.readCount(4), qsizetype(1));
+}
+
+void ReadReceiptsBenchmark::historicalIndices()
+{
+    IdPool pool;
+    ReadReceiptsIndex index(pool);
+    // Historical events have negative indices
+    index.setAt(userId(1), eventId(-100), -100);
+    index.setAt(userId(2), eventId(-1), -1);
+    index.setAt(userId(3), eventId(0), 0);
+    index.setAt(userId(4), eventId(100), 100);
+    QCOMPARE(index.readCount(-1000), qsizetype(4));
+    QCOMPARE(index.readCount(-100), qsizetype(4));
+    QCOMPARE(index.readCount(-99), qsizetype(3));
+    QCOMPARE(index.readCount(-1), qsizetype(3));
+    QCOMPARE(index.readCount(0), qsizetype(2));
+    QCOMPARE(index.readCount(1), qsizetype(1));
+    QCOMPARE(index.readCount(101), qsizetype(0));
+}
+
+void ReadReceiptsBenchmark::benchmarkSetting()
+{
+    std::mt19937 rng(UsersCount);
+    std::vector<int> positions(UsersCount);
+    for (auto& p : positions)
+        p = TimelineSize - 1 - int(rng() % 500);
+    QBENCHMARK {
+        IdPool pool;
+        ReadReceiptsIndex index(pool);
+        for (int n = 0; n < UsersCount; ++n)
+            index.setAt(userId(n), eventId(positions[size_t(n)]), positions[size_t(n)]);
+    }
+}
+
+void ReadReceiptsBenchmark::benchmarkReadCount_data()
+{
+    QTest::addColumn<bool>("scanning");
+    QTest::newRow("scanning all receipts") << true;
+    QTest::newRow("index") << false;
+}
+
+void ReadReceiptsBenchmark::benchmarkReadCount()
+{
+    QFETCH(bool, scanning);
+    IdPool pool;
+    ReadReceiptsIndex index(pool);
+    QHash<QString, int> receipts;
+    std::mt19937 rng(UsersCount);
+    for (int n = 0; n < UsersCount; ++n) {
+        const auto position = TimelineSize - 1 - int(rng() % 500);
+        index.setAt(userId(n), eventId(position), position);
+        receipts.insert(userId(n), position);
+    }
+    QCOMPARE(index.readCount(TimelineSize - 250), countByScanning(receipts, TimelineSize - 250));
+
+    // What a client does to show read counts on the last screen of events
+    qsizetype total = 0;
+    QBENCHMARK {
+        for (int i = TimelineSize - 50; i < TimelineSize; ++i)
+            total += scanning ? countByScanning(receipts, i) : index.readCount(i);
+    }
+    QVERIFY(total > 0);
+}
+
+QTEST_APPLESS_MAIN(ReadReceiptsBenchmark)
+#include "readreceiptsbenchmark.moc"
@@ -0,0 +1,211 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include <Quotient/relationsindex.h>
+
+#include <Quotient/events/reactionevent.h>
+#include <Quotient/events/roommessageevent.h>
+
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+constexpr auto MessagesCount = 1000;
+constexpr auto ReactionsPerMessage = 100;
+constexpr auto KeysCount = 10;
+constexpr auto SendersCount = 60;
+
+const QStringList Keys{ u"👍"_s, u"👎"_s, u"😄"_s, u"🎉"_s, u"😕"_s,
+                        u"❤️"_s, u"🚀"_s, u"👀"_s, u"🙏"_s, u"🔥"_s };
+
+QString messageId(int n) { return u"$message%1:example.org"_s.arg(n); }
+QString senderId(int n) { return u"@user%1:example.org"_s.arg(n); }
+
+RoomEventPtr makeEvent(const QString& type, const QString& id, const QString& sender, qint64 ts,
+                       QJsonObject content)
+{
+    return loadEvent<RoomEvent>(QJsonObject{ { TypeKey, type },
+                                             { EventIdKey, id },
+                                             { SenderKey, sender },
+                                             { "origin_server_ts"_L1, ts },
+                                             { ContentKey, content } });
+}
+
+RoomEventPtr makeReaction(int n, const QString& targetId, const QString& key, const QString& sender)
+{
+    return makeEvent(ReactionEvent::TypeId, u"$reaction%1:example.org"_s.arg(n), sender, n,
+                     { { RelatesToKey, QJsonObject{ { RelTypeKey, EventRelation::AnnotationType },
+                                                    { EventIdKey, targetId },
+                                                    { "key"_L1, key } } } });
+}
+
+RoomEventPtr makeMessage(const QString& id, qint64 ts, std::optional<EventRelation> relation = {})
+{
+    QJsonObject content{ { "msgtype"_L1, "m.text"_L1 }, { "body"_L1, id } };
+    if (relation)
+        content.insert(RelatesToKey, toJson(*relation));
+    return makeEvent(RoomMessageEvent::TypeId, id, senderId(0), ts, content);
+}
+
+} // namespace
+
+class RelationsBenchmark : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void reactions();
+    void threads();
+    void edits();
+    void benchmarkIndexing();
+    void benchmarkCounts_data();
+    void benchmarkCounts();
+
+private:
+    // A reaction-heavy room: many users reacting to each message, often with the same keys,
+    // and sometimes twice with the same key
+    RoomEvents reactionEvents;
+};
+
+void RelationsBenchmark::initTestCase()
+{
+    reactionEvents.reserve(MessagesCount * ReactionsPerMessage);
+    for (int m = 0; m < MessagesCount; ++m)
+        for (int r = 0; r < ReactionsPerMessage; ++r)
+            reactionEvents.push_back(makeReaction(m * ReactionsPerMessage + r, messageId(m),
+                                                  Keys[(m + r) % KeysCount],
+                                                  senderId((m * 7 + r) % SendersCount)));
+}
+
+void RelationsBenchmark::reactions()
+{
+    IdPool pool;
+    RelationsIndex index(pool);
+    const auto target = messageId(1);
+    auto r1 = makeReaction(1, target, Keys[0], senderId(1));
+    auto r2 = makeReaction(2, target, Keys[0], senderId(2));
+    auto r1dup = makeReaction(3, target, Keys[0], senderId(1));
+    auto r3 = makeReaction(4, target, Keys[1], senderId(1));
+    QCOMPARE(index.add(*r1), target);
+    QCOMPARE(index.add(*r2), target);
+    QVERIFY(index.add(*r1dup).isEmpty()); // The same user, the same key
+    QCOMPARE(index.add(*r3), target);
+
+    QCOMPARE(index.reactionCount(target, Keys[0]), qsizetype(2));
+    QCOMPARE(index.reactionCount(target, Keys[1]), qsizetype(1));
+    QCOMPARE(index.reactionCount(target, Keys[2]), qsizetype(0));
+    QCOMPARE(index.reaction(target, Keys[0], senderId(1)), eventCast<const ReactionEvent>(r1));
+    QCOMPARE(index.relatedEvents(target, EventRelation::AnnotationType).size(), qsizetype(3));
+    auto keys = index.reactionKeys(target);
+    keys.sort();
+    auto expectedKeys = QStringList{ Keys[0], Keys[1] };
+    expectedKeys.sort();
+    QCOMPARE(keys, expectedKeys);
+
+    QVERIFY(index.remove(*r1dup).isEmpty()); // Never indexed
+    QCOMPARE(index.remove(*r1), target);
+    QCOMPARE(index.reactionCount(target, Keys[0]), qsizetype(1));
+    QCOMPARE(index.reactionSenders(target, Keys[0]), QStringList{ senderId(2) });
+    QCOMPARE(index.reaction(target, Keys[0], senderId(1)), nullptr);
+    index.remove(*r2);
+    index.remove(*r3);
+    QVERIFY(index.reactionKeys(target).isEmpty());
+    QVERIFY(index.relatedEvents(target, EventRelation::AnnotationType).isEmpty());
+}
+
+void RelationsBenchmark::threads()
+{
+    IdPool pool;
+    RelationsIndex index(pool);
+    const auto root = messageId(0);
+    const auto inThread = EventRelation::replyInThread(root, true, root);
+    auto reply1 = makeMessage(messageId(1), 100, inThread);
+    auto reply2 = makeMessage(messageId(2), 200, inThread);
+    auto reply = makeMessage(messageId(3), 300, EventRelation::replyTo(root));
+    // Historical events arrive in reverse order
+    QCOMPARE(index.add(*reply2), root);
+    QCOMPARE(index.add(*reply1), root);
+    QVERIFY(index.add(*reply).isEmpty());
+
+    QCOMPARE(index.threadRootIds(), QStringList{ root });
+    QCOMPARE(index.threadSummary(root).replyCount, qsizetype(2));
+    QCOMPARE(index.threadSummary(root).latestEvent, reply2.get());
+    QCOMPARE(index.replies(root), RelationsIndex::RelatedEvents{ reply.get() });
+
+    QCOMPARE(index.remove(*reply2), root);
+    QCOMPARE(index.threadSummary(root).replyCount, qsizetype(1));
+    QCOMPARE(index.threadSummary(root).latestEvent, reply1.get());
+    index.remove(*reply1);
+    QVERIFY(index.threadRootIds().isEmpty());
+    QCOMPARE(index.threadSummary(root).latestEvent, nullptr);
+}
+
+void RelationsBenchmark::edits()
+{
+    IdPool pool;
+    RelationsIndex index(pool);
+    const auto original = messageId(0);
+    auto edit1 = makeMessage(messageId(1), 100, EventRelation::replace(original));
+    auto edit2 = makeMessage(messageId(2), 200, EventRelation::replace(original));
+    auto edit3 = makeMessage(messageId(3), 300, EventRelation::replace(original));
+    // Each edit changes the aggregated edits of the original event
+    QCOMPARE(index.add(*edit2), original);
+    QCOMPARE(index.add(*edit3), original);
+    QCOMPARE(index.add(*edit1), original);
+    QCOMPARE(index.edits(original),
+             (RelationsIndex::RelatedEvents{ edit1.get(), edit2.get(), edit3.get() }));
+    QCOMPARE(index.latestEdit(original), edit3.get());
+    QCOMPARE(index.remove(*edit3), original);
+    QCOMPARE(index.latestEdit(original), edit2.get());
+    QCOMPARE(index.latestEdit(messageId(1)), nullptr);
+}
+
+void RelationsBenchmark::benchmarkIndexing()
+{
+    QBENCHMARK {
+        IdPool pool;
+        RelationsIndex index(pool);
+        for (const auto& e : reactionEvents)
+            index.add(*e);
+    }
+}
+
+void RelationsBenchmark::benchmarkCounts_data()
+{
+    QTest::addColumn<bool>("scanning");
+    QTest::newRow("scanning related events") << true;
+    QTest::newRow("aggregated counts") << false;
+}
+
+void RelationsBenchmark::benchmarkCounts()
+{
+    QFETCH(bool, scanning);
+    IdPool pool;
+    RelationsIndex index(pool);
+    for (const auto& e : reactionEvents)
+        index.add(*e);
+
+    // What a client does to show reactions under each message
+    qsizetype total = 0;
+    QBENCHMARK {
+        for (int m = 0; m < MessagesCount; ++m) {
+            const auto targetId = messageId(m);
+            if (scanning) {
+                const auto related = index.relatedEvents(targetId, EventRelation::AnnotationType);
+                for (const auto& key : Keys)
+                    total += std::ranges::count_if(related, [&key](const RoomEvent* e) {
+                        return eventCast<const ReactionEvent>(e)->key() == key;
+                    });
+            } else
+                for (const auto& key : Keys)
+                    total += index.reactionCount(targetId, key);
+        }
+    }
+    QVERIFY(total > 0);
+}
+
+QTEST_APPLESS_MAIN(RelationsBenchmark)
+#include "relationsbenchmark.moc"
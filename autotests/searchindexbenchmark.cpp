@@ -0,0 +1,140 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include <Quotient/searchindex.h>
+
+#include <QtCore/QRandomGenerator>
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+// A million short messages over a vocabulary of 20k words with a skewed (roughly Zipfian)
+// distribution, so that some words are in a big share of messages and most are rare
+constexpr auto MessagesCount = 1'000'000;
+constexpr auto RoomsCount = 200;
+constexpr auto VocabularySize = 20'000;
+constexpr auto WordsPerMessage = 8;
+constexpr qint64 BaseTimestamp = 1'700'000'000'000;
+const auto LocalUserId = u"@benchmark:example.org"_s;
+
+//! A pronounceable word made of syllables, unique for each \p n
+QString word(int n)
+{
+    static constexpr std::array<QStringView, 12> Syllables{ u"ka", u"lo", u"mi", u"nu",
+                                                            u"pe", u"ri", u"so", u"ta",
+                                                            u"ve", u"zo", u"bu", u"di" };
+    QString result;
+    do {
+        result += Syllables[size_t(n) % Syllables.size()];
+        n /= int(Syllables.size());
+    } while (n > 0);
+    return result;
+}
+
+QString roomId(int n) { return u"!room%1:example.org"_s.arg(n); }
+
+} // namespace
+
+class SearchIndexBenchmark : public QObject {
+    Q_OBJECT
+
+    std::unique_ptr<SearchIndex> index;
+    QStringList vocabulary;
+
+    void runQuery(const QString& query, const QStringList& roomIds = {});
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void commonWord();
+    void rareWord();
+    void commonAndRareWords();
+    void twoCommonWords();
+    void shortPrefix();
+    void singleRoom();
+    void nextPage();
+};
+
+void SearchIndexBenchmark::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    auto dbDir = LocalUserId;
+    dbDir.replace(u':', u'_');
+    const QString dbPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+                           % u'/' % dbDir % "/quotient_search.db3"_L1;
+    for (const auto& suffix : { ""_L1, "-wal"_L1, "-shm"_L1 })
+        QFile::remove(dbPath + suffix);
+
+    for (int n = 0; n < VocabularySize; ++n)
+        vocabulary.push_back(word(n));
+
+    index = std::make_unique<SearchIndex>(LocalUserId);
+    QRandomGenerator rng(42);
+    QElapsedTimer et;
+    et.start();
+    for (int n = 0; n < MessagesCount; ++n) {
+        QString text;
+        for (int w = 0; w < WordsPerMessage; ++w) {
+            const auto u = rng.generateDouble();
+            text += vocabulary[int(VocabularySize * u * u * u)] + u' ';
+        }
+        index->addMessage(roomId(n % RoomsCount), u"$event%1:example.org"_s.arg(n), LocalUserId,
+                          QDateTime::fromMSecsSinceEpoch(BaseTimestamp + qint64(n) * 1000, Qt::UTC),
+                          text);
+        // Don't let updates pile up in memory faster than the index thread applies them
+        if (n % 50'000 == 0)
+            index->search(vocabulary.front()).waitForFinished();
+    }
+    // A search only runs after all updates before it are applied
+    index->search(vocabulary.front()).waitForFinished();
+    qInfo() << "Indexed" << MessagesCount << "messages in" << et;
+}
+
+void SearchIndexBenchmark::cleanupTestCase() { index.reset(); }
+
+void SearchIndexBenchmark::runQuery(const QString& query, const QStringList& roomIds)
+{
+    SearchIndex::Results results;
+    QBENCHMARK {
+        results = index->search(query, roomIds).result();
+    }
+    QVERIFY(!results.hits.isEmpty());
+    QVERIFY(std::ranges::is_sorted(results.hits, std::greater{}, &SearchIndex::Hit::timestamp));
+}
+
+void SearchIndexBenchmark::commonWord() { runQuery(vocabulary[0] + u' '); }
+
+void SearchIndexBenchmark::rareWord() { runQuery(vocabulary[VocabularySize / 2] + u' '); }
+
+void SearchIndexBenchmark::commonAndRareWords()
+{
+    runQuery(vocabulary[1] + u' ' + vocabulary[VocabularySize / 3] + u' ');
+}
+
+void SearchIndexBenchmark::twoCommonWords() { runQuery(vocabulary[2] + u' ' + vocabulary[3]); }
+
+void SearchIndexBenchmark::shortPrefix() { runQuery(vocabulary[5].left(1)); }
+
+void SearchIndexBenchmark::singleRoom()
+{
+    runQuery(vocabulary[100] + u' ', { roomId(7) });
+}
+
+void SearchIndexBenchmark::nextPage()
+{
+    const QString query = vocabulary[4] + u' ';
+    const auto firstPage = index->search(query).result();
+    QVERIFY(!firstPage.nextBatch.isEmpty());
+    SearchIndex::Results results;
+    QBENCHMARK {
+        results = index->search(query, {}, 20, firstPage.nextBatch).result();
+    }
+    QVERIFY(!results.hits.isEmpty());
+    QVERIFY(results.hits.front().timestamp < firstPage.hits.back().timestamp);
+}
+
+QTEST_GUILESS_MAIN(SearchIndexBenchmark)
+#include "searchindexbenchmark.moc"
@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/accountregistry.h>
+#include <Quotient/connection.h>
+#include <Quotient/room.h>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtTest/QtTest>
+
+#include <atomic>
+
+using namespace Quotient;
+
+namespace {
+
+constexpr auto AccountsCount = 8;
+constexpr auto RoomsPerAccount = 100;
+constexpr auto MessagesPerRoom = 30;
+
+QString userId(int n) { return u"@user%1:example.org"_s.arg(n); }
+
+//! The first sync response for each account: many rooms, each with a bunch of messages
+QJsonObject makeSyncResponse()
+{
+    QJsonObject joinedRooms;
+    for (int room = 0; room < RoomsPerAccount; ++room) {
+        QJsonArray events;
+        for (int n = 0; n < MessagesPerRoom; ++n)
+            events.append(messageJson(u"$r%1-m%2:example.org"_s.arg(room).arg(n),
+                                      u"@sender:example.org"_s, 1'000'000 + n,
+                                      u"Message %1"_s.arg(n)));
+        const QJsonObject timelineJson{ { "events"_L1, events } };
+        joinedRooms.insert(u"!room%1:example.org"_s.arg(room),
+                           QJsonObject{ { "timeline"_L1, timelineJson } });
+    }
+    return { { "next_batch"_L1, "s1"_L1 },
+             { "rooms"_L1, QJsonObject{ { "join"_L1, joinedRooms } } } };
+}
+
+} // namespace
+
+class TestAccountThreads : public QObject {
+    Q_OBJECT
+
+    QJsonObject syncResponse = makeSyncResponse();
+    StandInServer server{ [this](const StandInServer::Request& request) -> StandInServer::Reply {
+        if (request.path.endsWith("/sync"_L1))
+            return syncResponse;
+        if (request.path.endsWith("/account/whoami"_L1))
+            return QJsonObject{ { "user_id"_L1, userId(0) } };
+        return {};
+    } };
+
+private Q_SLOTS:
+    void initTestCase();
+    void simultaneousCatchUp_data();
+    void simultaneousCatchUp();
+};
+
+void TestAccountThreads::initTestCase() { QVERIFY(server.isListening()); }
+
+void TestAccountThreads::simultaneousCatchUp_data()
+{
+    QTest::addColumn<AccountRegistry::ThreadingMode>("mode");
+    QTest::newRow("shared thread") << AccountRegistry::ThreadingMode::SharedThread;
+    QTest::newRow("thread per account") << AccountRegistry::ThreadingMode::ThreadPerAccount;
+}
+
+void TestAccountThreads::simultaneousCatchUp()
+{
+    QFETCH(AccountRegistry::ThreadingMode, mode);
+    AccountRegistry registry;
+    registry.setThreadingMode(mode);
+    for (int i = 0; i < AccountsCount; ++i) {
+        auto future = registry.createConnection(server.url());
+        QVERIFY(waitForFuture(future));
+        auto* connection = future.result();
+        QVERIFY(connection);
+        QCOMPARE(connection->thread() == thread(),
+                 mode == AccountRegistry::ThreadingMode::SharedThread);
+        QMetaObject::invokeMethod(connection, [connection, i, &registry] {
+            connection->enableEncryption(false);
+            connection->assumeIdentity(userId(i), u"DEVICE"_s, u"token"_s);
+            QMetaObject::invokeMethod(&registry, [connection, &registry] {
+                registry.add(connection);
+            });
+        });
+    }
+    QTRY_COMPARE(registry.size(), qsizetype(AccountsCount));
+    QVERIFY(registry.get(userId(AccountsCount - 1)));
+
+    // Each account counts its rooms with all messages in place once the sync is fully applied
+    std::atomic<int> accountsApplied = 0;
+    std::atomic<int> roomsApplied = 0;
+    std::atomic<bool> roomsOnConnectionThreads = true;
+    for (auto* connection : registry) {
+        connect(connection, &Connection::syncApplied, connection, [&, connection] {
+            for (const auto* room : connection->allRooms()) {
+                if (room->timelineSize() == MessagesPerRoom)
+                    ++roomsApplied;
+                if (room->thread() != connection->thread())
+                    roomsOnConnectionThreads = false;
+            }
+            ++accountsApplied;
+        });
+    }
+
+    // How long the main (GUI) thread is unavailable at worst; note that the stand-in server
+    // runs on this thread too
+    QElapsedTimer sinceTick;
+    qint64 maxStallMs = 0;
+    QTimer ticker;
+    ticker.setInterval(5);
+    connect(&ticker, &QTimer::timeout, this, [&sinceTick, &maxStallMs] {
+        maxStallMs = std::max(maxStallMs, sinceTick.restart());
+    });
+
+    QElapsedTimer et;
+    et.start();
+    sinceTick.start();
+    ticker.start();
+    for (auto* connection : registry)
+        QMetaObject::invokeMethod(connection, [connection] { connection->sync(0); });
+    QTRY_COMPARE_WITH_TIMEOUT(accountsApplied.load(), AccountsCount, 120'000);
+    ticker.stop();
+
+    QCOMPARE(roomsApplied.load(), AccountsCount * RoomsPerAccount);
+    QVERIFY(roomsOnConnectionThreads);
+    qInfo().noquote() << AccountsCount << "accounts caught up in" << et.elapsed()
+                      << "ms; the main thread stalled for up to" << maxStallMs << "ms";
+
+    if (mode == AccountRegistry::ThreadingMode::SharedThread)
+        qDeleteAll(registry.accounts());
+    // Otherwise, the registry deletes the connections along with their threads
+}
+
+QTEST_MAIN(TestAccountThreads)
+#include "testaccountthreads.moc"
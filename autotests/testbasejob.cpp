@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+
+#include <QtCore/QJsonArray>
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+constexpr auto ItemsCount = 10'000;
+
+class LargeResponseJob : public BaseJob {
+public:
+    LargeResponseJob()
+        : BaseJob(HttpVerb::Get, u"LargeResponseJob"_s, "/_matrix/client/v3/large"_ba)
+    {}
+};
+
+} // namespace
+
+class TestBaseJob : public QObject {
+    Q_OBJECT
+
+    StandInServer server{ [](const StandInServer::Request& request) -> StandInServer::Reply {
+        if (!request.path.endsWith("/large"_L1))
+            return {};
+        QJsonArray items;
+        for (int i = 0; i < ItemsCount; ++i)
+            items.append(u"item number %1"_s.arg(i));
+        return QJsonObject{ { "items"_L1, items } };
+    } };
+
+private Q_SLOTS:
+    void initTestCase() { QVERIFY(server.isListening()); }
+    void oversizedResponse();
+};
+
+void TestBaseJob::oversizedResponse()
+{
+    std::unique_ptr<Connection> connection{ connectToStandInServer(server,
+                                                                   u"@tester:example.org"_s) };
+    QByteArray rawData;
+    QString sample;
+    QJsonArray items;
+    auto job = connection->callApi<LargeResponseJob>().then([&](LargeResponseJob* j) {
+        rawData = j->rawData();
+        sample = j->rawDataSample(100);
+        items = j->jsonData().value("items"_L1).toArray();
+    });
+    QVERIFY(waitForFuture(job));
+    const auto fullSize = server.bytesSent.value(u"/_matrix/client/v3/large"_s);
+    QVERIFY(fullSize > 65536);
+
+    // The parsed response is complete, only the raw bytes are cut down to 64 KiB
+    QCOMPARE(items.size(), qsizetype(ItemsCount));
+    QCOMPARE(items.last().toString(), u"item number %1"_s.arg(ItemsCount - 1));
+    QCOMPARE(rawData.size(), qsizetype(65536));
+    QVERIFY(rawData.startsWith(R"({"items":["item number 0",)"));
+    QVERIFY(sample.startsWith(QString::fromUtf8(rawData.left(100))));
+    QVERIFY(sample.contains("truncated"_L1));
+}
+
+QTEST_GUILESS_MAIN(TestBaseJob)
+#include "testbasejob.moc"
@@ -0,0 +1,247 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+#include <Quotient/eventstats.h>
+#include <Quotient/room.h>
+#include <Quotient/syncdata.h>
+
+#include <Quotient/events/roommessageevent.h>
+
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+const auto RoomId = u"!stats-test:example.org"_s;
+const auto LocalUserId = u"@alice:example.org"_s;
+const auto OtherUserId = u"@bob:example.org"_s;
+
+//! A room that highlights messages mentioning the local user
+class HighlightingRoom : public NoticesTogglingRoom {
+public:
+    using NoticesTogglingRoom::NoticesTogglingRoom;
+
+protected:
+    Notification checkForNotifications(const TimelineItem& ti) override
+    {
+        const auto* rme = ti.viewAs<RoomMessageEvent>();
+        return { rme && rme->plainBody().contains("alice"_L1) ? Notification::Highlight
+                                                              : Notification::None };
+    }
+};
+
+QJsonObject redaction(int n, int target)
+{
+    return { { TypeKey, u"m.room.redaction"_s },
+             { EventIdKey, numberedEventId(n) },
+             { SenderKey, OtherUserId },
+             { "origin_server_ts"_L1, 1000 + n },
+             { "redacts"_L1, numberedEventId(target) },
+             { ContentKey, QJsonObject{} } };
+}
+
+QJsonObject edit(int n, int target, const QString& newBody)
+{
+    const QJsonObject newContent{ { "msgtype"_L1, "m.text"_L1 }, { "body"_L1, newBody } };
+    return messageJson(numberedEventId(n), OtherUserId, 1000 + n, u"* "_s + newBody,
+                       { { "m.new_content"_L1, newContent },
+                         { RelatesToKey,
+                           toJson(EventRelation::replace(numberedEventId(target))) } });
+}
+
+QJsonObject fullyRead(int target)
+{
+    return { { TypeKey, u"m.fully_read"_s },
+             { ContentKey, QJsonObject{ { "event_id"_L1, numberedEventId(target) } } } };
+}
+
+void sync(Connection* c, const QString& nextBatch, const QJsonArray& timeline,
+          const QJsonArray& ephemeral = {}, const QJsonArray& accountData = {})
+{
+    const QJsonObject timelineJson{ { "events"_L1, timeline },
+                                    { "limited"_L1, false },
+                                    { "prev_batch"_L1, u"p_"_s + nextBatch } };
+    const QJsonObject roomJson{ { "timeline"_L1, timelineJson },
+                                { "ephemeral"_L1, QJsonObject{ { "events"_L1, ephemeral } } },
+                                { "account_data"_L1, QJsonObject{ { "events"_L1, accountData } } } };
+    SyncData data;
+    data.parseJson({ { "next_batch"_L1, nextBatch },
+                     { "rooms"_L1, QJsonObject{ { "join"_L1, QJsonObject{ { RoomId, roomJson } } } } } });
+    syncMockConnection(c, std::move(data));
+}
+
+//! Count notable and highlighted events by going through the range, the way it used to be done
+EventStats scan(const Room* room, Room::rev_iter_t from, const Room::rev_iter_t& to)
+{
+    EventStats stats{ 0, 0, false };
+    for (; from != to; ++from) {
+        stats.notableCount += room->isEventNotable(*from);
+        stats.highlightCount += room->notificationFor(*from).type == Notification::Highlight;
+    }
+    return stats;
+}
+
+//! Compare counts over every range of the timeline with the result of scanning it
+bool countsMatchScanning(const Room* room)
+{
+    const auto begin = Room::rev_iter_t(room->syncEdge());
+    for (auto from = begin; from != room->historyEdge(); ++from)
+        for (auto to = from; to <= room->historyEdge(); ++to)
+            if (room->countEvents(from, to) != scan(room, from, to)) {
+                qWarning() << "Counts mismatch between indices" << from->index() << "and"
+                           << (to - 1)->index() << "- counted" << room->countEvents(from, to)
+                           << "but scanned" << scan(room, from, to);
+                return false;
+            }
+    return true;
+}
+
+} // namespace
+
+class TestEventStats : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void countsOnInsertion();
+    void countsOnRedactionAndReplacement();
+    void statsInvariants();
+    void countsAreSnapshots();
+};
+
+void TestEventStats::initTestCase() { Connection::setRoomType<HighlightingRoom>(); }
+
+void TestEventStats::countsOnInsertion()
+{
+    auto* connection = Connection::makeMockConnection(LocalUserId);
+    sync(connection, u"s1"_s,
+         { numberedMessage(1), numberedMessage(2, LocalUserId),
+           numberedMessage(3, OtherUserId, u"Hi alice"_s),
+           numberedMessage(4, OtherUserId, u"Beep"_s, u"m.notice"_s), numberedMessage(5) });
+    auto* room = connection->room(RoomId);
+    QVERIFY(room);
+    QCOMPARE(room->countEvents(Room::rev_iter_t(room->syncEdge()), room->historyEdge()),
+             (EventStats{ 3, 1, false }));
+    QVERIFY(countsMatchScanning(room));
+
+    sync(connection, u"s2"_s,
+         { numberedMessage(6, OtherUserId, u"alice?"_s), numberedMessage(7, LocalUserId),
+           numberedMessage(8) });
+    QCOMPARE(room->countEvents(Room::rev_iter_t(room->syncEdge()), room->historyEdge()),
+             (EventStats{ 5, 2, false }));
+    QVERIFY(countsMatchScanning(room));
+}
+
+void TestEventStats::countsOnRedactionAndReplacement()
+{
+    auto* connection = Connection::makeMockConnection(LocalUserId);
+    QJsonArray events;
+    for (int n = 1; n <= 20; ++n)
+        events.append(numberedMessage(n, n % 3 == 0 ? LocalUserId : OtherUserId,
+                                      n % 4 == 0 ? u"Ping alice"_s : u"Hello"_s));
+    sync(connection, u"s1"_s, events);
+    auto* room = connection->room(RoomId);
+    QVERIFY(room);
+    QVERIFY(countsMatchScanning(room));
+
+    // Redacted events stop being notable; edits are not notable themselves
+    sync(connection, u"s2"_s, { redaction(21, 4), redaction(22, 5), edit(23, 7, u"Edited"_s) });
+    QVERIFY(!room->isEventNotable(*room->findInTimeline(numberedEventId(5))));
+    QVERIFY(!room->isEventNotable(*room->findInTimeline(numberedEventId(23))));
+    QVERIFY(countsMatchScanning(room));
+}
+
+void TestEventStats::statsInvariants()
+{
+    auto* connection = Connection::makeMockConnection(LocalUserId);
+    QJsonArray events;
+    for (int n = 1; n <= 10; ++n)
+        events.append(numberedMessage(n, OtherUserId, n % 2 == 0 ? u"Ping alice"_s : u"Hello"_s));
+    sync(connection, u"s1"_s, events, { readReceipt(LocalUserId, 6) }, { fullyRead(4) });
+    auto* room = connection->room(RoomId);
+    QVERIFY(room);
+
+    const auto checkInvariants = [room] {
+        const auto receiptMarker = room->localReadReceiptMarker();
+        const auto fullyReadMarker = room->fullyReadMarker();
+        QVERIFY(room->unreadStats().isValidFor(room, receiptMarker));
+        QVERIFY(room->partiallyReadStats().isValidFor(room, fullyReadMarker));
+        QVERIFY(!room->unreadStats().isEstimate);
+        QVERIFY(!room->partiallyReadStats().isEstimate);
+        const auto syncEdge = Room::rev_iter_t(room->syncEdge());
+        QCOMPARE(room->unreadStats(), scan(room, syncEdge, receiptMarker));
+        QCOMPARE(room->partiallyReadStats(), scan(room, syncEdge, fullyReadMarker));
+        QCOMPARE(room->unreadStats(), EventStats::fromMarker(room, receiptMarker));
+    };
+    QCOMPARE(room->unreadStats(), (EventStats{ 4, 2, false }));
+    QCOMPARE(room->partiallyReadStats(), (EventStats{ 6, 3, false }));
+    checkInvariants();
+
+    // New events add up to both statistics
+    sync(connection, u"s2"_s,
+         { numberedMessage(11), numberedMessage(12, OtherUserId, u"alice!"_s) });
+    QCOMPARE(room->unreadStats(), (EventStats{ 6, 3, false }));
+    checkInvariants();
+
+    // Redacting an unread event updates the statistics right away; redacting a read one doesn't
+    QSignalSpy unreadSpy(room, &Room::unreadStatsChanged);
+    sync(connection, u"s3"_s, { redaction(13, 11), redaction(14, 2) });
+    QCOMPARE(unreadSpy.size(), 1);
+    QCOMPARE(room->unreadStats(), (EventStats{ 5, 3, false }));
+    checkInvariants();
+
+    // Moving the markers subtracts the events in between
+    sync(connection, u"s4"_s, {}, { readReceipt(LocalUserId, 9) }, { fullyRead(8) });
+    QCOMPARE(room->unreadStats(), (EventStats{ 2, 2, false }));
+    checkInvariants();
+}
+
+void TestEventStats::countsAreSnapshots()
+{
+    auto* connection = Connection::makeMockConnection(LocalUserId);
+    QJsonArray events;
+    for (int n = 1; n <= 8; ++n)
+        events.append(
+            numberedMessage(n, OtherUserId, u"Hello"_s, n % 2 == 0 ? u"m.notice"_s : u"m.text"_s));
+    sync(connection, u"s1"_s, events, { readReceipt(LocalUserId, 4) });
+    auto* room = connection->room(RoomId);
+    QVERIFY(room);
+    const auto wholeTimeline = [room] {
+        return room->countEvents(Room::rev_iter_t(room->syncEdge()), room->historyEdge());
+    };
+    QCOMPARE(wholeTimeline(), (EventStats{ 4, 0, false }));
+    QCOMPARE(room->unreadStats(), (EventStats{ 2, 0, false }));
+
+    // Changing what isEventNotable() returns doesn't change the counts by itself...
+    HighlightingRoom::noticesAreNotable = true;
+    QCOMPARE(wholeTimeline(), (EventStats{ 4, 0, false }));
+    QCOMPARE(room->unreadStats(), (EventStats{ 2, 0, false }));
+
+    // ...an edit of a notice, counted when it was not notable, only recounts that event...
+    sync(connection, u"s2"_s, { edit(9, 6, u"Edited"_s) });
+    QCOMPARE(wholeTimeline(), (EventStats{ 5, 0, false }));
+    QCOMPARE(room->unreadStats(), (EventStats{ 3, 0, false }));
+
+    // ...and recountEvents() counts everything anew
+    QSignalSpy unreadSpy(room, &Room::unreadStatsChanged);
+    room->recountEvents();
+    QCOMPARE(unreadSpy.size(), 1);
+    QVERIFY(countsMatchScanning(room));
+    QCOMPARE(wholeTimeline(), (EventStats{ 8, 0, false }));
+    QCOMPARE(room->unreadStats(), (EventStats{ 4, 0, false }));
+
+    HighlightingRoom::noticesAreNotable = false;
+    room->recountEvents();
+    QCOMPARE(unreadSpy.size(), 2);
+    QVERIFY(countsMatchScanning(room));
+    QCOMPARE(room->unreadStats(), (EventStats{ 3, 0, false }));
+}
+
+QTEST_MAIN(TestEventStats)
+#include "testeventstats.moc"
@@ -0,0 +1,241 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+#include <Quotient/eventstore.h>
+#include <Quotient/util.h>
+
+#include <QtCore/QFile>
+#include <QtCore/QJsonObject>
+#include <QtCore/QStandardPaths>
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+const auto UserId = u"@archivist:example.org"_s;
+const auto RoomId = u"!archive:example.org"_s;
+const auto OtherRoomId = u"!other:example.org"_s;
+const auto ConnectionUserId = u"@connected-archivist:example.org"_s;
+
+QString storeFilePath(const QString& userId)
+{
+    auto dbDir = userId;
+    dbDir.replace(u':', u'_');
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) % u'/' % dbDir
+           % "/quotient_events.db3"_L1;
+}
+
+//! Events \p from to \p to, in chronological order or, if \p from > \p to, in reverse
+QJsonArray messages(int from, int to)
+{
+    QJsonArray events;
+    for (int n = from; from <= to ? n <= to : n >= to; from <= to ? ++n : --n)
+        events.append(numberedMessage(n));
+    return events;
+}
+
+QStringList idsOf(const QJsonArray& events)
+{
+    QStringList ids;
+    for (const auto& e : events)
+        ids.push_back(e["event_id"_L1].toString());
+    return ids;
+}
+
+QStringList eventIds(int from, int to) { return idsOf(messages(from, to)); }
+
+//! \brief Write buffered events and wait until \p eventId can be read back
+//!
+//! If \p stored is false, wait until it can no longer be read instead.
+bool flushAndWait(EventStore& store, const QString& roomId, const QString& eventId,
+                  bool stored = true)
+{
+    store.flush();
+    return QTest::qWaitFor(
+        [&] { return store.loadHistory(roomId, eventId, 1).has_value() == stored; });
+}
+
+} // namespace
+
+class TestEventStore : public QObject {
+    Q_OBJECT
+
+    std::unique_ptr<EventStore> store;
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void newEvents();
+    void historicalEvents();
+    void relatedEvents();
+    void persistence();
+    void clearRoom();
+    void purge();
+};
+
+void TestEventStore::initTestCase() { QStandardPaths::setTestModeEnabled(true); }
+
+void TestEventStore::init()
+{
+    // Start from scratch; destroying the store waits until the clearing is written. Only one
+    // store for the account can exist at a time, as they share database connection names.
+    store = std::make_unique<EventStore>(UserId);
+    for (const auto& roomId : { RoomId, OtherRoomId })
+        store->clearRoom(roomId);
+    store.reset();
+    store = std::make_unique<EventStore>(UserId);
+}
+
+void TestEventStore::cleanup() { store.reset(); }
+
+void TestEventStore::newEvents()
+{
+    store->storeNewEvents(RoomId, messages(1, 5), false, u"t0"_s);
+    QVERIFY(flushAndWait(*store, RoomId, numberedEventId(5)));
+
+    // Events come back in reverse-chronological order, with the full JSON
+    auto batch = store->loadHistory(RoomId, numberedEventId(5), 2);
+    QVERIFY(batch);
+    QCOMPARE(idsOf(batch->events), eventIds(4, 3));
+    QCOMPARE(batch->events.first().toObject(), numberedMessage(4));
+    QVERIFY(!batch->chunkExhausted);
+    batch = store->loadHistory(RoomId, numberedEventId(3), 10);
+    QVERIFY(batch);
+    QCOMPARE(idsOf(batch->events), eventIds(2, 1));
+    QVERIFY(batch->chunkExhausted);
+    QCOMPARE(batch->prevBatch, u"t0"_s);
+
+    // A sync without a gap continues the same chunk
+    store->storeNewEvents(RoomId, messages(6, 7), false, u"t1"_s);
+    QVERIFY(flushAndWait(*store, RoomId, numberedEventId(7)));
+    batch = store->loadHistory(RoomId, numberedEventId(7), 10);
+    QVERIFY(batch);
+    QCOMPARE(idsOf(batch->events), eventIds(6, 1));
+
+    // A limited sync starts a new one, so history before it comes from its token
+    store->storeNewEvents(RoomId, messages(20, 22), true, u"t2"_s);
+    QVERIFY(flushAndWait(*store, RoomId, numberedEventId(22)));
+    batch = store->loadHistory(RoomId, numberedEventId(22), 10);
+    QVERIFY(batch);
+    QCOMPARE(idsOf(batch->events), eventIds(21, 20));
+    QVERIFY(batch->chunkExhausted);
+    QCOMPARE(batch->prevBatch, u"t2"_s);
+
+    // Events that are not stored have no history
+    QVERIFY(!store->loadHistory(RoomId, numberedEventId(100), 10));
+    QVERIFY(!store->loadHistory(OtherRoomId, numberedEventId(5), 10));
+}
+
+void TestEventStore::historicalEvents()
+{
+    store->storeNewEvents(RoomId, messages(10, 12), false, u"t10"_s);
+    QVERIFY(flushAndWait(*store, RoomId, numberedEventId(12)));
+
+    // History loaded from the server goes before the anchor and takes over the chunk token
+    store->storeHistoricalEvents(RoomId, numberedEventId(10), messages(9, 6), u"t6"_s);
+    QVERIFY(flushAndWait(*store, RoomId, numberedEventId(6)));
+    auto batch = store->loadHistory(RoomId, numberedEventId(10), 3);
+    QVERIFY(batch);
+    QCOMPARE(idsOf(batch->events), eventIds(9, 7));
+    QVERIFY(!batch->chunkExhausted);
+    batch = store->loadHistory(RoomId, numberedEventId(7), 3);
+    QVERIFY(batch);
+    QCOMPARE(idsOf(batch->events), eventIds(6, 6));
+    QVERIFY(batch->chunkExhausted);
+    QCOMPARE(batch->prevBatch, u"t6"_s);
+
+    // Reaching the room start leaves no token
+    store->storeHistoricalEvents(RoomId, numberedEventId(6), messages(5, 1), {});
+    QVERIFY(flushAndWait(*store, RoomId, numberedEventId(1)));
+    batch = store->loadHistory(RoomId, numberedEventId(12), 100);
+    QVERIFY(batch);
+    QCOMPARE(idsOf(batch->events), eventIds(11, 1));
+    QVERIFY(batch->chunkExhausted);
+    QVERIFY(batch->prevBatch.isEmpty());
+
+    // History before an anchor that already has stored history is not stored again
+    store->storeHistoricalEvents(RoomId, numberedEventId(12), messages(50, 49), u"t49"_s);
+    store->storeNewEvents(RoomId, messages(13, 13), false, {});
+    QVERIFY(flushAndWait(*store, RoomId, numberedEventId(13)));
+    QVERIFY(!store->loadHistory(RoomId, numberedEventId(50), 1));
+}
+
+void TestEventStore::relatedEvents()
+{
+    QJsonArray events = messages(1, 3);
+    events.append(numberedReaction(4, 1));
+    events.append(numberedReaction(5, 2));
+    events.append(numberedReaction(6, 1));
+    store->storeNewEvents(RoomId, events, false, u"t0"_s);
+    QVERIFY(flushAndWait(*store, RoomId, numberedEventId(6)));
+
+    QCOMPARE(idsOf(store->loadRelatedEvents(RoomId, numberedEventId(1))),
+             (QStringList{ numberedEventId(4), numberedEventId(6) }));
+    QCOMPARE(idsOf(store->loadRelatedEvents(RoomId, numberedEventId(2), u"m.annotation"_s)),
+             QStringList{ numberedEventId(5) });
+    QVERIFY(store->loadRelatedEvents(RoomId, numberedEventId(2), u"m.replace"_s).isEmpty());
+    QVERIFY(store->loadRelatedEvents(RoomId, numberedEventId(3)).isEmpty());
+}
+
+void TestEventStore::persistence()
+{
+    store->storeNewEvents(RoomId, messages(1, 3), false, u"t0"_s);
+    // Destroying the store writes everything buffered
+    store.reset();
+    store = std::make_unique<EventStore>(UserId);
+    const auto batch = store->loadHistory(RoomId, numberedEventId(3), 10);
+    QVERIFY(batch);
+    QCOMPARE(idsOf(batch->events), eventIds(2, 1));
+    QCOMPARE(batch->prevBatch, u"t0"_s);
+}
+
+void TestEventStore::clearRoom()
+{
+    store->storeNewEvents(RoomId, messages(1, 3), false, u"t0"_s);
+    store->storeNewEvents(OtherRoomId, messages(11, 13), false, u"t10"_s);
+    QVERIFY(flushAndWait(*store, RoomId, numberedEventId(3)));
+    QVERIFY(flushAndWait(*store, OtherRoomId, numberedEventId(13)));
+
+    store->clearRoom(RoomId);
+    QVERIFY(flushAndWait(*store, RoomId, numberedEventId(3), false));
+    QVERIFY(store->loadRelatedEvents(RoomId, numberedEventId(1)).isEmpty());
+    const auto batch = store->loadHistory(OtherRoomId, numberedEventId(13), 10);
+    QVERIFY(batch);
+    QCOMPARE(idsOf(batch->events), eventIds(12, 11));
+
+    // The room can be filled again from scratch
+    store->storeNewEvents(RoomId, messages(5, 6), false, u"t4"_s);
+    QVERIFY(flushAndWait(*store, RoomId, numberedEventId(6)));
+    QCOMPARE(store->loadHistory(RoomId, numberedEventId(6), 10)->prevBatch, u"t4"_s);
+}
+
+void TestEventStore::purge()
+{
+    store->storeNewEvents(RoomId, messages(1, 3), false, u"t0"_s);
+    store.reset();
+    QVERIFY(QFile::exists(storeFilePath(UserId)));
+    QVERIFY(EventStore::purge(UserId));
+    QVERIFY(!QFile::exists(storeFilePath(UserId)));
+    store = std::make_unique<EventStore>(UserId);
+    QVERIFY(!store->loadHistory(RoomId, numberedEventId(3), 10));
+
+    // Disabling the store of a connection deletes it from the disk
+    const std::unique_ptr<Connection> connection{
+        Connection::makeMockConnection(ConnectionUserId)
+    };
+    connection->setEventStoreEnabled(true);
+    QVERIFY(connection->eventStore());
+    QVERIFY(QFile::exists(storeFilePath(ConnectionUserId)));
+    connection->setEventStoreEnabled(false);
+    QVERIFY(!connection->eventStore());
+    QVERIFY(!QFile::exists(storeFilePath(ConnectionUserId)));
+}
+
+QTEST_MAIN(TestEventStore)
+#include "testeventstore.moc"
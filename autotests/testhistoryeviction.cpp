@@ -0,0 +1,162 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+#include <Quotient/eventstats.h>
+#include <Quotient/relationsindex.h>
+#include <Quotient/room.h>
+#include <Quotient/syncdata.h>
+
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+const auto RoomId = u"!eviction:example.org"_s;
+const auto LocalUserId = u"@alice:example.org"_s;
+const auto OtherUserId = u"@bob:example.org"_s;
+const auto CarolId = u"@carol:example.org"_s;
+const auto DaveId = u"@dave:example.org"_s;
+const auto ReactionKey = u"👍"_s;
+
+//! Events 1 to 10 with a notice at 6 and a reaction to 2 at 5
+QJsonArray firstBatch()
+{
+    QJsonArray events;
+    for (int n = 1; n <= 10; ++n)
+        events.append(n == 5 ? numberedReaction(n, 2)
+                             : numberedMessage(n, OtherUserId, u"Hello"_s,
+                                               n == 6 ? u"m.notice"_s : u"m.text"_s));
+    return events;
+}
+
+//! Events 11 to 20 with a reaction to 4 at 16
+QJsonArray secondBatch()
+{
+    QJsonArray events;
+    for (int n = 11; n <= 20; ++n)
+        events.append(n == 16 ? numberedReaction(n, 4) : numberedMessage(n));
+    return events;
+}
+
+void sync(Connection* c, const QString& nextBatch, const QJsonArray& timeline, bool limited,
+          const QJsonArray& ephemeral)
+{
+    const QJsonObject timelineJson{ { "events"_L1, timeline },
+                                    { "limited"_L1, limited },
+                                    { "prev_batch"_L1, u"p_"_s + nextBatch } };
+    const QJsonObject roomJson{ { "timeline"_L1, timelineJson },
+                                { "ephemeral"_L1, QJsonObject{ { "events"_L1, ephemeral } } } };
+    SyncData data;
+    data.parseJson({ { "next_batch"_L1, nextBatch },
+                     { "rooms"_L1,
+                       QJsonObject{ { "join"_L1, QJsonObject{ { RoomId, roomJson } } } } } });
+    syncMockConnection(c, std::move(data));
+}
+
+//! Check that the counters over the whole timeline match what isEventNotable() says now
+bool countsMatchScanning(const Room* room)
+{
+    EventStats scanned{ 0, 0, false };
+    for (auto it = Room::rev_iter_t(room->syncEdge()); it != room->historyEdge(); ++it) {
+        scanned.notableCount += room->isEventNotable(*it);
+        scanned.highlightCount += room->notificationFor(*it).type == Notification::Highlight;
+    }
+    const auto counted = room->countEvents(Room::rev_iter_t(room->syncEdge()), room->historyEdge());
+    if (counted != scanned)
+        qWarning() << "Counted" << counted << "but scanned" << scanned;
+    return counted == scanned;
+}
+
+} // namespace
+
+class TestHistoryEviction : public QObject {
+    Q_OBJECT
+
+    StandInServer server{ [](const StandInServer::Request& request) -> StandInServer::Reply {
+        if (!request.path.endsWith("/messages"_L1))
+            return {};
+        // Everything before the second batch, newest first
+        const auto events = firstBatch();
+        QJsonArray chunk;
+        for (auto it = events.crbegin(); it != events.crend(); ++it)
+            chunk.append(*it);
+        return QJsonObject{ { "start"_L1, request.query.queryItemValue(u"from"_s) },
+                            { "chunk"_L1, chunk } };
+    } };
+
+private Q_SLOTS:
+    void initTestCase();
+    void evictionAndReload();
+};
+
+void TestHistoryEviction::initTestCase()
+{
+    QVERIFY(server.isListening());
+    Connection::setRoomType<NoticesTogglingRoom>();
+}
+
+void TestHistoryEviction::evictionAndReload()
+{
+    std::unique_ptr<Connection> connection{ connectToStandInServer(server, LocalUserId) };
+    sync(connection.get(), u"s1"_s, firstBatch(), false, { readReceipt(CarolId, 3) });
+    // A limited sync leaves a point to cut the timeline at and load the evicted part back from
+    sync(connection.get(), u"s2"_s, secondBatch(), true, { readReceipt(DaveId, 15) });
+    auto* room = connection->room(RoomId);
+    QVERIFY(room);
+    QCOMPARE(room->timelineSize(), 20);
+    QCOMPARE(room->relations().reactionCount(numberedEventId(2), ReactionKey), qsizetype(1));
+    QCOMPARE(room->relations().reactionCount(numberedEventId(4), ReactionKey), qsizetype(1));
+    QCOMPARE(room->readCount(numberedEventId(3)), qsizetype(2));
+    QVERIFY(countsMatchScanning(room));
+
+    // The notice at 6 was counted as not notable; evicting it must not take it off the counters
+    // as a notable event
+    NoticesTogglingRoom::noticesAreNotable = true;
+    QSignalSpy evictionSpy(room, &Room::evictedHistoricalMessages);
+    room->setTimelineWindow(10);
+    QCOMPARE(evictionSpy.size(), 1);
+    QCOMPARE(room->timelineSize(), 10);
+    QCOMPARE(room->minTimelineIndex(), 10);
+    // Lookups by timestamp only see what's left
+    QVERIFY(room->findInTimeline(QDateTime::fromMSecsSinceEpoch(1000 + 15))
+            == room->findInTimeline(numberedEventId(15)));
+    QVERIFY(room->findInTimeline(QDateTime::fromMSecsSinceEpoch(1000))
+            == room->findInTimeline(numberedEventId(11)));
+    QVERIFY(room->findInTimeline(QDateTime::fromMSecsSinceEpoch(1000 + 21)) == room->historyEdge());
+
+    // Receipts on evicted events are kept by event id and are not counted in the timeline
+    QCOMPARE(room->userIdsAtEvent(numberedEventId(3)), QSet{ CarolId });
+    QCOMPARE(room->userIdsReadUpTo(numberedEventId(11)), QSet{ DaveId });
+    QCOMPARE(room->readCount(numberedEventId(11)), qsizetype(1));
+    // Relations from evicted events are gone; those from remaining events stay, even if their
+    // targets are evicted
+    QCOMPARE(room->relations().reactionCount(numberedEventId(2), ReactionKey), qsizetype(0));
+    QVERIFY(room->relations()
+                .relatedEvents(numberedEventId(2), EventRelation::AnnotationType)
+                .isEmpty());
+    QCOMPARE(room->relations().reactionCount(numberedEventId(4), ReactionKey), qsizetype(1));
+
+    // Load the evicted events back; everything should be as if they had never left
+    const auto job = room->getPreviousContent(20);
+    QVERIFY(waitForFuture(job));
+    QVERIFY(!job.isCanceled());
+    QCOMPARE(room->timelineSize(), 20);
+    QCOMPARE(room->minTimelineIndex(), 0);
+    QVERIFY(room->findInTimeline(QDateTime::fromMSecsSinceEpoch(1000))
+            == room->findInTimeline(numberedEventId(1)));
+    QCOMPARE(room->userIdsAtEvent(numberedEventId(3)), QSet{ CarolId });
+    QCOMPARE(room->readCount(numberedEventId(3)), qsizetype(2));
+    QCOMPARE(room->relations().reactionCount(numberedEventId(2), ReactionKey), qsizetype(1));
+    QCOMPARE(room->relations().reactionCount(numberedEventId(4), ReactionKey), qsizetype(1));
+    QVERIFY(countsMatchScanning(room));
+    NoticesTogglingRoom::noticesAreNotable = false;
+}
+
+QTEST_GUILESS_MAIN(TestHistoryEviction)
+#include "testhistoryeviction.moc"
@@ -0,0 +1,85 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/networkaccessmanager.h>
+
+#include <QtNetwork/QNetworkReply>
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+using namespace std::chrono_literals;
+
+class TestHttp2Fallback : public QObject {
+    Q_OBJECT
+
+    StandInServer server{ [](const StandInServer::Request&) -> StandInServer::Reply {
+        return {};
+    } };
+
+    //! Start a request to the stand-in server and drop it right away
+    bool nextRequestAllowsHttp2(QNetworkReply::NetworkError failure = QNetworkReply::NoError)
+    {
+        auto* reply = NetworkAccessManager::instance()->get(QNetworkRequest(server.url()));
+        const auto result = reply->request().attribute(QNetworkRequest::Http2AllowedAttribute);
+        if (failure != QNetworkReply::NoError)
+            emit reply->errorOccurred(failure);
+        reply->abort();
+        reply->deleteLater();
+        return result.toBool();
+    }
+
+private Q_SLOTS:
+    void initTestCase() { QVERIFY(server.isListening()); }
+    void init();
+    void closedConnection();
+    void protocolFailure();
+    void fallbackExpiry();
+};
+
+void TestHttp2Fallback::init()
+{
+    NetworkAccessManager::clearHttp2Fallbacks();
+    NetworkAccessManager::setHttp2FallbackPeriod(1h);
+}
+
+void TestHttp2Fallback::closedConnection()
+{
+    // Servers close HTTP/2 connections all the time (GOAWAY, idle timeouts); that's no reason
+    // to give up on HTTP/2
+    QVERIFY(nextRequestAllowsHttp2(QNetworkReply::RemoteHostClosedError));
+    QVERIFY(nextRequestAllowsHttp2(QNetworkReply::SslHandshakeFailedError));
+    QVERIFY(nextRequestAllowsHttp2());
+}
+
+void TestHttp2Fallback::protocolFailure()
+{
+    QVERIFY(nextRequestAllowsHttp2(QNetworkReply::ProtocolFailure));
+    QVERIFY(!nextRequestAllowsHttp2());
+    QVERIFY(!nextRequestAllowsHttp2());
+
+    // Requests that set the attribute explicitly are left alone
+    QNetworkRequest request(server.url());
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    auto* reply = NetworkAccessManager::instance()->get(request);
+    QVERIFY(reply->request().attribute(QNetworkRequest::Http2AllowedAttribute).toBool());
+    reply->abort();
+    reply->deleteLater();
+
+    NetworkAccessManager::clearHttp2Fallbacks();
+    QVERIFY(nextRequestAllowsHttp2());
+}
+
+void TestHttp2Fallback::fallbackExpiry()
+{
+    NetworkAccessManager::setHttp2FallbackPeriod(200ms);
+    QVERIFY(nextRequestAllowsHttp2(QNetworkReply::ProtocolFailure));
+    QVERIFY(!nextRequestAllowsHttp2());
+    QTest::qWait(300);
+    QVERIFY(nextRequestAllowsHttp2());
+}
+
+QTEST_GUILESS_MAIN(TestHttp2Fallback)
+#include "testhttp2fallback.moc"
@@ -0,0 +1,370 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+#include <Quotient/messagesearch.h>
+#include <Quotient/room.h>
+#include <Quotient/searchindex.h>
+#include <Quotient/syncdata.h>
+
+#include <Quotient/events/roommessageevent.h>
+
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+const auto LocalUserId = u"@searcher:example.org"_s;
+const auto PlainRoomId = u"!plain:example.org"_s;
+const auto SecretRoomId = u"!secret:example.org"_s;
+const auto OtherSecretRoomId = u"!other-secret:example.org"_s;
+constexpr qint64 BaseTimestamp = 1'700'000'000'000;
+constexpr auto ServerMessages = 25;
+
+QDateTime timestamp(int n) { return QDateTime::fromMSecsSinceEpoch(BaseTimestamp + n, Qt::UTC); }
+
+QString gardenEventId(int n) { return u"$garden%1:example.org"_s.arg(n); }
+
+QString gardenMessage(int n)
+{
+    auto text = n % 2 == 1 ? u"Meet me in the garden at %1"_s.arg(n)
+                           : u"Planting roses, message %1."_s.arg(n);
+    if (n % 5 == 0)
+        text += u" Bring gardening tools!"_s;
+    return text;
+}
+
+QJsonObject serverMessage(int n)
+{
+    auto json = messageJson(u"$server%1:example.org"_s.arg(n), LocalUserId, BaseTimestamp + n,
+                            u"hello from the server %1"_s.arg(n));
+    json.insert(RoomIdKey, PlainRoomId);
+    return json;
+}
+
+QJsonObject roomState(bool encrypted)
+{
+    QJsonArray events{ QJsonObject{ { TypeKey, u"m.room.create"_s },
+                                    { EventIdKey, u"$create"_s },
+                                    { SenderKey, LocalUserId },
+                                    { StateKeyKey, QString() },
+                                    { "origin_server_ts"_L1, BaseTimestamp },
+                                    { ContentKey, QJsonObject{} } } };
+    if (encrypted)
+        events.append(QJsonObject{
+            { TypeKey, u"m.room.encryption"_s },
+            { EventIdKey, u"$encryption"_s },
+            { SenderKey, LocalUserId },
+            { StateKeyKey, QString() },
+            { "origin_server_ts"_L1, BaseTimestamp },
+            { ContentKey, QJsonObject{ { "algorithm"_L1, u"m.megolm.v1.aes-sha2"_s } } } });
+    return { { "state"_L1, QJsonObject{ { "events"_L1, events } } } };
+}
+
+QStringList eventIds(const SearchIndex::Results& results)
+{
+    QStringList ids;
+    for (const auto& hit : results.hits)
+        ids.push_back(hit.eventId);
+    return ids;
+}
+
+bool waitForLoading(const MessageSearch& search)
+{
+    return QTest::qWaitFor([&search] { return !search.isLoading(); }, 10'000);
+}
+
+QString indexFilePath()
+{
+    auto dbDir = LocalUserId;
+    dbDir.replace(u':', u'_');
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) % u'/' % dbDir
+           % "/quotient_search.db3"_L1;
+}
+
+} // namespace
+
+class TestMessageSearch : public QObject {
+    Q_OBJECT
+
+    QVector<QJsonObject> searchRequests; //!< `room_events` criteria of server requests
+
+    StandInServer server{ [this](const StandInServer::Request& request) -> StandInServer::Reply {
+        if (!request.path.endsWith("/search"_L1))
+            return {};
+        const auto criteria = request.body["search_categories"_L1]["room_events"_L1].toObject();
+        searchRequests.push_back(criteria);
+        const auto limit = criteria["filter"_L1]["limit"_L1].toInt();
+        const auto offset = request.query.queryItemValue(u"next_batch"_s).toInt();
+        QJsonArray results;
+        for (int n = ServerMessages - 1 - offset; n >= 0 && results.size() < limit; --n)
+            results.append(QJsonObject{ { "rank"_L1, 1.0 }, { "result"_L1, serverMessage(n) } });
+        QJsonObject roomEvents{ { "results"_L1, results }, { "count"_L1, ServerMessages } };
+        if (offset + limit < ServerMessages)
+            roomEvents.insert("next_batch"_L1, QString::number(offset + limit));
+        return QJsonObject{ { "search_categories"_L1,
+                              QJsonObject{ { "room_events"_L1, roomEvents } } } };
+    } };
+
+    Connection* connection = nullptr;
+    SearchIndex* index = nullptr;
+
+    SearchIndex::Results search(const QString& query, const QStringList& roomIds = {},
+                                int limit = 100, const QString& nextBatch = {})
+    {
+        // The search runs on the index thread; no event loop is needed to get the result
+        return index->search(query, roomIds, limit, nextBatch).result();
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void tokenizing();
+    void localIndex();
+    void pagination();
+    void removal();
+    void edits();
+    void streaming();
+    void roomSelection();
+};
+
+void TestMessageSearch::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(SearchIndex::purge(LocalUserId));
+
+    QVERIFY(server.isListening());
+    connection = connectToStandInServer(server, LocalUserId);
+    QVERIFY(connection->searchIndex() == nullptr);
+    connection->setSearchIndexEnabled(true);
+    index = connection->searchIndex();
+    QVERIFY(index);
+
+    SyncData data;
+    data.parseJson({ { "next_batch"_L1, u"s_1"_s },
+                     { "rooms"_L1,
+                       QJsonObject{ { "join"_L1, QJsonObject{
+                                                     { PlainRoomId, roomState(false) },
+                                                     { SecretRoomId, roomState(true) },
+                                                     { OtherSecretRoomId, roomState(true) },
+                                                 } } } } });
+    syncMockConnection(connection, std::move(data));
+    QVERIFY(connection->room(SecretRoomId) && connection->room(SecretRoomId)->usesEncryption());
+    QVERIFY(connection->room(PlainRoomId) && !connection->room(PlainRoomId)->usesEncryption());
+
+    // 40 messages in one encrypted room and 10 in the other one
+    for (int n = 0; n < 50; ++n)
+        index->addMessage(n < 40 ? SecretRoomId : OtherSecretRoomId, gardenEventId(n),
+                          LocalUserId, timestamp(n), gardenMessage(n));
+}
+
+void TestMessageSearch::cleanupTestCase() { delete connection; }
+
+void TestMessageSearch::tokenizing()
+{
+    QCOMPARE(SearchIndex::tokenize(u"Hello, WORLD! hello again... Ünïcode_42 🙂 mañana"),
+             QStringList({ u"hello"_s, u"world"_s, u"again"_s, u"ünïcode"_s, u"42"_s,
+                           u"mañana"_s }));
+    // Supplementary-plane letters are letters too
+    QCOMPARE(SearchIndex::tokenize(u"𝒳𝒴 z"), QStringList({ u"𝒳𝒴"_s, u"z"_s }));
+    // Overly long words are cut
+    QCOMPARE(SearchIndex::tokenize(QString(100, u'a')), QStringList{ QString(32, u'a') });
+    QVERIFY(SearchIndex::tokenize(u" ... "_s).isEmpty());
+}
+
+void TestMessageSearch::localIndex()
+{
+    // A complete word; results come most recent first
+    auto results = search(u"garden "_s);
+    QCOMPARE(results.hits.size(), qsizetype(25));
+    QCOMPARE(results.hits.front().eventId, gardenEventId(49));
+    QCOMPARE(results.hits.front().roomId, OtherSecretRoomId);
+    QCOMPARE(results.hits.front().senderId, LocalUserId);
+    QCOMPARE(results.hits.front().timestamp, timestamp(49));
+    QCOMPARE(results.hits.back().eventId, gardenEventId(1));
+    QVERIFY(results.nextBatch.isEmpty());
+
+    // The last word as a prefix: "garden" or "gardening"; 5, 15 etc. contain both
+    QCOMPARE(search(u"GARD"_s).hits.size(), qsizetype(30));
+    QCOMPARE(search(u"garden"_s).hits.size(), qsizetype(30));
+    QCOMPARE(search(u"gardening"_s).hits.size(), qsizetype(10));
+    QCOMPARE(search(u"gardening."_s).hits.size(), qsizetype(10));
+
+    // Several words, in any order and case
+    QCOMPARE(eventIds(search(u"AT garden 4"_s)),
+             QStringList({ gardenEventId(49), gardenEventId(47), gardenEventId(45),
+                           gardenEventId(43), gardenEventId(41) }));
+    QCOMPARE(search(u"roses tools"_s).hits.size(), qsizetype(5));
+    QVERIFY(search(u"roses garden."_s).hits.isEmpty());
+    QVERIFY(search(u"orchids"_s).hits.isEmpty());
+    QVERIFY(search(u"garden orch"_s).hits.isEmpty());
+    QVERIFY(search(u"  "_s).hits.isEmpty());
+
+    // Rooms
+    QCOMPARE(search(u"garden "_s, { OtherSecretRoomId }).hits.size(), qsizetype(5));
+    QCOMPARE(search(u"garden "_s, { SecretRoomId, OtherSecretRoomId }).hits.size(),
+             qsizetype(25));
+    QVERIFY(search(u"garden"_s, { PlainRoomId }).hits.isEmpty());
+}
+
+void TestMessageSearch::pagination()
+{
+    // A single complete word and a prefix take different paths; check both
+    for (const auto& query : { u"garden "_s, u"gard"_s }) {
+        QStringList ids;
+        QString nextBatch;
+        int pages = 0;
+        do {
+            const auto results = search(query, {}, 7, nextBatch);
+            QVERIFY(results.hits.size() <= 7);
+            ids += eventIds(results);
+            nextBatch = results.nextBatch;
+            ++pages;
+        } while (!nextBatch.isEmpty() && pages < 10);
+        const auto expected = search(query);
+        QCOMPARE(ids, eventIds(expected));
+        QCOMPARE(pages, int((expected.hits.size() + 6) / 7));
+    }
+}
+
+void TestMessageSearch::removal()
+{
+    index->removeEvent(gardenEventId(49));
+    auto results = search(u"garden "_s);
+    QCOMPARE(results.hits.size(), qsizetype(24));
+    QCOMPARE(results.hits.front().eventId, gardenEventId(47));
+    // Adding the same message again is a no-op, removing it again as well
+    index->addMessage(OtherSecretRoomId, gardenEventId(47), LocalUserId, timestamp(47),
+                      gardenMessage(47));
+    index->removeEvent(gardenEventId(49));
+    QCOMPARE(search(u"garden "_s).hits.size(), qsizetype(24));
+
+    index->clearRoom(OtherSecretRoomId);
+    QCOMPARE(search(u"garden "_s).hits.size(), qsizetype(20));
+    QVERIFY(search(u"garden"_s, { OtherSecretRoomId }).hits.isEmpty());
+    // The words of removed messages are gone too
+    QVERIFY(search(u"49"_s).hits.isEmpty());
+}
+
+void TestMessageSearch::edits()
+{
+    const auto bulbsEventId = u"$bulbs:example.org"_s;
+    const auto edit = [&bulbsEventId](int n, const QString& newBody) {
+        const QJsonObject newContent{ { "msgtype"_L1, "m.text"_L1 }, { "body"_L1, newBody } };
+        return loadEvent<RoomMessageEvent>(messageJson(
+            u"$bulbs-edit%1:example.org"_s.arg(n), LocalUserId, BaseTimestamp + n,
+            u"* "_s + newBody,
+            { { "m.new_content"_L1, newContent },
+              { RelatesToKey, toJson(EventRelation::replace(bulbsEventId)) } }));
+    };
+    index->addEvent(SecretRoomId,
+                    *loadEvent<RoomMessageEvent>(messageJson(bulbsEventId, LocalUserId,
+                                                             BaseTimestamp + 200,
+                                                             u"Bulbs: tulips"_s)));
+    index->addEvent(SecretRoomId, *edit(202, u"Bulbs: daffodils"_s));
+
+    // The edit replaces the text of the original message, which keeps its place
+    QVERIFY(search(u"tulips"_s).hits.isEmpty());
+    const auto results = search(u"bulbs daffodils"_s);
+    QCOMPARE(eventIds(results), QStringList{ bulbsEventId });
+    QCOMPARE(results.hits.front().timestamp, timestamp(200));
+    // The fallback body of the edit is not indexed on its own
+    QCOMPARE(search(u"bulbs"_s).hits.size(), qsizetype(1));
+
+    // An older edit coming later, e.g. with history, doesn't override the newer one
+    index->addEvent(SecretRoomId, *edit(201, u"Bulbs: crocuses"_s));
+    QVERIFY(search(u"crocuses"_s).hits.isEmpty());
+    QCOMPARE(eventIds(search(u"daffodils"_s)), QStringList{ bulbsEventId });
+
+    index->removeEvent(bulbsEventId);
+    QVERIFY(search(u"bulbs"_s).hits.isEmpty());
+}
+
+void TestMessageSearch::streaming()
+{
+    for (int n = 0; n < 15; ++n)
+        index->addMessage(SecretRoomId, u"$local%1:example.org"_s.arg(n), LocalUserId,
+                          timestamp(100 + n), u"hello from the index %1"_s.arg(n));
+
+    searchRequests.clear();
+    MessageSearch allRooms(connection, u"hello"_s);
+    allRooms.setPageSize(10);
+    QSignalSpy addedSpy(&allRooms, &MessageSearch::resultsAdded);
+    QVERIFY(allRooms.canFetchMore());
+    allRooms.fetchMore();
+    QVERIFY(allRooms.isLoading());
+    QVERIFY(waitForLoading(allRooms));
+
+    // One page from each source, each announced separately
+    QCOMPARE(allRooms.results().size(), size_t(20));
+    QCOMPARE(addedSpy.size(), qsizetype(2));
+    QCOMPARE(searchRequests.size(), qsizetype(1));
+    QCOMPARE(searchRequests.front()["search_term"_L1].toString(), u"hello"_s);
+    QCOMPARE(searchRequests.front()["order_by"_L1].toString(), u"recent"_s);
+    QVERIFY(!searchRequests.front()["filter"_L1].toObject().contains("rooms"_L1));
+    for (const auto& r : allRooms.results()) {
+        if (r.roomId == PlainRoomId) {
+            QVERIFY(r.event);
+            QCOMPARE(r.event->id(), r.eventId);
+            QVERIFY(r.eventId.startsWith(u"$server"_s));
+        } else {
+            QCOMPARE(r.roomId, SecretRoomId);
+            QVERIFY(!r.event);
+            QVERIFY(r.eventId.startsWith(u"$local"_s));
+        }
+    }
+
+    while (allRooms.canFetchMore()) {
+        allRooms.fetchMore();
+        QVERIFY(waitForLoading(allRooms));
+    }
+    QCOMPARE(allRooms.results().size(), size_t(ServerMessages + 15));
+    QCOMPARE(searchRequests.size(), qsizetype(3));
+    QCOMPARE(searchRequests.back()["filter"_L1]["limit"_L1].toInt(), 10);
+    QSet<QString> ids;
+    for (const auto& r : allRooms.results())
+        ids.insert(r.eventId);
+    QCOMPARE(ids.size(), qsizetype(ServerMessages + 15));
+    int announced = 0;
+    for (const auto& args : addedSpy) {
+        QCOMPARE(args[0].toInt(), announced);
+        announced += args[1].toInt();
+    }
+    QCOMPARE(announced, ServerMessages + 15);
+}
+
+void TestMessageSearch::roomSelection()
+{
+    // Encrypted rooms go to the index, the rest to the server
+    searchRequests.clear();
+    MessageSearch mixed(connection, u"hello"_s, { PlainRoomId, SecretRoomId });
+    mixed.fetchMore();
+    QVERIFY(waitForLoading(mixed));
+    QCOMPARE(searchRequests.size(), qsizetype(1));
+    QCOMPARE(searchRequests.front()["filter"_L1]["rooms"_L1].toArray(), QJsonArray{ PlainRoomId });
+
+    MessageSearch encryptedOnly(connection, u"hello"_s, { SecretRoomId });
+    encryptedOnly.fetchMore();
+    QVERIFY(waitForLoading(encryptedOnly));
+    QCOMPARE(searchRequests.size(), qsizetype(1));
+    QCOMPARE(encryptedOnly.results().size(), size_t(15));
+    QVERIFY(!encryptedOnly.canFetchMore());
+
+    // Disabling the index deletes it; without it, encrypted rooms are left to the server
+    connection->setSearchIndexEnabled(false);
+    QVERIFY(!connection->searchIndex());
+    QVERIFY(!QFile::exists(indexFilePath()));
+    MessageSearch withoutIndex(connection, u"hello"_s, { SecretRoomId });
+    withoutIndex.fetchMore();
+    QVERIFY(waitForLoading(withoutIndex));
+    QCOMPARE(searchRequests.size(), qsizetype(2));
+    QCOMPARE(searchRequests.back()["filter"_L1]["rooms"_L1].toArray(), QJsonArray{ SecretRoomId });
+}
+
+QTEST_MAIN(TestMessageSearch)
+#include "testmessagesearch.moc"
@@ -0,0 +1,166 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+#include <Quotient/csapi/profile.h>
+
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+const auto LocalUserId = u"@requester:example.org"_s;
+const auto ProfileUserId = u"@popular:example.org"_s;
+const auto ProfilePath = u"/profile/@popular:example.org"_s;
+
+} // namespace
+
+class TestRequestCoalescing : public QObject {
+    Q_OBJECT
+
+    int profileRequests = 0;
+
+    StandInServer server{ [this](const StandInServer::Request& request) -> StandInServer::Reply {
+        if (!request.path.endsWith(ProfilePath))
+            return {};
+        ++profileRequests;
+        return QJsonObject{ { "displayname"_L1, u"Popular"_s } };
+    } };
+
+    std::unique_ptr<Connection> connection;
+
+    auto requestProfile(RunningPolicy policy = ForegroundRequest)
+    {
+        return connection->callApiCoalesced<GetUserProfileJob>(policy, ProfileUserId);
+    }
+
+private Q_SLOTS:
+    void initTestCase() { QVERIFY(server.isListening()); }
+    void init();
+    void coalescing();
+    void runningPolicy();
+    void abandonRefcount();
+    void responseCacheExpiry();
+};
+
+void TestRequestCoalescing::init()
+{
+    profileRequests = 0;
+    connection.reset(connectToStandInServer(server, LocalUserId));
+}
+
+void TestRequestCoalescing::coalescing()
+{
+    // Each requester attaches its own continuation; none of them may displace the others
+    QStringList names;
+    auto h1 = requestProfile().then([&names](const GetUserProfileJob::Response& r) {
+        names.push_back(r.displayname);
+    });
+    auto h2 = requestProfile().then([&names](const GetUserProfileJob::Response& r) {
+        names.push_back(r.displayname);
+    });
+    auto h3 = requestProfile();
+    QCOMPARE(h2.get(), h1.get());
+    QCOMPARE(h3.get(), h1.get());
+    QVERIFY(waitForFuture(h1));
+    QVERIFY(waitForFuture(h2));
+    QVERIFY(waitForFuture(h3));
+    QVERIFY(!h3.isCanceled());
+    QCOMPARE(names, QStringList(2, u"Popular"_s));
+    QCOMPARE(profileRequests, 1);
+    const auto stats = connection->requestCoalescingStats();
+    QCOMPARE(stats.sent, quint64(1));
+    QCOMPARE(stats.attached, quint64(2));
+
+    // Once the request is done, the next one goes to the server again
+    auto h4 = requestProfile();
+    QVERIFY(waitForFuture(h4));
+    QCOMPARE(profileRequests, 2);
+}
+
+void TestRequestCoalescing::runningPolicy()
+{
+    auto background = requestProfile(BackgroundRequest);
+    QVERIFY(background->isBackground());
+    auto alsoBackground = requestProfile(BackgroundRequest);
+    QVERIFY(background->isBackground());
+    auto foreground = requestProfile(ForegroundRequest);
+    QCOMPARE(foreground.get(), background.get());
+    QVERIFY(!background->isBackground());
+    QVERIFY(waitForFuture(foreground));
+    QCOMPARE(profileRequests, 1);
+}
+
+void TestRequestCoalescing::abandonRefcount()
+{
+    auto h1 = requestProfile();
+    auto h2 = requestProfile();
+    auto h3 = requestProfile();
+    QPointer job = h1.get();
+
+    // Detaching some of the requesters leaves the request alone for the others
+    h1.abandon();
+    h2.abandon();
+    QVERIFY(h1.isCanceled());
+    QVERIFY(h2.isCanceled());
+    QVERIFY(isJobPending(job));
+    // Abandoning again from the same handle doesn't detach anybody else
+    h1.abandon();
+    QVERIFY(isJobPending(job));
+    QVERIFY(waitForFuture(h3));
+    QVERIFY(!h3.isCanceled());
+    QCOMPARE(profileRequests, 1);
+
+    // Detaching all of them abandons the request
+    auto h4 = requestProfile();
+    auto h5 = requestProfile();
+    job = h4.get();
+    QCOMPARE(h5.get(), job.get());
+    h5.abandon();
+    QVERIFY(isJobPending(job));
+    h4.abandon();
+    QVERIFY(!isJobPending(job));
+    QVERIFY(waitForFuture(h4));
+    QVERIFY(waitForFuture(h5));
+    QVERIFY(h4.isCanceled());
+    QVERIFY(h5.isCanceled());
+    QVERIFY(QTest::qWaitFor([&job] { return job.isNull(); }));
+    QCOMPARE(profileRequests, 1);
+}
+
+void TestRequestCoalescing::responseCacheExpiry()
+{
+    using namespace std::chrono_literals;
+    connection->setResponseCacheTtl(300ms);
+    QVERIFY(waitForFuture(requestProfile()));
+    QCOMPARE(profileRequests, 1);
+
+    // Within the time-to-live, the response comes from the cache, with the same contents
+    QString name;
+    auto cached = requestProfile().then(
+        [&name](const GetUserProfileJob::Response& r) { name = r.displayname; });
+    QVERIFY(waitForFuture(cached));
+    QCOMPARE(name, u"Popular"_s);
+    QCOMPARE(profileRequests, 1);
+    QCOMPARE(connection->requestCoalescingStats().cached, quint64(1));
+
+    // After it, the request is sent again
+    QTest::qWait(400);
+    QVERIFY(waitForFuture(requestProfile()));
+    QCOMPARE(profileRequests, 2);
+    const auto stats = connection->requestCoalescingStats();
+    QCOMPARE(stats.sent, quint64(2));
+    QCOMPARE(stats.cached, quint64(1));
+
+    // Turning the cache off drops what's there
+    connection->setResponseCacheTtl(0ms);
+    QVERIFY(waitForFuture(requestProfile()));
+    QCOMPARE(profileRequests, 3);
+}
+
+QTEST_GUILESS_MAIN(TestRequestCoalescing)
+#include "testrequestcoalescing.moc"
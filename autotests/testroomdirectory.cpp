@@ -0,0 +1,254 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+#include <Quotient/roomdirectorymodel.h>
+
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+const auto LocalUserId = u"@browser:example.org"_s;
+constexpr auto DirectorySize = 250;
+
+QString roomName(int n)
+{
+    // Every tenth room is about cats, the rest are about dogs
+    return n % 10 == 0 ? u"Cat lovers %1"_s.arg(n) : u"Dog walkers %1"_s.arg(n);
+}
+
+QJsonObject directoryRoom(int n)
+{
+    return { { "room_id"_L1, u"!room%1:example.org"_s.arg(n) },
+             { "name"_L1, roomName(n) },
+             { "topic"_L1, n % 7 == 0 ? u"Mostly about gardening"_s : u"Chit-chat"_s },
+             { "canonical_alias"_L1, u"#room%1:example.org"_s.arg(n) },
+             { "num_joined_members"_L1, DirectorySize - n },
+             { "world_readable"_L1, true },
+             { "guest_can_join"_L1, false } };
+}
+
+} // namespace
+
+class TestRoomDirectory : public QObject {
+    Q_OBJECT
+
+    int listingRequests = 0;
+    QStringList searchTerms; //!< Search terms in server requests, in the order of arrival
+
+    StandInServer server{ [this](const StandInServer::Request& request) -> StandInServer::Reply {
+        if (!request.path.endsWith("/publicRooms"_L1))
+            return {};
+        const auto isSearch = request.method == "POST";
+        const auto since = isSearch ? request.body.value("since"_L1).toString()
+                                    : request.query.queryItemValue(u"since"_s);
+        const auto limit = isSearch ? request.body.value("limit"_L1).toInt()
+                                    : request.query.queryItemValue(u"limit"_s).toInt();
+        QString term;
+        if (isSearch) {
+            term = request.body["filter"_L1]["generic_search_term"_L1].toString();
+            searchTerms.push_back(term);
+        } else
+            ++listingRequests;
+
+        QList<int> rooms;
+        for (int n = 0; n < DirectorySize; ++n)
+            if (roomName(n).contains(term, Qt::CaseInsensitive))
+                rooms.push_back(n);
+        const auto offset = since.toInt();
+        QJsonArray chunk;
+        for (const auto n : rooms.mid(offset, limit))
+            chunk.append(directoryRoom(n));
+        QJsonObject response{ { "chunk"_L1, chunk },
+                              { "total_room_count_estimate"_L1, DirectorySize } };
+        if (offset + limit < rooms.size())
+            response.insert("next_batch"_L1, QString::number(offset + limit));
+        return response;
+    } };
+
+    Connection* connection = nullptr;
+
+    //! Wait until \p model has no pending requests
+    static bool waitForLoading(RoomDirectoryModel& model);
+    static QString nameAt(const RoomDirectoryModel& model, int row);
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanupTestCase();
+    void prefetching();
+    void localFiltering();
+    void debouncedSearch();
+    void boundedMemory();
+};
+
+bool TestRoomDirectory::waitForLoading(RoomDirectoryModel& model)
+{
+    return QTest::qWaitFor([&model] { return !model.isLoading(); }, 10'000);
+}
+
+QString TestRoomDirectory::nameAt(const RoomDirectoryModel& model, int row)
+{
+    return model.data(model.index(row), RoomDirectoryModel::NameRole).toString();
+}
+
+void TestRoomDirectory::initTestCase()
+{
+    QVERIFY(server.isListening());
+    connection = connectToStandInServer(server, LocalUserId);
+}
+
+void TestRoomDirectory::init()
+{
+    listingRequests = 0;
+    searchTerms.clear();
+}
+
+void TestRoomDirectory::cleanupTestCase() { delete connection; }
+
+void TestRoomDirectory::prefetching()
+{
+    RoomDirectoryModel model(connection);
+    QVERIFY(model.canFetchMore());
+    model.fetchMore();
+    QVERIFY(waitForLoading(model));
+    QCOMPARE(model.rowCount(), 50);
+    QCOMPARE(model.totalRoomCountEstimate(), DirectorySize);
+    QCOMPARE(nameAt(model, 0), roomName(0));
+    QCOMPARE(model.data(model.index(3), RoomDirectoryModel::JoinedMembersCountRole).toInt(),
+             DirectorySize - 3);
+
+    // Rows far from the end don't cause loading
+    QCOMPARE(nameAt(model, 10), roomName(10));
+    QTest::qWait(10);
+    QCOMPARE(listingRequests, 1);
+
+    // A row close enough to the end does, before the view asks for more
+    QCOMPARE(nameAt(model, 40), roomName(40));
+    QTRY_COMPARE(model.rowCount(), 100);
+    QCOMPARE(listingRequests, 2);
+    QCOMPARE(nameAt(model, 99), roomName(99));
+
+    while (model.canFetchMore()) {
+        model.fetchMore();
+        QVERIFY(waitForLoading(model));
+    }
+    QCOMPARE(model.rowCount(), DirectorySize);
+    QVERIFY(model.isComplete());
+    QCOMPARE(listingRequests, 5);
+}
+
+void TestRoomDirectory::localFiltering()
+{
+    RoomDirectoryModel model(connection);
+    model.setPageSize(100);
+    while (model.canFetchMore()) {
+        model.fetchMore();
+        QVERIFY(waitForLoading(model));
+    }
+    QVERIFY(model.isComplete());
+
+    // Narrowing the filter down; no requests are made since the whole directory is there
+    model.setFilterText(u"c"_s);
+    QCOMPARE(model.rowCount(), DirectorySize / 10);
+    model.setFilterText(u"cat LOVERS"_s);
+    QCOMPARE(model.rowCount(), DirectorySize / 10);
+    QCOMPARE(nameAt(model, 1), roomName(10));
+    model.setFilterText(u"cat lovers 12"_s); // 120 and 12x, but only 120 is about cats
+    QCOMPARE(model.rowCount(), 1);
+    QCOMPARE(nameAt(model, 0), roomName(120));
+
+    // Widening it back
+    model.setFilterText(u"lovers"_s);
+    QCOMPARE(model.rowCount(), DirectorySize / 10);
+    model.setFilterText(u"overs"_s); // Not a word start
+    QCOMPARE(model.rowCount(), 0);
+    model.setFilterMode(RoomDirectoryModel::FilterMode::Substring);
+    QCOMPARE(model.rowCount(), DirectorySize / 10);
+    model.setFilterText(u"gardening"_s); // From the topic
+    QCOMPARE(model.rowCount(), (DirectorySize + 6) / 7);
+    model.setFilterText({});
+    QCOMPARE(model.rowCount(), DirectorySize);
+
+    QTest::qWait(int(model.searchDelay().count()) * 2);
+    QVERIFY(searchTerms.isEmpty());
+}
+
+void TestRoomDirectory::debouncedSearch()
+{
+    RoomDirectoryModel model(connection);
+    model.setPageSize(20);
+    model.setSearchDelay(std::chrono::milliseconds(100));
+    model.fetchMore();
+    QVERIFY(waitForLoading(model));
+    QCOMPARE(model.rowCount(), 20);
+
+    // Local matches come immediately; the server only gets the final text
+    model.setFilterText(u"c"_s);
+    QCOMPARE(model.rowCount(), 2); // Rooms 0 and 10
+    model.setFilterText(u"ca"_s);
+    model.setFilterText(u"cat"_s);
+    QCOMPARE(model.rowCount(), 2);
+    QVERIFY(!model.canFetchMore());
+    QTRY_COMPARE(searchTerms, QStringList{ u"cat"_s });
+    QVERIFY(waitForLoading(model));
+    // Rooms 0 and 10 from the listing, then 20..190 from the server search
+    QCOMPARE(model.rowCount(), 20);
+    QCOMPARE(nameAt(model, 0), roomName(0));
+    QCOMPARE(nameAt(model, 2), roomName(20));
+    QCOMPARE(nameAt(model, 19), roomName(190));
+
+    // More search results, with no duplicates
+    QVERIFY(model.canFetchMore());
+    model.fetchMore();
+    QVERIFY(waitForLoading(model));
+    QCOMPARE(model.rowCount(), DirectorySize / 10);
+    QCOMPARE(nameAt(model, model.rowCount() - 1), roomName(240));
+    QVERIFY(!model.canFetchMore());
+
+    // A search started and superseded before completion gets cancelled
+    model.setSearchDelay(std::chrono::milliseconds(0));
+    model.setFilterText(u"dog"_s);
+    QTRY_VERIFY(model.isLoading());
+    model.setFilterText(u"dog walkers 3"_s);
+    QVERIFY(waitForLoading(model));
+    QTest::qWait(50);
+    QCOMPARE(model.rowCount(), 10); // 3 and 31..39
+    for (int row = 0; row < model.rowCount(); ++row)
+        QVERIFY(nameAt(model, row).startsWith(u"Dog walkers 3"_s));
+}
+
+void TestRoomDirectory::boundedMemory()
+{
+    RoomDirectoryModel model(connection);
+    model.setPageSize(50);
+    model.setMaxRooms(120);
+    for (int i = 0; i < 3; ++i) {
+        model.fetchMore();
+        QVERIFY(waitForLoading(model));
+    }
+    // 150 rooms loaded, the earliest 30 dropped
+    QCOMPARE(model.rowCount(), 120);
+    QCOMPARE(nameAt(model, 0), roomName(30));
+    QVERIFY(!model.isComplete());
+
+    // Filtering only sees the rooms in memory; dropping rooms drops local matches
+    model.setSearchDelay(std::chrono::hours(1));
+    model.setFilterText(u"cat"_s);
+    QCOMPARE(model.rowCount(), 12); // 30..140
+    model.setFilterText({});
+    model.fetchMore();
+    QVERIFY(waitForLoading(model));
+    QCOMPARE(model.rowCount(), 120);
+    QCOMPARE(nameAt(model, 0), roomName(80));
+    QCOMPARE(nameAt(model, 119), roomName(199));
+}
+
+QTEST_MAIN(TestRoomDirectory)
+#include "testroomdirectory.moc"
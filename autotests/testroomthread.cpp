@@ -0,0 +1,139 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+#include <Quotient/relationsindex.h>
+#include <Quotient/room.h>
+#include <Quotient/roomthread.h>
+#include <Quotient/syncdata.h>
+
+#include <Quotient/events/roommessageevent.h>
+
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+const auto RoomId = u"!thread-test:example.org"_s;
+const auto RootId = u"$root:example.org"_s;
+
+QJsonObject message(const QString& id, qint64 ts, std::optional<EventRelation> relation = {})
+{
+    return messageJson(id, u"@bob:example.org"_s, ts, id,
+                       relation ? QJsonObject{ { RelatesToKey, toJson(*relation) } }
+                                : QJsonObject());
+}
+
+QJsonObject threadReply(const QString& id, qint64 ts)
+{
+    return message(id, ts, EventRelation::replyInThread(RootId, true, RootId));
+}
+
+void sync(Connection* c, const QString& nextBatch, const QJsonArray& timeline)
+{
+    const QJsonObject timelineJson{ { "events"_L1, timeline },
+                                    { "limited"_L1, false },
+                                    { "prev_batch"_L1, u"p_"_s + nextBatch } };
+    const QJsonObject joinedRooms{ { RoomId, QJsonObject{ { "timeline"_L1, timelineJson } } } };
+    SyncData data;
+    data.parseJson({ { "next_batch"_L1, nextBatch },
+                     { "rooms"_L1, QJsonObject{ { "join"_L1, joinedRooms } } } });
+    syncMockConnection(c, std::move(data));
+}
+
+} // namespace
+
+class TestRoomThread : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void sharedWithTimeline();
+    void updatedFromSync();
+    void editedReply();
+};
+
+void TestRoomThread::sharedWithTimeline()
+{
+    auto* connection = Connection::makeMockConnection(u"@alice:example.org"_s);
+    sync(connection, u"s1"_s,
+         { message(RootId, 1000), threadReply(u"$r1:example.org"_s, 2000),
+           message(u"$m1:example.org"_s, 1500), threadReply(u"$r2:example.org"_s, 3000) });
+    auto* room = connection->room(RoomId);
+    QVERIFY(room);
+
+    auto* thread = room->thread(RootId);
+    QVERIFY(thread);
+    QCOMPARE(room->thread(RootId), thread);
+    QCOMPARE(room->threads(), QList<RoomThread*>{ thread });
+    QCOMPARE(thread->size(), 2);
+    QCOMPARE(thread->eventId(0), u"$r1:example.org"_s);
+    QCOMPARE(thread->eventId(1), u"$r2:example.org"_s);
+    QCOMPARE(thread->indexOf(u"$r2:example.org"_s), 1);
+    QCOMPARE(thread->indexOf(u"$m1:example.org"_s), -1);
+    // The very same event objects as in the main timeline
+    QCOMPARE(thread->event(0), room->findInTimeline(u"$r1:example.org"_s)->event());
+    QCOMPARE(thread->root(), room->findInTimeline(RootId)->event());
+    QVERIFY(!thread->allHistoryLoaded());
+}
+
+void TestRoomThread::updatedFromSync()
+{
+    auto* connection = Connection::makeMockConnection(u"@alice:example.org"_s);
+    sync(connection, u"s1"_s, { message(RootId, 1000), threadReply(u"$r1:example.org"_s, 2000) });
+    auto* room = connection->room(RoomId);
+    QVERIFY(room);
+    auto* thread = room->thread(RootId);
+    QCOMPARE(thread->size(), 1);
+
+    QSignalSpy addedSpy(thread, &RoomThread::addedEvents);
+    sync(connection, u"s2"_s,
+         { message(u"$m2:example.org"_s, 4000), threadReply(u"$r3:example.org"_s, 5000) });
+    QCOMPARE(addedSpy.size(), 1);
+    QCOMPARE(addedSpy.front(), (QVariantList{ 1, 1 }));
+    QCOMPARE(thread->size(), 2);
+    QCOMPARE(thread->eventId(1), u"$r3:example.org"_s);
+
+    QSignalSpy replacedSpy(thread, &RoomThread::replacedEvent);
+    sync(connection, u"s3"_s,
+         { QJsonObject{ { TypeKey, u"m.room.redaction"_s },
+                        { EventIdKey, u"$redaction:example.org"_s },
+                        { SenderKey, u"@bob:example.org"_s },
+                        { "origin_server_ts"_L1, 6000 },
+                        { "redacts"_L1, u"$r1:example.org"_s },
+                        { ContentKey, QJsonObject{} } } });
+    QCOMPARE(replacedSpy.size(), 1);
+    QCOMPARE(thread->size(), 2);
+    QVERIFY(thread->event(0)->isRedacted());
+}
+
+void TestRoomThread::editedReply()
+{
+    auto* connection = Connection::makeMockConnection(u"@alice:example.org"_s);
+    sync(connection, u"s1"_s, { message(RootId, 1000), threadReply(u"$r1:example.org"_s, 2000) });
+    auto* room = connection->room(RoomId);
+    QVERIFY(room);
+
+    QSignalSpy updatedSpy(room, &Room::updatedEvent);
+    const QJsonObject newContent{ { "msgtype"_L1, "m.text"_L1 }, { "body"_L1, "Edited"_L1 } };
+    sync(connection, u"s2"_s,
+         { messageJson(u"$e1:example.org"_s, u"@bob:example.org"_s, 3000, u"* Edited"_s,
+                       { { "m.new_content"_L1, newContent },
+                         { RelatesToKey,
+                           toJson(EventRelation::replace(u"$r1:example.org"_s)) } }) });
+
+    // Both the edited reply and the thread it is in have changed
+    QSet<QString> updatedIds;
+    for (const auto& args : updatedSpy)
+        updatedIds.insert(args.front().toString());
+    QCOMPARE(updatedIds, (QSet{ u"$r1:example.org"_s, RootId }));
+    QCOMPARE(room->relations().latestEdit(u"$r1:example.org"_s)->id(), u"$e1:example.org"_s);
+    QCOMPARE(room->relations().threadSummary(RootId).replyCount, qsizetype(1));
+}
+
+QTEST_MAIN(TestRoomThread)
+#include "testroomthread.moc"
@@ -0,0 +1,166 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+#include <Quotient/room.h>
+
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+#include <numeric>
+
+using namespace Quotient;
+
+namespace {
+
+const auto LocalUserId = u"@updater:example.org"_s;
+
+QString roomId(int n) { return u"!room%1:example.org"_s.arg(n); }
+
+QJsonObject message(int room, int n)
+{
+    return messageJson(u"$r%1-m%2:example.org"_s.arg(room).arg(n), LocalUserId, 1'000 + n,
+                       u"Message %1"_s.arg(n));
+}
+
+QJsonObject member(int n)
+{
+    return { { TypeKey, u"m.room.member"_s },
+             { EventIdKey, u"$member%1:example.org"_s.arg(n) },
+             { SenderKey, u"@u%1:example.org"_s.arg(n) },
+             { StateKeyKey, u"@u%1:example.org"_s.arg(n) },
+             { "origin_server_ts"_L1, 500 },
+             { ContentKey, QJsonObject{ { "membership"_L1, "join"_L1 } } } };
+}
+
+//! A sync response with \p messagesPerRoom new messages in each of the rooms from \p rooms
+QJsonObject syncResponse(const QList<int>& rooms, int firstMessage, int messagesPerRoom)
+{
+    QJsonObject joinedRooms;
+    for (const auto room : rooms) {
+        QJsonArray events;
+        for (int n = firstMessage; n < firstMessage + messagesPerRoom; ++n)
+            events.append(message(room, n));
+        const QJsonObject timelineJson{ { "events"_L1, events } };
+        joinedRooms.insert(roomId(room), QJsonObject{ { "timeline"_L1, timelineJson } });
+    }
+    return { { "rooms"_L1, QJsonObject{ { "join"_L1, joinedRooms } } } };
+}
+
+} // namespace
+
+class TestRoomUpdates : public QObject {
+    Q_OBJECT
+
+    //! Responses to /sync requests, in the order of serving
+    QList<QJsonObject> syncResponses;
+    StandInServer server{ [this](const StandInServer::Request& request) -> StandInServer::Reply {
+        if (request.path.endsWith("/sync"_L1)) {
+            auto response = syncResponses.isEmpty() ? QJsonObject() : syncResponses.takeFirst();
+            response.insert("next_batch"_L1, u"s%1"_s.arg(syncResponses.size()));
+            return response;
+        }
+        if (request.path.endsWith("/account/whoami"_L1))
+            return QJsonObject{ { "user_id"_L1, LocalUserId } };
+        return {};
+    } };
+
+private Q_SLOTS:
+    void initTestCase();
+    void displayedRoomsFirst();
+    void largeRoomInChunks();
+};
+
+void TestRoomUpdates::initTestCase() { QVERIFY(server.isListening()); }
+
+void TestRoomUpdates::displayedRoomsFirst()
+{
+    constexpr auto RoomsCount = 20;
+    QList<int> allRooms(RoomsCount);
+    std::iota(allRooms.begin(), allRooms.end(), 0);
+    syncResponses = { syncResponse(allRooms, 0, 3), syncResponse(allRooms, 3, 2) };
+    auto* connection = connectToStandInServer(server, LocalUserId);
+    QVERIFY(syncOnce(connection, false));
+    connection->applyPendingRoomUpdates();
+    QCOMPARE(connection->pendingRoomUpdates(), 0);
+    QCOMPARE(connection->allRooms().size(), qsizetype(RoomsCount));
+
+    auto* const displayedRoom = connection->room(roomId(15));
+    QVERIFY(displayedRoom);
+    displayedRoom->setDisplayed();
+    QStringList updatedRoomIds;
+    for (auto* room : connection->allRooms())
+        connect(room, &Room::addedMessages, this,
+                [room, &updatedRoomIds] { updatedRoomIds.push_back(room->id()); });
+    QSignalSpy progressSpy(connection, &Connection::roomUpdatesProgress);
+    QSignalSpy appliedSpy(connection, &Connection::syncApplied);
+
+    // Room updates are applied after syncDone(), starting from the displayed room
+    QVERIFY(syncOnce(connection, false));
+    QCOMPARE(connection->pendingRoomUpdates(), RoomsCount);
+    QCOMPARE(displayedRoom->timelineSize(), 3);
+    QVERIFY(appliedSpy.wait());
+    QCOMPARE(appliedSpy.size(), qsizetype(1));
+    QCOMPARE(connection->pendingRoomUpdates(), 0);
+    QCOMPARE(updatedRoomIds.size(), qsizetype(RoomsCount));
+    QCOMPARE(updatedRoomIds.front(), roomId(15));
+    QCOMPARE(displayedRoom->timelineSize(), 5);
+    QVERIFY(!progressSpy.isEmpty());
+    QCOMPARE(progressSpy.back().at(0).toInt(), RoomsCount);
+    QCOMPARE(progressSpy.back().at(1).toInt(), RoomsCount);
+    delete connection;
+}
+
+void TestRoomUpdates::largeRoomInChunks()
+{
+    constexpr auto MembersCount = 1'000;
+    constexpr auto MessagesCount = 450;
+    QJsonArray stateEvents{ QJsonObject{ { TypeKey, u"m.room.create"_s },
+                                         { EventIdKey, u"$create:example.org"_s },
+                                         { SenderKey, LocalUserId },
+                                         { StateKeyKey, QString() },
+                                         { "origin_server_ts"_L1, 100 },
+                                         { ContentKey, QJsonObject{} } } };
+    for (int n = 0; n < MembersCount; ++n)
+        stateEvents.append(member(n));
+    QJsonArray timelineEvents;
+    for (int n = 0; n < MessagesCount; ++n)
+        timelineEvents.append(message(0, n));
+    const QJsonObject roomJson{
+        { "state"_L1, QJsonObject{ { "events"_L1, stateEvents } } },
+        { "timeline"_L1, QJsonObject{ { "events"_L1, timelineEvents },
+                                      { "limited"_L1, true },
+                                      { "prev_batch"_L1, "p0"_L1 } } }
+    };
+    syncResponses = { QJsonObject{
+        { "rooms"_L1, QJsonObject{ { "join"_L1, QJsonObject{ { roomId(0), roomJson } } } } } } };
+
+    auto* connection = connectToStandInServer(server, LocalUserId);
+    QVERIFY(syncOnce(connection, false));
+    auto* room = connection->room(roomId(0));
+    QVERIFY(room);
+    QSignalSpy baseStateSpy(room, &Room::baseStateLoaded);
+    QSignalSpy addedSpy(room, &Room::addedMessages);
+    QSignalSpy displaynameSpy(room, &Room::displaynameChanged);
+    QSignalSpy appliedSpy(connection, &Connection::syncApplied);
+    QVERIFY(appliedSpy.wait());
+
+    // The state goes in chunks, then the timeline, with the rest applied as a whole at the end
+    QCOMPARE(addedSpy.size(), qsizetype(5));
+    QCOMPARE(baseStateSpy.size(), qsizetype(1));
+    // The display name is only calculated once, after the last chunk
+    QCOMPARE(displaynameSpy.size(), qsizetype(1));
+    QCOMPARE(room->timelineSize(), MessagesCount);
+    QCOMPARE(room->joinedMembers().size(), qsizetype(MembersCount));
+    QCOMPARE(room->messageEvents().front()->id(), u"$r0-m0:example.org"_s);
+    QCOMPARE(room->messageEvents().back()->id(),
+             u"$r0-m%1:example.org"_s.arg(MessagesCount - 1));
+    QVERIFY(!room->timelineGap()); // Nothing was there before the first chunk
+    delete connection;
+}
+
+QTEST_MAIN(TestRoomUpdates)
+#include "testroomupdates.moc"
@@ -0,0 +1,270 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+#include <Quotient/room.h>
+#include <Quotient/slidingsync.h>
+#include <Quotient/syncdata.h>
+
+#include <Quotient/jobs/slidingsyncjob.h>
+#include <Quotient/jobs/syncjob.h>
+
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+// An account with many rooms, each having a few state events and some messages
+constexpr auto RoomsCount = 2000;
+constexpr auto MessagesPerRoom = 10;
+const auto LocalUserId = u"@alice:example.org"_s;
+
+QString roomId(int n) { return u"!room%1:example.org"_s.arg(n); }
+
+QJsonObject stateEvent(int room, const QString& type, const QString& stateKey,
+                       const QJsonObject& content)
+{
+    return { { TypeKey, type },
+             { EventIdKey, u"$r%1-%2:example.org"_s.arg(room).arg(type) },
+             { SenderKey, LocalUserId },
+             { StateKeyKey, stateKey },
+             { "origin_server_ts"_L1, 1'000 },
+             { ContentKey, content } };
+}
+
+QJsonArray roomState(int room)
+{
+    return { stateEvent(room, u"m.room.create"_s, {}, { { "creator"_L1, LocalUserId } }),
+             stateEvent(room, u"m.room.name"_s, {}, { { "name"_L1, u"Room %1"_s.arg(room) } }),
+             stateEvent(room, u"m.room.member"_s, LocalUserId,
+                        { { "membership"_L1, "join"_L1 }, { "displayname"_L1, "Alice"_L1 } }) };
+}
+
+//! The latest \p limit messages in the room; lower-numbered rooms are more recently active
+QJsonArray roomTimeline(int room, int limit = MessagesPerRoom)
+{
+    QJsonArray timeline;
+    for (int n = MessagesPerRoom - limit; n < MessagesPerRoom; ++n)
+        timeline.append(messageJson(u"$r%1-m%2:example.org"_s.arg(room).arg(n), LocalUserId,
+                                    1'000'000'000 - room * 1000 + n,
+                                    u"Message %1 in room %2"_s.arg(n).arg(room)));
+    return timeline;
+}
+
+QJsonObject syncResponse()
+{
+    QJsonObject joinedRooms;
+    for (int room = 0; room < RoomsCount; ++room) {
+        const QJsonObject timelineJson{ { "events"_L1, roomTimeline(room) },
+                                        { "limited"_L1, true },
+                                        { "prev_batch"_L1, "p1"_L1 } };
+        joinedRooms.insert(roomId(room),
+                           QJsonObject{ { "state"_L1,
+                                          QJsonObject{ { "events"_L1, roomState(room) } } },
+                                        { "timeline"_L1, timelineJson } });
+    }
+    return { { "next_batch"_L1, "s1"_L1 },
+             { "rooms"_L1, QJsonObject{ { "join"_L1, joinedRooms } } } };
+}
+
+QJsonObject slidingRoom(int room, int timelineLimit)
+{
+    return { { "initial"_L1, true },
+             { "required_state"_L1, roomState(room) },
+             { "timeline"_L1, roomTimeline(room, std::min(timelineLimit, MessagesPerRoom)) },
+             { "limited"_L1, timelineLimit < MessagesPerRoom },
+             { "prev_batch"_L1, "p1"_L1 },
+             { "joined_count"_L1, 1 },
+             { "bump_stamp"_L1, RoomsCount - room } };
+}
+
+QJsonObject slidingSyncResponse(const QJsonObject& request)
+{
+    QJsonObject roomsJson;
+    QJsonObject listsJson;
+    const auto lists = request.value("lists"_L1).toObject();
+    for (auto it = lists.begin(); it != lists.end(); ++it) {
+        const auto listJson = it->toObject();
+        const auto timelineLimit = listJson.value("timeline_limit"_L1).toInt();
+        for (const auto& range : listJson.value("ranges"_L1).toArray()) {
+            const auto bounds = range.toArray();
+            const auto last = std::min(bounds[1].toInt(), RoomsCount - 1);
+            for (int room = bounds[0].toInt(); room <= last; ++room)
+                roomsJson.insert(roomId(room), slidingRoom(room, timelineLimit));
+        }
+        listsJson.insert(it.key(), QJsonObject{ { "count"_L1, RoomsCount } });
+    }
+    const auto subscriptions = request.value("room_subscriptions"_L1).toObject();
+    for (auto it = subscriptions.begin(); it != subscriptions.end(); ++it) {
+        const auto room = it.key().mid(5, it.key().indexOf(u':') - 5).toInt();
+        roomsJson.insert(it.key(),
+                         slidingRoom(room, it->toObject().value("timeline_limit"_L1).toInt()));
+    }
+    return { { "pos"_L1, "1"_L1 }, { "lists"_L1, listsJson }, { "rooms"_L1, roomsJson } };
+}
+
+//! Serve /sync and sliding sync for a big account
+StandInServer::Reply respond(const StandInServer::Request& request)
+{
+    if (request.path.endsWith("/sync"_L1) && request.path.contains("msc3575"_L1))
+        return slidingSyncResponse(request.body);
+    if (request.path.endsWith("/sync"_L1))
+        return syncResponse();
+    if (request.path.endsWith("/account/whoami"_L1))
+        return QJsonObject{ { "user_id"_L1, LocalUserId } };
+    if (request.path.endsWith("/login"_L1))
+        return QJsonObject{ { "flows"_L1, QJsonArray() } };
+    return {};
+}
+
+} // namespace
+
+class TestSlidingSync : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void convertResponse();
+    void roomListWindows();
+    void benchmarkFirstRoomList_data();
+    void benchmarkFirstRoomList();
+};
+
+void TestSlidingSync::convertResponse()
+{
+    const QJsonObject receipt{ { TypeKey, "m.receipt"_L1 }, { ContentKey, QJsonObject() } };
+    const QJsonArray heroes{ QJsonObject{ { "user_id"_L1, "@bob:example.org"_L1 },
+                                          { "displayname"_L1, "Bob"_L1 } } };
+    const QJsonArray leaveTimeline{ stateEvent(3, u"m.room.member"_s, LocalUserId,
+                                               { { "membership"_L1, "leave"_L1 } }) };
+    const QJsonObject slidingSyncJson{
+        { "pos"_L1, "5"_L1 },
+        { "rooms"_L1,
+          QJsonObject{
+              { roomId(1),
+                QJsonObject{ { "required_state"_L1, roomState(1) },
+                             { "timeline"_L1, roomTimeline(1, 2) },
+                             { "limited"_L1, true },
+                             { "joined_count"_L1, 3 },
+                             { "notification_count"_L1, 2 },
+                             { "heroes"_L1, heroes } } },
+              { roomId(2),
+                QJsonObject{ { "invite_state"_L1, roomState(2) } } },
+              { roomId(3),
+                QJsonObject{ { "timeline"_L1, leaveTimeline } } } } },
+        { "extensions"_L1,
+          QJsonObject{ { "receipts"_L1,
+                         QJsonObject{ { "rooms"_L1, QJsonObject{ { roomId(1), receipt },
+                                                                 { roomId(4), receipt } } } } } } }
+    };
+
+    const auto syncJson = SlidingSyncJob::toSyncJson(slidingSyncJson, LocalUserId);
+    const auto rooms = syncJson.value("rooms"_L1).toObject();
+    QCOMPARE(rooms.value("join"_L1).toObject().keys(), (QStringList{ roomId(1), roomId(4) }));
+    QCOMPARE(rooms.value("invite"_L1).toObject().keys(), QStringList{ roomId(2) });
+    QCOMPARE(rooms.value("leave"_L1).toObject().keys(), QStringList{ roomId(3) });
+
+    SyncData data;
+    data.parseJson(syncJson);
+    QVERIFY(data.nextBatch().isEmpty());
+    auto roomData = data.takeRoomData();
+    QCOMPARE(roomData.size(), size_t(4));
+    const auto& room1 =
+        *std::ranges::find(roomData, roomId(1), &SyncRoomData::roomId);
+    QCOMPARE(room1.joinState, JoinState::Join);
+    QCOMPARE(room1.state.size(), size_t(3));
+    QCOMPARE(room1.timeline.size(), size_t(2));
+    QVERIFY(room1.timelineLimited);
+    QCOMPARE(room1.summary.joinedMemberCount.value_or(0), 3);
+    QCOMPARE(room1.summary.heroes.value_or(QStringList()),
+             QStringList{ u"@bob:example.org"_s });
+    QCOMPARE(room1.unreadCount.value_or(0), 2);
+    QVERIFY(!room1.highlightCount.has_value());
+    QCOMPARE(room1.ephemeral.size(), size_t(1));
+    const auto& room4 =
+        *std::ranges::find(roomData, roomId(4), &SyncRoomData::roomId);
+    QVERIFY(room4.timeline.empty());
+    QCOMPARE(room4.ephemeral.size(), size_t(1));
+}
+
+void TestSlidingSync::roomListWindows()
+{
+    StandInServer server(respond);
+    QVERIFY(server.isListening());
+    auto* connection = connectToStandInServer(server, LocalUserId);
+    auto* slidingSync = new SlidingSync(connection);
+    QSignalSpy doneSpy(slidingSync, &SlidingSync::syncDone);
+    QSignalSpy listSpy(slidingSync, &SlidingSync::roomListChanged);
+
+    slidingSync->setList(u"all"_s, 20);
+    slidingSync->sync(0);
+    QVERIFY(doneSpy.wait());
+    connection->applyPendingRoomUpdates();
+    QCOMPARE(listSpy.size(), qsizetype(1));
+    QCOMPARE(slidingSync->roomCount(u"all"_s), RoomsCount);
+    QCOMPARE(slidingSync->roomIds().size(), qsizetype(20));
+    QCOMPARE(slidingSync->roomIds().front(), roomId(0));
+    QCOMPARE(connection->allRooms().size(), qsizetype(20));
+    auto* room = connection->room(roomId(19));
+    QVERIFY(room);
+    QCOMPARE(room->displayName(), u"Room 19"_s);
+    QCOMPARE(room->timelineSize(), 1);
+
+    // Scrolling down the list and opening a room further away
+    slidingSync->setListWindow(u"all"_s, 20, 39);
+    slidingSync->subscribeToRoom(roomId(500), 5);
+    slidingSync->sync(0);
+    QVERIFY(doneSpy.wait());
+    connection->applyPendingRoomUpdates();
+    QCOMPARE(slidingSync->roomIds().size(), qsizetype(41));
+    QCOMPARE(slidingSync->roomIds().back(), roomId(500));
+    QCOMPARE(slidingSync->roomIds()[20], roomId(20));
+    QVERIFY(connection->room(roomId(39)));
+    QCOMPARE(connection->room(roomId(500))->timelineSize(), 5);
+    QVERIFY(slidingSync->bytesReceived() > 0);
+    delete connection;
+}
+
+void TestSlidingSync::benchmarkFirstRoomList_data()
+{
+    QTest::addColumn<bool>("sliding");
+    QTest::newRow("/sync") << false;
+    QTest::newRow("sliding sync") << true;
+}
+
+void TestSlidingSync::benchmarkFirstRoomList()
+{
+    QFETCH(bool, sliding);
+    StandInServer server(respond);
+    QVERIFY(server.isListening());
+    auto* connection = connectToStandInServer(server, LocalUserId);
+    // Time until the rooms to be shown in the room list are there
+    QBENCHMARK_ONCE {
+        if (sliding) {
+            auto* slidingSync = new SlidingSync(connection);
+            slidingSync->setList(u"all"_s, 20);
+            QSignalSpy doneSpy(slidingSync, &SlidingSync::syncDone);
+            slidingSync->sync(0);
+            QVERIFY(doneSpy.wait());
+        } else {
+            QSignalSpy doneSpy(connection, &Connection::syncDone);
+            connection->sync(0);
+            QVERIFY(doneSpy.wait(60'000));
+        }
+        connection->applyPendingRoomUpdates();
+    }
+    QVERIFY(connection->room(roomId(0)));
+    qint64 bytesSent = 0;
+    for (const auto& bytes : std::as_const(server.bytesSent))
+        bytesSent += bytes;
+    qInfo() << connection->allRooms().size() << "room(s) received," << bytesSent
+            << "bytes sent by the server";
+    delete connection;
+}
+
+QTEST_MAIN(TestSlidingSync)
+#include "testslidingsync.moc"
@@ -0,0 +1,297 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+#include <Quotient/spacegraph.h>
+#include <Quotient/syncdata.h>
+
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+const auto LocalUserId = u"@explorer:example.org"_s;
+const auto RootId = u"!root:example.org"_s;
+const auto SpaceAId = u"!a:example.org"_s;
+const auto SpaceBId = u"!b:example.org"_s;
+const auto SharedId = u"!shared:example.org"_s;
+const auto Room1Id = u"!r1:example.org"_s;
+const auto Room2Id = u"!r2:example.org"_s;
+const auto Room3Id = u"!r3:example.org"_s;
+const auto Room4Id = u"!r4:example.org"_s;
+const auto Room5Id = u"!r5:example.org"_s;
+
+QJsonObject childEvent(const QString& childId, qint64 timestamp, const QString& order = {})
+{
+    QJsonObject content{ { "via"_L1, QJsonArray{ u"example.org"_s } } };
+    if (!order.isEmpty())
+        content.insert("order"_L1, order);
+    return { { "type"_L1, SpaceChildEventType },
+             { "state_key"_L1, childId },
+             { "sender"_L1, LocalUserId },
+             { "origin_server_ts"_L1, timestamp },
+             { "content"_L1, content } };
+}
+
+} // namespace
+
+class TestSpaceGraph : public QObject {
+    Q_OBJECT
+
+    //! Children of each space on the server; both subspaces contain the shared one, and
+    //! the shared one links back to the root
+    QHash<QString, QStringList> hierarchy;
+    QStringList requestedIds; //!< Spaces in hierarchy requests, once per page
+
+    StandInServer server{ [this](const StandInServer::Request& request) -> StandInServer::Reply {
+        if (!request.path.endsWith("/hierarchy"_L1))
+            return {};
+        const auto spaceId = request.path.section(u'/', -2, -2);
+        requestedIds.push_back(spaceId);
+        // Requests are expected to go one level at a time
+        if (request.query.queryItemValue(u"max_depth"_s) != "1"_L1)
+            return { QJsonObject{ { "errcode"_L1, "M_INVALID_PARAM"_L1 } }, 400 };
+
+        QStringList roomIds{ spaceId };
+        roomIds += hierarchy.value(spaceId);
+        const auto offset = request.query.queryItemValue(u"from"_s).toInt();
+        const auto limit = request.query.queryItemValue(u"limit"_s).toInt();
+        QJsonArray rooms;
+        for (const auto& roomId : roomIds.mid(offset, limit)) {
+            QJsonObject chunk{ { "room_id"_L1, roomId },
+                               { "name"_L1, roomId.section(u':', 0, 0).mid(1) },
+                               { "num_joined_members"_L1, 1 },
+                               { "world_readable"_L1, false },
+                               { "guest_can_join"_L1, false },
+                               { "join_rule"_L1, "public"_L1 } };
+            QJsonArray childrenState;
+            if (hierarchy.contains(roomId)) {
+                chunk.insert("room_type"_L1, "m.space"_L1);
+                const auto& childIds = hierarchy[roomId];
+                for (int n = 0; n < childIds.size(); ++n)
+                    // Give the plain room in the root an order to put it first
+                    childrenState.append(childEvent(childIds[n], n + 1,
+                                                    childIds[n] == Room1Id ? u"0"_s : QString()));
+            }
+            chunk.insert("children_state"_L1, childrenState);
+            rooms.append(chunk);
+        }
+        QJsonObject response{ { "rooms"_L1, rooms } };
+        if (offset + limit < roomIds.size())
+            response.insert("next_batch"_L1, QString::number(offset + limit));
+        return response;
+    } };
+
+    Connection* connection = nullptr;
+
+    static bool traverse(SpaceTraversal& traversal, int count = 100);
+    static QStringList visitedIds(const SpaceTraversal& traversal);
+    void syncChildEvent(const QString& spaceId, QJsonObject event);
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanupTestCase();
+    void breadthFirst();
+    void depthLimit();
+    void incrementalFetch();
+    void pagination();
+    void invalidation();
+};
+
+bool TestSpaceGraph::traverse(SpaceTraversal& traversal, int count)
+{
+    traversal.fetchMore(count);
+    return QTest::qWaitFor([&traversal] { return !traversal.isLoading(); }, 10'000);
+}
+
+QStringList TestSpaceGraph::visitedIds(const SpaceTraversal& traversal)
+{
+    QStringList result;
+    for (const auto& visit : traversal.visits())
+        result.push_back(visit.node->roomId);
+    return result;
+}
+
+void TestSpaceGraph::syncChildEvent(const QString& spaceId, QJsonObject event)
+{
+    static int batch = 0;
+    event.insert("event_id"_L1, u"$child%1:example.org"_s.arg(++batch));
+    const QJsonObject roomData{ { "state"_L1,
+                                  QJsonObject{ { "events"_L1, QJsonArray{ event } } } } };
+    SyncData data;
+    data.parseJson({ { "next_batch"_L1, u"s_%1"_s.arg(batch) },
+                     { "rooms"_L1,
+                       QJsonObject{ { "join"_L1, QJsonObject{ { spaceId, roomData } } } } } });
+    syncMockConnection(connection, std::move(data));
+}
+
+void TestSpaceGraph::initTestCase()
+{
+    QVERIFY(server.isListening());
+    connection = connectToStandInServer(server, LocalUserId);
+}
+
+void TestSpaceGraph::init()
+{
+    hierarchy = { { RootId, { SpaceAId, SpaceBId, Room1Id } },
+                  { SpaceAId, { SharedId, Room2Id } },
+                  { SpaceBId, { SharedId, Room3Id } },
+                  { SharedId, { Room4Id, RootId } } };
+    requestedIds.clear();
+}
+
+void TestSpaceGraph::cleanupTestCase() { delete connection; }
+
+void TestSpaceGraph::breadthFirst()
+{
+    SpaceGraph graph(connection);
+    SpaceTraversal traversal(&graph, RootId, 10);
+    QSignalSpy finishedSpy(&traversal, &SpaceTraversal::finished);
+    QVERIFY(traverse(traversal));
+    QVERIFY(traversal.isFinished());
+    QCOMPARE(finishedSpy.size(), 1);
+    // The ordered child goes first; the shared space and the root are only visited once
+    QCOMPARE(visitedIds(traversal), (QStringList{ RootId, Room1Id, SpaceAId, SpaceBId, SharedId,
+                                                  Room2Id, Room3Id, Room4Id }));
+    const auto& visits = traversal.visits();
+    QCOMPARE(visits[0].depth, 0);
+    QCOMPARE(visits[3].depth, 1);
+    QCOMPARE(visits[4].depth, 2);
+    QCOMPARE(visits[4].parentId, SpaceAId);
+    QCOMPARE(visits[6].parentId, SpaceBId);
+    QCOMPARE(visits[7].depth, 3);
+    QCOMPARE(visits[7].parentId, SharedId);
+    // Each space is loaded once; plain rooms are not requested
+    QCOMPARE(requestedIds, (QStringList{ RootId, SpaceAId, SpaceBId, SharedId }));
+
+    // Overlapping spaces share the node, and its summary
+    QCOMPARE(graph.node(SharedId), visits[4].node);
+    QVERIFY(graph.node(SharedId)->isSpace());
+    QVERIFY(graph.node(SharedId)->childrenLoaded);
+    QCOMPARE(graph.node(Room2Id)->name, u"r2"_s);
+    QCOMPARE(graph.parentSpaces(SharedId), (QSet{ SpaceAId, SpaceBId }));
+    QCOMPARE(graph.parentSpaces(RootId), QSet{ SharedId });
+    QVERIFY(graph.parentSpaces(u"!unknown:example.org"_s).isEmpty());
+
+    // Another traversal is served from the cache
+    SpaceTraversal secondTraversal(&graph, SpaceBId, 10);
+    secondTraversal.fetchMore();
+    QVERIFY(secondTraversal.isFinished());
+    QCOMPARE(visitedIds(secondTraversal),
+             (QStringList{ SpaceBId, SharedId, Room3Id, Room4Id, RootId, Room1Id, SpaceAId,
+                           Room2Id }));
+    QCOMPARE(requestedIds.size(), qsizetype(4));
+}
+
+void TestSpaceGraph::depthLimit()
+{
+    SpaceGraph graph(connection);
+    SpaceTraversal traversal(&graph, RootId, 1);
+    QVERIFY(traverse(traversal));
+    QVERIFY(traversal.isFinished());
+    QCOMPARE(visitedIds(traversal), (QStringList{ RootId, Room1Id, SpaceAId, SpaceBId }));
+    QCOMPARE(requestedIds, QStringList{ RootId });
+    // Subspaces at the limit are known but not entered
+    QVERIFY(graph.node(SpaceAId)->isSpace());
+    QVERIFY(!graph.node(SpaceAId)->childrenLoaded);
+    QCOMPARE(graph.node(SpaceAId)->childIds, (QStringList{ SharedId, Room2Id }));
+
+    // Going one level deeper only loads the spaces of that level
+    requestedIds.clear();
+    SpaceTraversal deeperTraversal(&graph, RootId, 2);
+    QVERIFY(traverse(deeperTraversal));
+    QCOMPARE(deeperTraversal.visits().size(), qsizetype(7));
+    QCOMPARE(requestedIds, (QStringList{ SpaceAId, SpaceBId }));
+}
+
+void TestSpaceGraph::incrementalFetch()
+{
+    SpaceGraph graph(connection);
+    SpaceTraversal traversal(&graph, RootId, 10);
+    QSignalSpy addedSpy(&traversal, &SpaceTraversal::visitsAdded);
+    QVERIFY(traversal.visits().isEmpty());
+    QVERIFY(requestedIds.isEmpty()); // Nothing is loaded until asked
+
+    QVERIFY(traverse(traversal, 3));
+    QCOMPARE(traversal.visits().size(), qsizetype(3));
+    QVERIFY(!traversal.isFinished());
+    // Visiting a subspace needs its children, to queue them
+    QCOMPARE(requestedIds, (QStringList{ RootId, SpaceAId }));
+    QCOMPARE(addedSpy.size(), 1);
+    QCOMPARE(addedSpy.front(), (QVariantList{ 0, 3 }));
+
+    QVERIFY(traverse(traversal, 3));
+    QCOMPARE(traversal.visits().size(), qsizetype(6));
+    QCOMPARE(requestedIds, (QStringList{ RootId, SpaceAId, SpaceBId, SharedId }));
+
+    QVERIFY(traverse(traversal));
+    QVERIFY(traversal.isFinished());
+    QCOMPARE(traversal.visits().size(), qsizetype(8));
+}
+
+void TestSpaceGraph::pagination()
+{
+    SpaceGraph graph(connection);
+    graph.setPageSize(2);
+    QSignalSpy loadedSpy(&graph, &SpaceGraph::spaceLoaded);
+    graph.loadSpace(RootId);
+    QVERIFY(graph.isLoading(RootId));
+    graph.loadSpace(RootId); // No duplicate requests
+    QVERIFY(loadedSpy.wait());
+    // The root and its three children make two pages
+    QCOMPARE(requestedIds, (QStringList{ RootId, RootId }));
+    QCOMPARE(graph.node(RootId)->childIds, (QStringList{ Room1Id, SpaceAId, SpaceBId }));
+    QVERIFY(graph.node(Room1Id)->hasSummary);
+    QVERIFY(graph.node(SpaceBId)->hasSummary);
+}
+
+void TestSpaceGraph::invalidation()
+{
+    auto* graph = connection->spaceGraph();
+    QVERIFY(graph);
+    QCOMPARE(connection->spaceGraph(), graph);
+    SpaceTraversal traversal(graph, RootId, 10);
+    QVERIFY(traverse(traversal));
+    QCOMPARE(requestedIds.size(), qsizetype(4));
+    const auto* spaceB = graph->node(SpaceBId);
+    const auto generation = spaceB->generation;
+
+    // A new child shows up in the state of a joined space
+    hierarchy[SpaceBId].push_back(Room5Id);
+    QSignalSpy changedSpy(graph, &SpaceGraph::spaceChanged);
+    syncChildEvent(SpaceBId, childEvent(Room5Id, 100));
+    QCOMPARE(changedSpy.size(), 1);
+    QCOMPARE(changedSpy.front().front().toString(), SpaceBId);
+    QVERIFY(!spaceB->childrenLoaded);
+    QVERIFY(spaceB->generation > generation);
+    QCOMPARE(graph->parentSpaces(Room5Id), QSet{ SpaceBId });
+    QCOMPARE(spaceB->childIds, (QStringList{ SharedId, Room3Id, Room5Id }));
+
+    // Only the changed space is requested again
+    requestedIds.clear();
+    SpaceTraversal secondTraversal(graph, RootId, 10);
+    QVERIFY(traverse(secondTraversal));
+    QCOMPARE(requestedIds, QStringList{ SpaceBId });
+    QCOMPARE(graph->node(SpaceBId), spaceB);
+    QVERIFY(spaceB->childrenLoaded);
+    QCOMPARE(visitedIds(secondTraversal), (QStringList{ RootId, Room1Id, SpaceAId, SpaceBId,
+                                                        SharedId, Room2Id, Room3Id, Room5Id,
+                                                        Room4Id }));
+    QCOMPARE(secondTraversal.visits()[7].parentId, SpaceBId);
+
+    // A child event without `via` removes the child
+    auto removal = childEvent(Room3Id, 101);
+    removal.insert("content"_L1, QJsonObject{});
+    syncChildEvent(SpaceBId, removal);
+    QVERIFY(graph->parentSpaces(Room3Id).isEmpty());
+    QCOMPARE(spaceB->childIds, (QStringList{ SharedId, Room5Id }));
+}
+
+QTEST_GUILESS_MAIN(TestSpaceGraph)
+#include "testspacegraph.moc"
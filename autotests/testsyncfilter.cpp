@@ -0,0 +1,221 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+#include <Quotient/room.h>
+#include <Quotient/settings.h>
+
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+const auto LocalUserId = u"@filter-tester:example.org"_s;
+const auto RoomId = u"!gap:example.org"_s;
+
+QJsonObject message(int n)
+{
+    return messageJson(u"$m%1:example.org"_s.arg(n), LocalUserId, 1'000 + n,
+                       u"Message %1"_s.arg(n));
+}
+
+QJsonArray messages(int from, int to)
+{
+    QJsonArray result;
+    for (int n = from; n <= to; ++n)
+        result.append(message(n));
+    return result;
+}
+
+int timelineLimit(const QString& inlineFilter)
+{
+    return QJsonDocument::fromJson(inlineFilter.toUtf8())
+        .object()
+        .value("room"_L1)
+        .toObject()
+        .value("timeline"_L1)
+        .toObject()
+        .value("limit"_L1)
+        .toInt();
+}
+
+QString storedFilterId(const QJsonObject& filter)
+{
+    return AccountSettings(LocalUserId)
+        .filterId(QJsonDocument(filter).toJson(QJsonDocument::Compact));
+}
+
+} // namespace
+
+class TestSyncFilter : public QObject {
+    Q_OBJECT
+
+    //! The `filter` parameters of /sync requests, in the order of arrival
+    QStringList syncFilters;
+    //! The filters uploaded to the server, in the order of arrival
+    QList<QJsonObject> definedFilters;
+    QSet<QString> knownFilterIds;
+    //! Timeline sections of /sync responses for RoomId, one per request
+    QList<QJsonObject> roomTimelines;
+    QList<QUrlQuery> messagesQueries;
+    StandInServer server{ [this](const StandInServer::Request& request) {
+        return respond(request);
+    } };
+
+    StandInServer::Reply respond(const StandInServer::Request& request);
+    Connection* makeConnection(const SyncTimelineLimits& limits);
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanupTestCase();
+    void reuseFilters();
+    void timelineGap();
+};
+
+StandInServer::Reply TestSyncFilter::respond(const StandInServer::Request& request)
+{
+    if (request.path.endsWith("/sync"_L1)) {
+        const auto filter = request.query.queryItemValue(u"filter"_s, QUrl::FullyDecoded);
+        syncFilters.push_back(filter);
+        if (!filter.startsWith(u'{') && !knownFilterIds.contains(filter))
+            return { QJsonObject{ { "errcode"_L1, "M_NOT_FOUND"_L1 },
+                                  { "error"_L1, "No such filter"_L1 } },
+                     404 };
+        QJsonObject syncJson{ { "next_batch"_L1, u"s%1"_s.arg(syncFilters.size()) } };
+        if (!roomTimelines.isEmpty()) {
+            const QJsonObject roomJson{ { "timeline"_L1, roomTimelines.takeFirst() } };
+            syncJson.insert("rooms"_L1,
+                            QJsonObject{ { "join"_L1, QJsonObject{ { RoomId, roomJson } } } });
+        }
+        return syncJson;
+    }
+    if (request.path.endsWith("/filter"_L1)) {
+        definedFilters.push_back(request.body);
+        const auto filterId = u"f%1"_s.arg(definedFilters.size());
+        knownFilterIds.insert(filterId);
+        return QJsonObject{ { "filter_id"_L1, filterId } };
+    }
+    if (request.path.endsWith("/messages"_L1)) {
+        messagesQueries.push_back(request.query);
+        QJsonArray chunk;
+        for (int n = 9; n > 9 - request.query.queryItemValue(u"limit"_s).toInt(); --n)
+            chunk.append(message(n));
+        return QJsonObject{ { "start"_L1, request.query.queryItemValue(u"from"_s) },
+                            { "end"_L1, "p1"_L1 },
+                            { "chunk"_L1, chunk } };
+    }
+    if (request.path.endsWith("/account/whoami"_L1))
+        return QJsonObject{ { "user_id"_L1, LocalUserId } };
+    return {};
+}
+
+Connection* TestSyncFilter::makeConnection(const SyncTimelineLimits& limits)
+{
+    auto* connection = connectToStandInServer(server, LocalUserId);
+    connection->setSyncTimelineLimits(limits);
+    return connection;
+}
+
+void TestSyncFilter::initTestCase() { QVERIFY(server.isListening()); }
+
+void TestSyncFilter::init()
+{
+    SettingsGroup("Accounts"_L1).remove(LocalUserId);
+    syncFilters.clear();
+    definedFilters.clear();
+    knownFilterIds.clear();
+}
+
+void TestSyncFilter::cleanupTestCase() { SettingsGroup("Accounts"_L1).remove(LocalUserId); }
+
+void TestSyncFilter::reuseFilters()
+{
+    const SyncTimelineLimits limits{ .initialSync = 5,
+                                     .catchUp = 7,
+                                     .steadyState = 30,
+                                     .catchUpAfter = std::chrono::hours(1) };
+    auto* connection = makeConnection(limits);
+
+    // The very first sync passes the filter inline while uploading it
+    QVERIFY(syncOnce(connection));
+    QCOMPARE(timelineLimit(syncFilters.back()), 5);
+    QTRY_COMPARE(definedFilters.size(), qsizetype(1));
+    QTRY_COMPARE(storedFilterId(definedFilters[0]), u"f1"_s);
+
+    // Syncs following each other get more events, with another filter
+    QVERIFY(syncOnce(connection));
+    QCOMPARE(timelineLimit(syncFilters.back()), 30);
+    QTRY_COMPARE(storedFilterId(definedFilters.value(1)), u"f2"_s);
+    QVERIFY(syncOnce(connection));
+    QCOMPARE(syncFilters.back(), u"f2"_s);
+    delete connection;
+
+    // Another session reuses the filter ids stored before
+    auto catchUpLimits = limits;
+    catchUpLimits.catchUpAfter = std::chrono::seconds(0);
+    connection = makeConnection(catchUpLimits);
+    QVERIFY(syncOnce(connection));
+    QCOMPARE(syncFilters.back(), u"f1"_s);
+    QVERIFY(syncOnce(connection));
+    QCOMPARE(timelineLimit(syncFilters.back()), 7);
+    QTRY_COMPARE(definedFilters.size(), qsizetype(3));
+    delete connection;
+
+    // A filter forgotten by the server gets defined again
+    knownFilterIds.remove(u"f1"_s);
+    connection = makeConnection(limits);
+    QVERIFY(syncOnce(connection));
+    QCOMPARE(syncFilters.size(), qsizetype(7));
+    QCOMPARE(syncFilters[5], u"f1"_s);
+    QCOMPARE(timelineLimit(syncFilters[6]), 5);
+    QTRY_COMPARE(storedFilterId(definedFilters[0]), u"f4"_s);
+    delete connection;
+}
+
+void TestSyncFilter::timelineGap()
+{
+    SyncTimelineLimits limits;
+    limits.gapFillByRoomType.insert(QString(), 4);
+    auto* connection = makeConnection(limits);
+    roomTimelines = {
+        QJsonObject{ { "events"_L1, messages(0, 4) }, { "prev_batch"_L1, "p0"_L1 } },
+        QJsonObject{ { "events"_L1, messages(10, 12) },
+                     { "limited"_L1, true },
+                     { "prev_batch"_L1, "gap"_L1 } }
+    };
+    QVERIFY(syncOnce(connection));
+    auto* room = connection->room(RoomId);
+    QVERIFY(room);
+    QCOMPARE(room->timelineSize(), 5);
+    QVERIFY(!room->timelineGap());
+
+    QSignalSpy gapSpy(room, &Room::timelineGapChanged);
+    QVERIFY(syncOnce(connection));
+    QCOMPARE(room->timelineSize(), 8);
+    QCOMPARE(gapSpy.size(), qsizetype(1));
+    const auto gapIndex = room->timelineGap();
+    QVERIFY(gapIndex.has_value());
+    QCOMPARE(room->findInTimeline(*gapIndex)->event()->id(), u"$m10:example.org"_s);
+
+    // Events before the gap go away and the gap is loaded with the limit for the room type
+    room->fillTimelineGap();
+    QVERIFY(!room->timelineGap());
+    QCOMPARE(gapSpy.size(), qsizetype(2));
+    QCOMPARE(room->timelineSize(), 3);
+    QTRY_COMPARE(room->timelineSize(), 7);
+    QCOMPARE(messagesQueries.size(), qsizetype(1));
+    QCOMPARE(messagesQueries[0].queryItemValue(u"from"_s), u"gap"_s);
+    QCOMPARE(messagesQueries[0].queryItemValue(u"limit"_s), u"4"_s);
+    QCOMPARE(room->messageEvents().front()->id(), u"$m6:example.org"_s);
+    QCOMPARE(room->minTimelineIndex(), *gapIndex - 4);
+    delete connection;
+}
+
+QTEST_MAIN(TestSyncFilter)
+#include "testsyncfilter.moc"
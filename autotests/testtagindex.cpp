@@ -0,0 +1,169 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+#include <Quotient/room.h>
+#include <Quotient/syncdata.h>
+
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+const auto LocalUserId = u"@organiser:example.org"_s;
+const auto FriendId = u"@friend:example.org"_s;
+const auto OtherFriendId = u"@other:example.org"_s;
+const auto WorkTag = u"u.work"_s;
+
+QString roomId(int n) { return u"!room%1:example.org"_s.arg(n); }
+
+//! Room tags in the m.tag format; a negative order means no order
+QJsonObject tagsJson(std::initializer_list<std::pair<QString, double>> tags)
+{
+    QJsonObject tagsObject;
+    for (const auto& [name, order] : tags)
+        tagsObject.insert(name, order < 0 ? QJsonObject{}
+                                          : QJsonObject{ { "order"_L1, order } });
+    return { { TypeKey, TagEvent::TypeId },
+             { ContentKey, QJsonObject{ { "tags"_L1, tagsObject } } } };
+}
+
+} // namespace
+
+class TestTagIndex : public QObject {
+    Q_OBJECT
+
+    StandInServer server{ [](const StandInServer::Request&) -> StandInServer::Reply {
+        return {};
+    } };
+    Connection* connection = nullptr;
+
+    //! Sync room account data from \p roomsToTags and global account data from \p accountData
+    void sync(const QHash<int, QJsonObject>& roomsToTags, const QJsonArray& accountData = {});
+    QList<int> roomNumbers(const QVector<Room*>& rooms) const;
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void tagOrder();
+    void tagUpdates();
+    void directChats();
+};
+
+void TestTagIndex::sync(const QHash<int, QJsonObject>& roomsToTags, const QJsonArray& accountData)
+{
+    static int batch = 0;
+    QJsonObject joinedRooms;
+    for (auto it = roomsToTags.cbegin(); it != roomsToTags.cend(); ++it)
+        joinedRooms.insert(roomId(it.key()),
+                           QJsonObject{ { "account_data"_L1,
+                                          QJsonObject{ { "events"_L1, QJsonArray{ *it } } } } });
+    SyncData data;
+    data.parseJson({ { "next_batch"_L1, u"s_%1"_s.arg(++batch) },
+                     { "account_data"_L1, QJsonObject{ { "events"_L1, accountData } } },
+                     { "rooms"_L1, QJsonObject{ { "join"_L1, joinedRooms } } } });
+    syncMockConnection(connection, std::move(data));
+}
+
+QList<int> TestTagIndex::roomNumbers(const QVector<Room*>& rooms) const
+{
+    QList<int> result;
+    for (const auto* r : rooms)
+        result.push_back(r->id().section(u':', 0, 0).mid(5).toInt());
+    return result;
+}
+
+void TestTagIndex::initTestCase()
+{
+    QVERIFY(server.isListening());
+    connection = connectToStandInServer(server, LocalUserId);
+    sync({ { 1, tagsJson({ { FavouriteTag, 0.5 }, { WorkTag, 0.1 } }) },
+           { 2, tagsJson({ { FavouriteTag, 0.1 } }) },
+           { 3, tagsJson({ { FavouriteTag, -1 }, { LowPriorityTag, 0.3 } }) },
+           { 4, tagsJson({ { FavouriteTag, 0.5 } }) },
+           { 5, tagsJson({}) } });
+}
+
+void TestTagIndex::cleanupTestCase() { delete connection; }
+
+void TestTagIndex::tagOrder()
+{
+    // Rooms without order go last; equal orders are sorted by room id
+    QCOMPARE(roomNumbers(connection->roomsWithTag(FavouriteTag)), (QList{ 2, 1, 4, 3 }));
+    QCOMPARE(roomNumbers(connection->roomsWithTag(WorkTag)), QList{ 1 });
+    QVERIFY(connection->roomsWithTag(u"u.unknown"_s).isEmpty());
+    QCOMPARE(connection->tagNames(), (QStringList{ FavouriteTag, WorkTag, LowPriorityTag }));
+    const auto tagsToRooms = connection->tagsToRooms();
+    QCOMPARE(tagsToRooms.size(), qsizetype(3));
+    QCOMPARE(tagsToRooms.value(FavouriteTag), connection->roomsWithTag(FavouriteTag));
+    QCOMPARE(roomNumbers(tagsToRooms.value(LowPriorityTag)), QList{ 3 });
+}
+
+void TestTagIndex::tagUpdates()
+{
+    QSignalSpy tagSpy(connection, &Connection::roomsWithTagChanged);
+    // Room 1 moves to the top of favourites and leaves work; room 5 gets to work
+    sync({ { 1, tagsJson({ { FavouriteTag, 0.05 } }) },
+           { 5, tagsJson({ { WorkTag, 0.2 } }) } });
+    QCOMPARE(roomNumbers(connection->roomsWithTag(FavouriteTag)), (QList{ 1, 2, 4, 3 }));
+    QCOMPARE(roomNumbers(connection->roomsWithTag(WorkTag)), QList{ 5 });
+    QSet<QString> changedTags;
+    for (const auto& args : std::as_const(tagSpy))
+        changedTags.insert(args.front().toString());
+    QCOMPARE(changedTags, (QSet{ FavouriteTag, WorkTag }));
+
+    // Tags that don't change don't cause signals
+    tagSpy.clear();
+    sync({ { 2, tagsJson({ { FavouriteTag, 0.1 }, { LowPriorityTag, 0.9 } }) } });
+    QCOMPARE(tagSpy.size(), 1);
+    QCOMPARE(tagSpy.front().front().toString(), LowPriorityTag);
+    QCOMPARE(roomNumbers(connection->roomsWithTag(LowPriorityTag)), (QList{ 3, 2 }));
+
+    // The last room with a tag takes the tag away with it
+    tagSpy.clear();
+    sync({ { 5, tagsJson({}) } });
+    QCOMPARE(tagSpy.size(), 1);
+    QVERIFY(!connection->tagsToRooms().contains(WorkTag));
+    QCOMPARE(connection->tagNames(), (QStringList{ FavouriteTag, LowPriorityTag }));
+}
+
+void TestTagIndex::directChats()
+{
+    QSignalSpy roomSpy(connection, &Connection::directChatMembersChanged);
+    QSignalSpy listSpy(connection, &Connection::directChatsListChanged);
+    const QJsonObject directChatsJson{
+        { FriendId, QJsonArray{ roomId(4), roomId(5) } },
+        { OtherFriendId, QJsonArray{ roomId(5) } },
+    };
+    sync({}, { QJsonObject{ { TypeKey, "m.direct"_L1 }, { ContentKey, directChatsJson } } });
+    QCOMPARE(listSpy.size(), 1);
+    QCOMPARE(roomSpy.size(), 2); // Once per room, not per user
+    QVERIFY(connection->isDirectChat(roomId(5)));
+    auto* room5 = connection->room(roomId(5));
+    QVERIFY(room5);
+    auto memberIds = connection->directChatMemberIds(room5);
+    std::ranges::sort(memberIds);
+    QCOMPARE(memberIds, (QStringList{ FriendId, OtherFriendId }));
+
+    roomSpy.clear();
+    connection->removeFromDirectChats(roomId(5), OtherFriendId);
+    QCOMPARE(roomSpy.size(), 1);
+    QCOMPARE(connection->directChatMemberIds(room5), QStringList{ FriendId });
+
+    // Removal for all users clears the reverse lookup too
+    roomSpy.clear();
+    connection->removeFromDirectChats(roomId(4));
+    QCOMPARE(roomSpy.size(), 1);
+    QCOMPARE(roomSpy.front().front().toString(), roomId(4));
+    QVERIFY(!connection->isDirectChat(roomId(4)));
+    QVERIFY(connection->isDirectChat(roomId(5)));
+    QCOMPARE(connection->directChats().size(), qsizetype(1));
+}
+
+QTEST_GUILESS_MAIN(TestTagIndex)
+#include "testtagindex.moc"
@@ -7,7 +7,11 @@
 
 #include <Quotient/connection.h>
 #include <Quotient/networkaccessmanager.h>
+#include <Quotient/syncdata.h>
 
+#include <Quotient/events/roommessageevent.h>
+
+#include <QtNetwork/QTcpSocket>
 #include <QtTest/QSignalSpy>
 
 using Quotient::Connection;
@@ -45,3 +49,126 @@ std::shared_ptr<Quotient::Connection> Quotient::createTestConnection(QLatin1Stri
     }
     return c;
 }
+
+void Quotient::syncMockConnection(Connection* connection, SyncData&& data)
+{
+    connection->onSyncSuccess(std::move(data), false);
+    // Rooms get their updates in time slices, deliver them now
+    connection->applyPendingRoomUpdates();
+}
+
+bool Quotient::syncOnce(Connection* connection, bool applyRoomUpdates)
+{
+    QSignalSpy doneSpy(connection, &Connection::syncDone);
+    connection->sync(0);
+    if (!doneSpy.wait())
+        return false;
+    if (applyRoomUpdates)
+        connection->applyPendingRoomUpdates();
+    return true;
+}
+
+QJsonObject Quotient::messageJson(const QString& eventId, const QString& senderId,
+                                  qint64 timestamp, const QString& body,
+                                  const QJsonObject& content)
+{
+    QJsonObject fullContent{ { "msgtype"_L1, "m.text"_L1 }, { "body"_L1, body } };
+    for (auto it = content.begin(); it != content.end(); ++it)
+        fullContent.insert(it.key(), it.value());
+    return { { TypeKey, u"m.room.message"_s },
+             { EventIdKey, eventId },
+             { SenderKey, senderId },
+             { "origin_server_ts"_L1, timestamp },
+             { ContentKey, fullContent } };
+}
+
+QString Quotient::numberedEventId(int n) { return u"$event%1:example.org"_s.arg(n); }
+
+QJsonObject Quotient::numberedMessage(int n, const QString& senderId, const QString& body,
+                                      const QString& msgtype)
+{
+    return messageJson(numberedEventId(n), senderId, 1000 + n, body,
+                       { { "msgtype"_L1, msgtype } });
+}
+
+QJsonObject Quotient::numberedReaction(int n, int target, const QString& senderId)
+{
+    const QJsonObject relation{ { "rel_type"_L1, "m.annotation"_L1 },
+                                { "event_id"_L1, numberedEventId(target) },
+                                { "key"_L1, u"👍"_s } };
+    return { { TypeKey, u"m.reaction"_s },
+             { EventIdKey, numberedEventId(n) },
+             { SenderKey, senderId },
+             { "origin_server_ts"_L1, 1000 + n },
+             { ContentKey, QJsonObject{ { RelatesToKey, relation } } } };
+}
+
+QJsonObject Quotient::readReceipt(const QString& userId, int target)
+{
+    const QJsonObject users{ { userId, QJsonObject{ { "ts"_L1, 1 } } } };
+    return { { TypeKey, u"m.receipt"_s },
+             { ContentKey, QJsonObject{ { numberedEventId(target),
+                                          QJsonObject{ { "m.read"_L1, users } } } } } };
+}
+
+bool Quotient::NoticesTogglingRoom::isEventNotable(const TimelineItem& ti) const
+{
+    const auto* rme = ti.viewAs<RoomMessageEvent>();
+    return Room::isEventNotable(ti)
+           || (noticesAreNotable && rme && rme->msgtype() == MessageEventType::Notice);
+}
+
+Quotient::StandInServer::StandInServer(Handler handler) : handler(std::move(handler))
+{
+    connect(this, &QTcpServer::newConnection, this, [this] {
+        while (auto* socket = nextPendingConnection()) {
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket] { serve(socket); });
+        }
+    });
+    listen(QHostAddress::LocalHost);
+}
+
+QUrl Quotient::StandInServer::url() const
+{
+    return QUrl(u"http://127.0.0.1:%1"_s.arg(serverPort()));
+}
+
+void Quotient::StandInServer::serve(QTcpSocket* socket)
+{
+    auto& buffer = buffers[socket];
+    buffer += socket->readAll();
+    while (true) {
+        const auto headersEnd = buffer.indexOf("\r\n\r\n");
+        if (headersEnd == -1)
+            return;
+        const auto headers = buffer.left(headersEnd);
+        qsizetype contentLength = 0;
+        for (const auto& line : headers.split('\n'))
+            if (line.toLower().startsWith("content-length:"))
+                contentLength = line.mid(15).trimmed().toLongLong();
+        if (buffer.size() < headersEnd + 4 + contentLength)
+            return;
+        const auto requestLine = headers.left(headers.indexOf("\r\n")).split(' ');
+        const auto body = buffer.mid(headersEnd + 4, contentLength);
+        buffer.remove(0, headersEnd + 4 + contentLength);
+
+        const QUrl requestUrl(QString::fromLatin1(requestLine.value(1)));
+        const auto reply = handler({ requestLine.value(0), requestUrl.path(), QUrlQuery(requestUrl),
+                                     QJsonDocument::fromJson(body).object() });
+        const auto replyBody = QJsonDocument(reply.body).toJson(QJsonDocument::Compact);
+        bytesSent[requestUrl.path()] += replyBody.size();
+        socket->write("HTTP/1.1 " + QByteArray::number(reply.httpCode)
+                      + (reply.httpCode == 200 ? " OK" : " Error")
+                      + "\r\nContent-Type: application/json\r\nContent-Length: "
+                      + QByteArray::number(replyBody.size()) + "\r\n\r\n" + replyBody);
+    }
+}
+
+Connection* Quotient::connectToStandInServer(const StandInServer& server, const QString& userId)
+{
+    auto* c = new Connection(server.url());
+    c->enableEncryption(false);
+    c->assumeIdentity(userId, u"DEVICE"_s, u"token"_s);
+    return c;
+}
@@ -4,17 +4,107 @@
 
 #pragma once
 
+#include <Quotient/room.h>
+
+#include <QtCore/QJsonObject>
+#include <QtCore/QUrlQuery>
+#include <QtNetwork/QTcpServer>
 #include <QtTest/QTest>
 
+#include <functional>
 #include <memory>
 
 namespace Quotient {
 
 class Connection;
+class SyncData;
 
 std::shared_ptr<Connection> createTestConnection(QLatin1StringView localUserName,
                                                  QLatin1StringView secret,
                                                  QLatin1StringView deviceName);
+
+//! \brief Feed \p data to \p connection as if it came from /sync
+//!
+//! This is meant for connections made with Connection::makeMockConnection(); room updates,
+//! normally applied by Connection asynchronously, are all applied by the time this returns.
+void syncMockConnection(Connection* connection, SyncData&& data);
+
+//! \brief Sync \p connection once, with whatever server it's connected to
+//!
+//! \param applyRoomUpdates whether room updates, normally applied by Connection
+//!                         asynchronously, should all be applied by the time this returns
+//! \return false if the sync didn't finish in time
+bool syncOnce(Connection* connection, bool applyRoomUpdates = true);
+
+//! \brief Make the JSON of a text message event as it comes from the server
+//!
+//! Entries of \p content are added to the default message content, or replace its parts;
+//! e.g., to change the message type or add a relation.
+QJsonObject messageJson(const QString& eventId, const QString& senderId, qint64 timestamp,
+                        const QString& body, const QJsonObject& content = {});
+
+//! The id of the event number \p n, as made by numberedMessage() and numberedReaction()
+QString numberedEventId(int n);
+
+//! A text message with the id numberedEventId(\p n) and the timestamp 1000 + \p n
+QJsonObject numberedMessage(int n, const QString& senderId = u"@bob:example.org"_s,
+                            const QString& body = u"Hello"_s,
+                            const QString& msgtype = u"m.text"_s);
+
+//! A reaction with the id numberedEventId(\p n) to the event numberedEventId(\p target)
+QJsonObject numberedReaction(int n, int target, const QString& senderId = u"@bob:example.org"_s);
+
+//! An m.receipt event with the read receipt of \p userId on numberedEventId(\p target)
+QJsonObject readReceipt(const QString& userId, int target);
+
+//! A room where notices can become notable, as a client setting would decide
+class NoticesTogglingRoom : public Room {
+public:
+    using Room::Room;
+
+    static inline bool noticesAreNotable = false;
+
+    bool isEventNotable(const TimelineItem& ti) const override;
+};
+
+//! \brief A minimal stand-in for a homeserver
+//!
+//! The server speaks just enough HTTP/1.1 for QNetworkAccessManager, passes each request to
+//! the handler and sends back what the handler returns; it also counts bytes of response bodies
+//! sent for each path.
+class StandInServer : public QTcpServer {
+public:
+    struct Request {
+        QByteArray method;
+        QString path;
+        QUrlQuery query;
+        QJsonObject body;
+    };
+    struct Reply {
+        Reply(QJsonObject body = {}, int httpCode = 200)
+            : body(std::move(body)), httpCode(httpCode)
+        {}
+
+        QJsonObject body;
+        int httpCode;
+    };
+    using Handler = std::function<Reply(const Request&)>;
+
+    explicit StandInServer(Handler handler);
+
+    QUrl url() const;
+
+    QHash<QString, qint64> bytesSent;
+
+private:
+    Handler handler;
+    QHash<QTcpSocket*, QByteArray> buffers;
+
+    void serve(QTcpSocket* socket);
+};
+
+//! Make a connection to \p server that is logged in as \p userId without talking to the server
+Connection* connectToStandInServer(const StandInServer& server, const QString& userId);
 }
 
 #define CREATE_CONNECTION(VAR, USERNAME, SECRET, DEVICE_NAME)             \
@@ -0,0 +1,146 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include <Quotient/timelinecolumns.h>
+
+#include <Quotient/events/roommessageevent.h>
+
+#include <QtTest/QtTest>
+
+#include <deque>
+
+using namespace Quotient;
+
+namespace {
+
+// A long timeline window where a bot has posted a long series of messages in a row
+constexpr auto TimelineSize = 20'000;
+
+QString senderId(int n) { return u"@user%1:example.org"_s.arg(n); }
+
+RoomEventPtr makeMessage(int n, const QString& sender)
+{
+    return loadEvent<RoomEvent>(
+        QJsonObject{ { TypeKey, RoomMessageEvent::TypeId },
+                     { EventIdKey, u"$event%1:example.org"_s.arg(n) },
+                     { SenderKey, sender },
+                     { "origin_server_ts"_L1, 1'000'000 + n * 1000 },
+                     { ContentKey, QJsonObject{ { "msgtype"_L1, "m.text"_L1 },
+                                                { "body"_L1, u"Message %1"_s.arg(n) } } } });
+}
+
+} // namespace
+
+class TimelineColumnsBenchmark : public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void rows();
+    void benchmarkSenderScan_data();
+    void benchmarkSenderScan();
+    void benchmarkTimestampScan_data();
+    void benchmarkTimestampScan();
+
+private:
+    IdPool pool;
+    std::deque<TimelineItem> timeline;
+    TimelineColumns columns{ pool };
+};
+
+void TimelineColumnsBenchmark::initTestCase()
+{
+    // The bot posts everything but the first and the last 10 messages
+    for (int n = 0; n < TimelineSize; ++n) {
+        auto e = makeMessage(n, n < 10 || n >= TimelineSize - 10 ? senderId(n % 3)
+                                                                  : u"@bot:example.org"_s);
+        e->internIds(pool);
+        columns.append(timeline.emplace_back(std::move(e), n));
+    }
+    qInfo() << "Column storage per event:"
+            << sizeof(InternedId) + sizeof(qint64) << "bytes";
+}
+
+void TimelineColumnsBenchmark::rows()
+{
+    IdPool localPool;
+    TimelineColumns c(localPool);
+    std::deque<TimelineItem> items;
+    // Historical events come with negative indices
+    c.prepend(items.emplace_front(makeMessage(-1, senderId(1)), -1));
+    c.append(items.emplace_back(makeMessage(0, senderId(1)), 0));
+    c.append(items.emplace_back(makeMessage(1, senderId(2)), 1));
+    c.prepend(items.emplace_front(makeMessage(-2, senderId(2)), -2));
+    QCOMPARE(c.size(), size_t(4));
+    QCOMPARE(c.minIndex(), -2);
+    QCOMPARE(c.endIndex(), 2);
+    QCOMPARE(c.senderId(-1).toString(), senderId(1));
+    QCOMPARE(c.timestamp(1), items.back()->originTimestampMs());
+
+    const auto user1 = localPool.find(senderId(1));
+    QCOMPARE(c.findNotSentBy(-1, user1), 1);
+    QCOMPARE(c.findNotSentBy(-2, user1), -2);
+    QCOMPARE(c.findNotSentBy(2, user1), 2);
+    QCOMPARE(c.findNotSentBy(0, localPool.find(senderId(2))), 0);
+    QCOMPARE(c.findNotBefore(items.front()->originTimestampMs()), -2);
+    QCOMPARE(c.findNotBefore(items[2]->originTimestampMs()), 0);
+    QCOMPARE(c.findNotBefore(items.back()->originTimestampMs() + 1), 2);
+
+    c.dropOldest(2);
+    QCOMPARE(c.minIndex(), 0);
+    QCOMPARE(c.size(), size_t(2));
+    QCOMPARE(c.senderId(1).toString(), senderId(2));
+}
+
+void TimelineColumnsBenchmark::benchmarkSenderScan_data()
+{
+    QTest::addColumn<bool>("columnar");
+    QTest::newRow("events") << false;
+    QTest::newRow("columns") << true;
+}
+
+void TimelineColumnsBenchmark::benchmarkSenderScan()
+{
+    QFETCH(bool, columnar);
+    // Promoting the bot's read receipt over its own messages, as Room does for read receipts
+    const auto botId = u"@bot:example.org"_s;
+    const auto botHandle = pool.find(botId);
+    int foundIndex = -1;
+    QBENCHMARK {
+        if (columnar)
+            foundIndex = columns.findNotSentBy(10, botHandle);
+        else
+            foundIndex = std::find_if(timeline.cbegin() + 10, timeline.cend(),
+                                      [&botId](const TimelineItem& ti) {
+                                          return ti->senderId() != botId;
+                                      })
+                             ->index();
+    }
+    QCOMPARE(foundIndex, TimelineSize - 10);
+}
+
+void TimelineColumnsBenchmark::benchmarkTimestampScan_data()
+{
+    benchmarkSenderScan_data();
+}
+
+void TimelineColumnsBenchmark::benchmarkTimestampScan()
+{
+    QFETCH(bool, columnar);
+    // Find where the last hour begins, as Room::findInTimeline(QDateTime) does
+    const auto since = timeline.back()->originTimestampMs() - 3'599'999;
+    int foundIndex = -1;
+    QBENCHMARK {
+        if (columnar)
+            foundIndex = columns.findNotBefore(since);
+        else
+            foundIndex = std::ranges::find_if(timeline, [since](const TimelineItem& ti) {
+                             return ti->originTimestampMs() >= since;
+                         })->index();
+    }
+    QCOMPARE(foundIndex, TimelineSize - 3600);
+}
+
+QTEST_APPLESS_MAIN(TimelineColumnsBenchmark)
+#include "timelinecolumnsbenchmark.moc"
@@ -0,0 +1,182 @@
+// SPDX-FileCopyrightText: 2026 Quotient contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "testutils.h"
+
+#include <Quotient/connection.h>
+#include <Quotient/idpool.h>
+#include <Quotient/room.h>
+#include <Quotient/syncdata.h>
+#include <Quotient/user.h>
+
+#include <QtCore/QRandomGenerator>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+using namespace Quotient;
+
+namespace {
+
+// A bot in big federated rooms: a few regular posters and a long tail of senders who show up
+// once and never again
+constexpr auto LookupsCount = 200'000;
+constexpr auto RegularsCount = 2'000;
+constexpr auto MembersCount = 1'000;
+constexpr auto CacheCapacity = 10'000;
+const auto LocalUserId = u"@bot:example.org"_s;
+const auto JoinedRoomId = u"!joined:example.org"_s;
+
+QString memberId(int n) { return u"@member%1:example.org"_s.arg(n); }
+
+//! The sender of the \p n-th message; one in five messages is from a regular
+QString senderId(int n, QRandomGenerator& rng)
+{
+    return n % 5 == 0 ? u"@regular%1:example.org"_s.arg(rng.bounded(RegularsCount))
+                      : u"@passer%1:far-away.example.org"_s.arg(n);
+}
+
+QJsonObject memberEvent(int n)
+{
+    return { { TypeKey, u"m.room.member"_s },
+             { EventIdKey, u"$member%1:example.org"_s.arg(n) },
+             { SenderKey, memberId(n) },
+             { StateKeyKey, memberId(n) },
+             { "origin_server_ts"_L1, 1000 },
+             { ContentKey, QJsonObject{ { "membership"_L1, "join"_L1 } } } };
+}
+
+//! The number of user objects alive, after finishing pending deletions
+qsizetype liveUsers(const Connection* connection)
+{
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    return connection->findChildren<User*>(Qt::FindDirectChildrenOnly).size();
+}
+
+} // namespace
+
+class UserCacheBenchmark : public QObject {
+    Q_OBJECT
+
+    StandInServer server{ [](const StandInServer::Request&) -> StandInServer::Reply {
+        return {};
+    } };
+
+    //! A new connection that is a member of a joined room with MembersCount members
+    Connection* makeConnection();
+
+private Q_SLOTS:
+    void initTestCase();
+    void retention();
+    void memoryFootprint();
+    void benchmarkChurn_data();
+    void benchmarkChurn();
+};
+
+Connection* UserCacheBenchmark::makeConnection()
+{
+    auto* connection = connectToStandInServer(server, LocalUserId);
+    QJsonArray members;
+    for (int n = 0; n < MembersCount; ++n)
+        members.append(memberEvent(n));
+    const QJsonObject roomData{ { "state"_L1, QJsonObject{ { "events"_L1, members } } } };
+    SyncData data;
+    data.parseJson({ { "next_batch"_L1, u"s_1"_s },
+                     { "rooms"_L1,
+                       QJsonObject{ { "join"_L1, QJsonObject{ { JoinedRoomId, roomData } } } } } });
+    syncMockConnection(connection, std::move(data));
+    return connection;
+}
+
+void UserCacheBenchmark::initTestCase() { QVERIFY(server.isListening()); }
+
+void UserCacheBenchmark::retention()
+{
+    std::unique_ptr<Connection> connection{ makeConnection() };
+    QVERIFY(connection->room(JoinedRoomId));
+    connection->setUserCacheCapacity(CacheCapacity);
+    QCOMPARE(connection->userCacheCapacity(), qsizetype(CacheCapacity));
+    QSignalSpy deletionSpy(connection.get(), &Connection::aboutToDeleteUser);
+
+    std::vector<QPointer<User>> members;
+    for (int n = 0; n < MembersCount; ++n)
+        members.emplace_back(connection->user(memberId(n)));
+    auto* heldUser = connection->user(u"@held:far-away.example.org"_s);
+    connection->holdUser(heldUser);
+    QPointer releasedUser = connection->user(u"@released:far-away.example.org"_s);
+    connection->holdUser(releasedUser);
+    connection->releaseUser(releasedUser);
+    QPointer localUser = connection->user();
+
+    QRandomGenerator rng(42);
+    for (int n = 0; n < LookupsCount; ++n) {
+        QVERIFY(connection->user(senderId(n, rng)));
+        if (n % 10'000 == 0)
+            QVERIFY(connection->userIds().size() <= CacheCapacity);
+    }
+    QVERIFY(!deletionSpy.isEmpty());
+    QVERIFY(liveUsers(connection.get()) <= CacheCapacity);
+
+    // Members of joined rooms, held users and the local user stay; others go
+    QVERIFY(std::ranges::all_of(members, [](const QPointer<User>& u) { return !u.isNull(); }));
+    QCOMPARE(connection->user(memberId(0)), members.front().get());
+    QCOMPARE(connection->user(heldUser->id()), heldUser);
+    QVERIFY(localUser);
+    QVERIFY(!releasedUser);
+
+    // Users that come back get a new object
+    const auto* passer = connection->user(u"@passer1:far-away.example.org"_s);
+    QVERIFY(passer);
+    QCOMPARE(passer->id(), u"@passer1:far-away.example.org"_s);
+
+    // Once released, the held user can go as well
+    connection->releaseUser(heldUser);
+    connection->setUserCacheCapacity(MembersCount + 10);
+    QVERIFY(liveUsers(connection.get()) <= MembersCount + 10);
+    QVERIFY(std::ranges::all_of(members, [](const QPointer<User>& u) { return !u.isNull(); }));
+}
+
+void UserCacheBenchmark::memoryFootprint()
+{
+    for (const auto capacity : { 0, CacheCapacity }) {
+        std::unique_ptr<Connection> connection{ makeConnection() };
+        connection->setUserCacheCapacity(capacity);
+        QRandomGenerator rng(42);
+        for (int n = 0; n < LookupsCount; ++n)
+            connection->user(senderId(n, rng));
+        const auto users = liveUsers(connection.get());
+        connection->idPool().squeeze();
+        qInfo().nospace() << LookupsCount << " lookups with "
+                          << (capacity > 0 ? u"capacity %1"_s.arg(capacity) : u"no capacity"_s)
+                          << ": " << users << " user objects alive, "
+                          << connection->idPool().size() << " identifiers in the pool";
+        if (capacity > 0) {
+            QVERIFY(users <= capacity);
+            QVERIFY(connection->idPool().size() < LookupsCount / 2);
+        } else
+            QVERIFY(users > LookupsCount / 2);
+    }
+}
+
+void UserCacheBenchmark::benchmarkChurn_data()
+{
+    QTest::addColumn<int>("capacity");
+    QTest::newRow("unbounded") << 0;
+    QTest::newRow("bounded") << CacheCapacity;
+}
+
+void UserCacheBenchmark::benchmarkChurn()
+{
+    QFETCH(int, capacity);
+    std::unique_ptr<Connection> connection{ makeConnection() };
+    connection->setUserCacheCapacity(capacity);
+    QRandomGenerator rng(42);
+    int n = 0;
+    QBENCHMARK {
+        for (int i = 0; i < 10'000; ++i, ++n)
+            connection->user(senderId(n, rng));
+    }
+}
+
+QTEST_GUILESS_MAIN(UserCacheBenchmark)
+#include "usercachebenchmark.moc"